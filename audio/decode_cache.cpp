@@ -0,0 +1,241 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "audio/decode_cache.h"
+#include "audio/audiostream.h"
+
+#include "common/atomic.h"
+#include "common/textconsole.h"
+#include "common/util.h"
+
+namespace Common {
+DECLARE_SINGLETON(Audio::DecodeCache);
+}
+
+namespace Audio {
+
+/**
+ * The samples of a decoded clip. They are shared between the cache and the
+ * streams playing them, which may be deleted by the mixer thread, so the
+ * reference count is atomic.
+ */
+class DecodedAudio {
+public:
+	/** Take over the samples, with one reference held by the caller. */
+	DecodedAudio(int16 *samples, uint32 length, int rate, bool stereo)
+		: _samples(samples), _length(length), _rate(rate), _isStereo(stereo), _refCount(1) {
+	}
+
+	void acquire() {
+		uint32 count;
+		do {
+			count = _refCount;
+		} while (!Common::atomicCompareAndSwap(_refCount, count, count + 1));
+	}
+
+	void release() {
+		uint32 count;
+		do {
+			count = _refCount;
+		} while (!Common::atomicCompareAndSwap(_refCount, count, count - 1));
+
+		if (count == 1)
+			delete this;
+	}
+
+	const int16 *getSamples() const { return _samples; }
+	/** Return the number of samples, counting both channels of stereo clips. */
+	uint32 getLength() const { return _length; }
+	int getRate() const { return _rate; }
+	bool isStereo() const { return _isStereo; }
+	uint32 getSize() const { return _length * 2; }
+
+private:
+	~DecodedAudio() { free(_samples); }
+
+	int16 *_samples;
+	const uint32 _length;
+	const int _rate;
+	const bool _isStereo;
+	volatile uint32 _refCount;
+};
+
+/**
+ * A reference to the samples of a clip, held by the cache.
+ */
+class DecodedAudioRef {
+public:
+	explicit DecodedAudioRef(DecodedAudio *audio) : _audio(audio) {
+		_audio->acquire();
+	}
+
+	DecodedAudioRef(const DecodedAudioRef &other) : _audio(other._audio) {
+		_audio->acquire();
+	}
+
+	~DecodedAudioRef() {
+		_audio->release();
+	}
+
+	DecodedAudio *get() const { return _audio; }
+
+private:
+	DecodedAudioRef &operator=(const DecodedAudioRef &);
+
+	DecodedAudio *const _audio;
+};
+
+/**
+ * A stream playing the samples of a cached clip.
+ */
+class DecodedAudioStream : public SeekableAudioStream {
+public:
+	DecodedAudioStream(DecodedAudio *audio) : _audio(audio), _pos(0) {
+		_audio->acquire();
+	}
+
+	~DecodedAudioStream() {
+		_audio->release();
+	}
+
+	int readBuffer(int16 *buffer, const int numSamples) {
+		const int samples = MIN<int>(numSamples, _audio->getLength() - _pos);
+		memcpy(buffer, _audio->getSamples() + _pos, samples * 2);
+		_pos += samples;
+		return samples;
+	}
+
+	bool isStereo() const { return _audio->isStereo(); }
+	int getRate() const { return _audio->getRate(); }
+	bool endOfData() const { return _pos >= _audio->getLength(); }
+
+	bool seek(const Timestamp &where) {
+		if (where > getLength())
+			return false;
+
+		_pos = MIN<uint32>(convertTimeToStreamPos(where, getRate(), isStereo()).totalNumberOfFrames(), _audio->getLength());
+		return true;
+	}
+
+	Timestamp getLength() const {
+		return Timestamp(0, _audio->getLength() / (isStereo() ? 2 : 1), getRate());
+	}
+
+private:
+	DecodedAudio *_audio;
+	uint32 _pos;
+};
+
+DecodeCache::DecodeCache(uint32 maxSize, uint32 maxClipSize)
+	: _clips(maxSize), _maxClipSize(maxClipSize) {
+}
+
+// Out of line, where DecodedAudioRef is complete
+DecodeCache::~DecodeCache() {
+}
+
+SeekableAudioStream *DecodeCache::get(const Common::String &key) {
+	const DecodedAudioRef *ref = _clips.get(key);
+	if (!ref)
+		return 0;
+
+	return new DecodedAudioStream(ref->get());
+}
+
+SeekableAudioStream *DecodeCache::add(const Common::String &key, SeekableAudioStream *stream) {
+	if (!stream)
+		return 0;
+
+	const bool stereo = stream->isStereo();
+	const int rate = stream->getRate();
+
+	// Don't bother decoding clips which are known to be too long
+	const uint64 length = (uint64)stream->getLength().convertToFramerate(rate).totalNumberOfFrames() * (stereo ? 2 : 1);
+	if (length * 2 > _maxClipSize)
+		return stream;
+
+	// The length is only trusted to size the buffer, the stream is decoded
+	// until it ends
+	const int kChunkSize = 4096;
+	uint32 capacity = (uint32)length + kChunkSize;
+	uint32 decoded = 0;
+	int16 *samples = (int16 *)malloc(capacity * 2);
+	if (!samples)
+		return stream;
+
+	while (!stream->endOfData()) {
+		if (decoded * 2 > _maxClipSize) {
+			free(samples);
+			if (!stream->rewind())
+				warning("DecodeCache::add: Could not rewind '%s'", key.c_str());
+			return stream;
+		}
+
+		if (capacity - decoded < (uint32)kChunkSize) {
+			capacity = capacity * 2 + kChunkSize;
+			int16 *grown = (int16 *)realloc(samples, capacity * 2);
+			if (!grown) {
+				free(samples);
+				stream->rewind();
+				return stream;
+			}
+			samples = grown;
+		}
+
+		const int read = stream->readBuffer(samples + decoded, kChunkSize);
+		if (read <= 0)
+			break;
+		decoded += read;
+	}
+
+	delete stream;
+
+	if (decoded < capacity) {
+		int16 *shrunk = (int16 *)realloc(samples, MAX<uint32>(decoded, 1) * 2);
+		if (shrunk)
+			samples = shrunk;
+	}
+
+	DecodedAudio *audio = new DecodedAudio(samples, decoded, rate, stereo);
+	SeekableAudioStream *result = new DecodedAudioStream(audio);
+
+	// Make room by dropping the least recently used clips. Clips bigger
+	// than the whole budget are played, but not cached.
+	_clips.put(key, DecodedAudioRef(audio), audio->getSize());
+	audio->release();
+
+	return result;
+}
+
+void DecodeCache::remove(const Common::String &key) {
+	_clips.remove(key);
+}
+
+void DecodeCache::clear() {
+	_clips.clear();
+}
+
+void DecodeCache::setMaxSize(uint32 maxSize) {
+	_clips.setMaxSize(maxSize);
+}
+
+} // End of namespace Audio
@@ -0,0 +1,124 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef AUDIO_DECODE_CACHE_H
+#define AUDIO_DECODE_CACHE_H
+
+#include "common/hash-str.h"
+#include "common/lru-cache.h"
+#include "common/singleton.h"
+#include "common/str.h"
+
+namespace Audio {
+
+class SeekableAudioStream;
+class DecodedAudioRef;
+
+/**
+ * A cache of decoded sounds, for engines which play the same short
+ * compressed clips over and over, like speech and sound effects. Instead of
+ * opening and decoding the clip each time, a stream reading from the cached
+ * samples is handed out.
+ *
+ * Clips are identified by a key naming their source, usually the name of
+ * the file they come from, plus their offset if the file holds several
+ * clips. Keys are case insensitive. Only clips up to a maximum size are
+ * cached, and the least recently used clips are dropped when the cached
+ * samples take up more than the memory budget.
+ *
+ * The cache itself must only be used from one thread, normally the engine
+ * thread. The streams it hands out may be played and deleted by the mixer,
+ * and keep their samples alive after the clip has been dropped.
+ */
+class DecodeCache : public Common::Singleton<DecodeCache> {
+public:
+	enum {
+		kDefaultMaxSize = 16 * 1024 * 1024,
+		kDefaultMaxClipSize = 1024 * 1024
+	};
+
+	/**
+	 * @param maxSize		the maximum number of bytes taken by the cached
+	 *						samples
+	 * @param maxClipSize	the maximum number of bytes the samples of a
+	 *						single clip may take
+	 */
+	explicit DecodeCache(uint32 maxSize = kDefaultMaxSize, uint32 maxClipSize = kDefaultMaxClipSize);
+	~DecodeCache();
+
+	/**
+	 * Look up a clip, counting a hit or a miss.
+	 *
+	 * @return a new stream playing the clip from the start, or 0 if it is
+	 *         not cached
+	 */
+	SeekableAudioStream *get(const Common::String &key);
+
+	/**
+	 * Decode a clip and add it to the cache, replacing the one with the same
+	 * key. The stream is always taken over.
+	 *
+	 * Clips which are too long to be cached are not decoded. The stream is
+	 * rewound and returned as is, so it can be played all the same.
+	 *
+	 * @param key		the name of the source of the clip
+	 * @param stream	the decoder of the clip, positioned at its start
+	 * @return a stream playing the clip from the start
+	 */
+	SeekableAudioStream *add(const Common::String &key, SeekableAudioStream *stream);
+
+	/** Drop a clip, for example because its file changed. */
+	void remove(const Common::String &key);
+
+	/** Drop all clips. */
+	void clear();
+
+	/** Change the memory budget, dropping clips which don't fit anymore. */
+	void setMaxSize(uint32 maxSize);
+	uint32 getMaxSize() const { return _clips.getMaxSize(); }
+
+	/** Change the size of the longest clip which is cached. */
+	void setMaxClipSize(uint32 maxClipSize) { _maxClipSize = maxClipSize; }
+	uint32 getMaxClipSize() const { return _maxClipSize; }
+
+	/** Return the number of bytes taken by the cached samples. */
+	uint32 getSize() const { return _clips.getSize(); }
+
+	/** Return the number of cached clips. */
+	uint getCount() const { return _clips.getCount(); }
+
+	uint32 getHits() const { return _clips.getHits(); }
+	uint32 getMisses() const { return _clips.getMisses(); }
+	uint32 getEvictions() const { return _clips.getEvictions(); }
+	void resetStatistics() { _clips.resetStatistics(); }
+
+private:
+	Common::LRUCache<Common::String, DecodedAudioRef, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> _clips;
+	uint32 _maxClipSize;
+};
+
+} // End of namespace Audio
+
+/** Shortcut for accessing the shared decode cache. */
+#define AudioDecodeCache Audio::DecodeCache::instance()
+
+#endif
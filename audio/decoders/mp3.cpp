@@ -24,7 +24,9 @@
 
 #ifdef USE_MAD
 
+#include "common/array.h"
 #include "common/debug.h"
+#include "common/md5.h"
 #include "common/mutex.h"
 #include "common/ptr.h"
 #include "common/queue.h"
@@ -61,12 +63,27 @@ protected:
 	void decodeMP3Data(Common::ReadStream &stream);
 	void readMP3Data(Common::ReadStream &stream);
 
-	void initStream(Common::ReadStream &stream);
+	void initStream(Common::ReadStream &stream, uint32 offset = 0);
 	void readHeader(Common::ReadStream &stream);
 	void deinitStream();
 
 	int fillBuffer(Common::ReadStream &stream, int16 *buffer, const int numSamples);
 
+	/**
+	 * Called for each frame which has been read, before its duration is
+	 * added to the playback time.
+	 *
+	 * @param offset	the offset of the frame in the input
+	 * @param size		the size of the frame
+	 */
+	virtual void frameRead(uint32 offset, uint32 size) {}
+
+	/** Called when a frame could not be decoded and its time was lost. */
+	virtual void frameLost() {}
+
+	/** Return the offset in the input of the frame which was read last. */
+	uint32 getFrameOffset() const { return _bufferOffset + (_stream.this_frame - _buf); }
+
 	enum State {
 		MP3_STATE_INIT,	// Need to init the decoder
 		MP3_STATE_READY,	// ready for processing data
@@ -85,6 +102,9 @@ protected:
 	uint _channels;
 	uint _rate;
 
+	// Offset in the input of the start of the buffer
+	uint32 _bufferOffset;
+
 	enum {
 		BUFFER_SIZE = 5 * 8192
 	};
@@ -97,18 +117,98 @@ class MP3Stream : private BaseMP3Stream, public SeekableAudioStream {
 public:
 	MP3Stream(Common::SeekableReadStream *inStream,
 	               DisposeAfterUse::Flag dispose);
+	~MP3Stream();
 
 	int readBuffer(int16 *buffer, const int numSamples);
 	bool seek(const Timestamp &where);
 	Timestamp getLength() const { return _length; }
 
+	/** Create the cache of the indices of deleted streams, see createMP3IndexCache(). */
+	static void createIndexCache();
+	/** Free the indices kept for deleted streams, see destroyMP3IndexCache(). */
+	static void destroyIndexCache();
+
 protected:
 	Common::ScopedPtr<Common::SeekableReadStream> _inStream;
 
 	Timestamp _length;
 
+	void frameRead(uint32 offset, uint32 size);
+	void frameLost();
+
 private:
+	enum {
+		// Number of frames between two index entries
+		kIndexInterval = 16,
+		// Number of streams whose index is kept after they are deleted
+		kIndexCacheSize = 8
+	};
+
+	struct IndexEntry {
+		uint32 offset;
+		mad_timer_t time;
+	};
+
+	/**
+	 * The table of contents of a Xing header: the position of each percent
+	 * of the playback time, in 1/256 of the size of the audio data.
+	 */
+	struct XingTOC {
+		byte positions[100];
+		// Offset and size of the audio data the positions refer to
+		uint32 offset;
+		uint32 size;
+	};
+
+	/**
+	 * The offset and start time of every kIndexInterval-th frame, from the
+	 * start of the stream up to the first frame which has not been read
+	 * yet. Seeking starts reading headers from the last entry before the
+	 * destination. Past the end, it starts from the rough position which
+	 * the table of contents of the Xing header gives, if there is one.
+	 */
+	struct FrameIndex {
+		Common::Array<IndexEntry> entries;
+		// Offset of the first frame which is not indexed yet
+		uint32 end;
+		// Number of frames between the last entry and the end
+		uint32 frames;
+		bool hasTOC;
+		XingTOC toc;
+	};
+
+	struct CachedIndex {
+		Common::String key;
+		Timestamp length;
+		FrameIndex index;
+	};
+
 	static Common::SeekableReadStream *skipID3(Common::SeekableReadStream *stream, DisposeAfterUse::Flag dispose);
+
+	bool readXingHeader();
+	bool findTOCEntry(uint32 time, IndexEntry &entry) const;
+	void resetIndex(uint32 offset);
+	void restartAt(const IndexEntry &entry);
+
+	bool loadIndex();
+	void saveIndex();
+
+	FrameIndex _index;
+	// Whether the time of the frames being read is right, so they can be
+	// added to the index
+	bool _indexing;
+	// Identifies the input in the index cache
+	Common::String _indexKey;
+
+	// The indices of recently deleted streams, most recently used last, so
+	// that streams which are opened again can seek right away. It is made
+	// at startup, once there is a backend for the mutex.
+	struct IndexCache {
+		Common::Array<CachedIndex> entries;
+		Common::Mutex mutex;
+	};
+
+	static IndexCache *_indexCache;
 };
 
 class PacketizedMP3Stream : private BaseMP3Stream, public PacketizedAudioStream {
@@ -135,7 +235,8 @@ private:
 BaseMP3Stream::BaseMP3Stream() :
 	_posInFrame(0),
 	_state(MP3_STATE_INIT),
-	_curTime(mad_timer_zero) {
+	_curTime(mad_timer_zero),
+	_bufferOffset(0) {
 
 	// The MAD_BUFFER_GUARD must always contain zeros (the reason
 	// for this is that the Layer III Huffman decoder of libMAD
@@ -171,6 +272,7 @@ void BaseMP3Stream::decodeMP3Data(Common::ReadStream &stream) {
 					// These are normal and expected (caused by our frame skipping (i.e. "seeking")
 					// code above).
 					debug(6, "MP3Stream: Recoverable error in mad_frame_decode (%s)", mad_stream_errorstr(&_stream));
+					frameLost();
 					continue;
 				} else {
 					warning("MP3Stream: Unrecoverable error in mad_frame_decode (%s)", mad_stream_errorstr(&_stream));
@@ -178,6 +280,8 @@ void BaseMP3Stream::decodeMP3Data(Common::ReadStream &stream) {
 				}
 			}
 
+			frameRead(getFrameOffset(), _stream.next_frame - _stream.this_frame);
+
 			// Sum up the total playback time so far
 			mad_timer_add(&_curTime, _frame.header.duration);
 			// Synthesize PCM data
@@ -206,6 +310,7 @@ void BaseMP3Stream::readMP3Data(Common::ReadStream &stream) {
 		// and hence the data regions we copy from and to may overlap.
 		remaining = _stream.bufend - _stream.next_frame;
 		assert(remaining < BUFFER_SIZE);	// Paranoia check
+		_bufferOffset += _stream.next_frame - _buf;
 		memmove(_buf, _stream.next_frame, remaining);
 	}
 
@@ -221,7 +326,7 @@ void BaseMP3Stream::readMP3Data(Common::ReadStream &stream) {
 	mad_stream_buffer(&_stream, _buf, size + remaining);
 }
 
-void BaseMP3Stream::initStream(Common::ReadStream &stream) {
+void BaseMP3Stream::initStream(Common::ReadStream &stream, uint32 offset) {
 	if (_state != MP3_STATE_INIT)
 		deinitStream();
 
@@ -233,6 +338,7 @@ void BaseMP3Stream::initStream(Common::ReadStream &stream) {
 	// Reset the stream data
 	_curTime = mad_timer_zero;
 	_posInFrame = 0;
+	_bufferOffset = offset;
 
 	// Update state
 	_state = MP3_STATE_READY;
@@ -268,6 +374,8 @@ void BaseMP3Stream::readHeader(Common::ReadStream &stream) {
 			}
 		}
 
+		frameRead(getFrameOffset(), _stream.next_frame - _stream.this_frame);
+
 		// Sum up the total playback time so far
 		mad_timer_add(&_curTime, _frame.header.duration);
 		break;
@@ -325,10 +433,19 @@ int BaseMP3Stream::fillBuffer(Common::ReadStream &stream, int16 *buffer, const i
 	return samples;
 }
 
+MP3Stream::IndexCache *MP3Stream::_indexCache = 0;
+
 MP3Stream::MP3Stream(Common::SeekableReadStream *inStream, DisposeAfterUse::Flag dispose) :
 		BaseMP3Stream(),
 		_inStream(skipID3(inStream, dispose)),
-		_length(0, 1000) {
+		_length(0, 1000),
+		_indexing(true) {
+
+	// The size and the first bytes of the stream identify it well enough to
+	// reuse its index
+	_indexKey = Common::String::format("%d:", _inStream->size()) + Common::computeStreamMD5AsString(*_inStream, 4096);
+	_inStream->seek(0);
+	resetIndex(0);
 
 	// Initialize the stream with some data and set the channels and rate
 	// variables
@@ -336,29 +453,35 @@ MP3Stream::MP3Stream(Common::SeekableReadStream *inStream, DisposeAfterUse::Flag
 	_channels = MAD_NCHANNELS(&_frame.header);
 	_rate = _frame.header.samplerate;
 
-	// Calculate the length of the stream
-	while (_state != MP3_STATE_EOS)
-		readHeader(*_inStream);
-
-	// To rule out any invalid sample rate to be encountered here, say in case the
-	// MP3 stream is invalid, we just check the MAD error code here.
-	// We need to assure this, since else we might trigger an assertion in Timestamp
-	// (When getRate() returns 0 or a negative number to be precise).
-	// Note that we allow "MAD_ERROR_BUFLEN" as error code here, since according
-	// to mad.h it is also set on EOF.
-	if ((_stream.error == MAD_ERROR_NONE || _stream.error == MAD_ERROR_BUFLEN) && getRate() > 0)
-		_length = Timestamp(mad_timer_count(_curTime, MAD_UNITS_MILLISECONDS), getRate());
+	if (!loadIndex() && !readXingHeader()) {
+		// Calculate the length of the stream, which indexes all frames
+		while (_state != MP3_STATE_EOS)
+			readHeader(*_inStream);
+
+		// To rule out any invalid sample rate to be encountered here, say in case the
+		// MP3 stream is invalid, we just check the MAD error code here.
+		// We need to assure this, since else we might trigger an assertion in Timestamp
+		// (When getRate() returns 0 or a negative number to be precise).
+		// Note that we allow "MAD_ERROR_BUFLEN" as error code here, since according
+		// to mad.h it is also set on EOF.
+		if ((_stream.error == MAD_ERROR_NONE || _stream.error == MAD_ERROR_BUFLEN) && getRate() > 0)
+			_length = Timestamp(mad_timer_count(_curTime, MAD_UNITS_MILLISECONDS), getRate());
+	}
 
 	deinitStream();
 
 	// Reinit stream
 	_state = MP3_STATE_INIT;
-	_inStream->seek(0);
+	restartAt(_index.entries[0]);
 
 	// Decode the first chunk of data to set up the stream again.
 	decodeMP3Data(*_inStream);
 }
 
+MP3Stream::~MP3Stream() {
+	saveIndex();
+}
+
 int MP3Stream::readBuffer(int16 *buffer, const int numSamples) {
 	return fillBuffer(*_inStream, buffer, numSamples);
 }
@@ -376,9 +499,32 @@ bool MP3Stream::seek(const Timestamp &where) {
 	mad_timer_t destination;
 	mad_timer_set(&destination, time / 1000, time % 1000, 1000);
 
-	if (_state != MP3_STATE_READY || mad_timer_compare(destination, _curTime) < 0) {
-		_inStream->seek(0);
-		initStream(*_inStream);
+	// Find the last indexed frame which starts before the destination
+	uint first = 0, last = _index.entries.size();
+	while (last - first > 1) {
+		const uint middle = (first + last) / 2;
+		if (mad_timer_compare(_index.entries[middle].time, destination) > 0)
+			last = middle;
+		else
+			first = middle;
+	}
+	const IndexEntry *entry = &_index.entries[first];
+
+	// Past the indexed frames, start closer to the destination if the Xing
+	// header tells roughly where
+	IndexEntry tocEntry;
+	if (first == _index.entries.size() - 1 && findTOCEntry(time, tocEntry) && tocEntry.offset > _index.end)
+		entry = &tocEntry;
+
+	// Jump to it, unless reading on from the current position is shorter
+	if (_state != MP3_STATE_READY || mad_timer_compare(destination, _curTime) < 0 ||
+	    mad_timer_compare(entry->time, _curTime) > 0) {
+		restartAt(*entry);
+
+		// The time of the frames read from a rough position is not right
+		// either, so they are not indexed
+		if (entry == &tocEntry)
+			_indexing = false;
 	}
 
 	while (mad_timer_compare(destination, _curTime) > 0 && _state != MP3_STATE_EOS)
@@ -389,6 +535,176 @@ bool MP3Stream::seek(const Timestamp &where) {
 	return (_state != MP3_STATE_EOS);
 }
 
+void MP3Stream::frameRead(uint32 offset, uint32 size) {
+	// Frames before the end of the index are known already. Data between
+	// frames the decoder had to skip has no duration, so the index goes on
+	// after it.
+	if (!_indexing || offset < _index.end)
+		return;
+
+	if (_index.frames == kIndexInterval) {
+		IndexEntry entry;
+		entry.offset = offset;
+		entry.time = _curTime;
+		_index.entries.push_back(entry);
+		_index.frames = 0;
+	}
+
+	_index.frames++;
+	_index.end = offset + size;
+}
+
+void MP3Stream::frameLost() {
+	// The playback time does not include the lost frame, so the time of the
+	// following frames is wrong until the next seek
+	_indexing = false;
+}
+
+bool MP3Stream::readXingHeader() {
+	// The Xing (or Info) header takes the place of the audio data of the
+	// first frame. It is written by most encoders, which count the frames
+	// of the stream into it, so the stream does not need to be scanned to
+	// know its length. Its table of contents only gives the position of
+	// each percent of the stream to 1/256 of its size, so it is only used
+	// for seeking past the frames which are indexed already.
+	if (_state != MP3_STATE_READY || _frame.header.layer != MAD_LAYER_III || !_stream.this_frame)
+		return false;
+
+	uint32 sideInfoSize;
+	if (_frame.header.flags & MAD_FLAG_LSF_EXT)
+		sideInfoSize = (_channels == 1) ? 9 : 17;
+	else
+		sideInfoSize = (_channels == 1) ? 17 : 32;
+
+	const byte *xing = _stream.this_frame + 4 + sideInfoSize;
+	if (_frame.header.flags & MAD_FLAG_PROTECTION)
+		xing += 2;
+
+	if (xing + 12 > _stream.next_frame)
+		return false;
+	if (memcmp(xing, "Xing", 4) && memcmp(xing, "Info", 4))
+		return false;
+
+	// The frame count is needed, the byte count and the table of contents
+	// which follow it are optional
+	const uint32 flags = READ_BE_UINT32(xing + 4);
+	if (!(flags & 1))
+		return false;
+	const uint32 frames = READ_BE_UINT32(xing + 8);
+	if (!frames || getRate() <= 0)
+		return false;
+
+	_length = Timestamp(0, frames * 32 * MAD_NSBSAMPLES(&_frame.header), getRate());
+
+	// The frame itself is silent and not counted, so playback starts after it
+	resetIndex(getFrameOffset() + (_stream.next_frame - _stream.this_frame));
+
+	// The positions are relative to the audio data including the frame
+	_index.toc.offset = getFrameOffset();
+	_index.toc.size = _inStream->size() - _index.toc.offset;
+
+	const byte *toc = xing + 12;
+	if (flags & 2) {
+		if (toc + 4 <= _stream.next_frame && READ_BE_UINT32(toc))
+			_index.toc.size = READ_BE_UINT32(toc);
+		toc += 4;
+	}
+
+	if ((flags & 4) && toc + sizeof(_index.toc.positions) <= _stream.next_frame) {
+		memcpy(_index.toc.positions, toc, sizeof(_index.toc.positions));
+		_index.hasTOC = true;
+	}
+
+	return true;
+}
+
+bool MP3Stream::findTOCEntry(uint32 time, IndexEntry &entry) const {
+	const uint32 length = _length.msecs();
+	if (!_index.hasTOC || !length)
+		return false;
+
+	const uint percent = MIN<uint64>((uint64)time * 100 / length, 99);
+	entry.offset = _index.toc.offset + (uint32)((uint64)_index.toc.positions[percent] * _index.toc.size / 256);
+
+	const uint32 start = (uint64)length * percent / 100;
+	mad_timer_set(&entry.time, start / 1000, start % 1000, 1000);
+	return true;
+}
+
+void MP3Stream::resetIndex(uint32 offset) {
+	IndexEntry entry;
+	entry.offset = offset;
+	entry.time = mad_timer_zero;
+
+	_index.entries.clear();
+	_index.entries.push_back(entry);
+	_index.end = offset;
+	_index.frames = 0;
+	_index.hasTOC = false;
+}
+
+void MP3Stream::restartAt(const IndexEntry &entry) {
+	_inStream->seek(entry.offset);
+	initStream(*_inStream, entry.offset);
+	_curTime = entry.time;
+	_indexing = true;
+}
+
+bool MP3Stream::loadIndex() {
+	// Streams may be made before the cache or after it is freed
+	if (!_indexCache)
+		return false;
+
+	Common::StackLock lock(_indexCache->mutex);
+	Common::Array<CachedIndex> &entries = _indexCache->entries;
+	for (uint i = 0; i < entries.size(); i++) {
+		if (entries[i].key == _indexKey) {
+			_length = entries[i].length;
+			_index = entries[i].index;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void MP3Stream::saveIndex() {
+	if (!_indexCache)
+		return;
+
+	Common::StackLock lock(_indexCache->mutex);
+	Common::Array<CachedIndex> &entries = _indexCache->entries;
+
+	CachedIndex cached;
+	cached.key = _indexKey;
+	cached.length = _length;
+	cached.index = _index;
+
+	for (uint i = 0; i < entries.size(); i++) {
+		if (entries[i].key == _indexKey) {
+			// Another stream of the same input may have indexed more of it
+			if (entries[i].index.end > _index.end)
+				cached.index = entries[i].index;
+			entries.remove_at(i);
+			break;
+		}
+	}
+
+	if (entries.size() == kIndexCacheSize)
+		entries.remove_at(0);
+	entries.push_back(cached);
+}
+
+void MP3Stream::createIndexCache() {
+	if (!_indexCache)
+		_indexCache = new IndexCache();
+}
+
+void MP3Stream::destroyIndexCache() {
+	delete _indexCache;
+	_indexCache = 0;
+}
+
 Common::SeekableReadStream *MP3Stream::skipID3(Common::SeekableReadStream *stream, DisposeAfterUse::Flag dispose) {
 	// Skip ID3 TAG if any
 	// ID3v1 (beginning with with 'TAG') is located at the end of files. So we can ignore those.
@@ -549,6 +865,14 @@ PacketizedAudioStream *makePacketizedMP3Stream(uint channels, uint rate) {
 	return new PacketizedMP3Stream(channels, rate);
 }
 
+void createMP3IndexCache() {
+	MP3Stream::createIndexCache();
+}
+
+void destroyMP3IndexCache() {
+	MP3Stream::destroyIndexCache();
+}
+
 
 } // End of namespace Audio
 
@@ -87,6 +87,19 @@ PacketizedAudioStream *makePacketizedMP3Stream(
 PacketizedAudioStream *makePacketizedMP3Stream(
 	uint channels, uint rate);
 
+/**
+ * Create the cache of the seek indices of MP3 streams which were deleted,
+ * so that streams opened again can seek right away. It is created once the
+ * backend is initialized; streams deleted before don't keep their index.
+ */
+void createMP3IndexCache();
+
+/**
+ * Free the seek indices kept for MP3 streams which were deleted. They are
+ * only freed at shutdown; streams deleted afterwards don't keep theirs.
+ */
+void destroyMP3IndexCache();
+
 } // End of namespace Audio
 
 #endif // #ifdef USE_MAD
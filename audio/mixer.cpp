@@ -22,9 +22,11 @@
 
 #include "gui/EventRecorder.h"
 
+#include "common/atomic.h"
 #include "common/util.h"
 #include "common/system.h"
 #include "common/textconsole.h"
+#include "common/trace.h"
 
 #include "audio/mixer_intern.h"
 #include "audio/rate.h"
@@ -80,8 +82,9 @@ public:
 	 *
 	 * @param paused true, when the channel should be paused.
 	 *               false when it should be unpaused.
+	 * @param time   the time of the request, in the g_system->getMillis(true) scale
 	 */
-	void pause(bool paused);
+	void pause(bool paused, uint32 time);
 
 	/**
 	 * Queries whether the channel is currently paused.
@@ -123,9 +126,24 @@ public:
 	void notifyGlobalVolChange() { updateChannelVolumes(); }
 
 	/**
-	 * Queries how long the channel has been playing.
+	 * Queries the number of samples played before the last mix() call.
 	 */
-	Timestamp getElapsedTime();
+	uint32 getSamplesConsumed() const { return _samplesConsumed; }
+
+	/**
+	 * Queries the time of the last mix() call.
+	 */
+	uint32 getMixerTimeStamp() const { return _mixerTimeStamp; }
+
+	/**
+	 * Queries when the channel has been paused.
+	 */
+	uint32 getPauseStartTime() const { return _pauseStartTime; }
+
+	/**
+	 * Queries how long the channel has been paused since the last mix() call.
+	 */
+	uint32 getPauseTime() const { return _pauseTime; }
 
 	/**
 	 * Queries the channel's sound type.
@@ -175,15 +193,23 @@ private:
 
 // TODO: parameter "system" is unused
 MixerImpl::MixerImpl(OSystem *system, uint sampleRate)
-	: _mutex(), _sampleRate(sampleRate), _mixerReady(false), _handleSeed(0), _soundTypeSettings() {
+	: _mutex(), _sampleRate(sampleRate), _mixerReady(false), _handleSeed(0), _soundTypeSettings(),
+	  _channelsOwner(kOwnerNone) {
 
 	assert(sampleRate > 0);
 
-	for (int i = 0; i != NUM_CHANNELS; i++)
+	// No sound has finished yet. This is the value of invalid handles, so
+	// it does not match the first handle of a channel.
+	for (int i = 0; i != NUM_CHANNELS; i++) {
 		_channels[i] = 0;
+		_finishedHandles[i] = SoundHandle()._val;
+	}
 }
 
 MixerImpl::~MixerImpl() {
+	// Take care of channels which were never handed over to the audio thread
+	processCommands();
+
 	for (int i = 0; i != NUM_CHANNELS; i++)
 		delete _channels[i];
 }
@@ -196,10 +222,27 @@ uint MixerImpl::getOutputRate() const {
 	return _sampleRate;
 }
 
+bool MixerImpl::isChannelActive(int index) const {
+	// Sounds which came to their end are stopped by the audio thread
+	return _channelStates[index].active && Common::atomicLoad(_finishedHandles[index]) != _channelStates[index].handle;
+}
+
+int MixerImpl::findChannel(SoundHandle handle) const {
+	const int index = handle._val % NUM_CHANNELS;
+	if (!isChannelActive(index) || _channelStates[index].handle != handle._val)
+		return -1;
+	return index;
+}
+
+void MixerImpl::stopChannel(int index) {
+	pushCommand(kCommandStop, index);
+	_channelStates[index].active = false;
+}
+
 void MixerImpl::insertChannel(SoundHandle *handle, Channel *chan) {
 	int index = -1;
 	for (int i = 0; i != NUM_CHANNELS; i++) {
-		if (_channels[i] == 0) {
+		if (!isChannelActive(i)) {
 			index = i;
 			break;
 		}
@@ -210,8 +253,6 @@ void MixerImpl::insertChannel(SoundHandle *handle, Channel *chan) {
 		return;
 	}
 
-	_channels[index] = chan;
-
 	SoundHandle chanHandle;
 	chanHandle._val = index + (_handleSeed * NUM_CHANNELS);
 
@@ -219,6 +260,17 @@ void MixerImpl::insertChannel(SoundHandle *handle, Channel *chan) {
 	_handleSeed++;
 	if (handle)
 		*handle = chanHandle;
+
+	ChannelState &state = _channelStates[index];
+	state.active = true;
+	state.handle = chanHandle._val;
+	state.id = chan->getId();
+	state.type = chan->getType();
+	state.permanent = chan->isPermanent();
+	state.volume = chan->getVolume();
+	state.balance = chan->getBalance();
+
+	pushCommand(kCommandPlay, index, 0, chan);
 }
 
 void MixerImpl::playStream(
@@ -242,7 +294,7 @@ void MixerImpl::playStream(
 	// Prevent duplicate sounds
 	if (id != -1) {
 		for (int i = 0; i != NUM_CHANNELS; i++)
-			if (_channels[i] != 0 && _channels[i]->getId() == id) {
+			if (isChannelActive(i) && _channelStates[i].id == id) {
 				// Delete the stream if were asked to auto-dispose it.
 				// Note: This could cause trouble if the client code does not
 				// yet expect the stream to be gone. The primary example to
@@ -266,11 +318,112 @@ void MixerImpl::playStream(
 	insertChannel(handle, chan);
 }
 
+#pragma mark -
+#pragma mark --- Audio thread ---
+#pragma mark -
+
+void MixerImpl::pushCommand(CommandType type, int index, int value, Channel *channel) {
+	Command command;
+	command.type = type;
+	command.index = index;
+	command.handle = (index >= 0) ? _channelStates[index].handle : 0;
+	command.channel = channel;
+	command.value = value;
+	command.time = (type == kCommandPause) ? g_system->getMillis(true) : 0;
+
+	// The queue only fills up if the audio thread does not run, e.g.
+	// because the backend paused it. In that case we process the commands
+	// ourselves.
+	while (!_commands.push(command))
+		flushCommands();
+}
+
+void MixerImpl::processCommands() {
+	Command command;
+	while (_commands.pop(command)) {
+		if (command.type == kCommandUpdateVolumes) {
+			for (int i = 0; i != NUM_CHANNELS; ++i) {
+				if (_channels[i] && _channels[i]->getType() == command.value)
+					_channels[i]->notifyGlobalVolChange();
+			}
+			continue;
+		}
+
+		Channel *&chan = _channels[command.index];
+		if (command.type == kCommandPlay) {
+			delete chan;
+			chan = command.channel;
+			continue;
+		}
+
+		// Ignore requests for sounds which terminated in the meantime
+		if (!chan || chan->getHandle()._val != command.handle)
+			continue;
+
+		switch (command.type) {
+		case kCommandStop:
+			delete chan;
+			chan = 0;
+			break;
+		case kCommandPause:
+			chan->pause(command.value != 0, command.time);
+			break;
+		case kCommandSetVolume:
+			chan->setVolume(command.value);
+			break;
+		case kCommandSetBalance:
+			chan->setBalance(command.value);
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+void MixerImpl::publishChannelStatus(int index) {
+	const Channel *chan = _channels[index];
+	ChannelStatus &status = _channelStatus[index];
+
+	Common::atomicStore(status.sequence, status.sequence + 1);
+	status.handle = chan->getHandle()._val;
+	status.samplesConsumed = chan->getSamplesConsumed();
+	status.mixerTimeStamp = chan->getMixerTimeStamp();
+	status.paused = chan->isPaused();
+	status.pauseStartTime = chan->getPauseStartTime();
+	status.pauseTime = chan->getPauseTime();
+	Common::atomicStore(status.sequence, status.sequence + 1);
+}
+
+bool MixerImpl::readChannelStatus(int index, ChannelStatus &status) const {
+	const ChannelStatus &published = _channelStatus[index];
+	uint32 sequence;
+	do {
+		sequence = Common::atomicLoad(published.sequence);
+		status.handle = published.handle;
+		status.samplesConsumed = published.samplesConsumed;
+		status.mixerTimeStamp = published.mixerTimeStamp;
+		status.paused = published.paused;
+		status.pauseStartTime = published.pauseStartTime;
+		status.pauseTime = published.pauseTime;
+	} while ((sequence & 1) || Common::atomicLoad(published.sequence) != sequence);
+
+	// The audio thread may not have started the channel yet
+	return status.handle == _channelStates[index].handle;
+}
+
+void MixerImpl::flushCommands() {
+	// Wait for a callback in progress, which may still use the channels
+	while (!Common::atomicCompareAndSwap(_channelsOwner, kOwnerNone, kOwnerEngine))
+		g_system->delayMillis(1);
+
+	processCommands();
+	Common::atomicStore(_channelsOwner, (uint32)kOwnerNone);
+}
+
 int MixerImpl::mixCallback(byte *samples, uint len) {
+	TRACE_SCOPE("audio", "MixerImpl::mixCallback");
 	assert(samples);
 
-	Common::StackLock lock(_mutex);
-
 	int16 *buf = (int16 *)samples;
 	// we store stereo, 16-bit samples
 	assert(len % 4 == 0);
@@ -282,64 +435,79 @@ int MixerImpl::mixCallback(byte *samples, uint len) {
 	//  zero the buf
 	memset(buf, 0, 2 * len * sizeof(int16));
 
+	// The engine processes the commands itself, e.g. to stop a sound. Never
+	// wait for it here: the engine thread may have been preempted, and
+	// waiting for it could keep it from running again on ports with
+	// priority scheduling. Play silence this time instead.
+	if (!Common::atomicCompareAndSwap(_channelsOwner, kOwnerNone, kOwnerAudio))
+		return 0;
+
+	processCommands();
+
 	// mix all channels
 	int res = 0, tmp;
 	for (int i = 0; i != NUM_CHANNELS; i++)
 		if (_channels[i]) {
 			if (_channels[i]->isFinished()) {
+				const uint32 handle = _channels[i]->getHandle()._val;
 				delete _channels[i];
 				_channels[i] = 0;
-			} else if (!_channels[i]->isPaused()) {
-				tmp = _channels[i]->mix(buf, len);
-
-				if (tmp > res)
-					res = tmp;
+				Common::atomicStore(_finishedHandles[i], handle);
+			} else {
+				if (!_channels[i]->isPaused()) {
+					tmp = _channels[i]->mix(buf, len);
+
+					if (tmp > res)
+						res = tmp;
+				}
+				publishChannelStatus(i);
 			}
 		}
 
+	Common::atomicStore(_channelsOwner, (uint32)kOwnerNone);
 	return res;
 }
 
+#pragma mark -
+#pragma mark --- Engine side ---
+#pragma mark -
+
 void MixerImpl::stopAll() {
 	Common::StackLock lock(_mutex);
 	for (int i = 0; i != NUM_CHANNELS; i++) {
-		if (_channels[i] != 0 && !_channels[i]->isPermanent()) {
-			delete _channels[i];
-			_channels[i] = 0;
-		}
+		if (isChannelActive(i) && !_channelStates[i].permanent)
+			stopChannel(i);
 	}
+	flushCommands();
 }
 
 void MixerImpl::stopID(int id) {
 	Common::StackLock lock(_mutex);
 	for (int i = 0; i != NUM_CHANNELS; i++) {
-		if (_channels[i] != 0 && _channels[i]->getId() == id) {
-			delete _channels[i];
-			_channels[i] = 0;
-		}
+		if (isChannelActive(i) && _channelStates[i].id == id)
+			stopChannel(i);
 	}
+	flushCommands();
 }
 
 void MixerImpl::stopHandle(SoundHandle handle) {
 	Common::StackLock lock(_mutex);
 
 	// Simply ignore stop requests for handles of sounds that already terminated
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	const int index = findChannel(handle);
+	if (index == -1)
 		return;
 
-	delete _channels[index];
-	_channels[index] = 0;
+	stopChannel(index);
+	flushCommands();
 }
 
 void MixerImpl::muteSoundType(SoundType type, bool mute) {
 	assert(0 <= (int)type && (int)type < ARRAYSIZE(_soundTypeSettings));
-	_soundTypeSettings[type].mute = mute;
 
-	for (int i = 0; i != NUM_CHANNELS; ++i) {
-		if (_channels[i] && _channels[i]->getType() == type)
-			_channels[i]->notifyGlobalVolChange();
-	}
+	Common::StackLock lock(_mutex);
+	_soundTypeSettings[type].mute = mute;
+	pushCommand(kCommandUpdateVolumes, -1, type);
 }
 
 bool MixerImpl::isSoundTypeMuted(SoundType type) const {
@@ -350,37 +518,43 @@ bool MixerImpl::isSoundTypeMuted(SoundType type) const {
 void MixerImpl::setChannelVolume(SoundHandle handle, byte volume) {
 	Common::StackLock lock(_mutex);
 
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	const int index = findChannel(handle);
+	if (index == -1)
 		return;
 
-	_channels[index]->setVolume(volume);
+	_channelStates[index].volume = volume;
+	pushCommand(kCommandSetVolume, index, volume);
 }
 
 byte MixerImpl::getChannelVolume(SoundHandle handle) {
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	Common::StackLock lock(_mutex);
+
+	const int index = findChannel(handle);
+	if (index == -1)
 		return 0;
 
-	return _channels[index]->getVolume();
+	return _channelStates[index].volume;
 }
 
 void MixerImpl::setChannelBalance(SoundHandle handle, int8 balance) {
 	Common::StackLock lock(_mutex);
 
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	const int index = findChannel(handle);
+	if (index == -1)
 		return;
 
-	_channels[index]->setBalance(balance);
+	_channelStates[index].balance = balance;
+	pushCommand(kCommandSetBalance, index, balance);
 }
 
 int8 MixerImpl::getChannelBalance(SoundHandle handle) {
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	Common::StackLock lock(_mutex);
+
+	const int index = findChannel(handle);
+	if (index == -1)
 		return 0;
 
-	return _channels[index]->getBalance();
+	return _channelStates[index].balance;
 }
 
 uint32 MixerImpl::getSoundElapsedTime(SoundHandle handle) {
@@ -390,27 +564,46 @@ uint32 MixerImpl::getSoundElapsedTime(SoundHandle handle) {
 Timestamp MixerImpl::getElapsedTime(SoundHandle handle) {
 	Common::StackLock lock(_mutex);
 
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
-		return Timestamp(0, _sampleRate);
+	Timestamp ts(0, _sampleRate);
+
+	const int index = findChannel(handle);
+	ChannelStatus status;
+	if (index == -1 || !readChannelStatus(index, status) || status.mixerTimeStamp == 0)
+		return ts;
+
+	uint32 delta;
+	if (status.paused)
+		delta = status.pauseStartTime - status.mixerTimeStamp;
+	else
+		delta = g_system->getMillis(true) - status.mixerTimeStamp - status.pauseTime;
+
+	// Convert the number of samples into a time duration.
+
+	ts = ts.addFrames(status.samplesConsumed);
+	ts = ts.addMsecs(delta);
+
+	// In theory it would seem like a good idea to limit the approximation
+	// so that it never exceeds the theoretical upper bound set by
+	// the number of samples decoded. Meanwhile, back in the real world,
+	// doing so makes the Broken Sword cutscenes noticeably jerkier. I guess
+	// the mixer isn't invoked at the regular intervals that I first imagined.
 
-	return _channels[index]->getElapsedTime();
+	return ts;
 }
 
 void MixerImpl::pauseAll(bool paused) {
 	Common::StackLock lock(_mutex);
 	for (int i = 0; i != NUM_CHANNELS; i++) {
-		if (_channels[i] != 0) {
-			_channels[i]->pause(paused);
-		}
+		if (isChannelActive(i))
+			pushCommand(kCommandPause, i, paused);
 	}
 }
 
 void MixerImpl::pauseID(int id, bool paused) {
 	Common::StackLock lock(_mutex);
 	for (int i = 0; i != NUM_CHANNELS; i++) {
-		if (_channels[i] != 0 && _channels[i]->getId() == id) {
-			_channels[i]->pause(paused);
+		if (isChannelActive(i) && _channelStates[i].id == id) {
+			pushCommand(kCommandPause, i, paused);
 			return;
 		}
 	}
@@ -420,11 +613,11 @@ void MixerImpl::pauseHandle(SoundHandle handle, bool paused) {
 	Common::StackLock lock(_mutex);
 
 	// Simply ignore (un)pause requests for sounds that already terminated
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	const int index = findChannel(handle);
+	if (index == -1)
 		return;
 
-	_channels[index]->pause(paused);
+	pushCommand(kCommandPause, index, paused);
 }
 
 bool MixerImpl::isSoundIDActive(int id) {
@@ -435,16 +628,16 @@ bool MixerImpl::isSoundIDActive(int id) {
 #endif
 
 	for (int i = 0; i != NUM_CHANNELS; i++)
-		if (_channels[i] && _channels[i]->getId() == id)
+		if (isChannelActive(i) && _channelStates[i].id == id)
 			return true;
 	return false;
 }
 
 int MixerImpl::getSoundID(SoundHandle handle) {
 	Common::StackLock lock(_mutex);
-	const int index = handle._val % NUM_CHANNELS;
-	if (_channels[index] && _channels[index]->getHandle()._val == handle._val)
-		return _channels[index]->getId();
+	const int index = findChannel(handle);
+	if (index != -1)
+		return _channelStates[index].id;
 	return 0;
 }
 
@@ -455,14 +648,13 @@ bool MixerImpl::isSoundHandleActive(SoundHandle handle) {
 	g_eventRec.updateSubsystems();
 #endif
 
-	const int index = handle._val % NUM_CHANNELS;
-	return _channels[index] && _channels[index]->getHandle()._val == handle._val;
+	return findChannel(handle) != -1;
 }
 
 bool MixerImpl::hasActiveChannelOfType(SoundType type) {
 	Common::StackLock lock(_mutex);
 	for (int i = 0; i != NUM_CHANNELS; i++)
-		if (_channels[i] && _channels[i]->getType() == type)
+		if (isChannelActive(i) && _channelStates[i].type == type)
 			return true;
 	return false;
 }
@@ -481,11 +673,7 @@ void MixerImpl::setVolumeForSoundType(SoundType type, int volume) {
 
 	Common::StackLock lock(_mutex);
 	_soundTypeSettings[type].volume = volume;
-
-	for (int i = 0; i != NUM_CHANNELS; ++i) {
-		if (_channels[i] && _channels[i]->getType() == type)
-			_channels[i]->notifyGlobalVolChange();
-	}
+	pushCommand(kCommandUpdateVolumes, -1, type);
 }
 
 int MixerImpl::getVolumeForSoundType(SoundType type) const {
@@ -561,52 +749,24 @@ void Channel::updateChannelVolumes() {
 	}
 }
 
-void Channel::pause(bool paused) {
+void Channel::pause(bool paused, uint32 time) {
 	//assert((paused && _pauseLevel >= 0) || (!paused && _pauseLevel));
 
 	if (paused) {
 		_pauseLevel++;
 
 		if (_pauseLevel == 1)
-			_pauseStartTime = g_system->getMillis(true);
+			_pauseStartTime = time;
 	} else if (_pauseLevel > 0) {
 		_pauseLevel--;
 
 		if (!_pauseLevel) {
-			_pauseTime = (g_system->getMillis(true) - _pauseStartTime);
+			_pauseTime = (time - _pauseStartTime);
 			_pauseStartTime = 0;
 		}
 	}
 }
 
-Timestamp Channel::getElapsedTime() {
-	const uint32 rate = _mixer->getOutputRate();
-	uint32 delta = 0;
-
-	Audio::Timestamp ts(0, rate);
-
-	if (_mixerTimeStamp == 0)
-		return ts;
-
-	if (isPaused())
-		delta = _pauseStartTime - _mixerTimeStamp;
-	else
-		delta = g_system->getMillis(true) - _mixerTimeStamp - _pauseTime;
-
-	// Convert the number of samples into a time duration.
-
-	ts = ts.addFrames(_samplesConsumed);
-	ts = ts.addMsecs(delta);
-
-	// In theory it would seem like a good idea to limit the approximation
-	// so that it never exceeds the theoretical upper bound set by
-	// _samplesDecoded. Meanwhile, back in the real world, doing so makes
-	// the Broken Sword cutscenes noticeably jerkier. I guess the mixer
-	// isn't invoked at the regular intervals that I first imagined.
-
-	return ts;
-}
-
 int Channel::mix(int16 *data, uint len) {
 	assert(_stream);
 
@@ -25,6 +25,7 @@
 
 #include "common/scummsys.h"
 #include "common/mutex.h"
+#include "common/spscqueue.h"
 #include "audio/mixer.h"
 
 namespace Audio {
@@ -46,14 +47,81 @@ namespace Audio {
  * (partial) alternative implementations of the mixer, e.g. to make
  * better use of native sound mixing support on low-end devices.
  *
+ * The channels belong to the audio thread, which runs mixCallback() without
+ * ever waiting for the engine. The public methods only queue commands for
+ * it, and answer queries from their own copy of the channel settings plus
+ * the status the audio thread publishes after each callback. Only stopping
+ * sounds waits for a callback in progress, and then processes the commands
+ * itself, so that the stopped streams are deleted once the call returns.
+ *
  * @see OSystem::getMixer()
  */
 class MixerImpl : public Mixer {
 private:
 	enum {
-		NUM_CHANNELS = 16
+		NUM_CHANNELS = 16,
+		NUM_COMMANDS = 256
+	};
+
+	/**
+	 * The settings of a channel as seen by the engine. They are ahead of
+	 * the actual channel until the audio thread has processed the commands.
+	 */
+	struct ChannelState {
+		ChannelState() : active(false), handle(0), id(-1), type(kPlainSoundType), permanent(false), volume(0), balance(0) {}
+
+		bool active;
+		uint32 handle;
+		int id;
+		SoundType type;
+		bool permanent;
+		byte volume;
+		int8 balance;
+	};
+
+	/**
+	 * The playback position of a channel, published by the audio thread.
+	 * Readers retry while the sequence number is odd or changes, since the
+	 * audio thread may be updating the values.
+	 */
+	struct ChannelStatus {
+		ChannelStatus() : sequence(0), handle(0), samplesConsumed(0), mixerTimeStamp(0), paused(false), pauseStartTime(0), pauseTime(0) {}
+
+		volatile uint32 sequence;
+		uint32 handle;
+		uint32 samplesConsumed;
+		uint32 mixerTimeStamp;
+		bool paused;
+		uint32 pauseStartTime;
+		uint32 pauseTime;
+	};
+
+	enum CommandType {
+		kCommandPlay,
+		kCommandStop,
+		kCommandPause,
+		kCommandSetVolume,
+		kCommandSetBalance,
+		kCommandUpdateVolumes
 	};
 
+	struct Command {
+		CommandType type;
+		int index;
+		uint32 handle;
+		Channel *channel;
+		int value;
+		uint32 time;
+	};
+
+	/** Which thread works on the channels. */
+	enum ChannelsOwner {
+		kOwnerNone = 0,
+		kOwnerAudio = 1,
+		kOwnerEngine = 2
+	};
+
+	/** Serializes the calls from the engine side, e.g. main and timer threads. */
 	Common::Mutex _mutex;
 
 	const uint _sampleRate;
@@ -68,8 +136,21 @@ private:
 	};
 
 	SoundTypeSettings _soundTypeSettings[4];
+
+	/** Engine side */
+	ChannelState _channelStates[NUM_CHANNELS];
+
+	/** Audio thread side */
 	Channel *_channels[NUM_CHANNELS];
 
+	/** Engine to audio thread */
+	Common::SPSCQueue<Command, NUM_COMMANDS> _commands;
+
+	/** Audio thread to engine */
+	ChannelStatus _channelStatus[NUM_CHANNELS];
+	volatile uint32 _finishedHandles[NUM_CHANNELS];
+	volatile uint32 _channelsOwner;
+
 
 public:
 
@@ -121,6 +202,16 @@ public:
 protected:
 	void insertChannel(SoundHandle *handle, Channel *chan);
 
+	int findChannel(SoundHandle handle) const;
+	bool isChannelActive(int index) const;
+	void stopChannel(int index);
+	bool readChannelStatus(int index, ChannelStatus &status) const;
+
+	void pushCommand(CommandType type, int index, int value = 0, Channel *channel = 0);
+	void processCommands();
+	void publishChannelStatus(int index);
+	void flushCommands();
+
 public:
 	/**
 	 * The mixer callback function, to be called at regular intervals by
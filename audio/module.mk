@@ -3,6 +3,7 @@ MODULE := audio
 MODULE_OBJS := \
 	adlib.o \
 	audiostream.o \
+	decode_cache.o \
 	fmopl.o \
 	mididrv.o \
 	midiparser_qt.o \
@@ -16,6 +17,8 @@ MODULE_OBJS := \
 	mpu401.o \
 	musicplugin.o \
 	null.o \
+	rate_mix.o \
+	rate_sinc.o \
 	timestamp.o \
 	decoders/3do.o \
 	decoders/aac.o \
@@ -41,7 +44,9 @@ MODULE_OBJS := \
 	mods/soundfx.o \
 	mods/tfmx.o \
 	softsynth/cms.o \
+	softsynth/emumidi.o \
 	softsynth/opl/dbopl.o \
+	softsynth/opl/dbopl_block.o \
 	softsynth/opl/dosbox.o \
 	softsynth/opl/mame.o \
 	softsynth/fmtowns_pc98/towns_audio.o \
@@ -30,6 +30,8 @@
 
 #include "audio/audiostream.h"
 #include "audio/rate.h"
+#include "audio/rate_mix.h"
+#include "audio/rate_sinc.h"
 #include "audio/mixer.h"
 #include "common/frac.h"
 #include "common/textconsole.h"
@@ -114,6 +116,7 @@ SimpleRateConverter<stereo, reverseStereo>::SimpleRateConverter(st_rate_t inrate
 template<bool stereo, bool reverseStereo>
 int SimpleRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
 	st_sample_t *ostart, *oend;
+	MixBuffer<reverseStereo> mixBuf(vol_l, vol_r);
 
 	ostart = obuf;
 	oend = obuf + osamp * 2;
@@ -126,8 +129,10 @@ int SimpleRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_samp
 			if (inLen == 0) {
 				inPtr = inBuf;
 				inLen = input.readBuffer(inBuf, ARRAYSIZE(inBuf));
-				if (inLen <= 0)
+				if (inLen <= 0) {
+					mixBuf.flush(obuf);
 					return (obuf - ostart) / 2;
+				}
 			}
 			inLen -= (stereo ? 2 : 1);
 			opos--;
@@ -143,14 +148,10 @@ int SimpleRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_samp
 		// Increment output position
 		opos += opos_inc;
 
-		// output left channel
-		clampedAdd(obuf[reverseStereo    ], (out0 * (int)vol_l) / Audio::Mixer::kMaxMixerVolume);
-
-		// output right channel
-		clampedAdd(obuf[reverseStereo ^ 1], (out1 * (int)vol_r) / Audio::Mixer::kMaxMixerVolume);
-
+		mixBuf.put(out0, out1, obuf);
 		obuf += 2;
 	}
+	mixBuf.flush(obuf);
 	return (obuf - ostart) / 2;
 }
 
@@ -223,6 +224,7 @@ LinearRateConverter<stereo, reverseStereo>::LinearRateConverter(st_rate_t inrate
 template<bool stereo, bool reverseStereo>
 int LinearRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
 	st_sample_t *ostart, *oend;
+	MixBuffer<reverseStereo> mixBuf(vol_l, vol_r);
 
 	ostart = obuf;
 	oend = obuf + osamp * 2;
@@ -235,8 +237,10 @@ int LinearRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_samp
 			if (inLen == 0) {
 				inPtr = inBuf;
 				inLen = input.readBuffer(inBuf, ARRAYSIZE(inBuf));
-				if (inLen <= 0)
+				if (inLen <= 0) {
+					mixBuf.flush(obuf);
 					return (obuf - ostart) / 2;
+				}
 			}
 			inLen -= (stereo ? 2 : 1);
 			ilast0 = icur0;
@@ -258,18 +262,14 @@ int LinearRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_samp
 						  (st_sample_t)(ilast1 + (((icur1 - ilast1) * opos + FRAC_HALF_LOW) >> FRAC_BITS_LOW)) :
 						  out0);
 
-			// output left channel
-			clampedAdd(obuf[reverseStereo    ], (out0 * (int)vol_l) / Audio::Mixer::kMaxMixerVolume);
-
-			// output right channel
-			clampedAdd(obuf[reverseStereo ^ 1], (out1 * (int)vol_r) / Audio::Mixer::kMaxMixerVolume);
-
+			mixBuf.put(out0, out1, obuf);
 			obuf += 2;
 
 			// Increment output position
 			opos += opos_inc;
 		}
 	}
+	mixBuf.flush(obuf);
 	return (obuf - ostart) / 2;
 }
 
@@ -293,7 +293,6 @@ public:
 	virtual int flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
 		assert(input.isStereo() == stereo);
 
-		st_sample_t *ptr;
 		st_size_t len;
 
 		st_sample_t *ostart = obuf;
@@ -315,19 +314,12 @@ public:
 		len = input.readBuffer(_buffer, osamp);
 
 		// Mix the data into the output buffer
-		ptr = _buffer;
-		for (; len > 0; len -= (stereo ? 2 : 1)) {
-			st_sample_t out0, out1;
-			out0 = *ptr++;
-			out1 = (stereo ? *ptr++ : out0);
-
-			// output left channel
-			clampedAdd(obuf[reverseStereo    ], (out0 * (int)vol_l) / Audio::Mixer::kMaxMixerVolume);
-
-			// output right channel
-			clampedAdd(obuf[reverseStereo ^ 1], (out1 * (int)vol_r) / Audio::Mixer::kMaxMixerVolume);
-
-			obuf += 2;
+		if (stereo) {
+			mixStereoSamples(obuf, _buffer, len / 2, vol_l, vol_r, reverseStereo);
+			obuf += len;
+		} else {
+			mixMonoSamples(obuf, _buffer, len, vol_l, vol_r);
+			obuf += len * 2;
 		}
 		return (obuf - ostart) / 2;
 	}
@@ -356,7 +348,10 @@ RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate) {
 /**
  * Create and return a RateConverter object for the specified input and output rates.
  */
-RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo) {
+RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo, RateConverterQuality quality) {
+	if (inrate != outrate && quality == kRateConverterSinc)
+		return makeSincRateConverter(inrate, outrate, stereo, reverseStereo);
+
 	if (stereo) {
 		if (reverseStereo)
 			return makeRateConverter<true, true>(inrate, outrate);
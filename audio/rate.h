@@ -78,7 +78,38 @@ public:
 	virtual int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol) = 0;
 };
 
-RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo = false);
+/**
+ * The ways rate converters can interpolate between input samples.
+ */
+enum RateConverterQuality {
+	/** Pick or linearly interpolate input samples. Cheap, but it aliases. */
+	kRateConverterLinear,
+	/** Filter the input with a windowed sinc. Costs more CPU. */
+	kRateConverterSinc
+};
+
+/**
+ * Set the quality of the rate converters made from now on, unless another
+ * one is asked for.
+ */
+void setRateConverterQuality(RateConverterQuality quality);
+RateConverterQuality getRateConverterQuality();
+
+/**
+ * Parse the value of the "resampler" config setting.
+ *
+ * @return the quality it names, kRateConverterLinear if it is unknown
+ */
+RateConverterQuality parseRateConverterQuality(const char *name);
+
+/**
+ * Create a rate converter for the given rates.
+ *
+ * @param quality	how to interpolate, by default the quality set with
+ *					setRateConverterQuality()
+ */
+RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo = false,
+                                 RateConverterQuality quality = getRateConverterQuality());
 
 } // End of namespace Audio
 
@@ -43,6 +43,7 @@
 
 #include "audio/audiostream.h"
 #include "audio/rate.h"
+#include "audio/rate_sinc.h"
 #include "audio/mixer.h"
 #include "common/util.h"
 #include "common/textconsole.h"
@@ -447,7 +448,10 @@ public:
 /**
  * Create and return a RateConverter object for the specified input and output rates.
  */
-RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo) {
+RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo, RateConverterQuality quality) {
+	if (inrate != outrate && quality == kRateConverterSinc)
+		return makeSincRateConverter(inrate, outrate, stereo, reverseStereo);
+
 	if (inrate != outrate) {
 		if ((inrate % outrate) == 0 && (inrate < 65536)) {
 			if (stereo) {
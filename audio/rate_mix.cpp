@@ -0,0 +1,425 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+/*
+ * Sample accumulation kernels used by the rate converters in rate.cpp.
+ *
+ * Every rate converter ends up scaling its output by the channel volume and
+ * adding it with saturation to the mixer buffer. This is the innermost loop
+ * of the mixer, so besides the portable reference implementation we provide
+ * SSE2, AVX2 and NEON versions. They must produce bit-exact results compared
+ * to the scalar code; test/audio/rate.h verifies this.
+ *
+ * The same goes for the dot product which the sinc rate converter computes
+ * for every output sample and channel.
+ */
+
+#include "audio/rate_mix.h"
+#include "audio/mixer.h"
+
+// The vector kernels implement the saturation of clampedAdd() with signed
+// saturating adds, which does not work for unsigned output.
+#ifndef OUTPUT_UNSIGNED_AUDIO
+
+#include "common/cpudetect.h"
+
+#endif
+
+namespace Audio {
+
+#pragma mark --- Scalar reference ---
+
+static void mixStereoScalar(st_sample_t *obuf, const st_sample_t *ibuf, st_size_t pairs, st_volume_t vol_l, st_volume_t vol_r, bool reverseStereo) {
+	const int left = reverseStereo ? 1 : 0;
+	for (; pairs > 0; --pairs) {
+		clampedAdd(obuf[left    ], (ibuf[0] * (int)vol_l) / Audio::Mixer::kMaxMixerVolume);
+		clampedAdd(obuf[left ^ 1], (ibuf[1] * (int)vol_r) / Audio::Mixer::kMaxMixerVolume);
+		ibuf += 2;
+		obuf += 2;
+	}
+}
+
+static void mixMonoScalar(st_sample_t *obuf, const st_sample_t *ibuf, st_size_t samples, st_volume_t vol_l, st_volume_t vol_r) {
+	for (; samples > 0; --samples) {
+		clampedAdd(obuf[0], (*ibuf * (int)vol_l) / Audio::Mixer::kMaxMixerVolume);
+		clampedAdd(obuf[1], (*ibuf * (int)vol_r) / Audio::Mixer::kMaxMixerVolume);
+		++ibuf;
+		obuf += 2;
+	}
+}
+
+static int32 dotProductScalar(const st_sample_t *samples, const int16 *coefs, st_size_t count) {
+	int32 sum = 0;
+	for (st_size_t i = 0; i < count; ++i)
+		sum += samples[i] * coefs[i];
+	return sum;
+}
+
+// All vector kernels divide by kMaxMixerVolume with a shift. To stay
+// bit-exact with the C division, which rounds towards zero, negative
+// products are biased by kMaxMixerVolume - 1 before shifting.
+enum {
+	kVolumeShift = 8,
+	kVolumeBias = (1 << kVolumeShift) - 1
+};
+
+#pragma mark --- SSE2 ---
+
+#ifdef SCUMMVM_SSE2
+
+TARGET_ATTR("sse2")
+static inline __m128i scaleSSE2(__m128i in, __m128i vol) {
+	const __m128i bias = _mm_set1_epi32(kVolumeBias);
+	const __m128i lo = _mm_mullo_epi16(in, vol);
+	const __m128i hi = _mm_mulhi_epi16(in, vol);
+	__m128i p0 = _mm_unpacklo_epi16(lo, hi);
+	__m128i p1 = _mm_unpackhi_epi16(lo, hi);
+	p0 = _mm_srai_epi32(_mm_add_epi32(p0, _mm_and_si128(_mm_srai_epi32(p0, 31), bias)), kVolumeShift);
+	p1 = _mm_srai_epi32(_mm_add_epi32(p1, _mm_and_si128(_mm_srai_epi32(p1, 31), bias)), kVolumeShift);
+	return _mm_packs_epi32(p0, p1);
+}
+
+TARGET_ATTR("sse2")
+static inline void accumulateSSE2(st_sample_t *obuf, __m128i val) {
+	__m128i *dst = (__m128i *)obuf;
+	_mm_storeu_si128(dst, _mm_adds_epi16(_mm_loadu_si128(dst), val));
+}
+
+TARGET_ATTR("sse2")
+static void mixStereoSSE2(st_sample_t *obuf, const st_sample_t *ibuf, st_size_t pairs, st_volume_t vol_l, st_volume_t vol_r, bool reverseStereo) {
+	const __m128i vol = _mm_set_epi16(vol_r, vol_l, vol_r, vol_l, vol_r, vol_l, vol_r, vol_l);
+
+	for (; pairs >= 4; pairs -= 4) {
+		__m128i val = scaleSSE2(_mm_loadu_si128((const __m128i *)ibuf), vol);
+		if (reverseStereo)
+			val = _mm_shufflehi_epi16(_mm_shufflelo_epi16(val, 0xB1), 0xB1);
+		accumulateSSE2(obuf, val);
+		ibuf += 8;
+		obuf += 8;
+	}
+
+	mixStereoScalar(obuf, ibuf, pairs, vol_l, vol_r, reverseStereo);
+}
+
+TARGET_ATTR("sse2")
+static void mixMonoSSE2(st_sample_t *obuf, const st_sample_t *ibuf, st_size_t samples, st_volume_t vol_l, st_volume_t vol_r) {
+	const __m128i vol = _mm_set_epi16(vol_r, vol_l, vol_r, vol_l, vol_r, vol_l, vol_r, vol_l);
+
+	for (; samples >= 8; samples -= 8) {
+		const __m128i in = _mm_loadu_si128((const __m128i *)ibuf);
+		accumulateSSE2(obuf,     scaleSSE2(_mm_unpacklo_epi16(in, in), vol));
+		accumulateSSE2(obuf + 8, scaleSSE2(_mm_unpackhi_epi16(in, in), vol));
+		ibuf += 8;
+		obuf += 16;
+	}
+
+	mixMonoScalar(obuf, ibuf, samples, vol_l, vol_r);
+}
+
+TARGET_ATTR("sse2")
+static int32 dotProductSSE2(const st_sample_t *samples, const int16 *coefs, st_size_t count) {
+	__m128i sum = _mm_setzero_si128();
+	for (st_size_t i = 0; i < count; i += 8)
+		sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_loadu_si128((const __m128i *)(samples + i)), _mm_loadu_si128((const __m128i *)(coefs + i))));
+
+	sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+	sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+	return _mm_cvtsi128_si32(sum);
+}
+
+#endif
+
+#pragma mark --- AVX2 ---
+
+#ifdef SCUMMVM_AVX2
+
+// The unpack and pack instructions operate on each 128 bit lane separately.
+// Since we pack the products back in the same way we unpacked them, the
+// sample order is preserved.
+TARGET_ATTR("avx2")
+static inline __m256i scaleAVX2(__m256i in, __m256i vol) {
+	const __m256i bias = _mm256_set1_epi32(kVolumeBias);
+	const __m256i lo = _mm256_mullo_epi16(in, vol);
+	const __m256i hi = _mm256_mulhi_epi16(in, vol);
+	__m256i p0 = _mm256_unpacklo_epi16(lo, hi);
+	__m256i p1 = _mm256_unpackhi_epi16(lo, hi);
+	p0 = _mm256_srai_epi32(_mm256_add_epi32(p0, _mm256_and_si256(_mm256_srai_epi32(p0, 31), bias)), kVolumeShift);
+	p1 = _mm256_srai_epi32(_mm256_add_epi32(p1, _mm256_and_si256(_mm256_srai_epi32(p1, 31), bias)), kVolumeShift);
+	return _mm256_packs_epi32(p0, p1);
+}
+
+TARGET_ATTR("avx2")
+static inline void accumulateAVX2(st_sample_t *obuf, __m256i val) {
+	__m256i *dst = (__m256i *)obuf;
+	_mm256_storeu_si256(dst, _mm256_adds_epi16(_mm256_loadu_si256(dst), val));
+}
+
+TARGET_ATTR("avx2")
+static void mixStereoAVX2(st_sample_t *obuf, const st_sample_t *ibuf, st_size_t pairs, st_volume_t vol_l, st_volume_t vol_r, bool reverseStereo) {
+	const __m256i vol = _mm256_set1_epi32(((uint32)vol_r << 16) | vol_l);
+
+	for (; pairs >= 8; pairs -= 8) {
+		__m256i val = scaleAVX2(_mm256_loadu_si256((const __m256i *)ibuf), vol);
+		if (reverseStereo)
+			val = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(val, 0xB1), 0xB1);
+		accumulateAVX2(obuf, val);
+		ibuf += 16;
+		obuf += 16;
+	}
+
+	mixStereoScalar(obuf, ibuf, pairs, vol_l, vol_r, reverseStereo);
+}
+
+TARGET_ATTR("avx2")
+static void mixMonoAVX2(st_sample_t *obuf, const st_sample_t *ibuf, st_size_t samples, st_volume_t vol_l, st_volume_t vol_r) {
+	const __m256i vol = _mm256_set1_epi32(((uint32)vol_r << 16) | vol_l);
+
+	for (; samples >= 16; samples -= 16) {
+		const __m128i in0 = _mm_loadu_si128((const __m128i *)ibuf);
+		const __m128i in1 = _mm_loadu_si128((const __m128i *)(ibuf + 8));
+		const __m256i dup0 = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_unpacklo_epi16(in0, in0)), _mm_unpackhi_epi16(in0, in0), 1);
+		const __m256i dup1 = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_unpacklo_epi16(in1, in1)), _mm_unpackhi_epi16(in1, in1), 1);
+		accumulateAVX2(obuf,      scaleAVX2(dup0, vol));
+		accumulateAVX2(obuf + 16, scaleAVX2(dup1, vol));
+		ibuf += 16;
+		obuf += 32;
+	}
+
+	mixMonoScalar(obuf, ibuf, samples, vol_l, vol_r);
+}
+
+TARGET_ATTR("avx2")
+static int32 dotProductAVX2(const st_sample_t *samples, const int16 *coefs, st_size_t count) {
+	__m256i sum = _mm256_setzero_si256();
+	for (st_size_t i = 0; i < count; i += 16)
+		sum = _mm256_add_epi32(sum, _mm256_madd_epi16(_mm256_loadu_si256((const __m256i *)(samples + i)), _mm256_loadu_si256((const __m256i *)(coefs + i))));
+
+	__m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+	half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0x4E));
+	half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0xB1));
+	return _mm_cvtsi128_si32(half);
+}
+
+#endif
+
+#pragma mark --- NEON ---
+
+#ifdef SCUMMVM_NEON
+
+static inline int16x4_t scaleNEON(int16x4_t in, int16x4_t vol) {
+	int32x4_t p = vmull_s16(in, vol);
+	p = vaddq_s32(p, vandq_s32(vshrq_n_s32(p, 31), vdupq_n_s32(kVolumeBias)));
+	return vqmovn_s32(vshrq_n_s32(p, kVolumeShift));
+}
+
+static inline void accumulateNEON(st_sample_t *obuf, int16x8_t in, int16x4_t vol) {
+	const int16x8_t val = vcombine_s16(scaleNEON(vget_low_s16(in), vol), scaleNEON(vget_high_s16(in), vol));
+	vst1q_s16(obuf, vqaddq_s16(vld1q_s16(obuf), val));
+}
+
+static void mixStereoNEON(st_sample_t *obuf, const st_sample_t *ibuf, st_size_t pairs, st_volume_t vol_l, st_volume_t vol_r, bool reverseStereo) {
+	const int16_t volArray[4] = { (int16_t)vol_l, (int16_t)vol_r, (int16_t)vol_l, (int16_t)vol_r };
+	const int16x4_t vol = vld1_s16(volArray);
+
+	for (; pairs >= 4; pairs -= 4) {
+		int16x8_t in = vld1q_s16(ibuf);
+		if (reverseStereo) {
+			// Swapping the input and the volumes is the same as swapping
+			// the result.
+			const int16x4_t revVol = vrev32_s16(vol);
+			in = vrev32q_s16(in);
+			accumulateNEON(obuf, in, revVol);
+		} else {
+			accumulateNEON(obuf, in, vol);
+		}
+		ibuf += 8;
+		obuf += 8;
+	}
+
+	mixStereoScalar(obuf, ibuf, pairs, vol_l, vol_r, reverseStereo);
+}
+
+static void mixMonoNEON(st_sample_t *obuf, const st_sample_t *ibuf, st_size_t samples, st_volume_t vol_l, st_volume_t vol_r) {
+	const int16_t volArray[4] = { (int16_t)vol_l, (int16_t)vol_r, (int16_t)vol_l, (int16_t)vol_r };
+	const int16x4_t vol = vld1_s16(volArray);
+
+	for (; samples >= 8; samples -= 8) {
+		const int16x8_t in = vld1q_s16(ibuf);
+		const int16x8x2_t dup = vzipq_s16(in, in);
+		accumulateNEON(obuf,     dup.val[0], vol);
+		accumulateNEON(obuf + 8, dup.val[1], vol);
+		ibuf += 8;
+		obuf += 16;
+	}
+
+	mixMonoScalar(obuf, ibuf, samples, vol_l, vol_r);
+}
+
+static int32 dotProductNEON(const st_sample_t *samples, const int16 *coefs, st_size_t count) {
+	int32x4_t sum = vdupq_n_s32(0);
+	for (st_size_t i = 0; i < count; i += 8) {
+		const int16x8_t s = vld1q_s16(samples + i);
+		const int16x8_t c = vld1q_s16(coefs + i);
+		sum = vmlal_s16(sum, vget_low_s16(s), vget_low_s16(c));
+		sum = vmlal_s16(sum, vget_high_s16(s), vget_high_s16(c));
+	}
+
+	const int32x2_t half = vadd_s32(vget_low_s32(sum), vget_high_s32(sum));
+	return vget_lane_s32(vpadd_s32(half, half), 0);
+}
+
+#endif
+
+#pragma mark --- Kernel selection ---
+
+static bool isMixKernelSupported(MixKernel kernel) {
+	switch (kernel) {
+	case kMixKernelScalar:
+		return true;
+
+#ifdef SCUMMVM_SSE2
+	case kMixKernelSSE2:
+		return Common::hasSSE2();
+#endif
+
+#ifdef SCUMMVM_AVX2
+	case kMixKernelAVX2:
+		return Common::hasAVX2();
+#endif
+
+#ifdef SCUMMVM_NEON
+	case kMixKernelNEON:
+		return Common::hasNEON();
+#endif
+
+	default:
+		return false;
+	}
+}
+
+bool getMixKernelProcs(MixKernel kernel, MixStereoProc &stereoProc, MixMonoProc &monoProc) {
+	if (!isMixKernelSupported(kernel))
+		return false;
+
+	switch (kernel) {
+#ifdef SCUMMVM_SSE2
+	case kMixKernelSSE2:
+		stereoProc = mixStereoSSE2;
+		monoProc = mixMonoSSE2;
+		break;
+#endif
+
+#ifdef SCUMMVM_AVX2
+	case kMixKernelAVX2:
+		stereoProc = mixStereoAVX2;
+		monoProc = mixMonoAVX2;
+		break;
+#endif
+
+#ifdef SCUMMVM_NEON
+	case kMixKernelNEON:
+		stereoProc = mixStereoNEON;
+		monoProc = mixMonoNEON;
+		break;
+#endif
+
+	default:
+		stereoProc = mixStereoScalar;
+		monoProc = mixMonoScalar;
+		break;
+	}
+
+	return true;
+}
+
+bool getMixKernelDotProduct(MixKernel kernel, DotProductProc &proc) {
+	if (!isMixKernelSupported(kernel))
+		return false;
+
+	switch (kernel) {
+#ifdef SCUMMVM_SSE2
+	case kMixKernelSSE2:
+		proc = dotProductSSE2;
+		break;
+#endif
+
+#ifdef SCUMMVM_AVX2
+	case kMixKernelAVX2:
+		proc = dotProductAVX2;
+		break;
+#endif
+
+#ifdef SCUMMVM_NEON
+	case kMixKernelNEON:
+		proc = dotProductNEON;
+		break;
+#endif
+
+	default:
+		proc = dotProductScalar;
+		break;
+	}
+
+	return true;
+}
+
+static MixKernel s_activeKernel = kMixKernelCount;
+static MixStereoProc s_mixStereo = 0;
+static MixMonoProc s_mixMono = 0;
+static DotProductProc s_dotProduct = 0;
+
+static void selectMixKernel() {
+	// Pick the last supported kernel, the list is ordered by preference.
+	for (int i = kMixKernelCount - 1; i >= kMixKernelScalar; --i) {
+		if (getMixKernelProcs((MixKernel)i, s_mixStereo, s_mixMono)) {
+			getMixKernelDotProduct((MixKernel)i, s_dotProduct);
+			s_activeKernel = (MixKernel)i;
+			break;
+		}
+	}
+}
+
+MixKernel getActiveMixKernel() {
+	if (s_activeKernel == kMixKernelCount)
+		selectMixKernel();
+	return s_activeKernel;
+}
+
+void mixStereoSamples(st_sample_t *obuf, const st_sample_t *ibuf, st_size_t pairs, st_volume_t vol_l, st_volume_t vol_r, bool reverseStereo) {
+	if (!s_mixStereo)
+		selectMixKernel();
+	s_mixStereo(obuf, ibuf, pairs, vol_l, vol_r, reverseStereo);
+}
+
+void mixMonoSamples(st_sample_t *obuf, const st_sample_t *ibuf, st_size_t samples, st_volume_t vol_l, st_volume_t vol_r) {
+	if (!s_mixMono)
+		selectMixKernel();
+	s_mixMono(obuf, ibuf, samples, vol_l, vol_r);
+}
+
+int32 dotProduct(const st_sample_t *samples, const int16 *coefs, st_size_t count) {
+	if (!s_dotProduct)
+		selectMixKernel();
+	return s_dotProduct(samples, coefs, count);
+}
+
+} // End of namespace Audio
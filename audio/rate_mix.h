@@ -0,0 +1,168 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef AUDIO_RATE_MIX_H
+#define AUDIO_RATE_MIX_H
+
+#include "audio/rate.h"
+
+namespace Audio {
+
+/**
+ * The sample accumulation kernels available to the rate converters.
+ *
+ * kMixKernelScalar is the reference implementation and is always
+ * available. The others are only usable if they have been compiled in
+ * and the CPU we are running on supports them.
+ */
+enum MixKernel {
+	kMixKernelScalar = 0,
+	kMixKernelSSE2,
+	kMixKernelAVX2,
+	kMixKernelNEON,
+
+	kMixKernelCount
+};
+
+/**
+ * Mix interleaved stereo samples into a stereo output buffer.
+ *
+ * For every sample pair, the left input sample is scaled by vol_l and the
+ * right one by vol_r (both in the range 0 - Mixer::kMaxMixerVolume). The
+ * results are added to obuf with saturation, exactly like clampedAdd does.
+ * If reverseStereo is set, the left input is mixed into the right output
+ * channel and vice versa.
+ *
+ * @param obuf          output buffer, 2 * pairs samples
+ * @param ibuf          input buffer, 2 * pairs samples
+ * @param pairs         number of sample pairs to mix
+ */
+typedef void (*MixStereoProc)(st_sample_t *obuf, const st_sample_t *ibuf, st_size_t pairs, st_volume_t vol_l, st_volume_t vol_r, bool reverseStereo);
+
+/**
+ * Mix mono samples into a stereo output buffer.
+ *
+ * Every input sample is scaled by vol_l for the left and by vol_r for the
+ * right output channel and added to obuf with saturation.
+ *
+ * @param obuf          output buffer, 2 * samples samples
+ * @param ibuf          input buffer, samples samples
+ * @param samples       number of input samples to mix
+ */
+typedef void (*MixMonoProc)(st_sample_t *obuf, const st_sample_t *ibuf, st_size_t samples, st_volume_t vol_l, st_volume_t vol_r);
+
+/**
+ * Compute the sum of the products of samples and filter coefficients, as
+ * done by the sinc rate converter for each output sample.
+ *
+ * The sum must fit in 32 bits, which the converter guarantees by scaling
+ * its coefficients.
+ *
+ * @param samples       input samples, count samples
+ * @param coefs         filter coefficients, count values
+ * @param count         number of products, a multiple of 16
+ */
+typedef int32 (*DotProductProc)(const st_sample_t *samples, const int16 *coefs, st_size_t count);
+
+/**
+ * Query the procedures of a specific mix kernel.
+ *
+ * @return true if the kernel is usable on this machine, false otherwise.
+ */
+bool getMixKernelProcs(MixKernel kernel, MixStereoProc &stereoProc, MixMonoProc &monoProc);
+
+/**
+ * Query the dot product procedure of a specific mix kernel.
+ *
+ * @return true if the kernel is usable on this machine, false otherwise.
+ */
+bool getMixKernelDotProduct(MixKernel kernel, DotProductProc &proc);
+
+/**
+ * Return the kernel used by mixStereoSamples and mixMonoSamples. It is the
+ * fastest one supported by the CPU, as determined on first use.
+ */
+MixKernel getActiveMixKernel();
+
+/**
+ * Mix stereo samples using the active kernel.
+ * @see MixStereoProc
+ */
+void mixStereoSamples(st_sample_t *obuf, const st_sample_t *ibuf, st_size_t pairs, st_volume_t vol_l, st_volume_t vol_r, bool reverseStereo);
+
+/**
+ * Mix mono samples using the active kernel.
+ * @see MixMonoProc
+ */
+void mixMonoSamples(st_sample_t *obuf, const st_sample_t *ibuf, st_size_t samples, st_volume_t vol_l, st_volume_t vol_r);
+
+/**
+ * Compute a dot product using the active kernel.
+ * @see DotProductProc
+ */
+int32 dotProduct(const st_sample_t *samples, const int16 *coefs, st_size_t count);
+
+/**
+ * Collects the output sample pairs of a rate converter and mixes them into
+ * the output buffer in batches, so that the volume scaling and saturation
+ * can be done by the vectorized kernels from rate_mix.cpp.
+ */
+template<bool reverseStereo>
+class MixBuffer {
+	enum {
+		kBufferSize = 512
+	};
+
+	st_sample_t _buf[kBufferSize];
+	st_sample_t *_ptr;
+	const st_volume_t _volL, _volR;
+
+public:
+	MixBuffer(st_volume_t vol_l, st_volume_t vol_r) : _ptr(_buf), _volL(vol_l), _volR(vol_r) {}
+
+	/**
+	 * Queue a sample pair which is meant to go to obuf.
+	 */
+	void put(st_sample_t out0, st_sample_t out1, st_sample_t *obuf) {
+		*_ptr++ = out0;
+		*_ptr++ = out1;
+		if (_ptr == _buf + kBufferSize)
+			flush(obuf + 2);
+	}
+
+	/**
+	 * Mix all queued sample pairs into the output buffer.
+	 *
+	 * @param oend pointer just past the last queued output pair
+	 */
+	void flush(st_sample_t *oend) {
+		const st_size_t len = _ptr - _buf;
+		if (len) {
+			mixStereoSamples(oend - len, _buf, len / 2, _volL, _volR, reverseStereo);
+			_ptr = _buf;
+		}
+	}
+};
+
+} // End of namespace Audio
+
+#endif
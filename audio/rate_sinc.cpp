@@ -0,0 +1,385 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+/*
+ * Polyphase windowed sinc rate converter.
+ *
+ * The ratio of the rates is reduced to outrate / inrate = L / M. Each output
+ * sample then falls on one of L positions between two input samples, the
+ * phases. For each phase the filter is sampled into a row of coefficients
+ * once, so an output sample is a plain dot product of the input around it
+ * and a row, which is done by the kernels from rate_mix.cpp. Ratios with
+ * more than kMaxPhases phases, like 11127 to 44100 Hz, use the nearest of
+ * kMaxPhases evenly spaced phases instead.
+ *
+ * The tables are only computed with floating point; filtering itself is
+ * done with 16 bit coefficients and 32 bit sums.
+ */
+
+#include "audio/audiostream.h"
+#include "audio/rate_mix.h"
+#include "audio/rate_sinc.h"
+
+#include "common/algorithm.h"
+#include "common/atomic.h"
+#include "common/textconsole.h"
+#include "common/util.h"
+
+namespace Audio {
+
+static RateConverterQuality s_quality = kRateConverterLinear;
+
+void setRateConverterQuality(RateConverterQuality quality) {
+	s_quality = quality;
+}
+
+RateConverterQuality getRateConverterQuality() {
+	return s_quality;
+}
+
+RateConverterQuality parseRateConverterQuality(const char *name) {
+	if (!scumm_stricmp(name, "sinc"))
+		return kRateConverterSinc;
+	return kRateConverterLinear;
+}
+
+enum {
+	// Taps of the filter when upsampling. Downsampling widens the filter by
+	// the ratio of the rates, up to kMaxTaps. Both are multiples of 16, as
+	// required by the dot product kernels.
+	kSincTaps = 32,
+	kMaxSincTaps = 128,
+
+	kMaxPhases = 512,
+
+	// Number of fractional bits of the coefficients
+	kCoefBits = 14,
+
+	// Number of tables kept for later converters
+	kMaxSincTables = 16
+};
+
+// Cutoff frequency, relative to the lower Nyquist frequency of the two rates
+static const double kSincCutoff = 0.86;
+// Kaiser window parameter, for about 70 dB stopband attenuation
+static const double kSincBeta = 7.0;
+
+/**
+ * The filter coefficients for one ratio of rates, a row of taps
+ * coefficients for each phase.
+ */
+struct SincTable {
+	uint32 phaseCount;		// L
+	uint32 step;			// M
+	uint32 tableSize;		// Number of phases sampled, min(L, kMaxPhases)
+	uint32 taps;
+	int16 *coefs;
+
+	SincTable(uint32 l, uint32 m);
+	~SincTable() { delete[] coefs; }
+
+	/**
+	 * Return the coefficients of a phase. If not all phases were sampled, the
+	 * nearest one is used, which may be the extra row for the start of the
+	 * next input sample.
+	 */
+	const int16 *getRow(uint32 phase) const {
+		if (tableSize != phaseCount)
+			phase = (uint32)(((uint64)phase * tableSize + phaseCount / 2) / phaseCount);
+		return coefs + phase * taps;
+	}
+};
+
+static double besselI0(double x) {
+	// Power series, which converges quickly for the arguments used here
+	double sum = 1.0, term = 1.0;
+	for (int k = 1; k < 32; ++k) {
+		term *= (x / (2 * k)) * (x / (2 * k));
+		sum += term;
+	}
+	return sum;
+}
+
+SincTable::SincTable(uint32 l, uint32 m) : phaseCount(l), step(m) {
+	tableSize = MIN<uint32>(l, kMaxPhases);
+
+	// Downsampling lowers the cutoff, so the filter needs to be longer for
+	// the same steepness
+	const double scale = (m > l) ? (double)l / m : 1.0;
+	taps = kSincTaps;
+	if (m > l)
+		taps = MIN<uint32>((uint32)(kSincTaps * (double)m / l + 15) & ~15, kMaxSincTaps);
+
+	const double cutoff = kSincCutoff * scale;
+	const double halfWidth = taps / 2;
+	const double windowScale = 1.0 / besselI0(kSincBeta);
+
+	// Rounding to the nearest sampled phase can reach the next input sample,
+	// which gets a row of its own
+	const uint32 rows = tableSize + (tableSize != phaseCount ? 1 : 0);
+
+	coefs = new int16[rows * taps];
+	double *row = new double[taps];
+
+	for (uint32 p = 0; p < rows; ++p) {
+		// Output samples of this phase lie between input samples
+		// taps / 2 - 1 and taps / 2 of the row
+		const double frac = (double)p / tableSize;
+
+		double sum = 0.0;
+		for (uint32 k = 0; k < taps; ++k) {
+			const double x = (double)k - (taps / 2 - 1) - frac;
+			const double w = x / halfWidth;
+			const double window = (w * w < 1.0) ? besselI0(kSincBeta * sqrt(1.0 - w * w)) * windowScale : 0.0;
+			const double arg = M_PI * cutoff * x;
+			const double sinc = (x == 0.0) ? 1.0 : sin(arg) / arg;
+			row[k] = cutoff * sinc * window;
+			sum += row[k];
+		}
+
+		// Normalize each row so that a constant input gives the same output.
+		// Rounding errors are put into the biggest coefficient.
+		int16 *out = coefs + p * taps;
+		int total = 0;
+		uint32 biggest = 0;
+		for (uint32 k = 0; k < taps; ++k) {
+			out[k] = (int16)floor(row[k] / sum * (1 << kCoefBits) + 0.5);
+			total += out[k];
+			if (out[k] > out[biggest])
+				biggest = k;
+		}
+		out[biggest] += (1 << kCoefBits) - total;
+	}
+
+	delete[] row;
+}
+
+/**
+ * The tables computed so far. Converters are made from several threads, like
+ * the mixer and engine threads. Tables are computed without holding the lock,
+ * which is only held to look them up and add them, so a spin lock is good
+ * enough and works before there is a backend.
+ */
+class SincTableCache {
+public:
+	SincTableCache() : _count(0), _lock(0) {}
+
+	~SincTableCache() {
+		for (uint i = 0; i < _count; ++i)
+			delete _tables[i];
+	}
+
+	/**
+	 * Return the table for a ratio, computing it if needed. If the cache is
+	 * full, the table belongs to the caller, and owned is set.
+	 */
+	const SincTable *get(uint32 l, uint32 m, bool &owned) {
+		owned = false;
+		lock();
+		const SincTable *table = find(l, m);
+		unlock();
+		if (table)
+			return table;
+
+		SincTable *created = new SincTable(l, m);
+
+		lock();
+		table = find(l, m);
+		if (!table && _count < kMaxSincTables) {
+			_tables[_count++] = created;
+			table = created;
+		}
+		unlock();
+
+		if (!table) {
+			owned = true;
+			return created;
+		}
+
+		// Another thread may have added the same table in the meantime
+		if (table != created)
+			delete created;
+		return table;
+	}
+
+private:
+	void lock() {
+		while (!Common::atomicCompareAndSwap(_lock, 0, 1))
+			;
+	}
+
+	void unlock() {
+		Common::atomicStore(_lock, (uint32)0);
+	}
+
+	const SincTable *find(uint32 l, uint32 m) const {
+		for (uint i = 0; i < _count; ++i) {
+			if (_tables[i]->phaseCount == l && _tables[i]->step == m)
+				return _tables[i];
+		}
+		return 0;
+	}
+
+	SincTable *_tables[kMaxSincTables];
+	uint _count;
+	volatile uint32 _lock;
+};
+
+static SincTableCache s_sincTables;
+
+/**
+ * Audio rate converter based on a windowed sinc filter.
+ *
+ * The input is kept deinterleaved in a history buffer per channel, so the
+ * samples around an output sample are next to each other.
+ */
+template<bool stereo, bool reverseStereo>
+class SincRateConverter : public RateConverter {
+	enum {
+		kChannels = stereo ? 2 : 1,
+		kInputSize = 512,
+		kHistorySize = kMaxSincTaps + kInputSize
+	};
+
+	const SincTable *_table;
+	const bool _ownsTable;
+	DotProductProc _dotProduct;
+
+	st_sample_t _inBuf[kInputSize];
+	st_sample_t _history[kChannels][kHistorySize];
+
+	/** Index of the first input sample the next output sample is made of */
+	uint32 _pos;
+	/** Number of input samples in the history */
+	uint32 _fill;
+	/** Position of the next output sample between two input samples, < L */
+	uint32 _phase;
+
+	bool refill(AudioStream &input);
+	st_sample_t filter(const st_sample_t *samples, const int16 *coefs) const;
+
+public:
+	SincRateConverter(const SincTable *table, bool ownsTable);
+	~SincRateConverter();
+
+	int flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r);
+	int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol) {
+		return ST_SUCCESS;
+	}
+};
+
+template<bool stereo, bool reverseStereo>
+SincRateConverter<stereo, reverseStereo>::SincRateConverter(const SincTable *table, bool ownsTable)
+	: _table(table), _ownsTable(ownsTable), _pos(0), _phase(0) {
+	getMixKernelDotProduct(getActiveMixKernel(), _dotProduct);
+
+	// Start with silence before the input, so the first output sample is
+	// centered on the first input sample
+	_fill = _table->taps / 2 - 1;
+	for (int c = 0; c < kChannels; ++c)
+		memset(_history[c], 0, _fill * sizeof(st_sample_t));
+}
+
+template<bool stereo, bool reverseStereo>
+SincRateConverter<stereo, reverseStereo>::~SincRateConverter() {
+	if (_ownsTable)
+		delete _table;
+}
+
+template<bool stereo, bool reverseStereo>
+bool SincRateConverter<stereo, reverseStereo>::refill(AudioStream &input) {
+	// Move the samples which are still needed to the start
+	if (_fill + kInputSize / kChannels > kHistorySize) {
+		for (int c = 0; c < kChannels; ++c)
+			memmove(_history[c], _history[c] + _pos, (_fill - _pos) * sizeof(st_sample_t));
+		_fill -= _pos;
+		_pos = 0;
+	}
+
+	const int len = input.readBuffer(_inBuf, kInputSize);
+	if (len <= 0)
+		return false;
+
+	const st_sample_t *in = _inBuf;
+	for (int i = 0; i < len / kChannels; ++i) {
+		for (int c = 0; c < kChannels; ++c)
+			_history[c][_fill + i] = *in++;
+	}
+	_fill += len / kChannels;
+	return true;
+}
+
+template<bool stereo, bool reverseStereo>
+st_sample_t SincRateConverter<stereo, reverseStereo>::filter(const st_sample_t *samples, const int16 *coefs) const {
+	const int32 sum = (_dotProduct(samples, coefs, _table->taps) + (1 << (kCoefBits - 1))) >> kCoefBits;
+	return (st_sample_t)CLIP<int32>(sum, ST_SAMPLE_MIN, ST_SAMPLE_MAX);
+}
+
+template<bool stereo, bool reverseStereo>
+int SincRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
+	MixBuffer<reverseStereo> mixBuf(vol_l, vol_r);
+	st_sample_t *ostart = obuf;
+	st_sample_t *oend = obuf + osamp * 2;
+	const uint32 taps = _table->taps;
+
+	while (obuf < oend) {
+		// Read until all input samples of the next output sample are there
+		while (_pos + taps > _fill) {
+			if (!refill(input)) {
+				mixBuf.flush(obuf);
+				return (obuf - ostart) / 2;
+			}
+		}
+
+		const int16 *coefs = _table->getRow(_phase);
+		const st_sample_t out0 = filter(_history[0] + _pos, coefs);
+		const st_sample_t out1 = stereo ? filter(_history[kChannels - 1] + _pos, coefs) : out0;
+
+		mixBuf.put(out0, out1, obuf);
+		obuf += 2;
+
+		_phase += _table->step;
+		while (_phase >= _table->phaseCount) {
+			_phase -= _table->phaseCount;
+			_pos++;
+		}
+	}
+
+	mixBuf.flush(obuf);
+	return (obuf - ostart) / 2;
+}
+
+RateConverter *makeSincRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo) {
+	const st_rate_t divisor = Common::gcd(inrate, outrate);
+	bool owned;
+	const SincTable *table = s_sincTables.get(outrate / divisor, inrate / divisor, owned);
+
+	if (stereo) {
+		if (reverseStereo)
+			return new SincRateConverter<true, true>(table, owned);
+		else
+			return new SincRateConverter<true, false>(table, owned);
+	} else
+		return new SincRateConverter<false, false>(table, owned);
+}
+
+} // End of namespace Audio
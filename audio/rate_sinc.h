@@ -0,0 +1,44 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef AUDIO_RATE_SINC_H
+#define AUDIO_RATE_SINC_H
+
+#include "audio/rate.h"
+
+namespace Audio {
+
+/**
+ * Create a rate converter which interpolates with a windowed sinc filter.
+ *
+ * The filter coefficients are computed once for each pair of rates and
+ * shared between all converters for it. Upsampling cuts off a bit below
+ * the Nyquist frequency of the input, downsampling a bit below the one of
+ * the output, so neither produces audible aliases.
+ *
+ * @see makeRateConverter
+ */
+RateConverter *makeSincRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo);
+
+} // End of namespace Audio
+
+#endif
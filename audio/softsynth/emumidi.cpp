@@ -0,0 +1,442 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "audio/softsynth/emumidi.h"
+
+#include "common/atomic.h"
+#include "common/config-manager.h"
+#include "common/debug.h"
+#include "common/mutex.h"
+#include "common/spscqueue.h"
+#include "common/system.h"
+#include "common/textconsole.h"
+#include "common/thread.h"
+#include "common/trace.h"
+
+enum {
+	/** How often the renderer tops up the rendered audio, in milliseconds */
+	kRenderAheadInterval = 5,
+	/** The most frames rendered in one go, so readBuffer() never waits long */
+	kRenderChunkFrames = 512,
+	/** The most messages queued for the renderer */
+	kMaxQueuedEvents = 1024
+};
+
+struct MidiDriver_Emulated::RenderAhead {
+	struct Event {
+		uint32 time;
+		uint32 msg;
+		/** A copy of the SysEx message, or 0 for other messages */
+		byte *sysEx;
+		uint16 length;
+	};
+
+	RenderAhead() : frames(0), buffer(0), bufferSize(0), head(0), tail(0),
+		renderPos(0), playPos(0), inTimerCallback(false), timerThread(0),
+		pendingCount(0), quit(0) {}
+
+	~RenderAhead() {
+		reset();
+		delete[] buffer;
+	}
+
+	/** Drop the queued messages and rendered audio. The renderer must not run. */
+	void reset() {
+		head = tail = 0;
+		renderPos = playPos = 0;
+
+		Event event;
+		while (events.pop(event))
+			delete[] event.sysEx;
+		for (uint i = 0; i < pendingCount; ++i)
+			delete[] pending[i].sysEx;
+		pendingCount = 0;
+		freeSysEx();
+	}
+
+	/** Free the SysEx copies of the messages played. Producer only. */
+	void freeSysEx() {
+		byte *sysEx;
+		while (playedSysEx.pop(sysEx))
+			delete[] sysEx;
+	}
+
+	/** Held while rendering a chunk, by the renderer or by readBuffer() */
+	Common::Mutex renderMutex;
+
+	/** The number of frames to keep rendered, 0 when not rendering ahead */
+	volatile uint32 frames;
+
+	// The rendered samples. Like Common::SPSCQueue, the renderer only
+	// writes the tail and readBuffer() only writes the head.
+	int16 *buffer;
+	uint32 bufferSize;
+	volatile uint32 head;
+	volatile uint32 tail;
+
+	/** The number of frames rendered so far */
+	uint32 renderPos;
+	/** The number of frames handed to the mixer so far */
+	volatile uint32 playPos;
+	/**
+	 * Set while the renderer calls the timer callbacks, together with the
+	 * thread it runs on. Guarded by queueMutex.
+	 */
+	bool inTimerCallback;
+	uint64 timerThread;
+
+	/**
+	 * The messages queued for the renderer. The senders serialize through
+	 * queueMutex, so the renderer takes them without locking or allocating
+	 * memory.
+	 */
+	Common::Mutex queueMutex;
+	Common::SPSCQueue<Event, kMaxQueuedEvents> events;
+	/** The SysEx copies of the messages played, for the senders to free */
+	Common::SPSCQueue<byte *, 2 * kMaxQueuedEvents + 1> playedSysEx;
+
+	/** The messages taken from the queue by the renderer, ordered by time */
+	Event pending[kMaxQueuedEvents];
+	uint pendingCount;
+
+	/** The thread rendering ahead, see renderAheadThread() */
+	Common::Thread thread;
+	/** Posted to make the thread quit */
+	Common::Semaphore wakeUp;
+	volatile uint32 quit;
+};
+
+MidiDriver_Emulated::~MidiDriver_Emulated() {
+	// Subclasses should have stopped rendering ahead in close() already
+	unregisterRenderAhead();
+	delete _renderAhead;
+}
+
+int MidiDriver_Emulated::open() {
+	_isOpen = true;
+
+	int d = getRate() / _baseFreq;
+	int r = getRate() % _baseFreq;
+
+	// This is equivalent to (getRate() << FIXP_SHIFT) / BASE_FREQ
+	// but less prone to arithmetic overflow.
+
+	_samplesPerTick = (d << FIXP_SHIFT) + (r << FIXP_SHIFT) / _baseFreq;
+
+	if (supportsRenderAhead()) {
+		// Set up before the stream is played, since readBuffer() takes
+		// the rendered audio whenever _renderAhead is set
+		const uint stereoFactor = isStereo() ? 2 : 1;
+		const uint32 bufferSize = (getRate() * kMaxRenderAhead / 1000 + 1) * stereoFactor;
+
+		if (_renderAhead && _renderAhead->bufferSize != bufferSize) {
+			delete _renderAhead;
+			_renderAhead = 0;
+		}
+
+		if (!_renderAhead) {
+			_renderAhead = new RenderAhead();
+			_renderAhead->buffer = new int16[bufferSize];
+			_renderAhead->bufferSize = bufferSize;
+		}
+
+		_renderAhead->reset();
+
+		int msecs = ConfMan.getInt("midi_render_ahead");
+		if (msecs > 0)
+			setRenderAhead(MIN<int>(msecs, kMaxRenderAhead));
+	}
+
+	return 0;
+}
+
+bool MidiDriver_Emulated::setRenderAhead(uint msecs) {
+	if (!msecs) {
+		unregisterRenderAhead();
+		return true;
+	}
+
+	if (!_isOpen || !_renderAhead || msecs > kMaxRenderAhead)
+		return false;
+
+	const uint32 frames = getRate() * msecs / 1000;
+	if (!frames)
+		return false;
+
+	if (_renderAhead->frames) {
+		Common::StackLock lock(_renderAhead->queueMutex);
+		_renderAhead->frames = frames;
+		return true;
+	}
+
+	_renderAhead->frames = frames;
+	return registerRenderAhead();
+}
+
+uint MidiDriver_Emulated::getRenderAhead() const {
+	if (!_renderAhead || !_renderAhead->frames)
+		return 0;
+
+	return _renderAhead->frames * 1000 / getRate();
+}
+
+bool MidiDriver_Emulated::registerRenderAhead() {
+	// Without threads, readBuffer() keeps rendering everything itself
+	Common::atomicStore(_renderAhead->quit, 0U);
+	if (!_renderAhead->thread.start(&renderAheadThread, this, "MidiDriver_Emulated")) {
+		_renderAhead->frames = 0;
+		return false;
+	}
+
+	return true;
+}
+
+void MidiDriver_Emulated::unregisterRenderAhead() {
+	if (!_renderAhead || !_renderAhead->frames)
+		return;
+
+	Common::atomicStore(_renderAhead->quit, 1U);
+	_renderAhead->wakeUp.post();
+	_renderAhead->thread.join();
+
+	// From now on, messages are played right away. The ones queued before
+	// are still played when their time comes.
+	Common::StackLock lock(_renderAhead->queueMutex);
+	_renderAhead->frames = 0;
+}
+
+void MidiDriver_Emulated::renderAheadThread(void *param) {
+	MidiDriver_Emulated *driver = (MidiDriver_Emulated *)param;
+	RenderAhead &ahead = *driver->_renderAhead;
+
+	while (!Common::atomicLoad(ahead.quit)) {
+		driver->renderAhead();
+		ahead.wakeUp.wait(kRenderAheadInterval);
+	}
+}
+
+void MidiDriver_Emulated::renderAhead() {
+	TRACE_SCOPE("audio", "MidiDriver_Emulated::renderAhead");
+
+	RenderAhead &ahead = *_renderAhead;
+	const uint32 stereoFactor = isStereo() ? 2 : 1;
+	const uint32 size = ahead.bufferSize;
+
+	for (;;) {
+		// The lock is only held for one chunk at a time, so readBuffer()
+		// never waits long for it
+		Common::StackLock lock(ahead.renderMutex);
+
+		const uint32 tail = ahead.tail;
+		const uint32 buffered = (tail + size - Common::atomicLoad(ahead.head)) % size;
+		const uint32 target = ahead.frames * stereoFactor;
+		if (buffered >= target)
+			break;
+
+		// Only render into the part up to the end of the buffer, the
+		// next iteration continues at its start
+		uint32 count = MIN<uint32>(target - buffered, kRenderChunkFrames * stereoFactor);
+		count = MIN(count, size - tail);
+
+		renderSamples(ahead.buffer + tail, count / stereoFactor);
+		Common::atomicStore(ahead.tail, (tail + count) % size);
+	}
+}
+
+uint MidiDriver_Emulated::readRendered(int16 *data, uint numSamples) {
+	RenderAhead &ahead = *_renderAhead;
+	const uint32 size = ahead.bufferSize;
+	const uint32 head = ahead.head;
+	const uint32 available = (Common::atomicLoad(ahead.tail) + size - head) % size;
+
+	const uint32 count = MIN<uint32>(numSamples, available);
+	const uint32 first = MIN(count, size - head);
+	memcpy(data, ahead.buffer + head, first * sizeof(int16));
+	memcpy(data + first, ahead.buffer, (count - first) * sizeof(int16));
+
+	Common::atomicStore(ahead.head, (head + count) % size);
+	return count;
+}
+
+int MidiDriver_Emulated::readBuffer(int16 *data, const int numSamples) {
+	const int stereoFactor = isStereo() ? 2 : 1;
+
+	if (!_renderAhead) {
+		renderSamples(data, numSamples / stereoFactor);
+		return numSamples;
+	}
+
+	RenderAhead &ahead = *_renderAhead;
+
+	uint copied = readRendered(data, numSamples);
+	if (copied < (uint)numSamples) {
+		// The renderer did not keep up, or is not running: render the rest
+		// here, after the samples it is rendering right now
+		Common::StackLock lock(ahead.renderMutex);
+
+		copied += readRendered(data + copied, numSamples - copied);
+		if (copied < (uint)numSamples) {
+			if (ahead.frames)
+				debug(5, "MidiDriver_Emulated: Rendering ahead fell behind by %d samples", numSamples - copied);
+
+			renderSamples(data + copied, (numSamples - copied) / stereoFactor);
+		}
+	}
+
+	Common::atomicStore(ahead.playPos, ahead.playPos + numSamples / stereoFactor);
+	return numSamples;
+}
+
+void MidiDriver_Emulated::renderSamples(int16 *data, int len) {
+	const int stereoFactor = isStereo() ? 2 : 1;
+	int step;
+
+	do {
+		step = len;
+		if (step > (_nextTick >> FIXP_SHIFT))
+			step = (_nextTick >> FIXP_SHIFT);
+
+		if (_renderAhead)
+			step = processEvents(step);
+
+		generateSamples(data, step);
+
+		if (_renderAhead)
+			_renderAhead->renderPos += step;
+
+		_nextTick -= step << FIXP_SHIFT;
+		if (!(_nextTick >> FIXP_SHIFT)) {
+			if (_renderAhead)
+				setInTimerCallback(true);
+
+			if (_timerProc)
+				(*_timerProc)(_timerParam);
+
+			onTimer();
+
+			if (_renderAhead)
+				setInTimerCallback(false);
+
+			_nextTick += _samplesPerTick;
+		}
+
+		data += step * stereoFactor;
+		len -= step;
+	} while (len);
+}
+
+void MidiDriver_Emulated::setInTimerCallback(bool inTimerCallback) {
+	RenderAhead &ahead = *_renderAhead;
+	Common::StackLock lock(ahead.queueMutex);
+
+	ahead.inTimerCallback = inTimerCallback;
+	ahead.timerThread = inTimerCallback ? g_system->getCurrentThreadId() : 0;
+}
+
+int MidiDriver_Emulated::processEvents(int len) {
+	RenderAhead &ahead = *_renderAhead;
+
+	// Take over the new messages. Those sent by the timer callbacks may be
+	// due before the ones sent earlier from elsewhere.
+	RenderAhead::Event event;
+	while (ahead.pendingCount < kMaxQueuedEvents && ahead.events.pop(event)) {
+		uint i = ahead.pendingCount++;
+		while (i > 0 && (int32)(event.time - ahead.pending[i - 1].time) < 0) {
+			ahead.pending[i] = ahead.pending[i - 1];
+			--i;
+		}
+		ahead.pending[i] = event;
+	}
+
+	uint played = 0;
+	while (played < ahead.pendingCount) {
+		// Stop rendering at the next message
+		const int32 delta = (int32)(ahead.pending[played].time - ahead.renderPos);
+		if (delta > 0) {
+			len = MIN<int32>(len, delta);
+			break;
+		}
+
+		event = ahead.pending[played++];
+		if (event.sysEx) {
+			processSysEx(event.sysEx, event.length);
+			ahead.playedSysEx.push(event.sysEx);
+		} else {
+			processEvent(event.msg);
+		}
+	}
+
+	if (played) {
+		ahead.pendingCount -= played;
+		memmove(ahead.pending, ahead.pending + played, ahead.pendingCount * sizeof(RenderAhead::Event));
+	}
+
+	return len;
+}
+
+bool MidiDriver_Emulated::queueEvent(uint32 b) {
+	return insertEvent(b, 0, 0);
+}
+
+bool MidiDriver_Emulated::queueSysEx(const byte *msg, uint16 length) {
+	return length && insertEvent(0, msg, length);
+}
+
+bool MidiDriver_Emulated::insertEvent(uint32 msg, const byte *sysEx, uint16 length) {
+	if (!_renderAhead)
+		return false;
+
+	RenderAhead &ahead = *_renderAhead;
+	Common::StackLock lock(ahead.queueMutex);
+
+	if (!ahead.frames)
+		return false;
+
+	ahead.freeSysEx();
+
+	RenderAhead::Event event;
+	event.msg = msg;
+	event.length = length;
+	event.sysEx = 0;
+	if (length) {
+		event.sysEx = new byte[length];
+		memcpy(event.sysEx, sysEx, length);
+	}
+
+	// Messages sent by the timer callbacks are played where the renderer
+	// is, just like without rendering ahead. Others are delayed by the time
+	// rendered ahead, which puts them after everything already rendered
+	// and keeps the delay constant. That includes messages sent by other
+	// threads while the renderer is in a timer callback.
+	if (ahead.inTimerCallback && ahead.timerThread == g_system->getCurrentThreadId())
+		event.time = ahead.renderPos;
+	else
+		event.time = Common::atomicLoad(ahead.playPos) + ahead.frames;
+
+	if (!ahead.events.push(event)) {
+		warning("MidiDriver_Emulated: Too many queued MIDI messages");
+		delete[] event.sysEx;
+		return false;
+	}
+
+	return true;
+}
@@ -44,13 +44,65 @@ private:
 	int _nextTick;
 	int _samplesPerTick;
 
+	// Rendering ahead, see setRenderAhead()
+	struct RenderAhead;
+	RenderAhead *_renderAhead;
+
+	static void renderAheadThread(void *param);
+	void renderAhead();
+	void renderSamples(int16 *data, int len);
+	void setInTimerCallback(bool inTimerCallback);
+	int processEvents(int len);
+	bool insertEvent(uint32 msg, const byte *sysEx, uint16 length);
+	uint readRendered(int16 *data, uint numSamples);
+	bool registerRenderAhead();
+	void unregisterRenderAhead();
+
 protected:
 	int _baseFreq;
 
 	virtual void generateSamples(int16 *buf, int len) = 0;
 	virtual void onTimer() {}
 
+	/**
+	 * Can the synth render ahead in a thread of its own?
+	 *
+	 * A subclass which returns true has to pass the MIDI messages it gets
+	 * through queueEvent() and queueSysEx(), and it must be ready to
+	 * generate samples when it calls open(). After that, only the
+	 * processEvent(), processSysEx() and generateSamples() calls may touch
+	 * the synth, so other calls like setPitchBendRange() have to be sent as
+	 * messages as well.
+	 *
+	 * @see setRenderAhead()
+	 */
+	virtual bool supportsRenderAhead() const { return false; }
+
+	/**
+	 * Queue a MIDI message while rendering ahead, so that it is played at
+	 * the right sample in the rendered audio. Drivers which support
+	 * rendering ahead call this from send().
+	 *
+	 * @return true if the message was queued, false if the driver has to
+	 *         play it right away by calling processEvent() itself
+	 */
+	bool queueEvent(uint32 b);
+
+	/** Like queueEvent(), for SysEx messages. */
+	bool queueSysEx(const byte *msg, uint16 length);
+
+	/** Play a MIDI message queued by queueEvent(). */
+	virtual void processEvent(uint32 b) {}
+
+	/** Play a SysEx message queued by queueSysEx(). */
+	virtual void processSysEx(const byte *msg, uint16 length) {}
+
 public:
+	enum {
+		/** The maximum time setRenderAhead() accepts, in milliseconds. */
+		kMaxRenderAhead = 500
+	};
+
 	MidiDriver_Emulated(Audio::Mixer *mixer) :
 		_mixer(mixer),
 		_isOpen(false),
@@ -58,23 +110,14 @@ public:
 		_timerParam(0),
 		_nextTick(0),
 		_samplesPerTick(0),
+		_renderAhead(0),
 		_baseFreq(250) {
 	}
 
-	// MidiDriver API
-	virtual int open() {
-		_isOpen = true;
-
-		int d = getRate() / _baseFreq;
-		int r = getRate() % _baseFreq;
-
-		// This is equivalent to (getRate() << FIXP_SHIFT) / BASE_FREQ
-		// but less prone to arithmetic overflow.
+	virtual ~MidiDriver_Emulated();
 
-		_samplesPerTick = (d << FIXP_SHIFT) + (r << FIXP_SHIFT) / _baseFreq;
-
-		return 0;
-	}
+	// MidiDriver API
+	virtual int open();
 
 	bool isOpen() const { return _isOpen; }
 
@@ -87,35 +130,36 @@ public:
 		return 1000000 / _baseFreq;
 	}
 
-	// AudioStream API
-	virtual int readBuffer(int16 *data, const int numSamples) {
-		const int stereoFactor = isStereo() ? 2 : 1;
-		int len = numSamples / stereoFactor;
-		int step;
-
-		do {
-			step = len;
-			if (step > (_nextTick >> FIXP_SHIFT))
-				step = (_nextTick >> FIXP_SHIFT);
-
-			generateSamples(data, step);
-
-			_nextTick -= step << FIXP_SHIFT;
-			if (!(_nextTick >> FIXP_SHIFT)) {
-				if (_timerProc)
-					(*_timerProc)(_timerParam);
+	/**
+	 * Render the audio ahead of the mixer, so that a synth which is slow to
+	 * emulate does not hold up the mixer callback.
+	 *
+	 * A thread keeps the given amount of audio rendered, and readBuffer()
+	 * only copies it. If the thread falls behind, readBuffer() renders the
+	 * rest itself. The player's timer callback is called by the
+	 * renderer, at the same samples as before. Messages sent from elsewhere
+	 * are delayed by the render ahead time and played at the sample they
+	 * were sent at.
+	 *
+	 * open() sets up rendering ahead from the midi_render_ahead setting.
+	 * Subclasses have to call setRenderAhead(0) in close(), before they
+	 * tear down the synth.
+	 *
+	 * @param msecs the time to render ahead, up to kMaxRenderAhead, or 0 to
+	 *              render in the mixer callback (the default)
+	 * @return true on success, false if the driver is not open or does not
+	 *         support rendering ahead, or if the backend has no threads
+	 */
+	bool setRenderAhead(uint msecs);
+
+	/**
+	 * Returns the time rendered ahead, in milliseconds.
+	 * @see setRenderAhead()
+	 */
+	uint getRenderAhead() const;
 
-				onTimer();
-
-				_nextTick += _samplesPerTick;
-			}
-
-			data += step * stereoFactor;
-			len -= step;
-		} while (len);
-
-		return numSamples;
-	}
+	// AudioStream API
+	virtual int readBuffer(int16 *data, const int numSamples);
 
 	virtual bool endOfData() const {
 		return false;
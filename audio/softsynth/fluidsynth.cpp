@@ -53,6 +53,12 @@ protected:
 
 	void generateSamples(int16 *buf, int len);
 
+	// After open(), the synth is only touched by processEvent() and
+	// generateSamples(), which run on the renderer when rendering ahead.
+	// Everything else reaches it through send().
+	bool supportsRenderAhead() const { return true; }
+	void processEvent(uint32 b);
+
 public:
 	MidiDriver_FluidSynth(Audio::Mixer *mixer);
 
@@ -208,6 +214,7 @@ void MidiDriver_FluidSynth::close() {
 		return;
 	_isOpen = false;
 
+	setRenderAhead(0);
 	_mixer->stopHandle(_mixerSoundHandle);
 
 	if (_soundFont != -1)
@@ -218,6 +225,11 @@ void MidiDriver_FluidSynth::close() {
 }
 
 void MidiDriver_FluidSynth::send(uint32 b) {
+	if (!queueEvent(b))
+		processEvent(b);
+}
+
+void MidiDriver_FluidSynth::processEvent(uint32 b) {
 	//byte param3 = (byte) ((b >> 24) & 0xFF);
 	uint param2 = (byte) ((b >> 16) & 0xFF);
 	uint param1 = (byte) ((b >>  8) & 0xFF);
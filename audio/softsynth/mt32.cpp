@@ -116,6 +116,13 @@ private:
 protected:
 	void generateSamples(int16 *buf, int len);
 
+	// After open(), the synth is only touched by processEvent(),
+	// processSysEx() and generateSamples(), which run on the renderer when
+	// rendering ahead. Everything else reaches it through send() and sysEx().
+	bool supportsRenderAhead() const { return true; }
+	void processEvent(uint32 b);
+	void processSysEx(const byte *msg, uint16 length);
+
 public:
 	MidiDriver_MT32(Audio::Mixer *mixer);
 	virtual ~MidiDriver_MT32();
@@ -227,6 +234,11 @@ int MidiDriver_MT32::open() {
 }
 
 void MidiDriver_MT32::send(uint32 b) {
+	if (!queueEvent(b))
+		processEvent(b);
+}
+
+void MidiDriver_MT32::processEvent(uint32 b) {
 	Common::StackLock lock(_mutex);
 	_service.playMsg(b);
 }
@@ -237,12 +249,19 @@ void MidiDriver_MT32::setPitchBendRange(byte channel, uint range) {
 	if (range > 24) {
 		warning("setPitchBendRange() called with range > 24: %d", range);
 	}
-	byte benderRangeSysex[4] = { 0, 0, 4, (uint8)range };
-	Common::StackLock lock(_mutex);
-	_service.writeSysex(channel, benderRangeSysex, 4);
+
+	// Send it as a DT1 message, so that it is queued like the other
+	// messages when rendering ahead. processSysEx() skips the checksum.
+	const byte benderRangeSysex[9] = { 0x41, channel, 0x16, 0x12, 0, 0, 4, (uint8)range, 0 };
+	sysEx(benderRangeSysex, sizeof(benderRangeSysex));
 }
 
 void MidiDriver_MT32::sysEx(const byte *msg, uint16 length) {
+	if (!queueSysEx(msg, length))
+		processSysEx(msg, length);
+}
+
+void MidiDriver_MT32::processSysEx(const byte *msg, uint16 length) {
 	if (msg[0] == 0xf0) {
 		Common::StackLock lock(_mutex);
 		_service.playSysex(msg, length);
@@ -266,6 +285,8 @@ void MidiDriver_MT32::close() {
 		return;
 	_isOpen = false;
 
+	// Stop the renderer, which calls the player callback handler
+	setRenderAhead(0);
 	// Detach the player callback handler
 	setTimerCallback(NULL, NULL);
 	// Detach the mixer callback handler
@@ -314,121 +335,6 @@ MidiChannel *MidiDriver_MT32::getPercussionChannel() {
 	return &_midiChannels[9];
 }
 
-// This code should be used when calling the timer callback from the mixer thread is undesirable.
-// Note that it results in less accurate timing.
-#if 0
-class MidiEvent_MT32 {
-public:
-	MidiEvent_MT32 *_next;
-	uint32 _msg; // 0xFFFFFFFF indicates a sysex message
-	byte *_data;
-	uint32 _len;
-
-	MidiEvent_MT32(uint32 msg, byte *data, uint32 len) {
-		_msg = msg;
-		if (len > 0) {
-			_data = new byte[len];
-			memcpy(_data, data, len);
-		}
-		_len = len;
-		_next = NULL;
-	}
-
-	MidiEvent_MT32() {
-		if (_len > 0)
-			delete _data;
-	}
-};
-
-class MidiDriver_ThreadedMT32 : public MidiDriver_MT32 {
-private:
-	OSystem::Mutex _eventMutex;
-	MidiEvent_MT32 *_events;
-	TimerManager::TimerProc _timer_proc;
-
-	void pushMidiEvent(MidiEvent_MT32 *event);
-	MidiEvent_MT32 *popMidiEvent();
-
-protected:
-	void send(uint32 b);
-	void sysEx(const byte *msg, uint16 length);
-
-public:
-	MidiDriver_ThreadedMT32(Audio::Mixer *mixer);
-
-	void onTimer();
-	void close();
-	void setTimerCallback(void *timer_param, TimerManager::TimerProc timer_proc);
-};
-
-
-MidiDriver_ThreadedMT32::MidiDriver_ThreadedMT32(Audio::Mixer *mixer) : MidiDriver_MT32(mixer) {
-	_events = NULL;
-	_timer_proc = NULL;
-}
-
-void MidiDriver_ThreadedMT32::close() {
-	MidiDriver_MT32::close();
-	while ((popMidiEvent() != NULL)) {
-		// Just eat any leftover events
-	}
-}
-
-void MidiDriver_ThreadedMT32::setTimerCallback(void *timer_param, TimerManager::TimerProc timer_proc) {
-	if (!_timer_proc || !timer_proc) {
-		if (_timer_proc)
-			_vm->_timer->removeTimerProc(_timer_proc);
-		_timer_proc = timer_proc;
-		if (timer_proc)
-			_vm->_timer->installTimerProc(timer_proc, getBaseTempo(), timer_param, "MT32tempo");
-	}
-}
-
-void MidiDriver_ThreadedMT32::pushMidiEvent(MidiEvent_MT32 *event) {
-	Common::StackLock lock(_eventMutex);
-	if (_events == NULL) {
-		_events = event;
-	} else {
-		MidiEvent_MT32 *last = _events;
-		while (last->_next != NULL)
-			last = last->_next;
-		last->_next = event;
-	}
-}
-
-MidiEvent_MT32 *MidiDriver_ThreadedMT32::popMidiEvent() {
-	Common::StackLock lock(_eventMutex);
-	MidiEvent_MT32 *event;
-	event = _events;
-	if (event != NULL)
-		_events = event->_next;
-	return event;
-}
-
-void MidiDriver_ThreadedMT32::send(uint32 b) {
-	MidiEvent_MT32 *event = new MidiEvent_MT32(b, NULL, 0);
-	pushMidiEvent(event);
-}
-
-void MidiDriver_ThreadedMT32::sysEx(const byte *msg, uint16 length) {
-	MidiEvent_MT32 *event = new MidiEvent_MT32(0xFFFFFFFF, msg, length);
-	pushMidiEvent(event);
-}
-
-void MidiDriver_ThreadedMT32::onTimer() {
-	MidiEvent_MT32 *event;
-	while ((event = popMidiEvent()) != NULL) {
-		if (event->_msg == 0xFFFFFFFF) {
-			MidiDriver_MT32::sysEx(event->_data, event->_len);
-		} else {
-			MidiDriver_MT32::send(event->_msg);
-		}
-		delete event;
-	}
-}
-#endif
-
-
 // Plugin interface
 
 class MT32EmuMusicPlugin : public MusicPluginObject {
@@ -35,6 +35,7 @@
 // Last synch with DOSBox SVN trunk r3752
 
 #include "dbopl.h"
+#include "dbopl_block.h"
 
 #ifndef DISABLE_DOSBOX_OPL
 
@@ -146,7 +147,8 @@ static Bit16u SinTable[ 512 ];
 
 //6 is just 0 shifted and masked
 
-static Bit16s WaveTable[ 8 * 512 ];
+//Padded with an entry, for the block kernels which read 2 entries at once
+static Bit16s WaveTable[ 8 * 512 + 1 ];
 //Distance into WaveTable the wave starts
 static const Bit16u WaveBaseTable[8] = {
 	0x000, 0x200, 0x200, 0x800,
@@ -167,7 +169,7 @@ static const Bit16u WaveStartTable[8] = {
 #endif
 
 #if ( DBOPL_WAVE == WAVE_TABLEMUL )
-static Bit16u MulTable[ 384 ];
+static Bit16u MulTable[ 384 + 1 ];
 #endif
 
 static Bit8u KslTable[ 8 * 16 ];
@@ -1025,6 +1027,23 @@ Chip::Chip() {
 	regBD = 0;
 	reg104 = 0;
 	opl3Active = 0;
+#if ( DBOPL_WAVE == WAVE_TABLEMUL )
+	blockKernel = GetDefaultBlockKernel();
+#else
+	blockKernel = kBlockKernelScalar;
+#endif
+}
+
+bool Chip::SetBlockKernel( BlockKernel kernel ) {
+	if ( !IsBlockKernelSupported( kernel ) )
+		return false;
+#if ( DBOPL_WAVE != WAVE_TABLEMUL )
+	//The block kernels only implement the multiplication table wave generator
+	if ( kernel != kBlockKernelScalar )
+		return false;
+#endif
+	blockKernel = kernel;
+	return true;
 }
 
 INLINE Bit32u Chip::ForwardNoise() {
@@ -1220,14 +1239,130 @@ Bit32u Chip::WriteAddr( Bit32u port, Bit8u val ) {
 	return 0;
 }
 
+#if ( DBOPL_WAVE == WAVE_TABLEMUL )
+
+//Copy the state of an operator into a lane of the block kernels and back
+static inline void GatherOperator( BlockLanes::Operators& lanes, Bitu n, const Operator* op ) {
+	lanes.waveIndex[n] = op->waveIndex;
+	lanes.waveCurrent[n] = op->waveCurrent;
+	lanes.waveBase[n] = op->waveBase - WaveTable;
+	lanes.waveMask[n] = op->waveMask;
+	lanes.currentLevel[n] = op->currentLevel;
+	lanes.volume[n] = op->volume;
+	lanes.rateIndex[n] = op->rateIndex;
+	lanes.state[n] = op->state;
+	lanes.attackAdd[n] = op->attackAdd;
+	lanes.decayAdd[n] = op->decayAdd;
+	lanes.releaseAdd[n] = op->releaseAdd;
+	lanes.sustainLevel[n] = op->sustainLevel;
+	lanes.sustainHold[n] = ( op->reg20 & Operator::MASK_SUSTAIN ) ? -1 : 0;
+}
+
+static inline void ScatterOperator( const BlockLanes::Operators& lanes, Bitu n, Operator* op ) {
+	op->waveIndex = lanes.waveIndex[n];
+	op->volume = lanes.volume[n];
+	op->rateIndex = lanes.rateIndex[n];
+	if ( op->state != lanes.state[n] ) {
+		op->state = (Bit8u)lanes.state[n];
+		op->volHandler = VolumeHandlerTable[ op->state ];
+	}
+}
+
+//A lane which stays silent and adds nothing to the output
+static inline void ClearLane( BlockLanes& lanes, Bitu n ) {
+	for ( int i = 0; i < 2; i++ ) {
+		BlockLanes::Operators& op = lanes.op[i];
+		op.waveIndex[n] = op.waveCurrent[n] = 0;
+		op.waveBase[n] = 0;
+		op.waveMask[n] = 0;
+		op.currentLevel[n] = ENV_MAX;
+		op.volume[n] = ENV_MAX;
+		op.rateIndex[n] = 0;
+		op.state[n] = Operator::OFF;
+		op.attackAdd[n] = op.decayAdd[n] = op.releaseAdd[n] = 0;
+		op.sustainLevel[n] = ENV_MAX;
+		op.sustainHold[n] = 0;
+	}
+	lanes.old0[n] = lanes.old1[n] = 0;
+	lanes.feedback[n] = 31;
+	lanes.am[n] = 0;
+	lanes.maskLeft[n] = lanes.maskRight[n] = 0;
+}
+
+template< bool opl3Mode >
+void Chip::GenerateChannels( Bit32u samples, Bit32s* output ) {
+	STATIC_ASSERT( BLOCK_WAVE_SH == WAVE_SH && BLOCK_RATE_SH == RATE_SH && BLOCK_MUL_SH == MUL_SH, block_kernel_shifts_match );
+	STATIC_ASSERT( BLOCK_ENV_MAX == ENV_MAX && BLOCK_ENV_LIMIT == ENV_LIMIT && ENV_EXTRA == 0, block_kernel_envelope_matches );
+
+	const SynthHandler amHandler = opl3Mode ? &Channel::BlockTemplate< sm3AM > : &Channel::BlockTemplate< sm2AM >;
+	const SynthHandler fmHandler = opl3Mode ? &Channel::BlockTemplate< sm3FM > : &Channel::BlockTemplate< sm2FM >;
+	const int channels = opl3Mode ? 18 : 9;
+
+	BlockLanes lanes;
+	Channel* batched[ BlockLanes::MAX_LANES ];
+	Bitu count = 0;
+
+	//Generate the other channels right away, and take over the checks
+	//BlockTemplate does before generating for the 2 operator ones
+	for ( Channel* ch = chan; ch < chan + channels; ) {
+		const bool am = ch->synthHandler == amHandler;
+		if ( !am && ch->synthHandler != fmHandler ) {
+			ch = (ch->*(ch->synthHandler))( this, samples, output );
+			continue;
+		}
+		if ( ( am && ch->Op(0)->Silent() && ch->Op(1)->Silent() ) || ( !am && ch->Op(1)->Silent() ) ) {
+			ch->old[0] = ch->old[1] = 0;
+			ch++;
+			continue;
+		}
+		ch->Op(0)->Prepare( this );
+		ch->Op(1)->Prepare( this );
+
+		GatherOperator( lanes.op[0], count, ch->Op(0) );
+		GatherOperator( lanes.op[1], count, ch->Op(1) );
+		lanes.old0[count] = ch->old[0];
+		lanes.old1[count] = ch->old[1];
+		lanes.feedback[count] = ch->feedback;
+		lanes.am[count] = am ? -1 : 0;
+		lanes.maskLeft[count] = opl3Mode ? ch->maskLeft : -1;
+		lanes.maskRight[count] = opl3Mode ? ch->maskRight : -1;
+		batched[count++] = ch;
+		ch++;
+	}
+	if ( !count )
+		return;
+
+	lanes.count = ( count + BlockLanes::LANE_GROUP - 1 ) & ~( BlockLanes::LANE_GROUP - 1 );
+	for ( Bitu n = count; n < lanes.count; n++ ) {
+		ClearLane( lanes, n );
+	}
+
+	GetBlockLanesProc( blockKernel )( lanes, WaveTable, MulTable, samples, output, opl3Mode );
+
+	for ( Bitu n = 0; n < count; n++ ) {
+		Channel* ch = batched[n];
+		ScatterOperator( lanes.op[0], n, ch->Op(0) );
+		ScatterOperator( lanes.op[1], n, ch->Op(1) );
+		ch->old[0] = lanes.old0[n];
+		ch->old[1] = lanes.old1[n];
+	}
+}
+
+#endif
+
 void Chip::GenerateBlock2( Bitu total, Bit32s* output ) {
 	while ( total > 0 ) {
 		Bit32u samples = ForwardLFO( total );
 		memset(output, 0, sizeof(Bit32s) * samples);
-		int count = 0;
-		for( Channel* ch = chan; ch < chan + 9; ) {
-			count++;
-			ch = (ch->*(ch->synthHandler))( this, samples, output );
+#if ( DBOPL_WAVE == WAVE_TABLEMUL )
+		if ( blockKernel != kBlockKernelScalar ) {
+			GenerateChannels< false >( samples, output );
+		} else
+#endif
+		{
+			for( Channel* ch = chan; ch < chan + 9; ) {
+				ch = (ch->*(ch->synthHandler))( this, samples, output );
+			}
 		}
 		total -= samples;
 		output += samples;
@@ -1238,10 +1373,15 @@ void Chip::GenerateBlock3( Bitu total, Bit32s* output  ) {
 	while ( total > 0 ) {
 		Bit32u samples = ForwardLFO( total );
 		memset(output, 0, sizeof(Bit32s) * samples * 2);
-		int count = 0;
-		for( Channel* ch = chan; ch < chan + 18; ) {
-			count++;
-			ch = (ch->*(ch->synthHandler))( this, samples, output );
+#if ( DBOPL_WAVE == WAVE_TABLEMUL )
+		if ( blockKernel != kBlockKernelScalar ) {
+			GenerateChannels< true >( samples, output );
+		} else
+#endif
+		{
+			for( Channel* ch = chan; ch < chan + 18; ) {
+				ch = (ch->*(ch->synthHandler))( this, samples, output );
+			}
 		}
 		total -= samples;
 		output += samples * 2;
@@ -91,6 +91,15 @@ enum {
 	SHIFT_KEYCODE = 24
 };
 
+//Ways to generate the 2 operator channels, see dbopl_block.h
+enum BlockKernel {
+	kBlockKernelScalar = 0,		//One channel after the other, with BlockTemplate
+	kBlockKernelBatched,		//All channels at once, portable code
+	kBlockKernelAVX2,			//All channels at once, 8 at a time with AVX2
+
+	kBlockKernelCount
+};
+
 struct Operator {
 public:
 	//Masks for operator 20 values
@@ -253,6 +262,8 @@ struct Chip {
 	Bit8u waveFormMask;
 	//0 or -1 when enabled
 	Bit8s opl3Active;
+	//How the 2 operator channels are generated
+	BlockKernel blockKernel;
 
 	//Return the maximum amount of samples before and LFO change
 	Bit32u ForwardLFO( Bit32u samples );
@@ -263,9 +274,17 @@ struct Chip {
 
 	Bit32u WriteAddr( Bit32u port, Bit8u val );
 
+	//Generate all channels, with the 2 operator ones batched by the block kernel
+	template< bool opl3Mode >
+	void GenerateChannels( Bit32u samples, Bit32s* output );
+
 	void GenerateBlock2( Bitu samples, Bit32s* output );
 	void GenerateBlock3( Bitu samples, Bit32s* output );
 
+	//Select how the 2 operator channels are generated, returns false if the
+	//kernel is not supported on this machine
+	bool SetBlockKernel( BlockKernel kernel );
+
 	void Generate( Bit32u samples );
 	void Setup( Bit32u r );
 
@@ -0,0 +1,374 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+/*
+ * Generators for the 2 operator channels of the DOSBox OPL emulator, which
+ * process all channels of a chip at once.
+ *
+ * Channel::BlockTemplate generates one channel after the other, and steps
+ * through the envelope state machine of each operator with a member function
+ * pointer per sample. Here the envelope is written without branches, using
+ * masks, so the same code runs for every lane. The portable version keeps
+ * the loops over a lane group simple enough for the compiler to vectorize.
+ * The AVX2 version does this by hand, and uses gathers for the table
+ * lookups and per lane shifts for the feedback.
+ *
+ * Both must produce bit-identical output to Channel::BlockTemplate;
+ * test/audio/dbopl.h replays a register log to check this.
+ */
+
+#include "audio/softsynth/opl/dbopl_block.h"
+
+#ifndef DISABLE_DOSBOX_OPL
+
+#include "common/cpudetect.h"
+#include "common/util.h"
+
+namespace OPL {
+namespace DOSBox {
+namespace DBOPL {
+
+enum {
+	RATE_MASK = ( 1 << BLOCK_RATE_SH ) - 1
+};
+
+#pragma mark --- Portable ---
+
+//Advance the envelope of the operators in a lane group, like
+//Operator::TemplateVolume, and return the volume it produced
+static inline void EnvelopeBatched( BlockLanes::Operators& op, Bitu g, Bit32s* env ) {
+	for ( Bitu l = 0; l < BlockLanes::LANE_GROUP; l++ ) {
+		const Bitu n = g + l;
+		const Bit32s state = op.state[n];
+		const Bit32s isOff = -( state == Operator::OFF );
+		const Bit32s isAttack = -( state == Operator::ATTACK );
+		const Bit32s isDecay = -( state == Operator::DECAY );
+		//Sustain without MASK_SUSTAIN does a regular release
+		const Bit32s isRelease = -( state == Operator::RELEASE ) | ( -( state == Operator::SUSTAIN ) & ~op.sustainHold[n] );
+		const Bit32s advance = isAttack | isDecay | isRelease;
+
+		//RateForward, only for the states which call it
+		const Bit32u add = ( op.attackAdd[n] & isAttack ) | ( op.decayAdd[n] & isDecay ) | ( op.releaseAdd[n] & isRelease );
+		const Bit32u sum = op.rateIndex[n] + add;
+		const Bit32s change = ( sum >> BLOCK_RATE_SH ) & advance;
+		Bit32u rate = ( sum & RATE_MASK & advance ) | ( op.rateIndex[n] & ~advance );
+
+		const Bit32s vol = op.volume[n];
+		const Bit32s attackVol = vol + ( ( ( ~vol ) * change ) >> 3 );
+		const Bit32s attackDone = isAttack & -( change != 0 ) & -( attackVol < 0 );
+		const Bit32s linearVol = vol + change;
+		const Bit32s decayDone = isDecay & -( linearVol >= op.sustainLevel[n] );
+		const Bit32s reachedMax = -( linearVol >= BLOCK_ENV_MAX );
+		const Bit32s toOff = ( decayDone | isRelease ) & reachedMax;
+		const Bit32s toSustain = decayDone & ~reachedMax;
+
+		Bit32s newVol = ( attackVol & isAttack & ~attackDone ) | ( vol & ~advance );
+		newVol |= ( linearVol & ( isDecay | isRelease ) & ~toOff ) | ( BLOCK_ENV_MAX & toOff );
+
+		Bit32s newState = ( Operator::DECAY & attackDone ) | ( Operator::SUSTAIN & toSustain );
+		newState |= state & ~( attackDone | toOff | toSustain );
+		rate &= ~( attackDone | toSustain );
+
+		op.volume[n] = newVol;
+		op.state[n] = newState;
+		op.rateIndex[n] = rate;
+		env[l] = ( BLOCK_ENV_MAX & isOff ) | ( newVol & ~isOff );
+	}
+}
+
+//Generate a sample for the operators in a lane group, like Operator::GetSample
+static inline void OperatorBatched( BlockLanes::Operators& op, Bitu g, const Bit32s* mod, Bit32s* out, const Bit16s* waveTable, const Bit16u* mulTable ) {
+	Bit32s env[BlockLanes::LANE_GROUP];
+	EnvelopeBatched( op, g, env );
+
+	for ( Bitu l = 0; l < BlockLanes::LANE_GROUP; l++ ) {
+		const Bitu n = g + l;
+		const Bit32u total = op.currentLevel[n] + env[l];
+		const Bit32s silent = -( total >= BLOCK_ENV_LIMIT );
+		const Bit32u mulIndex = silent ? BLOCK_ENV_LIMIT - 1 : total;
+		op.waveIndex[n] += op.waveCurrent[n];
+		const Bit32u index = ( ( op.waveIndex[n] >> BLOCK_WAVE_SH ) + mod[l] ) & op.waveMask[n];
+		out[l] = ( ( waveTable[ op.waveBase[n] + index ] * mulTable[ mulIndex ] ) >> BLOCK_MUL_SH ) & ~silent;
+	}
+}
+
+static void GenerateLanesBatched( BlockLanes& lanes, const Bit16s* waveTable, const Bit16u* mulTable, Bitu samples, Bit32s* output, bool stereo ) {
+	for ( Bitu g = 0; g < lanes.count; g += BlockLanes::LANE_GROUP ) {
+		for ( Bitu i = 0; i < samples; i++ ) {
+			Bit32s mod[BlockLanes::LANE_GROUP];
+			Bit32s out[BlockLanes::LANE_GROUP];
+
+			for ( Bitu l = 0; l < BlockLanes::LANE_GROUP; l++ ) {
+				const Bitu n = g + l;
+				mod[l] = ( (Bit32u)lanes.old0[n] + (Bit32u)lanes.old1[n] ) >> lanes.feedback[n];
+			}
+			OperatorBatched( lanes.op[0], g, mod, out, waveTable, mulTable );
+
+			//AM channels add the first operator, FM channels modulate with it
+			for ( Bitu l = 0; l < BlockLanes::LANE_GROUP; l++ ) {
+				const Bitu n = g + l;
+				lanes.old0[n] = lanes.old1[n];
+				lanes.old1[n] = out[l];
+				mod[l] = lanes.old0[n] & ~lanes.am[n];
+			}
+			OperatorBatched( lanes.op[1], g, mod, out, waveTable, mulTable );
+
+			Bit32s left = 0, right = 0;
+			for ( Bitu l = 0; l < BlockLanes::LANE_GROUP; l++ ) {
+				const Bitu n = g + l;
+				const Bit32s sample = out[l] + ( lanes.old0[n] & lanes.am[n] );
+				left += sample & lanes.maskLeft[n];
+				right += sample & lanes.maskRight[n];
+			}
+			if ( stereo ) {
+				output[ i * 2 + 0 ] += left;
+				output[ i * 2 + 1 ] += right;
+			} else {
+				output[ i ] += left;
+			}
+		}
+	}
+}
+
+#pragma mark --- AVX2 ---
+
+#ifdef SCUMMVM_AVX2
+
+//The state of the operators of a lane group, kept in registers while
+//generating a block
+struct OperatorsAVX2 {
+	__m256i waveIndex, waveCurrent, waveBase, waveMask, currentLevel;
+	__m256i volume, rateIndex, state;
+	__m256i attackAdd, decayAdd, releaseAdd, sustainLevel, sustainHold;
+};
+
+#define LOAD_LANES( _ARRAY_ ) _mm256_loadu_si256( (const __m256i *)( ( _ARRAY_ ) + g ) )
+#define STORE_LANES( _ARRAY_, _VALUE_ ) _mm256_storeu_si256( (__m256i *)( ( _ARRAY_ ) + g ), ( _VALUE_ ) )
+
+TARGET_ATTR("avx2")
+static inline void LoadOperatorsAVX2( OperatorsAVX2& r, const BlockLanes::Operators& op, Bitu g ) {
+	r.waveIndex = LOAD_LANES( op.waveIndex );
+	r.waveCurrent = LOAD_LANES( op.waveCurrent );
+	r.waveBase = LOAD_LANES( op.waveBase );
+	r.waveMask = LOAD_LANES( op.waveMask );
+	r.currentLevel = LOAD_LANES( op.currentLevel );
+	r.volume = LOAD_LANES( op.volume );
+	r.rateIndex = LOAD_LANES( op.rateIndex );
+	r.state = LOAD_LANES( op.state );
+	r.attackAdd = LOAD_LANES( op.attackAdd );
+	r.decayAdd = LOAD_LANES( op.decayAdd );
+	r.releaseAdd = LOAD_LANES( op.releaseAdd );
+	r.sustainLevel = LOAD_LANES( op.sustainLevel );
+	r.sustainHold = LOAD_LANES( op.sustainHold );
+}
+
+TARGET_ATTR("avx2")
+static inline void StoreOperatorsAVX2( const OperatorsAVX2& r, BlockLanes::Operators& op, Bitu g ) {
+	STORE_LANES( op.waveIndex, r.waveIndex );
+	STORE_LANES( op.volume, r.volume );
+	STORE_LANES( op.rateIndex, r.rateIndex );
+	STORE_LANES( op.state, r.state );
+}
+
+TARGET_ATTR("avx2")
+static inline __m256i OperatorAVX2( OperatorsAVX2& op, __m256i mod, const Bit16s* waveTable, const Bit16u* mulTable ) {
+	const __m256i envMax = _mm256_set1_epi32( BLOCK_ENV_MAX );
+
+	//The envelope, see EnvelopeBatched
+	const __m256i isOff = _mm256_cmpeq_epi32( op.state, _mm256_set1_epi32( Operator::OFF ) );
+	const __m256i isAttack = _mm256_cmpeq_epi32( op.state, _mm256_set1_epi32( Operator::ATTACK ) );
+	const __m256i isDecay = _mm256_cmpeq_epi32( op.state, _mm256_set1_epi32( Operator::DECAY ) );
+	const __m256i isSustain = _mm256_cmpeq_epi32( op.state, _mm256_set1_epi32( Operator::SUSTAIN ) );
+	const __m256i isRelease = _mm256_or_si256( _mm256_cmpeq_epi32( op.state, _mm256_set1_epi32( Operator::RELEASE ) ),
+		_mm256_andnot_si256( op.sustainHold, isSustain ) );
+	const __m256i isLinear = _mm256_or_si256( isDecay, isRelease );
+	const __m256i advance = _mm256_or_si256( isAttack, isLinear );
+
+	__m256i add = _mm256_and_si256( op.attackAdd, isAttack );
+	add = _mm256_or_si256( add, _mm256_and_si256( op.decayAdd, isDecay ) );
+	add = _mm256_or_si256( add, _mm256_and_si256( op.releaseAdd, isRelease ) );
+	const __m256i sum = _mm256_add_epi32( op.rateIndex, add );
+	const __m256i change = _mm256_and_si256( _mm256_srli_epi32( sum, BLOCK_RATE_SH ), advance );
+	__m256i rate = _mm256_blendv_epi8( op.rateIndex, _mm256_and_si256( sum, _mm256_set1_epi32( RATE_MASK ) ), advance );
+
+	const __m256i vol = op.volume;
+	const __m256i notVol = _mm256_xor_si256( vol, _mm256_set1_epi32( -1 ) );
+	const __m256i attackVol = _mm256_add_epi32( vol, _mm256_srai_epi32( _mm256_mullo_epi32( notVol, change ), 3 ) );
+	const __m256i changed = _mm256_xor_si256( _mm256_cmpeq_epi32( change, _mm256_setzero_si256() ), _mm256_set1_epi32( -1 ) );
+	const __m256i attackDone = _mm256_and_si256( _mm256_and_si256( isAttack, changed ),
+		_mm256_cmpgt_epi32( _mm256_setzero_si256(), attackVol ) );
+	const __m256i linearVol = _mm256_add_epi32( vol, change );
+	const __m256i decayDone = _mm256_andnot_si256( _mm256_cmpgt_epi32( op.sustainLevel, linearVol ), isDecay );
+	const __m256i reachedMax = _mm256_cmpgt_epi32( linearVol, _mm256_set1_epi32( BLOCK_ENV_MAX - 1 ) );
+	const __m256i toOff = _mm256_and_si256( _mm256_or_si256( decayDone, isRelease ), reachedMax );
+	const __m256i toSustain = _mm256_andnot_si256( reachedMax, decayDone );
+
+	__m256i newVol = _mm256_blendv_epi8( vol, attackVol, isAttack );
+	newVol = _mm256_andnot_si256( attackDone, newVol );
+	newVol = _mm256_blendv_epi8( newVol, linearVol, isLinear );
+	newVol = _mm256_blendv_epi8( newVol, envMax, toOff );
+
+	__m256i state = _mm256_blendv_epi8( op.state, _mm256_set1_epi32( Operator::DECAY ), attackDone );
+	state = _mm256_blendv_epi8( state, _mm256_set1_epi32( Operator::OFF ), toOff );
+	state = _mm256_blendv_epi8( state, _mm256_set1_epi32( Operator::SUSTAIN ), toSustain );
+	rate = _mm256_andnot_si256( _mm256_or_si256( attackDone, toSustain ), rate );
+
+	op.volume = newVol;
+	op.state = state;
+	op.rateIndex = rate;
+	const __m256i env = _mm256_blendv_epi8( newVol, envMax, isOff );
+
+	//The wave, see OperatorBatched
+	const __m256i total = _mm256_add_epi32( op.currentLevel, env );
+	const __m256i silent = _mm256_cmpgt_epi32( total, _mm256_set1_epi32( BLOCK_ENV_LIMIT - 1 ) );
+	const __m256i mulIndex = _mm256_min_epu32( total, _mm256_set1_epi32( BLOCK_ENV_LIMIT - 1 ) );
+	op.waveIndex = _mm256_add_epi32( op.waveIndex, op.waveCurrent );
+	__m256i index = _mm256_add_epi32( _mm256_srli_epi32( op.waveIndex, BLOCK_WAVE_SH ), mod );
+	index = _mm256_add_epi32( _mm256_and_si256( index, op.waveMask ), op.waveBase );
+
+	//The tables hold 16 bit values, so gather 32 bits and use the lower
+	//half. The tables are padded so that this never reads past the end.
+	__m256i wave = _mm256_i32gather_epi32( (const int *)waveTable, index, 2 );
+	wave = _mm256_srai_epi32( _mm256_slli_epi32( wave, 16 ), 16 );
+	__m256i mul = _mm256_i32gather_epi32( (const int *)mulTable, mulIndex, 2 );
+	mul = _mm256_and_si256( mul, _mm256_set1_epi32( 0xffff ) );
+
+	const __m256i out = _mm256_srai_epi32( _mm256_mullo_epi32( wave, mul ), BLOCK_MUL_SH );
+	return _mm256_andnot_si256( silent, out );
+}
+
+TARGET_ATTR("avx2")
+static inline Bit32s HorizontalSumAVX2( __m256i v ) {
+	__m128i s = _mm_add_epi32( _mm256_castsi256_si128( v ), _mm256_extracti128_si256( v, 1 ) );
+	s = _mm_add_epi32( s, _mm_shuffle_epi32( s, 0x4e ) );
+	s = _mm_add_epi32( s, _mm_shuffle_epi32( s, 0xb1 ) );
+	return _mm_cvtsi128_si32( s );
+}
+
+TARGET_ATTR("avx2")
+static void GenerateLanesAVX2( BlockLanes& lanes, const Bit16s* waveTable, const Bit16u* mulTable, Bitu samples, Bit32s* output, bool stereo ) {
+	//The lane groups are summed up per sample first, so the horizontal sum
+	//is only done once per sample
+	enum { CHUNK = 64 };
+	__m256i left[CHUNK], right[CHUNK];
+
+	for ( Bitu start = 0; start < samples; start += CHUNK ) {
+		const Bitu count = MIN<Bitu>( samples - start, (Bitu)CHUNK );
+		for ( Bitu i = 0; i < count; i++ ) {
+			left[i] = right[i] = _mm256_setzero_si256();
+		}
+
+		for ( Bitu g = 0; g < lanes.count; g += BlockLanes::LANE_GROUP ) {
+			OperatorsAVX2 op0, op1;
+			LoadOperatorsAVX2( op0, lanes.op[0], g );
+			LoadOperatorsAVX2( op1, lanes.op[1], g );
+			__m256i old0 = LOAD_LANES( lanes.old0 );
+			__m256i old1 = LOAD_LANES( lanes.old1 );
+			const __m256i feedback = LOAD_LANES( lanes.feedback );
+			const __m256i am = LOAD_LANES( lanes.am );
+			const __m256i maskLeft = LOAD_LANES( lanes.maskLeft );
+			const __m256i maskRight = LOAD_LANES( lanes.maskRight );
+
+			for ( Bitu i = 0; i < count; i++ ) {
+				const __m256i mod = _mm256_srlv_epi32( _mm256_add_epi32( old0, old1 ), feedback );
+				old0 = old1;
+				old1 = OperatorAVX2( op0, mod, waveTable, mulTable );
+
+				__m256i sample = OperatorAVX2( op1, _mm256_andnot_si256( am, old0 ), waveTable, mulTable );
+				sample = _mm256_add_epi32( sample, _mm256_and_si256( old0, am ) );
+
+				left[i] = _mm256_add_epi32( left[i], _mm256_and_si256( sample, maskLeft ) );
+				if ( stereo )
+					right[i] = _mm256_add_epi32( right[i], _mm256_and_si256( sample, maskRight ) );
+			}
+
+			StoreOperatorsAVX2( op0, lanes.op[0], g );
+			StoreOperatorsAVX2( op1, lanes.op[1], g );
+			STORE_LANES( lanes.old0, old0 );
+			STORE_LANES( lanes.old1, old1 );
+		}
+
+		for ( Bitu i = 0; i < count; i++ ) {
+			if ( stereo ) {
+				output[ ( start + i ) * 2 + 0 ] += HorizontalSumAVX2( left[i] );
+				output[ ( start + i ) * 2 + 1 ] += HorizontalSumAVX2( right[i] );
+			} else {
+				output[ start + i ] += HorizontalSumAVX2( left[i] );
+			}
+		}
+	}
+}
+
+#undef LOAD_LANES
+#undef STORE_LANES
+
+#endif
+
+#pragma mark --- Kernel selection ---
+
+bool IsBlockKernelSupported( BlockKernel kernel ) {
+	switch ( kernel ) {
+	case kBlockKernelScalar:
+	case kBlockKernelBatched:
+		return true;
+
+#ifdef SCUMMVM_AVX2
+	case kBlockKernelAVX2:
+		return Common::hasAVX2();
+#endif
+
+	default:
+		return false;
+	}
+}
+
+BlockLanesProc GetBlockLanesProc( BlockKernel kernel ) {
+	if ( !IsBlockKernelSupported( kernel ) )
+		return 0;
+
+	switch ( kernel ) {
+	case kBlockKernelBatched:
+		return GenerateLanesBatched;
+
+#ifdef SCUMMVM_AVX2
+	case kBlockKernelAVX2:
+		return GenerateLanesAVX2;
+#endif
+
+	default:
+		return 0;
+	}
+}
+
+BlockKernel GetDefaultBlockKernel() {
+	// The portable batched kernel is not faster than generating the
+	// channels one by one, so it is only used when asked for
+	if ( IsBlockKernelSupported( kBlockKernelAVX2 ) )
+		return kBlockKernelAVX2;
+	return kBlockKernelScalar;
+}
+
+}		//Namespace DBOPL
+} // End of namespace DOSBox
+} // End of namespace OPL
+
+#endif // !DISABLE_DOSBOX_OPL
@@ -0,0 +1,124 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef AUDIO_SOFTSYNTH_OPL_DBOPL_BLOCK_H
+#define AUDIO_SOFTSYNTH_OPL_DBOPL_BLOCK_H
+
+#include "audio/softsynth/opl/dbopl.h"
+
+#ifndef DISABLE_DOSBOX_OPL
+
+namespace OPL {
+namespace DOSBox {
+namespace DBOPL {
+
+/**
+ * The constants of dbopl.cpp the lanes are generated with. dbopl.cpp checks
+ * that they match its own.
+ */
+enum {
+	BLOCK_WAVE_SH = 22,
+	BLOCK_RATE_SH = 24,
+	BLOCK_MUL_SH = 16,
+	BLOCK_ENV_MAX = 511,
+	BLOCK_ENV_LIMIT = 384
+};
+
+/**
+ * The 2 operator channels of a chip in structure of arrays form, so that a
+ * block of samples can be generated for all of them at once. Each channel
+ * is one lane, and the lanes are generated in groups of LANE_GROUP.
+ *
+ * Chip::GenerateChannels() copies the state of the operators in, after the
+ * silence check and Operator::Prepare() have been done, and copies it back
+ * afterwards. Unused lanes in the last group are filled with silent
+ * channels which do not change the output.
+ */
+struct BlockLanes {
+	enum {
+		LANE_GROUP = 8,
+		MAX_LANES = 24
+	};
+
+	struct Operators {
+		Bit32u waveIndex[MAX_LANES];
+		Bit32u waveCurrent[MAX_LANES];
+		Bit32u waveBase[MAX_LANES];		//Start of the wave in the wave table
+		Bit32u waveMask[MAX_LANES];
+		Bit32u currentLevel[MAX_LANES];
+		Bit32s volume[MAX_LANES];
+		Bit32u rateIndex[MAX_LANES];
+		Bit32s state[MAX_LANES];		//Operator::State
+		Bit32u attackAdd[MAX_LANES];
+		Bit32u decayAdd[MAX_LANES];
+		Bit32u releaseAdd[MAX_LANES];
+		Bit32s sustainLevel[MAX_LANES];
+		Bit32s sustainHold[MAX_LANES];	//-1 if MASK_SUSTAIN is set, 0 otherwise
+	};
+
+	Operators op[2];
+	Bit32s old0[MAX_LANES];
+	Bit32s old1[MAX_LANES];
+	Bit32u feedback[MAX_LANES];
+	Bit32s am[MAX_LANES];				//-1 for AM channels, 0 for FM channels
+	Bit32s maskLeft[MAX_LANES];
+	Bit32s maskRight[MAX_LANES];
+
+	//Number of lanes in use, a multiple of LANE_GROUP
+	Bitu count;
+};
+
+/**
+ * Generate samples for all lanes and add them to the output, exactly like
+ * Channel::BlockTemplate does for the sm2AM, sm2FM, sm3AM and sm3FM modes.
+ * Channels in the 4 operator and percussion modes are not batched, they are
+ * still generated one by one through their synth handler.
+ *
+ * @param waveTable	the wave table, followed by one padding entry
+ * @param mulTable	the volume table, followed by one padding entry
+ * @param samples	the number of samples to generate
+ * @param output	the output, interleaved if stereo is set
+ * @param stereo	use the sm3 modes, which output stereo with panning
+ */
+typedef void ( *BlockLanesProc )( BlockLanes& lanes, const Bit16s* waveTable, const Bit16u* mulTable, Bitu samples, Bit32s* output, bool stereo );
+
+/**
+ * Query the lane generator of a kernel.
+ *
+ * @return the generator, or 0 for kBlockKernelScalar and for kernels which
+ *         are not usable on this machine
+ */
+BlockLanesProc GetBlockLanesProc( BlockKernel kernel );
+
+/** Check whether a kernel has been compiled in and the CPU supports it. */
+bool IsBlockKernelSupported( BlockKernel kernel );
+
+/** Return the fastest kernel supported by the CPU. */
+BlockKernel GetDefaultBlockKernel();
+
+}		//Namespace DBOPL
+} // End of namespace DOSBox
+} // End of namespace OPL
+
+#endif // !DISABLE_DOSBOX_OPL
+
+#endif
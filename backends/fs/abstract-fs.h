@@ -173,6 +173,20 @@ public:
 	 */
 	virtual bool isWritable() const = 0;
 
+	/**
+	 * Returns the time of the last modification of the object referred by
+	 * this path, in seconds since a backend specific epoch.
+	 *
+	 * Backends which cannot determine it return 0.
+	 */
+	virtual uint32 getModificationTime() const { return 0; }
+
+	/**
+	 * Returns the size of the file referred by this path, in bytes.
+	 *
+	 * Backends which cannot determine it return -1.
+	 */
+	virtual int32 getFileSize() const { return -1; }
 
 	/**
 	 * Creates a SeekableReadStream instance corresponding to the file
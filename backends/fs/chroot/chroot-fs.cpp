@@ -78,6 +78,14 @@ bool ChRootFilesystemNode::isWritable() const {
 	return _realNode->isWritable();
 }
 
+uint32 ChRootFilesystemNode::getModificationTime() const {
+	return _realNode->getModificationTime();
+}
+
+int32 ChRootFilesystemNode::getFileSize() const {
+	return _realNode->getFileSize();
+}
+
 AbstractFSNode *ChRootFilesystemNode::getChild(const Common::String &n) const {
 	return new ChRootFilesystemNode(_root, (POSIXFilesystemNode *)_realNode->getChild(n));
 }
@@ -42,6 +42,8 @@ public:
 	virtual bool isDirectory() const;
 	virtual bool isReadable() const;
 	virtual bool isWritable() const;
+	virtual uint32 getModificationTime() const;
+	virtual int32 getFileSize() const;
 
 	virtual AbstractFSNode *getChild(const Common::String &n) const;
 	virtual bool getChildren(AbstractFSList &list, ListMode mode, bool hidden) const;
@@ -32,6 +32,9 @@
 
 #include "backends/fs/posix/posix-fs.h"
 #include "backends/fs/stdiostream.h"
+#ifdef POSIX
+#include "backends/fs/posix/posix-mmapstream.h"
+#endif
 #include "common/algorithm.h"
 
 #include <sys/param.h>
@@ -59,6 +62,22 @@ void POSIXFilesystemNode::setFlags() {
 	_isDirectory = _isValid ? S_ISDIR(st.st_mode) : false;
 }
 
+uint32 POSIXFilesystemNode::getModificationTime() const {
+	struct stat st;
+
+	if (stat(_path.c_str(), &st) != 0)
+		return 0;
+	return (uint32)st.st_mtime;
+}
+
+int32 POSIXFilesystemNode::getFileSize() const {
+	struct stat st;
+
+	if (stat(_path.c_str(), &st) != 0 || !S_ISREG(st.st_mode) || st.st_size > 0x7FFFFFFF)
+		return -1;
+	return (int32)st.st_size;
+}
+
 POSIXFilesystemNode::POSIXFilesystemNode(const Common::String &p) {
 	assert(p.size() > 0);
 
@@ -251,6 +270,15 @@ AbstractFSNode *POSIXFilesystemNode::getParent() const {
 }
 
 Common::SeekableReadStream *POSIXFilesystemNode::createReadStream() {
+#ifdef POSIX
+	// Map big files into memory if enabled, so their data can be accessed
+	// without copies
+	if (PosixMmapStream::isEnabled()) {
+		Common::SeekableReadStream *stream = PosixMmapStream::makeFromPath(getPath());
+		if (stream)
+			return stream;
+	}
+#endif
 	return StdioStream::makeFromPath(getPath(), false);
 }
 
@@ -0,0 +1,77 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#if defined(POSIX)
+
+// Disable symbol overrides so that we can use open, close etc.
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+#include "backends/fs/posix/posix-mmapstream.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(_POSIX_MAPPED_FILES) && _POSIX_MAPPED_FILES > 0
+#include <sys/mman.h>
+#define HAVE_MMAP
+#endif
+
+bool PosixMmapStream::_enabled = false;
+
+PosixMmapStream::PosixMmapStream(void *mapping, uint32 mappingSize)
+	: Common::MemoryReadStream((const byte *)mapping, mappingSize, DisposeAfterUse::NO),
+	  _mapping(mapping), _mappingSize(mappingSize) {
+	assert(mapping);
+}
+
+PosixMmapStream::~PosixMmapStream() {
+#ifdef HAVE_MMAP
+	munmap(_mapping, _mappingSize);
+#endif
+}
+
+PosixMmapStream *PosixMmapStream::makeFromPath(const Common::String &path) {
+#ifdef HAVE_MMAP
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return nullptr;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size < kMinMapSize || st.st_size > 0x7FFFFFFF) {
+		close(fd);
+		return nullptr;
+	}
+
+	// The mapping stays valid after the descriptor has been closed
+	void *mapping = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (mapping == MAP_FAILED)
+		return nullptr;
+
+	return new PosixMmapStream(mapping, st.st_size);
+#else
+	return nullptr;
+#endif
+}
+
+#endif
@@ -0,0 +1,82 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef BACKENDS_FS_POSIX_MMAPSTREAM_H
+#define BACKENDS_FS_POSIX_MMAPSTREAM_H
+
+#include "common/scummsys.h"
+#include "common/memstream.h"
+#include "common/noncopyable.h"
+#include "common/str.h"
+
+/**
+ * A read stream over a file which is mapped into memory with mmap().
+ *
+ * Reading is a plain memcpy() from the mapping, and getDataView() gives
+ * direct access to the file contents, so callers working on big resource
+ * files do not need a copy of them on the heap.
+ */
+class PosixMmapStream : public Common::MemoryReadStream, public Common::NonCopyable {
+protected:
+	void *_mapping;
+	uint32 _mappingSize;
+
+	PosixMmapStream(void *mapping, uint32 mappingSize);
+
+public:
+	enum {
+		/**
+		 * Files smaller than this are cheaper to read through stdio's
+		 * buffer than to map.
+		 */
+		kMinMapSize = 16 * 1024
+	};
+
+	/**
+	 * Map the file at the given path into memory and wrap the mapping in a
+	 * PosixMmapStream instance.
+	 *
+	 * @return the new stream, or nullptr if the file could not be mapped.
+	 *         This includes files smaller than kMinMapSize, and platforms
+	 *         without support for mmap(), so callers should fall back to
+	 *         another stream type.
+	 */
+	static PosixMmapStream *makeFromPath(const Common::String &path);
+
+	/**
+	 * Set whether POSIXFilesystemNode::createReadStream() maps files into
+	 * memory. This is off by default: if another process truncates a mapped
+	 * file, reading the part which is gone raises SIGBUS instead of failing.
+	 * Backends enable it for game data, which isn't changed while playing,
+	 * with the "mmap_files" setting. It must be set before the file system
+	 * is used from several threads.
+	 */
+	static void setEnabled(bool enabled) { _enabled = enabled; }
+	static bool isEnabled() { return _enabled; }
+
+	virtual ~PosixMmapStream();
+
+private:
+	static bool _enabled;
+};
+
+#endif
@@ -71,6 +71,7 @@ public:
 	virtual Graphics::Surface *lockScreen() = 0;
 	virtual void unlockScreen() = 0;
 	virtual void fillScreen(uint32 col) = 0;
+	virtual void copyYUVFrameToScreen(const Graphics::YUV420Frame &frame, int x, int y) {}
 	virtual void updateScreen() = 0;
 	virtual void setShakePos(int shakeOffset) = 0;
 	virtual void setFocusRectangle(const Common::Rect& rect) = 0;
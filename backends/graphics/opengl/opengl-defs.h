@@ -250,6 +250,7 @@ typedef GLhandleARB GLshader;
 /* Textures */
 #define GL_TEXTURE0                       0x84C0
 #define GL_TEXTURE1                       0x84C1
+#define GL_TEXTURE2                       0x84C2
 
 /* GetPName */
 #define GL_VIEWPORT                       0x0BA2
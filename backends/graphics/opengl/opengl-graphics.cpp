@@ -39,6 +39,7 @@
 #endif
 
 #include "graphics/conversion.h"
+#include "graphics/yuv_to_rgb.h"
 #ifdef USE_OSD
 #include "graphics/fontman.h"
 #include "graphics/font.h"
@@ -55,7 +56,8 @@ OpenGLGraphicsManager::OpenGLGraphicsManager()
       _pipeline(nullptr),
       _outputScreenWidth(0), _outputScreenHeight(0), _displayX(0), _displayY(0),
       _displayWidth(0), _displayHeight(0), _defaultFormat(), _defaultFormatAlpha(),
-      _gameScreen(nullptr), _gameScreenShakeOffset(0), _overlay(nullptr),
+      _gameScreen(nullptr), _gameScreenShakeOffset(0), _videoFrame(nullptr),
+      _videoFrameArea(), _overlay(nullptr),
       _overlayVisible(false), _cursor(nullptr),
       _cursorX(0), _cursorY(0), _cursorDisplayX(0),_cursorDisplayY(0), _cursorHotspotX(0), _cursorHotspotY(0),
       _cursorHotspotXScaled(0), _cursorHotspotYScaled(0), _cursorWidthScaled(0), _cursorHeightScaled(0),
@@ -72,6 +74,7 @@ OpenGLGraphicsManager::OpenGLGraphicsManager()
 
 OpenGLGraphicsManager::~OpenGLGraphicsManager() {
 	delete _gameScreen;
+	delete _videoFrame;
 	delete _overlay;
 	delete _cursor;
 #ifdef USE_OSD
@@ -93,6 +96,11 @@ bool OpenGLGraphicsManager::hasFeature(OSystem::Feature f) {
 	case OSystem::kFeatureOverlaySupportsAlpha:
 		return _defaultFormatAlpha.aBits() > 3;
 
+#if !USE_FORCED_GLES
+	case OSystem::kFeatureYUVFrames:
+		return TextureYUV420GPU::isSupportedByContext();
+#endif
+
 	default:
 		return false;
 	}
@@ -113,6 +121,10 @@ void OpenGLGraphicsManager::setFeatureState(OSystem::Feature f, bool enable) {
 			_gameScreen->enableLinearFiltering(enable);
 		}
 
+		if (_videoFrame) {
+			_videoFrame->enableLinearFiltering(enable);
+		}
+
 		if (_cursor) {
 			_cursor->enableLinearFiltering(enable);
 		}
@@ -313,6 +325,7 @@ OSystem::TransactionError OpenGLGraphicsManager::endGFXTransaction() {
 #else
 		_gameScreen->fill(0);
 #endif
+		_videoFrameArea = Common::Rect();
 	}
 
 	// Update our display area and cursor scaling. This makes sure we pick up
@@ -357,6 +370,7 @@ int16 OpenGLGraphicsManager::getHeight() {
 
 void OpenGLGraphicsManager::copyRectToScreen(const void *buf, int pitch, int x, int y, int w, int h) {
 	_gameScreen->copyRectToTexture(x, y, w, h, buf, pitch);
+	invalidateVideoFrame(Common::Rect(x, y, x + w, y + h));
 }
 
 void OpenGLGraphicsManager::fillScreen(uint32 col) {
@@ -366,6 +380,31 @@ void OpenGLGraphicsManager::fillScreen(uint32 col) {
 	// RGB support. Thus, we simply do the "sane" thing here and hope OSystem
 	// gets fixed one day.
 	_gameScreen->fill(col);
+	_videoFrameArea = Common::Rect();
+}
+
+void OpenGLGraphicsManager::copyYUVFrameToScreen(const Graphics::YUV420Frame &frame, int x, int y) {
+#if !USE_FORCED_GLES
+	if (!TextureYUV420GPU::isSupportedByContext()) {
+		return;
+	}
+
+	if (!_videoFrame) {
+		_videoFrame = new TextureYUV420GPU();
+		_videoFrame->enableLinearFiltering(_currentState.filtering);
+	}
+
+	static_cast<TextureYUV420GPU *>(_videoFrame)->setFrame(frame);
+	_videoFrameArea = Common::Rect(x, y, x + frame.width, y + frame.height);
+	_forceRedraw = true;
+#endif
+}
+
+void OpenGLGraphicsManager::invalidateVideoFrame(const Common::Rect &area) {
+	if (!_videoFrameArea.isEmpty() && _videoFrameArea.intersects(area)) {
+		_videoFrameArea = Common::Rect();
+		_forceRedraw = true;
+	}
 }
 
 void OpenGLGraphicsManager::setShakePos(int shakeOffset) {
@@ -405,6 +444,9 @@ void OpenGLGraphicsManager::updateScreen() {
 
 	// Update changes to textures.
 	_gameScreen->updateGLTexture();
+	if (!_videoFrameArea.isEmpty()) {
+		_videoFrame->updateGLTexture();
+	}
 	if (_cursorVisible && _cursor) {
 		_cursor->updateGLTexture();
 	}
@@ -425,6 +467,17 @@ void OpenGLGraphicsManager::updateScreen() {
 	// First step: Draw the (virtual) game screen.
 	g_context.getActivePipeline()->drawTexture(_gameScreen->getGLTexture(), _displayX, _displayY + shakeOffset, _displayWidth, _displayHeight);
 
+	// Draw the video frame on top of the game screen, scaled like it.
+	if (!_videoFrameArea.isEmpty()) {
+		const GLfloat scaleX = (GLfloat)_displayWidth / _gameScreen->getWidth();
+		const GLfloat scaleY = (GLfloat)_displayHeight / _gameScreen->getHeight();
+
+		g_context.getActivePipeline()->drawTexture(_videoFrame->getGLTexture(),
+		                         _displayX + _videoFrameArea.left * scaleX,
+		                         _displayY + _videoFrameArea.top * scaleY + shakeOffset,
+		                         _videoFrameArea.width() * scaleX, _videoFrameArea.height() * scaleY);
+	}
+
 	// Second step: Draw the overlay if visible.
 	if (_overlayVisible) {
 		g_context.getActivePipeline()->drawTexture(_overlay->getGLTexture(), 0, 0, _outputScreenWidth, _outputScreenHeight);
@@ -499,6 +552,7 @@ Graphics::Surface *OpenGLGraphicsManager::lockScreen() {
 
 void OpenGLGraphicsManager::unlockScreen() {
 	_gameScreen->flagDirty();
+	_videoFrameArea = Common::Rect();
 }
 
 void OpenGLGraphicsManager::setFocusRectangle(const Common::Rect& rect) {
@@ -974,6 +1028,18 @@ void OpenGLGraphicsManager::notifyContextCreate(const Graphics::PixelFormat &def
 		_gameScreen->recreate();
 	}
 
+	if (_videoFrame) {
+#if !USE_FORCED_GLES
+		// The new context might lack what is needed for the conversion.
+		if (!TextureYUV420GPU::isSupportedByContext()) {
+			delete _videoFrame;
+			_videoFrame = nullptr;
+			_videoFrameArea = Common::Rect();
+		} else
+#endif
+			_videoFrame->recreate();
+	}
+
 	if (_overlay) {
 		_overlay->recreate();
 	}
@@ -998,6 +1064,10 @@ void OpenGLGraphicsManager::notifyContextDestroy() {
 		_gameScreen->destroy();
 	}
 
+	if (_videoFrame) {
+		_videoFrame->destroy();
+	}
+
 	if (_overlay) {
 		_overlay->destroy();
 	}
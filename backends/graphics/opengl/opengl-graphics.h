@@ -29,6 +29,7 @@
 
 #include "common/frac.h"
 #include "common/mutex.h"
+#include "common/rect.h"
 
 #include "graphics/surface.h"
 
@@ -87,6 +88,7 @@ public:
 
 	virtual void copyRectToScreen(const void *buf, int pitch, int x, int y, int w, int h);
 	virtual void fillScreen(uint32 col);
+	virtual void copyYUVFrameToScreen(const Graphics::YUV420Frame &frame, int x, int y);
 
 	virtual void setShakePos(int shakeOffset);
 
@@ -415,6 +417,23 @@ private:
 	 */
 	int _gameScreenShakeOffset;
 
+	/**
+	 * The video frame shown on top of the game screen, converted from YUV
+	 * on the GPU. Allocated on first use.
+	 */
+	Surface *_videoFrame;
+
+	/**
+	 * The area of the game screen covered by the video frame. Empty when no
+	 * frame is shown.
+	 */
+	Common::Rect _videoFrameArea;
+
+	/**
+	 * Stop showing the video frame when the game screen changes below it.
+	 */
+	void invalidateVideoFrame(const Common::Rect &area);
+
 	//
 	// Overlay
 	//
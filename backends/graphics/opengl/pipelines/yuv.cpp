@@ -0,0 +1,61 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+
+#include "backends/graphics/opengl/pipelines/yuv.h"
+#include "backends/graphics/opengl/shader.h"
+#include "backends/graphics/opengl/framebuffer.h"
+
+namespace OpenGL {
+
+#if !USE_FORCED_GLES
+YUVToRGBPipeline::YUVToRGBPipeline()
+    : ShaderPipeline(ShaderMan.query(ShaderManager::kYUVToRGB)),
+      _uTexture(nullptr), _vTexture(nullptr), _ituScale(false) {
+}
+
+void YUVToRGBPipeline::drawTexture(const GLTexture &texture, const GLfloat *coordinates) {
+	if (_ituScale) {
+		_activeShader->setUniform("lumaScale", new ShaderUniformFloat(255.0f / 219.0f));
+		_activeShader->setUniform("lumaOffset", new ShaderUniformFloat(-16.0f / 219.0f));
+	} else {
+		_activeShader->setUniform("lumaScale", new ShaderUniformFloat(1.0f));
+		_activeShader->setUniform("lumaOffset", new ShaderUniformFloat(0.0f));
+	}
+
+	// Set the chrominance textures.
+	GL_CALL(glActiveTexture(GL_TEXTURE1));
+	if (_uTexture) {
+		_uTexture->bind();
+	}
+
+	GL_CALL(glActiveTexture(GL_TEXTURE2));
+	if (_vTexture) {
+		_vTexture->bind();
+	}
+
+	GL_CALL(glActiveTexture(GL_TEXTURE0));
+	ShaderPipeline::drawTexture(texture, coordinates);
+}
+#endif // !USE_FORCED_GLES
+
+} // End of namespace OpenGL
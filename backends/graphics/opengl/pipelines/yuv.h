@@ -0,0 +1,63 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+
+#ifndef BACKENDS_GRAPHICS_OPENGL_PIPELINES_YUV_H
+#define BACKENDS_GRAPHICS_OPENGL_PIPELINES_YUV_H
+
+#include "backends/graphics/opengl/pipelines/shader.h"
+
+namespace OpenGL {
+
+#if !USE_FORCED_GLES
+/**
+ * Pipeline converting YUV 4:2:0 planes to RGB. The texture passed to
+ * drawTexture holds the luminance, the chrominance textures are set up
+ * beforehand. All planes are stored as alpha textures.
+ */
+class YUVToRGBPipeline : public ShaderPipeline {
+public:
+	YUVToRGBPipeline();
+
+	void setChromaTextures(const GLTexture *uTexture, const GLTexture *vTexture) {
+		_uTexture = uTexture;
+		_vTexture = vTexture;
+	}
+
+	/**
+	 * Set whether the luminance needs to be expanded from the range of
+	 * ITU-R BT.601, [16, 235], to [0, 255].
+	 */
+	void setITUScale(bool enable) { _ituScale = enable; }
+
+	virtual void drawTexture(const GLTexture &texture, const GLfloat *coordinates);
+
+private:
+	const GLTexture *_uTexture;
+	const GLTexture *_vTexture;
+	bool _ituScale;
+};
+#endif // !USE_FORCED_GLES
+
+} // End of namespace OpenGL
+
+#endif
@@ -77,6 +77,27 @@ const char *const g_lookUpFragmentShader =
 	"\tgl_FragColor = blendColor * texture2D(palette, vec2(index.a * adjustFactor, 0.0));\n"
 	"}\n";
 
+// Same coefficients as Graphics::YUVToRGBManager, applied to the full range
+// before the optional expansion of ITU-R BT.601 luminance.
+const char *const g_yuvToRGBFragmentShader =
+	"varying vec2 texCoord;\n"
+	"varying vec4 blendColor;\n"
+	"\n"
+	"uniform sampler2D texture;\n"
+	"uniform sampler2D textureU;\n"
+	"uniform sampler2D textureV;\n"
+	"uniform float lumaScale;\n"
+	"uniform float lumaOffset;\n"
+	"\n"
+	"void main(void) {\n"
+	"\tfloat y = texture2D(texture, texCoord).a;\n"
+	"\tfloat u = texture2D(textureU, texCoord).a - 128.0 / 255.0;\n"
+	"\tfloat v = texture2D(textureV, texCoord).a - 128.0 / 255.0;\n"
+	"\tvec3 rgb = vec3(y + 1.40134 * v, y - 0.34441 * u - 0.71360 * v, y + 1.77341 * u);\n"
+	"\trgb = clamp(rgb * lumaScale + lumaOffset, 0.0, 1.0);\n"
+	"\tgl_FragColor = blendColor * vec4(rgb, 1.0);\n"
+	"}\n";
+
 
 // Taken from: https://en.wikibooks.org/wiki/OpenGL_Programming/Modern_OpenGL_Tutorial_03#OpenGL_ES_2_portability
 const char *const g_precisionDefines =
@@ -310,6 +331,9 @@ void ShaderManager::notifyCreate() {
 		_builtIn[kDefault] = new Shader(g_defaultVertexShader, g_defaultFragmentShader);
 		_builtIn[kCLUT8LookUp] = new Shader(g_defaultVertexShader, g_lookUpFragmentShader);
 		_builtIn[kCLUT8LookUp]->setUniform1I("palette", 1);
+		_builtIn[kYUVToRGB] = new Shader(g_defaultVertexShader, g_yuvToRGBFragmentShader);
+		_builtIn[kYUVToRGB]->setUniform1I("textureU", 1);
+		_builtIn[kYUVToRGB]->setUniform1I("textureV", 2);
 
 		for (uint i = 0; i < kMaxUsages; ++i) {
 			_builtIn[i]->setUniform1I("texture", 0);
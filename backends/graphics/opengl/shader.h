@@ -249,6 +249,9 @@ public:
 		/** CLUT8 look up shader. */
 		kCLUT8LookUp,
 
+		/** Shader converting YUV planes stored in three alpha textures to RGB. */
+		kYUVToRGB,
+
 		/** Number of built-in shaders. Should not be used for query. */
 		kMaxUsages
 	};
@@ -24,11 +24,14 @@
 #include "backends/graphics/opengl/shader.h"
 #include "backends/graphics/opengl/pipelines/pipeline.h"
 #include "backends/graphics/opengl/pipelines/clut8.h"
+#include "backends/graphics/opengl/pipelines/yuv.h"
 #include "backends/graphics/opengl/framebuffer.h"
 
 #include "common/rect.h"
 #include "common/textconsole.h"
 
+#include "graphics/yuv_to_rgb.h"
+
 namespace OpenGL {
 
 static GLuint nextHigher2(GLuint v) {
@@ -644,6 +647,143 @@ void TextureCLUT8GPU::lookUpColors() {
 	// Restore old state.
 	g_context.setPipeline(oldPipeline);
 }
+
+TextureYUV420GPU::TextureYUV420GPU()
+    : _yTexture(GL_ALPHA, GL_ALPHA, GL_UNSIGNED_BYTE),
+      _uTexture(GL_ALPHA, GL_ALPHA, GL_UNSIGNED_BYTE),
+      _vTexture(GL_ALPHA, GL_ALPHA, GL_UNSIGNED_BYTE),
+      _target(new TextureTarget()), _yuvPipeline(new YUVToRGBPipeline()),
+      _yuvVertices(), _yData(), _uData(), _vData(), _userPixelData() {
+	// Setup pipeline.
+	_yuvPipeline->setFramebuffer(_target);
+	_yuvPipeline->setChromaTextures(&_uTexture, &_vTexture);
+	_yuvPipeline->setColor(1.0f, 1.0f, 1.0f, 1.0f);
+}
+
+TextureYUV420GPU::~TextureYUV420GPU() {
+	delete _yuvPipeline;
+	delete _target;
+	_yData.free();
+	_uData.free();
+	_vData.free();
+}
+
+void TextureYUV420GPU::destroy() {
+	_yTexture.destroy();
+	_uTexture.destroy();
+	_vTexture.destroy();
+	_target->destroy();
+}
+
+void TextureYUV420GPU::recreate() {
+	_yTexture.create();
+	_uTexture.create();
+	_vTexture.create();
+	_target->create();
+
+	// In case image date exists assure it will be completely refreshed next
+	// time.
+	if (_yData.getPixels()) {
+		flagDirty();
+	}
+}
+
+void TextureYUV420GPU::enableLinearFiltering(bool enable) {
+	_target->getTexture()->enableLinearFiltering(enable);
+}
+
+void TextureYUV420GPU::allocate(uint width, uint height) {
+	// The chrominance planes are sampled with the texture coordinates of the
+	// luminance plane. This works because for even sizes the textures keep
+	// the same proportions, even when they need power of two sizes.
+	assert((width & 1) == 0 && (height & 1) == 0);
+
+	_yTexture.setSize(width, height);
+	_uTexture.setSize(width / 2, height / 2);
+	_vTexture.setSize(width / 2, height / 2);
+	_target->setSize(width, height);
+
+	// In case the needed texture dimension changed we will reinitialize the
+	// texture data buffers.
+	const Graphics::PixelFormat format = Graphics::PixelFormat::createFormatCLUT8();
+	if (_yTexture.getWidth() != _yData.w || _yTexture.getHeight() != _yData.h) {
+		_yData.create(_yTexture.getWidth(), _yTexture.getHeight(), format);
+	}
+	if (_uTexture.getWidth() != _uData.w || _uTexture.getHeight() != _uData.h) {
+		_uData.create(_uTexture.getWidth(), _uTexture.getHeight(), format);
+		_vData.create(_vTexture.getWidth(), _vTexture.getHeight(), format);
+	}
+
+	// Create a sub-buffer for raw access.
+	_userPixelData = _yData.getSubArea(Common::Rect(width, height));
+
+	// Setup structures for internal rendering to _glTexture.
+	_yuvVertices[0] = 0;
+	_yuvVertices[1] = 0;
+
+	_yuvVertices[2] = width;
+	_yuvVertices[3] = 0;
+
+	_yuvVertices[4] = 0;
+	_yuvVertices[5] = height;
+
+	_yuvVertices[6] = width;
+	_yuvVertices[7] = height;
+
+	flagDirty();
+}
+
+void TextureYUV420GPU::setFrame(const Graphics::YUV420Frame &frame) {
+	if (frame.width != _userPixelData.w || frame.height != _userPixelData.h) {
+		allocate(frame.width, frame.height);
+	}
+
+	for (int y = 0; y < frame.height; ++y) {
+		memcpy(_yData.getBasePtr(0, y), frame.y + y * frame.yPitch, frame.width);
+	}
+
+	for (int y = 0; y < frame.height / 2; ++y) {
+		memcpy(_uData.getBasePtr(0, y), frame.u + y * frame.uvPitch, frame.width / 2);
+		memcpy(_vData.getBasePtr(0, y), frame.v + y * frame.uvPitch, frame.width / 2);
+	}
+
+	_yuvPipeline->setITUScale(frame.scale == Graphics::YUVToRGBManager::kScaleITU);
+	flagDirty();
+}
+
+Graphics::PixelFormat TextureYUV420GPU::getFormat() const {
+	return Graphics::PixelFormat::createFormatCLUT8();
+}
+
+const GLTexture &TextureYUV420GPU::getGLTexture() const {
+	return *_target->getTexture();
+}
+
+void TextureYUV420GPU::updateGLTexture() {
+	if (!isDirty()) {
+		return;
+	}
+
+	// Frames replace all planes, so there is no point in tracking the dirty
+	// area of the chrominance.
+	_yTexture.updateArea(Common::Rect(_yData.w, _yData.h), _yData);
+	_uTexture.updateArea(Common::Rect(_uData.w, _uData.h), _uData);
+	_vTexture.updateArea(Common::Rect(_vData.w, _vData.h), _vData);
+	clearDirty();
+
+	convertColors();
+}
+
+void TextureYUV420GPU::convertColors() {
+	// Setup pipeline to do the color conversion.
+	Pipeline *oldPipeline = g_context.setPipeline(_yuvPipeline);
+
+	// Do color conversion.
+	g_context.getActivePipeline()->drawTexture(_yTexture, _yuvVertices);
+
+	// Restore old state.
+	g_context.setPipeline(oldPipeline);
+}
 #endif // !USE_FORCED_GLES
 
 } // End of namespace OpenGL
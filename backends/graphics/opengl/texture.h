@@ -30,6 +30,10 @@
 
 #include "common/rect.h"
 
+namespace Graphics {
+struct YUV420Frame;
+} // End of namespace Graphics
+
 namespace OpenGL {
 
 class Shader;
@@ -394,6 +398,63 @@ private:
 	byte _palette[4 * 256];
 	bool _paletteDirty;
 };
+
+class YUVToRGBPipeline;
+
+/**
+ * A surface for video frames in YUV 4:2:0. The three planes are uploaded as
+ * they are and converted to RGB by a shader. The surface data holds the
+ * luminance plane only, frames are passed in with setFrame.
+ */
+class TextureYUV420GPU : public Surface {
+public:
+	TextureYUV420GPU();
+	virtual ~TextureYUV420GPU();
+
+	virtual void destroy();
+
+	virtual void recreate();
+
+	virtual void enableLinearFiltering(bool enable);
+
+	virtual void allocate(uint width, uint height);
+
+	/**
+	 * Copy the planes of a frame, resizing the surface if needed.
+	 */
+	void setFrame(const Graphics::YUV420Frame &frame);
+
+	virtual uint getWidth() const { return _userPixelData.w; }
+	virtual uint getHeight() const { return _userPixelData.h; }
+
+	virtual Graphics::PixelFormat getFormat() const;
+
+	virtual Graphics::Surface *getSurface() { return &_userPixelData; }
+	virtual const Graphics::Surface *getSurface() const { return &_userPixelData; }
+
+	virtual void updateGLTexture();
+	virtual const GLTexture &getGLTexture() const;
+
+	static bool isSupportedByContext() {
+		return TextureCLUT8GPU::isSupportedByContext();
+	}
+private:
+	void convertColors();
+
+	GLTexture _yTexture;
+	GLTexture _uTexture;
+	GLTexture _vTexture;
+
+	TextureTarget *_target;
+	YUVToRGBPipeline *_yuvPipeline;
+
+	GLfloat _yuvVertices[4*2];
+
+	Graphics::Surface _yData;
+	Graphics::Surface _uData;
+	Graphics::Surface _vData;
+	Graphics::Surface _userPixelData;
+};
 #endif // !USE_FORCED_GLES
 
 } // End of namespace OpenGL
@@ -204,6 +204,9 @@ SurfaceSdlGraphicsManager::SurfaceSdlGraphicsManager(SdlEventSource *sdlEventSou
 	_videoMode.filtering = ConfMan.getBool("filtering");
 #endif
 
+	// By default, scale with one thread per core
+	_scalerPool.setNumThreads(ConfMan.hasKey("scaler_threads") ? ConfMan.getInt("scaler_threads") : 0);
+
 	// the default backend has no shaders
 	// shader number 0 is the entry NONE (no shader)
 	// for an example on shader support,
@@ -1095,6 +1098,18 @@ void SurfaceSdlGraphicsManager::updateShader() {
 // hardware-based up-scaling (sharp-bilinear-simple, etc.)
 }
 
+/**
+ * Check whether several instances of a scaler can run at the same time.
+ */
+static bool isScalerReentrant(ScalerProc *scalerProc) {
+#if defined(USE_HQ_SCALERS) && defined(USE_NASM)
+	// The assembler versions of the HQ scalers keep their state in globals
+	if (scalerProc == HQ2x || scalerProc == HQ3x)
+		return false;
+#endif
+	return true;
+}
+
 void SurfaceSdlGraphicsManager::internUpdateScreen() {
 	SDL_Surface *srcSurf, *origSurf;
 	int height, width;
@@ -1213,8 +1228,12 @@ void SurfaceSdlGraphicsManager::internUpdateScreen() {
 					dst_y = real2Aspect(dst_y);
 
 				assert(scalerProc != NULL);
-				scalerProc((byte *)srcSurf->pixels + (r->x * 2 + 2) + (r->y + 1) * srcPitch, srcPitch,
-					(byte *)_hwscreen->pixels + rx1 * 2 + dst_y * dstPitch, dstPitch, r->w, dst_h);
+				if (isScalerReentrant(scalerProc))
+					_scalerPool.scale(scalerProc, (byte *)srcSurf->pixels + (r->x * 2 + 2) + (r->y + 1) * srcPitch, srcPitch,
+						(byte *)_hwscreen->pixels + rx1 * 2 + dst_y * dstPitch, dstPitch, r->w, dst_h, scale1);
+				else
+					scalerProc((byte *)srcSurf->pixels + (r->x * 2 + 2) + (r->y + 1) * srcPitch, srcPitch,
+						(byte *)_hwscreen->pixels + rx1 * 2 + dst_y * dstPitch, dstPitch, r->w, dst_h);
 			}
 
 			r->x = rx1;
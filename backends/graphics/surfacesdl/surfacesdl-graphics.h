@@ -25,6 +25,7 @@
 
 #include "backends/graphics/graphics.h"
 #include "backends/graphics/sdl/sdl-graphics.h"
+#include "backends/graphics/surfacesdl/surfacesdl-scalerpool.h"
 #include "graphics/pixelformat.h"
 #include "graphics/scaler.h"
 #include "common/events.h"
@@ -293,6 +294,9 @@ protected:
 
 	ScalerProc *_scalerProc;
 	int _scalerType;
+
+	/** Worker threads for scaling large dirty rects */
+	SdlScalerPool _scalerPool;
 	int _transactionMode;
 
 	// Indicates whether it is needed to free _hwsurface in destructor
@@ -0,0 +1,182 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "common/scummsys.h"
+
+#if defined(SDL_BACKEND)
+
+#include "backends/graphics/surfacesdl/surfacesdl-scalerpool.h"
+
+#include "common/debug.h"
+#include "common/textconsole.h"
+#include "common/util.h"
+
+SdlScalerPool::SdlScalerPool()
+	: _mutex(0), _workCond(0), _doneCond(0), _numWorkers(0), _quit(false),
+	  _scalerProc(0), _srcPitch(0), _dstPitch(0), _width(0),
+	  _numStripes(0), _nextStripe(0), _pendingStripes(0) {
+}
+
+SdlScalerPool::~SdlScalerPool() {
+	stopWorkers();
+}
+
+void SdlScalerPool::setNumThreads(int numThreads) {
+	if (numThreads <= 0) {
+#if SDL_VERSION_ATLEAST(2, 0, 0)
+		numThreads = SDL_GetCPUCount();
+#else
+		numThreads = 1;
+#endif
+	}
+	numThreads = CLIP<int>(numThreads, 1, kMaxThreads);
+
+	if (numThreads == _numWorkers + 1)
+		return;
+
+	stopWorkers();
+	if (numThreads == 1)
+		return;
+
+	_mutex = SDL_CreateMutex();
+	_workCond = SDL_CreateCond();
+	_doneCond = SDL_CreateCond();
+	if (!_mutex || !_workCond || !_doneCond) {
+		warning("Could not create the scaler thread synchronization objects: %s", SDL_GetError());
+		stopWorkers();
+		return;
+	}
+
+	_quit = false;
+	for (int i = 0; i < numThreads - 1; ++i) {
+#if SDL_VERSION_ATLEAST(2, 0, 0)
+		_workers[_numWorkers] = SDL_CreateThread(workerThreadEntry, "ScummVM Scaler", this);
+#else
+		_workers[_numWorkers] = SDL_CreateThread(workerThreadEntry, this);
+#endif
+		if (!_workers[_numWorkers]) {
+			warning("Could not create scaler thread: %s", SDL_GetError());
+			break;
+		}
+		_numWorkers++;
+	}
+
+	debug(1, "Scaling with %d threads", _numWorkers + 1);
+}
+
+void SdlScalerPool::stopWorkers() {
+	if (_numWorkers) {
+		SDL_LockMutex(_mutex);
+		_quit = true;
+		SDL_CondBroadcast(_workCond);
+		SDL_UnlockMutex(_mutex);
+
+		for (int i = 0; i < _numWorkers; ++i)
+			SDL_WaitThread(_workers[i], NULL);
+		_numWorkers = 0;
+	}
+
+	if (_doneCond)
+		SDL_DestroyCond(_doneCond);
+	if (_workCond)
+		SDL_DestroyCond(_workCond);
+	if (_mutex)
+		SDL_DestroyMutex(_mutex);
+	_doneCond = 0;
+	_workCond = 0;
+	_mutex = 0;
+}
+
+void SdlScalerPool::scale(ScalerProc *scalerProc, const uint8 *srcPtr, uint32 srcPitch,
+                          uint8 *dstPtr, uint32 dstPitch, int width, int height, int scaleFactor) {
+	const int numStripes = MIN<int>(_numWorkers + 1, height / kMinStripeHeight);
+	if (numStripes <= 1) {
+		scalerProc(srcPtr, srcPitch, dstPtr, dstPitch, width, height);
+		return;
+	}
+
+	SDL_LockMutex(_mutex);
+
+	_scalerProc = scalerProc;
+	_srcPitch = srcPitch;
+	_dstPitch = dstPitch;
+	_width = width;
+
+	// Stripes start at even lines relative to the area, since some scalers
+	// handle two source lines at a time or use the line index for patterns.
+	int y = 0;
+	for (int i = 0; i < numStripes; ++i) {
+		const int end = (i == numStripes - 1) ? height : (height * (i + 1) / numStripes) & ~1;
+		_stripes[i].srcPtr = srcPtr + y * srcPitch;
+		_stripes[i].dstPtr = dstPtr + y * scaleFactor * dstPitch;
+		_stripes[i].height = end - y;
+		y = end;
+	}
+
+	_numStripes = numStripes;
+	_nextStripe = 0;
+	_pendingStripes = numStripes;
+	SDL_CondBroadcast(_workCond);
+
+	// Lend a hand instead of idling, then wait for the stragglers
+	processStripes();
+	while (_pendingStripes > 0)
+		SDL_CondWait(_doneCond, _mutex);
+
+	SDL_UnlockMutex(_mutex);
+}
+
+void SdlScalerPool::processStripes() {
+	while (_nextStripe < _numStripes) {
+		const Stripe stripe = _stripes[_nextStripe++];
+
+		SDL_UnlockMutex(_mutex);
+		_scalerProc(stripe.srcPtr, _srcPitch, stripe.dstPtr, _dstPitch, _width, stripe.height);
+		SDL_LockMutex(_mutex);
+
+		if (--_pendingStripes == 0)
+			SDL_CondSignal(_doneCond);
+	}
+}
+
+void SdlScalerPool::workerThread() {
+	SDL_LockMutex(_mutex);
+	while (true) {
+		while (!_quit && _nextStripe >= _numStripes)
+			SDL_CondWait(_workCond, _mutex);
+
+		if (_quit)
+			break;
+
+		processStripes();
+	}
+	SDL_UnlockMutex(_mutex);
+}
+
+int SDLCALL SdlScalerPool::workerThreadEntry(void *arg) {
+	SdlScalerPool *pool = (SdlScalerPool *)arg;
+	assert(pool);
+	pool->workerThread();
+	return 0;
+}
+
+#endif
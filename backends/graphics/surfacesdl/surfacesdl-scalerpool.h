@@ -0,0 +1,111 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef BACKENDS_GRAPHICS_SURFACESDL_SCALERPOOL_H
+#define BACKENDS_GRAPHICS_SURFACESDL_SCALERPOOL_H
+
+#include "graphics/scaler.h"
+
+#include "backends/platform/sdl/sdl-sys.h"
+
+/**
+ * A small pool of persistent worker threads which run a scaler over
+ * horizontal stripes of a rectangle in parallel.
+ *
+ * Every stripe covers a disjoint range of destination lines. The scalers
+ * read one source line above and one below the lines they scale; those
+ * lines are simply shared with the neighbouring stripes, since the source
+ * is not modified while scaling.
+ */
+class SdlScalerPool {
+public:
+	enum {
+		/** Upper limit for the number of threads used for scaling. */
+		kMaxThreads = 16
+	};
+
+	SdlScalerPool();
+	~SdlScalerPool();
+
+	/**
+	 * Set the number of threads to scale with, including the calling
+	 * thread. A value of 1 disables the worker threads, a value of 0 or
+	 * less picks one thread per CPU core.
+	 */
+	void setNumThreads(int numThreads);
+
+	/** Return the number of threads used for scaling. */
+	int getNumThreads() const { return _numWorkers + 1; }
+
+	/**
+	 * Run a scaler over the given area, split across the worker threads if
+	 * it is large enough to be worth it. The parameters are the same as
+	 * for the ScalerProc itself, plus the (integer) scale factor. Returns
+	 * when the whole area has been scaled.
+	 *
+	 * The scaler must not keep any global state, since several instances
+	 * run at the same time.
+	 */
+	void scale(ScalerProc *scalerProc, const uint8 *srcPtr, uint32 srcPitch,
+	           uint8 *dstPtr, uint32 dstPitch, int width, int height, int scaleFactor);
+
+private:
+	enum {
+		/** Areas are not split into stripes of fewer source lines than this. */
+		kMinStripeHeight = 16
+	};
+
+	struct Stripe {
+		const uint8 *srcPtr;
+		uint8 *dstPtr;
+		int height;
+	};
+
+	SDL_mutex *_mutex;
+	SDL_cond *_workCond;
+	SDL_cond *_doneCond;
+	SDL_Thread *_workers[kMaxThreads - 1];
+	int _numWorkers;
+	bool _quit;
+
+	// The current job; protected by _mutex
+	ScalerProc *_scalerProc;
+	uint32 _srcPitch, _dstPitch;
+	int _width;
+	Stripe _stripes[kMaxThreads];
+	int _numStripes;
+	int _nextStripe;
+	int _pendingStripes;
+
+	void stopWorkers();
+
+	/**
+	 * Scale the stripes of the current job until none is left. Expects
+	 * _mutex to be locked, and returns with it locked.
+	 */
+	void processStripes();
+
+	void workerThread();
+	static int SDLCALL workerThreadEntry(void *arg);
+};
+
+#endif
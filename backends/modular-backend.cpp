@@ -29,6 +29,7 @@
 #include "gui/EventRecorder.h"
 
 #include "audio/mixer.h"
+#include "common/trace.h"
 #include "graphics/pixelformat.h"
 
 ModularBackend::ModularBackend()
@@ -153,7 +154,13 @@ void ModularBackend::fillScreen(uint32 col) {
 	_graphicsManager->fillScreen(col);
 }
 
+void ModularBackend::copyYUVFrameToScreen(const Graphics::YUV420Frame &frame, int x, int y) {
+	_graphicsManager->copyYUVFrameToScreen(frame, x, y);
+}
+
 void ModularBackend::updateScreen() {
+	TRACE_SCOPE("graphics", "OSystem::updateScreen");
+
 #ifdef ENABLE_EVENTRECORDER
 	g_eventRec.preDrawOverlayGui();
 #endif
@@ -244,6 +251,41 @@ void ModularBackend::deleteMutex(MutexRef mutex) {
 	_mutexManager->deleteMutex(mutex);
 }
 
+OSystem::ThreadRef ModularBackend::createThread(ThreadProc proc, void *param, const char *name) {
+	assert(_mutexManager);
+	return _mutexManager->createThread(proc, param, name);
+}
+
+void ModularBackend::joinThread(ThreadRef thread) {
+	assert(_mutexManager);
+	_mutexManager->joinThread(thread);
+}
+
+OSystem::SemaphoreRef ModularBackend::createSemaphore(uint value) {
+	assert(_mutexManager);
+	return _mutexManager->createSemaphore(value);
+}
+
+bool ModularBackend::waitSemaphore(SemaphoreRef semaphore, int timeout) {
+	assert(_mutexManager);
+	return _mutexManager->waitSemaphore(semaphore, timeout);
+}
+
+void ModularBackend::postSemaphore(SemaphoreRef semaphore) {
+	assert(_mutexManager);
+	_mutexManager->postSemaphore(semaphore);
+}
+
+void ModularBackend::deleteSemaphore(SemaphoreRef semaphore) {
+	assert(_mutexManager);
+	_mutexManager->deleteSemaphore(semaphore);
+}
+
+uint64 ModularBackend::getCurrentThreadId() {
+	assert(_mutexManager);
+	return _mutexManager->getCurrentThreadId();
+}
+
 Audio::Mixer *ModularBackend::getMixer() {
 	assert(_mixer);
 	return (Audio::Mixer *)_mixer;
@@ -87,6 +87,7 @@ public:
 	virtual Graphics::Surface *lockScreen();
 	virtual void unlockScreen();
 	virtual void fillScreen(uint32 col);
+	virtual void copyYUVFrameToScreen(const Graphics::YUV420Frame &frame, int x, int y);
 	virtual void updateScreen();
 	virtual void setShakePos(int shakeOffset);
 	virtual void setFocusRectangle(const Common::Rect& rect);
@@ -118,6 +119,19 @@ public:
 
 	//@}
 
+	/** @name Threads */
+	//@{
+
+	virtual ThreadRef createThread(ThreadProc proc, void *param, const char *name);
+	virtual void joinThread(ThreadRef thread);
+	virtual SemaphoreRef createSemaphore(uint value);
+	virtual bool waitSemaphore(SemaphoreRef semaphore, int timeout = -1);
+	virtual void postSemaphore(SemaphoreRef semaphore);
+	virtual void deleteSemaphore(SemaphoreRef semaphore);
+	virtual uint64 getCurrentThreadId();
+
+	//@}
+
 	/** @name Sound */
 	//@{
 
@@ -38,6 +38,15 @@ public:
 	virtual void lockMutex(OSystem::MutexRef mutex) = 0;
 	virtual void unlockMutex(OSystem::MutexRef mutex) = 0;
 	virtual void deleteMutex(OSystem::MutexRef mutex) = 0;
+
+	// Threads are optional, see OSystem::createThread()
+	virtual OSystem::ThreadRef createThread(OSystem::ThreadProc proc, void *param, const char *name) { return 0; }
+	virtual void joinThread(OSystem::ThreadRef thread) {}
+	virtual OSystem::SemaphoreRef createSemaphore(uint value) { return 0; }
+	virtual bool waitSemaphore(OSystem::SemaphoreRef semaphore, int timeout) { return false; }
+	virtual void postSemaphore(OSystem::SemaphoreRef semaphore) {}
+	virtual void deleteSemaphore(OSystem::SemaphoreRef semaphore) {}
+	virtual uint64 getCurrentThreadId() { return 0; }
 };
 
 #endif
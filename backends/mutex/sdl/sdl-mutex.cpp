@@ -27,6 +27,26 @@
 #include "backends/mutex/sdl/sdl-mutex.h"
 #include "backends/platform/sdl/sdl-sys.h"
 
+#include "common/textconsole.h"
+
+namespace {
+
+/** The function to run on an SDL thread, which has a different signature. */
+struct ThreadStart {
+	OSystem::ThreadProc proc;
+	void *param;
+};
+
+int SDLCALL threadEntry(void *data) {
+	ThreadStart start = *(ThreadStart *)data;
+	delete (ThreadStart *)data;
+
+	start.proc(start.param);
+	return 0;
+}
+
+} // End of anonymous namespace
+
 
 OSystem::MutexRef SdlMutexManager::createMutex() {
 	return (OSystem::MutexRef) SDL_CreateMutex();
@@ -44,4 +64,49 @@ void SdlMutexManager::deleteMutex(OSystem::MutexRef mutex) {
 	SDL_DestroyMutex((SDL_mutex *)mutex);
 }
 
+OSystem::ThreadRef SdlMutexManager::createThread(OSystem::ThreadProc proc, void *param, const char *name) {
+	ThreadStart *start = new ThreadStart;
+	start->proc = proc;
+	start->param = param;
+
+#if SDL_VERSION_ATLEAST(2, 0, 0)
+	SDL_Thread *thread = SDL_CreateThread(threadEntry, name, start);
+#else
+	SDL_Thread *thread = SDL_CreateThread(threadEntry, start);
+#endif
+	if (!thread) {
+		warning("Could not create thread '%s': %s", name, SDL_GetError());
+		delete start;
+	}
+
+	return (OSystem::ThreadRef)thread;
+}
+
+void SdlMutexManager::joinThread(OSystem::ThreadRef thread) {
+	SDL_WaitThread((SDL_Thread *)thread, 0);
+}
+
+OSystem::SemaphoreRef SdlMutexManager::createSemaphore(uint value) {
+	return (OSystem::SemaphoreRef)SDL_CreateSemaphore(value);
+}
+
+bool SdlMutexManager::waitSemaphore(OSystem::SemaphoreRef semaphore, int timeout) {
+	if (timeout < 0)
+		return SDL_SemWait((SDL_sem *)semaphore) == 0;
+
+	return SDL_SemWaitTimeout((SDL_sem *)semaphore, timeout) == 0;
+}
+
+void SdlMutexManager::postSemaphore(OSystem::SemaphoreRef semaphore) {
+	SDL_SemPost((SDL_sem *)semaphore);
+}
+
+void SdlMutexManager::deleteSemaphore(OSystem::SemaphoreRef semaphore) {
+	SDL_DestroySemaphore((SDL_sem *)semaphore);
+}
+
+uint64 SdlMutexManager::getCurrentThreadId() {
+	return SDL_ThreadID();
+}
+
 #endif
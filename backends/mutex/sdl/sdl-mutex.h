@@ -26,7 +26,7 @@
 #include "backends/mutex/mutex.h"
 
 /**
- * SDL mutex manager
+ * SDL mutex manager, which also provides threads and semaphores
  */
 class SdlMutexManager : public MutexManager {
 public:
@@ -34,6 +34,14 @@ public:
 	virtual void lockMutex(OSystem::MutexRef mutex);
 	virtual void unlockMutex(OSystem::MutexRef mutex);
 	virtual void deleteMutex(OSystem::MutexRef mutex);
+
+	virtual OSystem::ThreadRef createThread(OSystem::ThreadProc proc, void *param, const char *name);
+	virtual void joinThread(OSystem::ThreadRef thread);
+	virtual OSystem::SemaphoreRef createSemaphore(uint value);
+	virtual bool waitSemaphore(OSystem::SemaphoreRef semaphore, int timeout);
+	virtual void postSemaphore(OSystem::SemaphoreRef semaphore);
+	virtual void deleteSemaphore(OSystem::SemaphoreRef semaphore);
+	virtual uint64 getCurrentThreadId();
 };
 
 
@@ -35,12 +35,14 @@
 #include "backends/saves/posix/posix-saves.h"
 #include "backends/fs/posix/posix-fs-factory.h"
 #include "backends/fs/posix/posix-fs.h"
+#include "backends/fs/posix/posix-mmapstream.h"
 #include "backends/taskbar/unity/unity-taskbar.h"
 
 #ifdef USE_LINUXCD
 #include "backends/audiocd/linux/linux-audiocd.h"
 #endif
 
+#include "common/config-manager.h"
 #include "common/textconsole.h"
 
 #include <stdlib.h>
@@ -72,6 +74,9 @@ void OSystem_POSIX::initBackend() {
 	if (_savefileManager == 0)
 		_savefileManager = new POSIXSaveFileManager();
 
+	// Mapping files is only safe if they are not truncated while in use
+	PosixMmapStream::setEnabled(ConfMan.hasKey("mmap_files") && ConfMan.getBool("mmap_files"));
+
 	// Invoke parent implementation of this method
 	OSystem_SDL::initBackend();
 
@@ -142,6 +142,14 @@ static const char HELP_STRING[] =
 	"  --record-file-name=FILE  Specify record file name\n"
 	"  --disable-display        Disable any gfx output. Used for headless events\n"
 	"                           playback by Event Recorder\n"
+	"  --benchmark=FILE         Replay the recording FILE as fast as possible without\n"
+	"                           display and write per-frame timings as JSON\n"
+	"  --benchmark-output=FILE  Specify the benchmark report file name\n"
+	"                           (default: benchmark.json)\n"
+#endif
+#ifdef USE_TRACING
+	"  --trace-file=FILE        Record the time spent in instrumented code as\n"
+	"                           Chrome trace events in FILE\n"
 #endif
 	"\n"
 #if defined(ENABLE_SKY) || defined(ENABLE_QUEEN)
@@ -216,6 +224,8 @@ void registerDefaults() {
 	ConfMan.registerDefault("native_mt32", false);
 	ConfMan.registerDefault("enable_gs", false);
 	ConfMan.registerDefault("midi_gain", 100);
+	ConfMan.registerDefault("midi_render_ahead", 0);
+	ConfMan.registerDefault("resampler", "linear");
 
 	ConfMan.registerDefault("music_driver", "auto");
 	ConfMan.registerDefault("mt32_device", "null");
@@ -264,6 +274,7 @@ void registerDefaults() {
 	ConfMan.registerDefault("disable_display", false);
 	ConfMan.registerDefault("record_mode", "none");
 	ConfMan.registerDefault("record_file_name", "record.bin");
+	ConfMan.registerDefault("benchmark_output", "benchmark.json");
 
 	ConfMan.registerDefault("gui_saveload_chooser", "grid");
 	ConfMan.registerDefault("gui_saveload_last_pos", "0");
@@ -489,6 +500,20 @@ Common::String parseCommandLine(Common::StringMap &settings, int argc, const cha
 
 			DO_LONG_OPTION("record-file-name")
 			END_OPTION
+
+			DO_LONG_OPTION("benchmark")
+				settings["record_mode"] = "playback";
+				settings["record_file_name"] = option;
+				settings["disable_display"] = "true";
+			END_OPTION
+
+			DO_LONG_OPTION("benchmark-output")
+			END_OPTION
+#endif
+
+#ifdef USE_TRACING
+			DO_LONG_OPTION("trace-file")
+			END_OPTION
 #endif
 
 			DO_LONG_OPTION("opl-driver")
@@ -32,6 +32,7 @@
 #define FORBIDDEN_SYMBOL_EXCEPTION_printf
 
 #include "engines/engine.h"
+#include "engines/md5cache.h"
 #include "engines/metaengine.h"
 #include "base/commandLine.h"
 #include "base/plugins.h"
@@ -50,13 +51,17 @@
 #include "common/system.h"
 #include "common/textconsole.h"
 #include "common/tokenizer.h"
+#include "common/trace.h"
 #include "common/translation.h"
 #include "common/osd_message_queue.h"
 
 #include "gui/gui-manager.h"
 #include "gui/error.h"
 
+#include "audio/decode_cache.h"
+#include "audio/decoders/mp3.h"
 #include "audio/mididrv.h"
+#include "audio/rate.h"
 #include "audio/musicplugin.h"  /* for music manager */
 
 #include "graphics/cursorman.h"
@@ -256,6 +261,9 @@ static Common::Error runGame(const EnginePlugin *plugin, OSystem &system, const
 	// Initialize any game-specific keymaps
 	engine->initKeymap();
 
+	// Use the resampling quality set for the game, if any
+	Audio::setRateConverterQuality(Audio::parseRateConverterQuality(ConfMan.get("resampler").c_str()));
+
 	// Inform backend that the engine is about to be run
 	system.engineInit();
 
@@ -277,6 +285,11 @@ static Common::Error runGame(const EnginePlugin *plugin, OSystem &system, const
 	// Reset the file/directory mappings
 	SearchMan.clear();
 
+	// Cached sounds are named after the files of the game
+	AudioDecodeCache.clear();
+
+	Audio::setRateConverterQuality(Audio::parseRateConverterQuality(ConfMan.get("resampler", Common::ConfigManager::kApplicationDomain).c_str()));
+
 	// Return result (== 0 means no error)
 	return result;
 }
@@ -435,6 +448,16 @@ extern "C" int scummvm_main(int argc, const char * const argv[]) {
 	// the command line params) was read.
 	system.initBackend();
 
+#ifdef USE_MAD
+	// The cache's mutex needs the backend
+	Audio::createMP3IndexCache();
+#endif
+
+#ifdef USE_TRACING
+	if (ConfMan.hasKey("trace_file"))
+		Common::startTracing(ConfMan.get("trace_file"));
+#endif
+
 	// If we received an invalid graphics mode parameter via command line
 	// we check this here. We can't do it until after the backend is inited,
 	// or there won't be a graphics manager to ask for the supported modes.
@@ -458,6 +481,8 @@ extern "C" int scummvm_main(int argc, const char * const argv[]) {
 	}
 	setupGraphics(system);
 
+	Audio::setRateConverterQuality(Audio::parseRateConverterQuality(ConfMan.get("resampler").c_str()));
+
 	// Init the different managers that are used by the engines.
 	// Do it here to prevent fragmentation later
 	system.getAudioCDManager();
@@ -505,6 +530,11 @@ extern "C" int scummvm_main(int argc, const char * const argv[]) {
 	while (0 != ConfMan.getActiveDomain()) {
 		// Try to find a plugin which feels responsible for the specified game.
 		const EnginePlugin *plugin = detectPlugin();
+
+		// Store the checksums computed by the detection before running the
+		// game, which might never return properly.
+		MD5CacheMan.flush();
+
 		if (plugin) {
 			// Unload all plugins not needed for this game,
 			// to save memory
@@ -612,6 +642,15 @@ extern "C" int scummvm_main(int argc, const char * const argv[]) {
 	//I think it's important to destroy it after ConnectionManager
 	Cloud::CloudManager::destroy();
 #endif
+#endif
+#ifdef USE_TRACING
+	Common::stopTracing();
+#endif
+	MD5CacheMan.flush();
+	MD5Cache::destroy();
+	Audio::DecodeCache::destroy();
+#ifdef USE_MAD
+	Audio::destroyMP3IndexCache();
 #endif
 	PluginManager::instance().unloadAllPlugins();
 	PluginManager::destroy();
@@ -0,0 +1,98 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef COMMON_ATOMIC_H
+#define COMMON_ATOMIC_H
+
+#include "common/scummsys.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+/**
+ * @file
+ * Minimal helpers to share data between threads without taking a lock.
+ *
+ * They only work on naturally aligned values which the CPU reads and writes
+ * in one go, i.e. up to the size of a pointer. All of them imply a full
+ * memory barrier.
+ */
+
+namespace Common {
+
+/**
+ * A full memory barrier. Neither the compiler nor the CPU move loads or
+ * stores across it.
+ */
+inline void memoryBarrier() {
+#if defined(__GNUC__)
+	__sync_synchronize();
+#elif defined(_MSC_VER)
+	// Interlocked operations are full barriers on all architectures
+	long dummy = 0;
+	_InterlockedOr(&dummy, 0);
+#else
+#error "Implement memoryBarrier() for this compiler"
+#endif
+}
+
+/**
+ * Read a value written by another thread. This is guaranteed to see
+ * everything that thread wrote before storing the value with atomicStore().
+ */
+template<typename T>
+inline T atomicLoad(const volatile T &var) {
+	T value = var;
+	memoryBarrier();
+	return value;
+}
+
+/**
+ * Write a value read by another thread. Everything written before is visible
+ * to the other thread once it sees the value with atomicLoad().
+ */
+template<typename T>
+inline void atomicStore(volatile T &var, T value) {
+	memoryBarrier();
+	var = value;
+	memoryBarrier();
+}
+
+/**
+ * Replace the value of var by newValue, but only if it is equal to oldValue.
+ *
+ * @return true if the value was replaced
+ */
+inline bool atomicCompareAndSwap(volatile uint32 &var, uint32 oldValue, uint32 newValue) {
+#if defined(__GNUC__)
+	return __sync_bool_compare_and_swap(&var, oldValue, newValue);
+#elif defined(_MSC_VER)
+	return (uint32)_InterlockedCompareExchange((volatile long *)&var, (long)newValue, (long)oldValue) == oldValue;
+#else
+#error "Implement atomicCompareAndSwap() for this compiler"
+#endif
+}
+
+} // End of namespace Common
+
+#endif
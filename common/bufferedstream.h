@@ -45,6 +45,10 @@ ReadStream *wrapBufferedReadStream(ReadStream *parentStream, uint32 bufSize, Dis
  * Users can specify how big the buffer should be, and whether the wrapped
  * stream should be disposed when the wrapper is disposed.
  *
+ * If the wrapped stream is to be disposed and it provides direct access to
+ * all of its data (see SeekableReadStream::getDataView()), buffering it
+ * would be pointless, and it is returned as is.
+ *
  * It is safe to call this with a NULL parameter (in this case, NULL is
  * returned).
  */
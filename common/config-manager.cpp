@@ -256,6 +256,14 @@ void ConfigManager::loadFromStream(SeekableReadStream &stream) {
 	addDomain(domainName, domain); // Add the last domain found
 }
 
+String ConfigManager::getConfigFileName() const {
+	if (!_filename.empty())
+		return _filename;
+
+	assert(g_system);
+	return g_system->getDefaultConfigFileName();
+}
+
 void ConfigManager::flushToDisk() {
 #ifndef __DC__
 	WriteStream *stream;
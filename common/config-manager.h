@@ -102,6 +102,12 @@ public:
 	void				loadDefaultConfigFile();
 	void				loadConfigFile(const String &filename);
 
+	/**
+	 * Return the name of the configuration file in use: the one passed to
+	 * loadConfigFile(), or else the default one of the backend.
+	 */
+	String				getConfigFileName() const;
+
 	/**
 	 * Retrieve the config domain with the given name.
 	 * @param domName	the name of the domain to retrieve
@@ -0,0 +1,95 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef COMMON_CPUDETECT_H
+#define COMMON_CPUDETECT_H
+
+#include "common/scummsys.h"
+
+/**
+ * @file
+ * Detection of the vector instruction sets used by the optimized kernels.
+ *
+ * SCUMMVM_SSE2, SCUMMVM_AVX2 and SCUMMVM_NEON are defined when kernels for
+ * those instruction sets can be compiled, and the matching intrinsics are
+ * included. Functions using instructions the compiler does not enable by
+ * default are marked with TARGET_ATTR("sse2") or TARGET_ATTR("avx2"). They
+ * may only be called when hasSSE2() or hasAVX2() returns true.
+ */
+
+#if (defined(__x86_64__) || defined(__i386__)) && \
+	(defined(__clang__) || (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+#define SCUMMVM_SSE2
+#define SCUMMVM_AVX2
+#define TARGET_ATTR(x) __attribute__((target(x)))
+#include <immintrin.h>
+#elif defined(_MSC_VER) && defined(_M_X64)
+#define SCUMMVM_SSE2
+#define TARGET_ATTR(x)
+#include <emmintrin.h>
+#else
+#define TARGET_ATTR(x)
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define SCUMMVM_NEON
+#include <arm_neon.h>
+#endif
+
+namespace Common {
+
+/** Check whether SSE2 kernels can be used on this machine. */
+inline bool hasSSE2() {
+#if defined(SCUMMVM_SSE2) && defined(__GNUC__)
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("sse2");
+#elif defined(SCUMMVM_SSE2)
+	// SSE2 is part of the x86-64 baseline
+	return true;
+#else
+	return false;
+#endif
+}
+
+/** Check whether AVX2 kernels can be used on this machine. */
+inline bool hasAVX2() {
+#ifdef SCUMMVM_AVX2
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2");
+#else
+	return false;
+#endif
+}
+
+/** Check whether NEON kernels can be used on this machine. */
+inline bool hasNEON() {
+#ifdef SCUMMVM_NEON
+	// NEON is only enabled by the compiler when the target guarantees it
+	return true;
+#else
+	return false;
+#endif
+}
+
+} // End of namespace Common
+
+#endif
@@ -26,6 +26,7 @@
 #include "common/fs.h"
 #include "common/textconsole.h"
 #include "common/system.h"
+#include "common/trace.h"
 #include "backends/fs/fs-factory.h"
 
 namespace Common {
@@ -43,6 +44,7 @@ bool File::open(const String &filename) {
 }
 
 bool File::open(const String &filename, Archive &archive) {
+	TRACE_SCOPE("io", "File::open");
 	assert(!filename.empty());
 	assert(!_handle);
 
@@ -60,6 +62,7 @@ bool File::open(const String &filename, Archive &archive) {
 }
 
 bool File::open(const FSNode &node) {
+	TRACE_SCOPE("io", "File::open");
 	assert(!_handle);
 
 	if (!node.exists()) {
@@ -138,6 +141,11 @@ bool File::seek(int32 offs, int whence) {
 	return _handle->seek(offs, whence);
 }
 
+const byte *File::getDataView(uint32 offset, uint32 size) const {
+	assert(_handle);
+	return _handle->getDataView(offset, size);
+}
+
 uint32 File::read(void *ptr, uint32 len) {
 	assert(_handle);
 	return _handle->read(ptr, len);
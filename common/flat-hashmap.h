@@ -0,0 +1,601 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef COMMON_FLAT_HASHMAP_H
+#define COMMON_FLAT_HASHMAP_H
+
+#include "common/func.h"
+#include "common/textconsole.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FLAT_HASHMAP_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace Common {
+
+/**
+ * FlatHashMap<Key,Val> is an open addressing alternative to HashMap.
+ *
+ * HashMap stores a pointer per bucket and allocates a node for every entry,
+ * so each lookup has to chase at least one pointer, and probing touches
+ * nodes all over the heap. FlatHashMap instead keeps all keys in one
+ * contiguous array and all values in another, plus an array of one control
+ * byte per slot. The control byte holds 7 bits of the hash of the key in
+ * that slot (or marks the slot as empty or deleted), so a lookup first
+ * compares the control bytes of a whole group of 16 slots at once (using
+ * SSE2 where available) and only compares the keys of the slots which
+ * match.
+ *
+ * The API mirrors that of HashMap, so the two can be swapped by changing
+ * the type. The only difference is that iterators do not point to a stored
+ * node; dereferencing one yields a temporary object with _key and _value
+ * reference members. Hence "it->_key" and "it->_value" work as usual, but
+ * the result of "*it" cannot be bound to a non-const reference.
+ *
+ * Like with HashMap, erasing an entry does not invalidate iterators to other
+ * entries, but inserting one may.
+ */
+template<class Key, class Val, class HashFunc = Hash<Key>, class EqualFunc = EqualTo<Key> >
+class FlatHashMap {
+public:
+	typedef uint size_type;
+
+private:
+	typedef FlatHashMap<Key, Val, HashFunc, EqualFunc> FHM_t;
+
+	enum {
+		FLAT_HASHMAP_GROUP_SIZE = 16,
+		FLAT_HASHMAP_MIN_CAPACITY = 16,
+
+		// The storage is grown once more than 7/8 of the slots are either
+		// in use or marked as deleted. This guarantees that every probe
+		// sequence ends in an empty slot.
+		FLAT_HASHMAP_LOADFACTOR_NUMERATOR = 7,
+		FLAT_HASHMAP_LOADFACTOR_DENOMINATOR = 8
+	};
+
+	enum {
+		kCtrlEmpty = -128,
+		kCtrlDeleted = -2
+		// Slots in use store the (non-negative) 7 bit hash fragment
+	};
+
+	int8 *_ctrl;        ///< Control byte of each slot
+	Key *_keys;         ///< Keys, only constructed in slots in use
+	Val *_values;       ///< Values, only constructed in slots in use
+	size_type _capacity; ///< Number of slots; a power of two, multiple of the group size
+	size_type _size;
+	size_type _deleted; ///< Number of slots marked as deleted
+
+	HashFunc _hash;
+	EqualFunc _equal;
+
+	/** Default value, returned by the const getVal. */
+	const Val _defaultVal;
+
+	static uint32 mixHash(uint hash) {
+		// Many of our hash functions (e.g. the one for integers) do not mix
+		// their input at all, but we need good entropy in the top 7 bits.
+		return (uint32)hash * 2654435769U;
+	}
+
+	static int8 hashFragment(uint32 hash) {
+		return (int8)(hash >> 25);
+	}
+
+	size_type firstGroup(uint32 hash) const {
+		return (hash ^ (hash >> 15)) & (_capacity / FLAT_HASHMAP_GROUP_SIZE - 1);
+	}
+
+	static uint32 matchByte(const int8 *group, int8 value) {
+#ifdef FLAT_HASHMAP_USE_SSE2
+		const __m128i ctrl = _mm_loadu_si128((const __m128i *)group);
+		return (uint32)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(value)));
+#else
+		uint32 mask = 0;
+		for (int i = 0; i < FLAT_HASHMAP_GROUP_SIZE; ++i) {
+			if (group[i] == value)
+				mask |= 1 << i;
+		}
+		return mask;
+#endif
+	}
+
+	static uint32 matchEmptyOrDeleted(const int8 *group) {
+#ifdef FLAT_HASHMAP_USE_SSE2
+		// Empty and deleted are the only negative control values
+		return (uint32)_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)group));
+#else
+		uint32 mask = 0;
+		for (int i = 0; i < FLAT_HASHMAP_GROUP_SIZE; ++i) {
+			if (group[i] < 0)
+				mask |= 1 << i;
+		}
+		return mask;
+#endif
+	}
+
+	static uint lowestBit(uint32 mask) {
+#if defined(__GNUC__)
+		return __builtin_ctz(mask);
+#else
+		uint bit = 0;
+		while (!(mask & 1)) {
+			mask >>= 1;
+			bit++;
+		}
+		return bit;
+#endif
+	}
+
+	void allocStorage(size_type capacity);
+	void freeStorage();
+	void assign(const FHM_t &map);
+	size_type lookup(const Key &key) const;
+	size_type lookupAndCreateIfMissing(const Key &key);
+	size_type findInsertSlot(uint32 hash) const;
+	void eraseSlot(size_type idx);
+	void rehash(size_type newCapacity);
+
+	/**
+	 * Temporary view of an entry, returned when dereferencing an iterator.
+	 */
+	template<class ValType>
+	struct NodeRef {
+		const Key &_key;
+		ValType &_value;
+
+		NodeRef(const Key &key, ValType &value) : _key(key), _value(value) {}
+		const NodeRef *operator->() const { return this; }
+	};
+
+	/**
+	 * Simple FlatHashMap iterator implementation.
+	 */
+	template<class ValType>
+	class IteratorImpl {
+		friend class FlatHashMap;
+		template<class T> friend class IteratorImpl;
+	protected:
+		typedef const FlatHashMap hashmap_t;
+
+		size_type _idx;
+		hashmap_t *_hashmap;
+
+		IteratorImpl(size_type idx, hashmap_t *hashmap) : _idx(idx), _hashmap(hashmap) {}
+
+	public:
+		IteratorImpl() : _idx(0), _hashmap(0) {}
+		template<class T>
+		IteratorImpl(const IteratorImpl<T> &c) : _idx(c._idx), _hashmap(c._hashmap) {}
+
+		NodeRef<ValType> operator*() const {
+			assert(_hashmap != 0);
+			assert(_idx < _hashmap->_capacity);
+			assert(_hashmap->_ctrl[_idx] >= 0);
+			return NodeRef<ValType>(_hashmap->_keys[_idx], _hashmap->_values[_idx]);
+		}
+		NodeRef<ValType> operator->() const { return operator*(); }
+
+		bool operator==(const IteratorImpl &iter) const { return _idx == iter._idx && _hashmap == iter._hashmap; }
+		bool operator!=(const IteratorImpl &iter) const { return !(*this == iter); }
+
+		IteratorImpl &operator++() {
+			assert(_hashmap);
+			do {
+				_idx++;
+			} while (_idx < _hashmap->_capacity && _hashmap->_ctrl[_idx] < 0);
+			if (_idx >= _hashmap->_capacity)
+				_idx = (size_type)-1;
+
+			return *this;
+		}
+
+		IteratorImpl operator++(int) {
+			IteratorImpl old = *this;
+			operator ++();
+			return old;
+		}
+	};
+
+public:
+	typedef IteratorImpl<Val> iterator;
+	typedef IteratorImpl<const Val> const_iterator;
+
+	FlatHashMap();
+	FlatHashMap(const FHM_t &map);
+	~FlatHashMap();
+
+	FHM_t &operator=(const FHM_t &map) {
+		if (this == &map)
+			return *this;
+
+		// Remove the previous content and ...
+		freeStorage();
+		// ... copy the new stuff.
+		assign(map);
+		return *this;
+	}
+
+	bool contains(const Key &key) const;
+
+	Val &operator[](const Key &key);
+	const Val &operator[](const Key &key) const;
+
+	Val &getVal(const Key &key);
+	const Val &getVal(const Key &key) const;
+	const Val &getVal(const Key &key, const Val &defaultVal) const;
+	void setVal(const Key &key, const Val &val);
+
+	void clear(bool shrinkArray = 0);
+
+	void erase(iterator entry);
+	void erase(const Key &key);
+
+	size_type size() const { return _size; }
+
+	iterator	begin() {
+		// Find and return the first non-empty entry
+		for (size_type ctr = 0; ctr < _capacity; ++ctr) {
+			if (_ctrl[ctr] >= 0)
+				return iterator(ctr, this);
+		}
+		return end();
+	}
+	iterator	end() {
+		return iterator((size_type)-1, this);
+	}
+
+	const_iterator	begin() const {
+		// Find and return the first non-empty entry
+		for (size_type ctr = 0; ctr < _capacity; ++ctr) {
+			if (_ctrl[ctr] >= 0)
+				return const_iterator(ctr, this);
+		}
+		return end();
+	}
+	const_iterator	end() const {
+		return const_iterator((size_type)-1, this);
+	}
+
+	iterator	find(const Key &key) {
+		return iterator(lookup(key), this);
+	}
+
+	const_iterator	find(const Key &key) const {
+		return const_iterator(lookup(key), this);
+	}
+
+	bool empty() const {
+		return (_size == 0);
+	}
+};
+
+//-------------------------------------------------------
+// FlatHashMap functions
+
+/**
+ * Base constructor, creates an empty hashmap.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+FlatHashMap<Key, Val, HashFunc, EqualFunc>::FlatHashMap() : _defaultVal() {
+	allocStorage(FLAT_HASHMAP_MIN_CAPACITY);
+}
+
+/**
+ * Copy constructor, creates a full copy of the given hashmap.
+ * We must provide a custom copy constructor as we use pointers
+ * to heap buffers for the internal storage.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+FlatHashMap<Key, Val, HashFunc, EqualFunc>::FlatHashMap(const FHM_t &map) : _defaultVal() {
+	assign(map);
+}
+
+/**
+ * Destructor, frees all used memory.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+FlatHashMap<Key, Val, HashFunc, EqualFunc>::~FlatHashMap() {
+	freeStorage();
+}
+
+/**
+ * Allocate empty storage for the given number of slots.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::allocStorage(size_type capacity) {
+	assert(capacity % FLAT_HASHMAP_GROUP_SIZE == 0);
+	assert((capacity & (capacity - 1)) == 0);
+
+	_capacity = capacity;
+	_ctrl = new int8[capacity];
+	memset(_ctrl, kCtrlEmpty, capacity);
+
+	// Keys and values are constructed in place when a slot is taken
+	_keys = (Key *)malloc(capacity * sizeof(Key));
+	_values = (Val *)malloc(capacity * sizeof(Val));
+	if (!_keys || !_values)
+		error("FlatHashMap: Could not allocate storage for %u entries", capacity);
+
+	_size = 0;
+	_deleted = 0;
+}
+
+/**
+ * Destroy all entries and free the storage.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::freeStorage() {
+	for (size_type ctr = 0; ctr < _capacity; ++ctr) {
+		if (_ctrl[ctr] >= 0) {
+			_keys[ctr].~Key();
+			_values[ctr].~Val();
+		}
+	}
+
+	delete[] _ctrl;
+	free(_keys);
+	free(_values);
+	_ctrl = 0;
+	_keys = 0;
+	_values = 0;
+	_capacity = 0;
+	_size = 0;
+	_deleted = 0;
+}
+
+/**
+ * Internal method for assigning the content of another FlatHashMap
+ * to this one.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::assign(const FHM_t &map) {
+	allocStorage(map._capacity);
+
+	// Using the same capacity means every entry can stay in its slot
+	memcpy(_ctrl, map._ctrl, _capacity);
+	for (size_type ctr = 0; ctr < _capacity; ++ctr) {
+		if (_ctrl[ctr] >= 0) {
+			new ((void *)&_keys[ctr]) Key(map._keys[ctr]);
+			new ((void *)&_values[ctr]) Val(map._values[ctr]);
+		}
+	}
+
+	_size = map._size;
+	_deleted = map._deleted;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::clear(bool shrinkArray) {
+	if (shrinkArray && _capacity > FLAT_HASHMAP_MIN_CAPACITY) {
+		freeStorage();
+		allocStorage(FLAT_HASHMAP_MIN_CAPACITY);
+		return;
+	}
+
+	for (size_type ctr = 0; ctr < _capacity; ++ctr) {
+		if (_ctrl[ctr] >= 0) {
+			_keys[ctr].~Key();
+			_values[ctr].~Val();
+		}
+	}
+	memset(_ctrl, kCtrlEmpty, _capacity);
+
+	_size = 0;
+	_deleted = 0;
+}
+
+/**
+ * Move all entries into freshly allocated storage with the given capacity.
+ * This also gets rid of all slots marked as deleted.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::rehash(size_type newCapacity) {
+	assert(newCapacity * FLAT_HASHMAP_LOADFACTOR_NUMERATOR >= _size * FLAT_HASHMAP_LOADFACTOR_DENOMINATOR);
+
+	int8 *oldCtrl = _ctrl;
+	Key *oldKeys = _keys;
+	Val *oldValues = _values;
+	const size_type oldCapacity = _capacity;
+	const size_type oldSize = _size;
+
+	allocStorage(newCapacity);
+
+	for (size_type ctr = 0; ctr < oldCapacity; ++ctr) {
+		if (oldCtrl[ctr] < 0)
+			continue;
+
+		const uint32 hash = mixHash(_hash(oldKeys[ctr]));
+		const size_type idx = findInsertSlot(hash);
+		_ctrl[idx] = hashFragment(hash);
+		new ((void *)&_keys[idx]) Key(oldKeys[ctr]);
+		new ((void *)&_values[idx]) Val(oldValues[ctr]);
+
+		oldKeys[ctr].~Key();
+		oldValues[ctr].~Val();
+	}
+
+	_size = oldSize;
+
+	delete[] oldCtrl;
+	free(oldKeys);
+	free(oldValues);
+}
+
+/**
+ * Return the index of the slot holding the given key, or (size_type)-1 if
+ * the key is not contained in the map.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+typename FlatHashMap<Key, Val, HashFunc, EqualFunc>::size_type FlatHashMap<Key, Val, HashFunc, EqualFunc>::lookup(const Key &key) const {
+	const uint32 hash = mixHash(_hash(key));
+	const int8 fragment = hashFragment(hash);
+	const size_type groupMask = _capacity / FLAT_HASHMAP_GROUP_SIZE - 1;
+	size_type group = firstGroup(hash);
+
+	// Triangular probing over the groups; this visits every group once
+	// since the number of groups is a power of two.
+	for (size_type step = 1; ; ++step) {
+		const int8 *ctrl = _ctrl + group * FLAT_HASHMAP_GROUP_SIZE;
+
+		for (uint32 match = matchByte(ctrl, fragment); match; match &= match - 1) {
+			const size_type idx = group * FLAT_HASHMAP_GROUP_SIZE + lowestBit(match);
+			if (_equal(_keys[idx], key))
+				return idx;
+		}
+
+		// An empty slot ends the probe sequence: had the key been inserted,
+		// it would have ended up here at the latest.
+		if (matchByte(ctrl, kCtrlEmpty))
+			return (size_type)-1;
+
+		group = (group + step) & groupMask;
+	}
+}
+
+/**
+ * Return the index of the first empty or deleted slot along the probe
+ * sequence of the given hash.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+typename FlatHashMap<Key, Val, HashFunc, EqualFunc>::size_type FlatHashMap<Key, Val, HashFunc, EqualFunc>::findInsertSlot(uint32 hash) const {
+	const size_type groupMask = _capacity / FLAT_HASHMAP_GROUP_SIZE - 1;
+	size_type group = firstGroup(hash);
+
+	for (size_type step = 1; ; ++step) {
+		const uint32 match = matchEmptyOrDeleted(_ctrl + group * FLAT_HASHMAP_GROUP_SIZE);
+		if (match)
+			return group * FLAT_HASHMAP_GROUP_SIZE + lowestBit(match);
+
+		group = (group + step) & groupMask;
+	}
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+typename FlatHashMap<Key, Val, HashFunc, EqualFunc>::size_type FlatHashMap<Key, Val, HashFunc, EqualFunc>::lookupAndCreateIfMissing(const Key &key) {
+	size_type idx = lookup(key);
+	if (idx != (size_type)-1)
+		return idx;
+
+	if ((_size + _deleted + 1) * FLAT_HASHMAP_LOADFACTOR_DENOMINATOR > _capacity * FLAT_HASHMAP_LOADFACTOR_NUMERATOR) {
+		// If at most half of the load consists of live entries, purging the
+		// deleted slots frees enough space; otherwise double the capacity.
+		if ((_size + 1) * 2 * FLAT_HASHMAP_LOADFACTOR_DENOMINATOR <= _capacity * FLAT_HASHMAP_LOADFACTOR_NUMERATOR)
+			rehash(_capacity);
+		else
+			rehash(_capacity * 2);
+	}
+
+	const uint32 hash = mixHash(_hash(key));
+	idx = findInsertSlot(hash);
+	if (_ctrl[idx] == kCtrlDeleted)
+		_deleted--;
+
+	_ctrl[idx] = hashFragment(hash);
+	new ((void *)&_keys[idx]) Key(key);
+	new ((void *)&_values[idx]) Val();
+	_size++;
+
+	return idx;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::eraseSlot(size_type idx) {
+	assert(idx < _capacity && _ctrl[idx] >= 0);
+
+	_keys[idx].~Key();
+	_values[idx].~Val();
+
+	// Probe sequences never go past a group containing an empty slot, so
+	// in that case no other key can depend on this slot being occupied.
+	const size_type groupStart = idx & ~(size_type)(FLAT_HASHMAP_GROUP_SIZE - 1);
+	if (matchByte(_ctrl + groupStart, kCtrlEmpty)) {
+		_ctrl[idx] = kCtrlEmpty;
+	} else {
+		_ctrl[idx] = kCtrlDeleted;
+		_deleted++;
+	}
+
+	_size--;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+bool FlatHashMap<Key, Val, HashFunc, EqualFunc>::contains(const Key &key) const {
+	return lookup(key) != (size_type)-1;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::operator[](const Key &key) {
+	return getVal(key);
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+const Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::operator[](const Key &key) const {
+	return getVal(key);
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::getVal(const Key &key) {
+	// Inserting may reallocate _values, so do not index it in the same expression
+	const size_type idx = lookupAndCreateIfMissing(key);
+	return _values[idx];
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+const Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::getVal(const Key &key) const {
+	return getVal(key, _defaultVal);
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+const Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::getVal(const Key &key, const Val &defaultVal) const {
+	const size_type idx = lookup(key);
+	if (idx != (size_type)-1)
+		return _values[idx];
+	else
+		return defaultVal;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::setVal(const Key &key, const Val &val) {
+	const size_type idx = lookupAndCreateIfMissing(key);
+	_values[idx] = val;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::erase(iterator entry) {
+	// Check whether we have a valid iterator
+	assert(entry._hashmap == this);
+	eraseSlot(entry._idx);
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::erase(const Key &key) {
+	const size_type idx = lookup(key);
+	if (idx != (size_type)-1)
+		eraseSlot(idx);
+}
+
+} // End of namespace Common
+
+#endif
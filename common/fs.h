@@ -213,6 +213,23 @@ public:
 	 */
 	bool isWritable() const;
 
+	/**
+	 * Returns the time of the last modification of the object referred by
+	 * this node. The value is only meant to be compared with earlier values
+	 * for the same node to detect changes.
+	 *
+	 * @return the modification time, or 0 if it cannot be determined
+	 */
+	uint32 getModificationTime() const;
+
+	/**
+	 * Returns the size of the file referred by this node, without opening
+	 * it.
+	 *
+	 * @return the size in bytes, or -1 if it cannot be determined
+	 */
+	int32 getFileSize() const;
+
 	/**
 	 * Creates a SeekableReadStream instance corresponding to the file
 	 * referred by this node. This assumes that the node actually refers
@@ -0,0 +1,210 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef COMMON_LRU_CACHE_H
+#define COMMON_LRU_CACHE_H
+
+#include "common/hashmap.h"
+#include "common/noncopyable.h"
+
+namespace Common {
+
+/**
+ * LRUCache<Key,Val> keeps values up to a memory budget, dropping the least
+ * recently used ones to make room for new ones.
+ *
+ * The caller gives the size of each value when adding it. The entries are
+ * kept in a doubly linked list ordered by their last use, whose links are
+ * stored in the entries themselves, so looking up, adding and dropping an
+ * entry take constant time.
+ *
+ * It also counts the hits, misses and evictions, to tune the budget.
+ */
+template<class Key, class Val, class HashFunc = Hash<Key>, class EqualFunc = EqualTo<Key> >
+class LRUCache : NonCopyable {
+	struct Node {
+		Node(const Key &k, const Val &v, uint32 s) : key(k), value(v), size(s), prev(0), next(0) {}
+
+		Key key;
+		Val value;
+		uint32 size;
+		/** The next more and less recently used entries */
+		Node *prev, *next;
+	};
+
+	typedef HashMap<Key, Node *, HashFunc, EqualFunc> NodeMap;
+
+	NodeMap _nodes;
+	/** The most recently used entry */
+	Node *_first;
+	/** The least recently used entry */
+	Node *_last;
+
+	uint32 _size;
+	uint32 _maxSize;
+
+	uint32 _hits;
+	uint32 _misses;
+	uint32 _evictions;
+
+	void detach(Node *node) {
+		if (node->prev)
+			node->prev->next = node->next;
+		else
+			_first = node->next;
+
+		if (node->next)
+			node->next->prev = node->prev;
+		else
+			_last = node->prev;
+	}
+
+	void pushFront(Node *node) {
+		node->prev = 0;
+		node->next = _first;
+		if (_first)
+			_first->prev = node;
+		else
+			_last = node;
+		_first = node;
+	}
+
+	void erase(Node *node) {
+		detach(node);
+		_nodes.erase(node->key);
+		_size -= node->size;
+		delete node;
+	}
+
+	void trim(uint32 maxSize) {
+		while (_size > maxSize) {
+			erase(_last);
+			++_evictions;
+		}
+	}
+
+public:
+	/**
+	 * @param maxSize	the maximum total size of the values
+	 */
+	explicit LRUCache(uint32 maxSize) : _first(0), _last(0), _size(0), _maxSize(maxSize),
+		_hits(0), _misses(0), _evictions(0) {}
+
+	~LRUCache() { clear(); }
+
+	/**
+	 * Look up a value and mark it as the most recently used, counting a hit
+	 * or a miss.
+	 *
+	 * @return the value, or 0 if it is not cached. It stays valid until the
+	 *         entry is dropped.
+	 */
+	Val *get(const Key &key) {
+		typename NodeMap::const_iterator i = _nodes.find(key);
+		if (i == _nodes.end()) {
+			++_misses;
+			return 0;
+		}
+
+		++_hits;
+		Node *node = i->_value;
+		detach(node);
+		pushFront(node);
+		return &node->value;
+	}
+
+	/**
+	 * Add a value, replacing the one with the same key, and drop the least
+	 * recently used values which don't fit anymore.
+	 *
+	 * @return true if the value was added, false if it is bigger than the
+	 *         whole budget
+	 */
+	bool put(const Key &key, const Val &value, uint32 size) {
+		remove(key);
+		if (size > _maxSize)
+			return false;
+
+		trim(_maxSize - size);
+
+		Node *node = new Node(key, value, size);
+		_nodes[key] = node;
+		pushFront(node);
+		_size += size;
+		return true;
+	}
+
+	/** Drop the value with the given key, if it is cached. */
+	void remove(const Key &key) {
+		typename NodeMap::const_iterator i = _nodes.find(key);
+		if (i != _nodes.end())
+			erase(i->_value);
+	}
+
+	/**
+	 * Drop all values for which the predicate returns true.
+	 * @param pred	a functor called with the key and the value
+	 */
+	template<class Pred>
+	void removeIf(Pred pred) {
+		for (Node *node = _first; node; ) {
+			Node *next = node->next;
+			if (pred(node->key, node->value))
+				erase(node);
+			node = next;
+		}
+	}
+
+	/** Drop all values. */
+	void clear() {
+		while (_first) {
+			Node *next = _first->next;
+			delete _first;
+			_first = next;
+		}
+		_last = 0;
+		_nodes.clear();
+		_size = 0;
+	}
+
+	/** Change the memory budget, dropping values which don't fit anymore. */
+	void setMaxSize(uint32 maxSize) {
+		_maxSize = maxSize;
+		trim(maxSize);
+	}
+	uint32 getMaxSize() const { return _maxSize; }
+
+	/** Return the total size of the cached values. */
+	uint32 getSize() const { return _size; }
+
+	/** Return the number of cached values. */
+	uint getCount() const { return _nodes.size(); }
+
+	uint32 getHits() const { return _hits; }
+	uint32 getMisses() const { return _misses; }
+	uint32 getEvictions() const { return _evictions; }
+	void resetStatistics() { _hits = _misses = _evictions = 0; }
+};
+
+} // End of namespace Common
+
+#endif
@@ -33,7 +33,9 @@ MODULE_OBJS := \
 	stream.o \
 	system.o \
 	textconsole.o \
+	thread.o \
 	tokenizer.o \
+	trace.o \
 	translation.o \
 	unarj.o \
 	unzip.o \
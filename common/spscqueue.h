@@ -0,0 +1,93 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef COMMON_SPSCQUEUE_H
+#define COMMON_SPSCQUEUE_H
+
+#include "common/scummsys.h"
+#include "common/atomic.h"
+#include "common/noncopyable.h"
+
+namespace Common {
+
+/**
+ * A fixed size FIFO queue which one thread can push to while another one
+ * pops from it, without locking.
+ *
+ * There must be at most one producer and one consumer at any time. If more
+ * threads push, or pop, they have to serialize that among themselves.
+ * The queue holds SIZE - 1 elements at most.
+ */
+template<class T, uint SIZE>
+class SPSCQueue : NonCopyable {
+public:
+	SPSCQueue() : _head(0), _tail(0) {}
+
+	/**
+	 * Add an element at the end of the queue. Producer only.
+	 *
+	 * @return false if the queue is full
+	 */
+	bool push(const T &item) {
+		const uint32 tail = _tail;
+		const uint32 next = (tail + 1) % SIZE;
+		if (next == atomicLoad(_head))
+			return false;
+
+		_items[tail] = item;
+		atomicStore(_tail, next);
+		return true;
+	}
+
+	/**
+	 * Remove the first element of the queue. Consumer only.
+	 *
+	 * @return false if the queue is empty
+	 */
+	bool pop(T &item) {
+		const uint32 head = _head;
+		if (head == atomicLoad(_tail))
+			return false;
+
+		item = _items[head];
+		atomicStore(_head, (head + 1) % SIZE);
+		return true;
+	}
+
+	/**
+	 * Check whether the queue is empty. From the producer's point of view,
+	 * it may become empty at any time, and from the consumer's point of
+	 * view, it may stop being empty at any time.
+	 */
+	bool empty() const {
+		return atomicLoad(_head) == atomicLoad(_tail);
+	}
+
+private:
+	T _items[SIZE];
+	volatile uint32 _head;	///< next element to pop, only written by the consumer
+	volatile uint32 _tail;	///< next element to push, only written by the producer
+};
+
+} // End of namespace Common
+
+#endif
@@ -102,6 +102,12 @@ bool MemoryReadStream::seek(int32 offs, int whence) {
 	return true;	// FIXME: STREAM REWRITE
 }
 
+const byte *MemoryReadStream::getDataView(uint32 offset, uint32 size) const {
+	if (offset > _size || size > _size - offset)
+		return nullptr;
+	return _ptrOrig + offset;
+}
+
 bool MemoryWriteStreamDynamic::seek(int32 offs, int whence) {
 	// Pre-Condition
 	assert(_pos <= _size);
@@ -261,6 +267,13 @@ bool SeekableSubReadStream::seek(int32 offset, int whence) {
 	return ret;
 }
 
+const byte *SeekableSubReadStream::getDataView(uint32 offset, uint32 size) const {
+	const uint32 subSize = _end - _begin;
+	if (offset > subSize || size > subSize - offset)
+		return nullptr;
+	return _parentStream->getDataView(_begin + offset, size);
+}
+
 uint32 SafeSeekableSubReadStream::read(void *dataPtr, uint32 dataSize) {
 	// Make sure the parent stream is at the right position
 	seek(0, SEEK_CUR);
@@ -403,6 +416,8 @@ public:
 	virtual int32 size() const { return _parentStream->size(); }
 
 	virtual bool seek(int32 offset, int whence = SEEK_SET);
+
+	virtual const byte *getDataView(uint32 offset, uint32 size) const { return _parentStream->getDataView(offset, size); }
 };
 
 BufferedSeekableReadStream::BufferedSeekableReadStream(SeekableReadStream *parentStream, uint32 bufSize, DisposeAfterUse::Flag disposeParentStream)
@@ -457,8 +472,14 @@ bool BufferedSeekableReadStream::seek(int32 offset, int whence) {
 } // End of anonymous namespace
 
 SeekableReadStream *wrapBufferedSeekableReadStream(SeekableReadStream *parentStream, uint32 bufSize, DisposeAfterUse::Flag disposeParentStream) {
-	if (parentStream)
+	if (parentStream) {
+		// Buffering a stream which is already in memory only adds copies.
+		// We can only skip the wrapper if the caller hands over ownership.
+		if (disposeParentStream == DisposeAfterUse::YES && parentStream->size() >= 0 &&
+		    parentStream->getDataView(0, parentStream->size()))
+			return parentStream;
 		return new BufferedSeekableReadStream(parentStream, bufSize, disposeParentStream);
+	}
 	return 0;
 }
 
@@ -527,6 +527,22 @@ public:
 	 */
 	virtual bool skip(uint32 offset) { return seek(offset, SEEK_CUR); }
 
+	/**
+	 * Gives direct read access to a range of the stream's data, without
+	 * copying it. This is only possible for streams which have all their
+	 * data in memory, e.g. memory streams or memory mapped files; for all
+	 * others, callers have to fall back to read().
+	 *
+	 * The returned pointer stays valid for as long as the stream exists.
+	 * The stream position indicator is not changed.
+	 *
+	 * @param offset	the start of the range, relative to the start of the stream
+	 * @param size	the size of the range in bytes
+	 * @return a pointer to the data, or nullptr if the stream does not support
+	 *         direct access or the range is not completely inside the stream
+	 */
+	virtual const byte *getDataView(uint32 offset, uint32 size) const { return nullptr; }
+
 	/**
 	 * Reads at most one less than the number of characters specified
 	 * by bufSize from the and stores them in the string buf. Reading
@@ -34,6 +34,7 @@ class Mixer;
 
 namespace Graphics {
 struct Surface;
+struct YUV420Frame;
 }
 
 namespace Common {
@@ -366,7 +367,13 @@ public:
 		/**
 		* shaders
 		*/
-		kFeatureShader
+		kFeatureShader,
+
+		/**
+		 * Video frames in YUV 4:2:0 can be shown with copyYUVFrameToScreen,
+		 * leaving the conversion to RGB to the backend (e.g. the GPU).
+		 */
+		kFeatureYUVFrames
 
 	};
 
@@ -774,6 +781,22 @@ public:
 	 */
 	virtual void fillScreen(uint32 col) = 0;
 
+	/**
+	 * Show a video frame in YUV 4:2:0 on the screen, with its top left
+	 * corner at the given position. The frame is shown on top of the game
+	 * screen until a new frame is passed, or until the game screen is changed
+	 * in the area covered by the frame through copyRectToScreen, lockScreen
+	 * or fillScreen. Like other screen changes, it only becomes visible with
+	 * the next call to updateScreen.
+	 *
+	 * The planes are copied, so the caller may reuse them after the call.
+	 * Only available if kFeatureYUVFrames is supported.
+	 *
+	 * @see kFeatureYUVFrames
+	 * @see Video::VideoDecoder::setYUVOutput
+	 */
+	virtual void copyYUVFrameToScreen(const Graphics::YUV420Frame &frame, int x, int y) {}
+
 	/**
 	 * Flush the whole screen, that is render the current content of the screen
 	 * framebuffer to the display.
@@ -1059,6 +1082,9 @@ public:
 	 *
 	 * Hence backends which do not use threads to implement the timers simply
 	 * can use dummy implementations for these methods.
+	 *
+	 * Backends may offer threads again for optional background work, see
+	 * createThread().
 	 */
 	//@{
 
@@ -1100,6 +1126,85 @@ public:
 
 
 
+	/**
+	 * @name Threads
+	 * Some work, like decoding video frames ahead, is best done on a thread
+	 * of its own, so that it neither holds up the engine thread nor the
+	 * timer and audio threads.
+	 *
+	 * Threads are optional. Backends without them keep the default
+	 * implementations, which never start a thread. Code using threads must
+	 * then do the work itself, on its own thread. Backends which implement
+	 * createThread() must implement the semaphores as well.
+	 */
+	//@{
+
+	typedef struct OpaqueThread *ThreadRef;
+	typedef struct OpaqueSemaphore *SemaphoreRef;
+
+	/** A function run on a thread of its own. */
+	typedef void (*ThreadProc)(void *param);
+
+	/**
+	 * Start a new thread.
+	 *
+	 * @param proc	the function to run on the thread
+	 * @param param	the parameter passed to proc
+	 * @param name	the name of the thread, for debugging
+	 * @return the new thread, or 0 if threads are not supported or an
+	 *         error occurred.
+	 */
+	virtual ThreadRef createThread(ThreadProc proc, void *param, const char *name) { return 0; }
+
+	/**
+	 * Wait for the function of a thread to return, and free the thread.
+	 * @param thread	the thread to wait for.
+	 */
+	virtual void joinThread(ThreadRef thread) {}
+
+	/**
+	 * Create a new semaphore.
+	 * @param value	the initial count of the semaphore.
+	 * @return the newly created semaphore, or 0 if an error occurred.
+	 */
+	virtual SemaphoreRef createSemaphore(uint value) { return 0; }
+
+	/**
+	 * Wait for the count of the semaphore to be above zero, and decrement it.
+	 *
+	 * @param semaphore	the semaphore to wait for.
+	 * @param timeout	the maximum time to wait in milliseconds, or -1 to
+	 *                  wait as long as needed.
+	 * @return true if the count was decremented, false on timeout.
+	 */
+	virtual bool waitSemaphore(SemaphoreRef semaphore, int timeout = -1) { return false; }
+
+	/**
+	 * Increment the count of the semaphore, waking up a thread waiting for it.
+	 * @param semaphore	the semaphore to increment.
+	 */
+	virtual void postSemaphore(SemaphoreRef semaphore) {}
+
+	/**
+	 * Delete the given semaphore. No thread may wait for it anymore.
+	 * @param semaphore	the semaphore to delete.
+	 */
+	virtual void deleteSemaphore(SemaphoreRef semaphore) {}
+
+	/**
+	 * Returns an identifier of the calling thread. It differs from the
+	 * identifiers of all other running threads, including those not
+	 * started through createThread().
+	 *
+	 * @return the identifier of the calling thread, or 0 if threads are
+	 *         not supported.
+	 */
+	virtual uint64 getCurrentThreadId() { return 0; }
+
+	//@}
+
+
+
 	/** @name Sound */
 	//@{
 
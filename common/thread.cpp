@@ -0,0 +1,69 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "common/thread.h"
+
+namespace Common {
+
+Thread::Thread() : _thread(0) {
+}
+
+Thread::~Thread() {
+	join();
+}
+
+bool Thread::start(OSystem::ThreadProc proc, void *param, const char *name) {
+	assert(g_system && !_thread);
+	_thread = g_system->createThread(proc, param, name);
+	return _thread != 0;
+}
+
+void Thread::join() {
+	if (!_thread)
+		return;
+
+	g_system->joinThread(_thread);
+	_thread = 0;
+}
+
+
+#pragma mark -
+
+
+Semaphore::Semaphore(uint value) {
+	assert(g_system);
+	_semaphore = g_system->createSemaphore(value);
+}
+
+Semaphore::~Semaphore() {
+	g_system->deleteSemaphore(_semaphore);
+}
+
+bool Semaphore::wait(int timeout) {
+	return g_system->waitSemaphore(_semaphore, timeout);
+}
+
+void Semaphore::post() {
+	g_system->postSemaphore(_semaphore);
+}
+
+} // End of namespace Common
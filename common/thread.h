@@ -0,0 +1,81 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef COMMON_THREAD_H
+#define COMMON_THREAD_H
+
+#include "common/scummsys.h"
+#include "common/noncopyable.h"
+#include "common/system.h"
+
+namespace Common {
+
+/**
+ * Wrapper class around the OSystem thread functions.
+ *
+ * Not all backends support threads, so start() may fail. The work then has
+ * to be done on the calling thread instead.
+ */
+class Thread : NonCopyable {
+	OSystem::ThreadRef _thread;
+
+public:
+	Thread();
+
+	/** Wait for the thread to end, if it was started. */
+	~Thread();
+
+	/**
+	 * Start running the given function on a new thread.
+	 *
+	 * @return true on success, false if threads are not supported or the
+	 *         thread could not be started
+	 */
+	bool start(OSystem::ThreadProc proc, void *param, const char *name);
+
+	/** Wait for the function to return. Does nothing if not started. */
+	void join();
+
+	/** Whether the thread has been started and not joined yet. */
+	bool isRunning() const { return _thread != 0; }
+};
+
+
+/**
+ * Wrapper class around the OSystem semaphore functions, to let threads
+ * wait for each other. Only needed together with Thread.
+ */
+class Semaphore : NonCopyable {
+	OSystem::SemaphoreRef _semaphore;
+
+public:
+	explicit Semaphore(uint value = 0);
+	~Semaphore();
+
+	/** @see OSystem::waitSemaphore() */
+	bool wait(int timeout = -1);
+	void post();
+};
+
+} // End of namespace Common
+
+#endif
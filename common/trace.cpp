@@ -0,0 +1,253 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#define FORBIDDEN_SYMBOL_EXCEPTION_time_h
+
+#if defined(WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+// winnt.h defines ARRAYSIZE, but we want our own one...
+#undef ARRAYSIZE
+#endif
+
+#include "common/trace.h"
+
+#ifdef USE_TRACING
+
+#include "common/file.h"
+#include "common/mutex.h"
+#include "common/str.h"
+#include "common/system.h"
+#include "common/textconsole.h"
+
+#ifdef POSIX
+#include <pthread.h>
+#include <time.h>
+#endif
+
+namespace Common {
+
+enum {
+	/** Number of events buffered before they are written to the file. */
+	kTraceBufferSize = 4096,
+	/** Number of threads told apart; any others share the last id. */
+	kTraceMaxThreads = 16
+};
+
+struct TraceEvent {
+	const char *category;
+	const char *name;
+	uint64 start;
+	uint32 duration;
+	uint32 thread;
+};
+
+volatile uint32 g_tracing = 0;
+
+// The mutexes are never deleted, since another thread may still be about
+// to record an event when tracing stops. The first one guards the buffer
+// events are recorded into. A full buffer is swapped for the other one and
+// written under the file mutex only, so recording doesn't wait for the
+// file. The file mutex is always locked first, and both are needed to
+// change the file.
+static Mutex *s_traceMutex = 0;
+static Mutex *s_traceFileMutex = 0;
+static DumpFile *s_traceFile = 0;
+static uint64 s_traceStart = 0;
+static bool s_traceFirstEvent = true;
+static TraceEvent s_traceBuffers[2][kTraceBufferSize];
+static TraceEvent *s_traceEvents = s_traceBuffers[0];
+static uint s_traceEventCount = 0;
+
+#ifdef POSIX
+static pthread_t s_traceThreads[kTraceMaxThreads];
+static uint s_traceThreadCount = 0;
+#endif
+
+uint64 getTraceMicros() {
+#if defined(POSIX) && defined(CLOCK_MONOTONIC)
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+#elif defined(WIN32)
+	LARGE_INTEGER counter, frequency;
+	QueryPerformanceCounter(&counter);
+	QueryPerformanceFrequency(&frequency);
+	return (uint64)(counter.QuadPart / frequency.QuadPart) * 1000000 + (uint64)(counter.QuadPart % frequency.QuadPart) * 1000000 / frequency.QuadPart;
+#else
+	return (uint64)g_system->getMillis() * 1000;
+#endif
+}
+
+/** Return a small number identifying the calling thread. Needs the mutex. */
+static uint32 getTraceThread() {
+#if defined(POSIX)
+	const pthread_t self = pthread_self();
+	for (uint i = 0; i < s_traceThreadCount; ++i) {
+		if (pthread_equal(s_traceThreads[i], self))
+			return i;
+	}
+	if (s_traceThreadCount == kTraceMaxThreads)
+		return kTraceMaxThreads - 1;
+	s_traceThreads[s_traceThreadCount] = self;
+	return s_traceThreadCount++;
+#elif defined(WIN32)
+	return GetCurrentThreadId();
+#else
+	return 0;
+#endif
+}
+
+/**
+ * Take the recorded events, and record further ones into the other buffer.
+ * Needs both mutexes, so that the other buffer has been written already.
+ */
+static const TraceEvent *swapTraceEvents(uint &count) {
+	const TraceEvent *events = s_traceEvents;
+	count = s_traceEventCount;
+
+	s_traceEvents = (s_traceEvents == s_traceBuffers[0]) ? s_traceBuffers[1] : s_traceBuffers[0];
+	s_traceEventCount = 0;
+	return events;
+}
+
+/** Write events to the file. Needs the file mutex. */
+static void writeTraceEvents(const TraceEvent *events, uint count) {
+	for (uint i = 0; i < count; ++i) {
+		const TraceEvent &event = events[i];
+		s_traceFile->writeString(String::format("%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%llu,\"dur\":%u}",
+			s_traceFirstEvent ? "" : ",\n", event.name, event.category, event.thread,
+			(unsigned long long)(event.start - s_traceStart), event.duration));
+		s_traceFirstEvent = false;
+	}
+}
+
+/** Write the events recorded so far if the buffer is full. */
+static void flushTraceEvents() {
+	StackLock fileLock(*s_traceFileMutex);
+
+	const TraceEvent *events;
+	uint count;
+	{
+		StackLock lock(*s_traceMutex);
+		if (!s_traceFile || s_traceEventCount < kTraceBufferSize)
+			return;
+
+		events = swapTraceEvents(count);
+	}
+
+	writeTraceEvents(events, count);
+}
+
+bool startTracing(const String &fileName) {
+	if (!s_traceMutex) {
+		s_traceMutex = new Mutex();
+		s_traceFileMutex = new Mutex();
+	}
+
+	StackLock fileLock(*s_traceFileMutex);
+	StackLock lock(*s_traceMutex);
+	if (s_traceFile)
+		return false;
+
+	s_traceFile = new DumpFile();
+	if (!s_traceFile->open(fileName)) {
+		warning("Could not create trace file '%s'", fileName.c_str());
+		delete s_traceFile;
+		s_traceFile = 0;
+		return false;
+	}
+
+	// Viewers also accept a file which was not closed properly, e.g.
+	// because of a crash
+	s_traceFile->writeString("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	s_traceStart = getTraceMicros();
+	s_traceFirstEvent = true;
+	s_traceEventCount = 0;
+	atomicStore(g_tracing, (uint32)1);
+	return true;
+}
+
+void stopTracing() {
+	if (!s_traceMutex)
+		return;
+
+	StackLock fileLock(*s_traceFileMutex);
+
+	const TraceEvent *events;
+	uint count;
+	{
+		StackLock lock(*s_traceMutex);
+		if (!s_traceFile)
+			return;
+
+		atomicStore(g_tracing, (uint32)0);
+		events = swapTraceEvents(count);
+	}
+
+	writeTraceEvents(events, count);
+	s_traceFile->writeString("\n]}\n");
+	s_traceFile->finalize();
+
+	// Events which were still recorded meanwhile are dropped
+	StackLock lock(*s_traceMutex);
+	delete s_traceFile;
+	s_traceFile = 0;
+}
+
+void addTraceEvent(const char *category, const char *name, uint64 start) {
+	if (!isTracing())
+		return;
+
+	const uint64 end = getTraceMicros();
+
+	bool recorded = false;
+	while (!recorded) {
+		{
+			StackLock lock(*s_traceMutex);
+			if (!s_traceFile || start < s_traceStart)
+				return;
+
+			// Unless the buffer is full and about to be written
+			if (s_traceEventCount < kTraceBufferSize) {
+				TraceEvent &event = s_traceEvents[s_traceEventCount++];
+				event.category = category;
+				event.name = name;
+				event.start = start;
+				event.duration = (uint32)(end - start);
+				event.thread = getTraceThread();
+
+				if (s_traceEventCount < kTraceBufferSize)
+					return;
+				recorded = true;
+			}
+		}
+
+		// Write the full buffer, or wait until it has been written, outside
+		// of the lock
+		flushTraceEvents();
+	}
+}
+
+} // End of namespace Common
+
+#endif
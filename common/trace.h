@@ -0,0 +1,121 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef COMMON_TRACE_H
+#define COMMON_TRACE_H
+
+#include "common/scummsys.h"
+
+/**
+ * @file
+ * Scoped markers which record how long hot code paths take, written as
+ * Chrome trace events. The resulting file can be opened with
+ * chrome://tracing or https://ui.perfetto.dev.
+ *
+ * Tracing is only compiled in when configuring with --enable-tracing, and
+ * then started with the --trace-file command line option. Otherwise
+ * TRACE_SCOPE expands to nothing.
+ *
+ * Usage:
+ * @code
+ * void MyEngine::updateFrame() {
+ *     TRACE_SCOPE("engine", "MyEngine::updateFrame");
+ *     ...
+ * }
+ * @endcode
+ */
+
+#ifdef USE_TRACING
+
+#include "common/atomic.h"
+#include "common/noncopyable.h"
+
+namespace Common {
+
+class String;
+
+/**
+ * Start writing trace events to the given file. Events recorded before,
+ * or after stopTracing(), are dropped.
+ *
+ * @return false if the file could not be created
+ */
+bool startTracing(const String &fileName);
+
+/** Write the remaining events and close the trace file. */
+void stopTracing();
+
+extern volatile uint32 g_tracing;
+
+/**
+ * Check whether events are being recorded. This is all trace markers do
+ * while tracing is off, so it does not take any lock.
+ */
+inline bool isTracing() { return atomicLoad(g_tracing) != 0; }
+
+/** Return the current time in microseconds, for trace events. */
+uint64 getTraceMicros();
+
+/**
+ * Record an event which started at the given time and ends now.
+ *
+ * The category and name are not copied, they have to be string literals
+ * (or live until tracing stops), and must not need escaping in JSON.
+ */
+void addTraceEvent(const char *category, const char *name, uint64 start);
+
+/**
+ * Record how long the current scope takes. Use the TRACE_SCOPE macro
+ * instead of this class, so the markers disappear when tracing is not
+ * compiled in.
+ */
+class TraceScope : NonCopyable {
+public:
+	TraceScope(const char *category, const char *name) : _category(category), _name(name), _start(0) {
+		if (isTracing())
+			_start = getTraceMicros();
+	}
+
+	~TraceScope() {
+		if (_start && isTracing())
+			addTraceEvent(_category, _name, _start);
+	}
+
+private:
+	const char *_category;
+	const char *_name;
+	uint64 _start;
+};
+
+} // End of namespace Common
+
+#define TRACE_SCOPE_CONCAT_(a, b) a ## b
+#define TRACE_SCOPE_CONCAT(a, b) TRACE_SCOPE_CONCAT_(a, b)
+#define TRACE_SCOPE(category, name) Common::TraceScope TRACE_SCOPE_CONCAT(traceScope, __LINE__)(category, name)
+
+#else
+
+#define TRACE_SCOPE(category, name) do {} while (0)
+
+#endif
+
+#endif
@@ -106,6 +106,11 @@ typedef struct {
 #include "common/fs.h"
 #include "common/unzip.h"
 #include "common/memstream.h"
+#include "common/ptr.h"
+#include "common/substream.h"
+#include "common/textconsole.h"
+#include "common/trace.h"
+#include "common/zlib.h"
 
 #include "common/hashmap.h"
 #include "common/hash-str.h"
@@ -1420,11 +1425,79 @@ int unzGetGlobalComment(unzFile file, char *szComment, uLong uSizeBuf) {
 namespace Common {
 
 
+namespace {
+
+/** Frees a buffer allocated with malloc(), for use with SharedPtr. */
+struct FreeDeleter {
+	void operator()(byte *ptr) { free(ptr); }
+};
+
+/**
+ * A member which was decompressed into memory. The data is shared with the
+ * cache of the archive, and stays alive as long as this stream does.
+ */
+class ZipMemoryReadStream : public MemoryReadStream {
+	SharedPtr<byte> _data;
+
+public:
+	ZipMemoryReadStream(const SharedPtr<byte> &data, uint32 size)
+		: MemoryReadStream(data.get(), size, DisposeAfterUse::NO), _data(data) {
+	}
+};
+
+/**
+ * A file found through SearchMan, which is looked up again each time it is
+ * opened.
+ */
+class SearchManMember : public ArchiveMember {
+	const String _name;
+
+public:
+	SearchManMember(const String &name) : _name(name) {
+	}
+
+	SeekableReadStream *createReadStream() const {
+		return SearchMan.createReadStreamForMember(_name);
+	}
+
+	String getName() const {
+		return _name;
+	}
+};
+
+} // End of anonymous namespace
+
 class ZipArchive : public Archive {
 	unzFile _zipFile;
 
+	/**
+	 * The ZIP file, which is opened again for each member bigger than
+	 * _streamThreshold. This gives every such stream its own file handle, as
+	 * they may be read from another thread. Without it, all members are
+	 * decompressed into memory.
+	 */
+	const ArchiveMemberPtr _file;
+	const uint32 _streamThreshold;
+
+	struct CacheEntry {
+		SharedPtr<byte> data;
+		uint32 size;
+		uint32 lastUse;
+	};
+
+	typedef HashMap<String, CacheEntry, IgnoreCase_Hash, IgnoreCase_EqualTo> MemberCache;
+
+	/** The decompressed members, most of which are likely to be opened again. */
+	mutable MemberCache _cache;
+	mutable uint32 _cacheUsed;
+	mutable uint32 _cacheClock;
+	const uint32 _cacheSize;
+
+	SeekableReadStream *decompressMember(const String &name, const unz_file_info &fileInfo) const;
+	void addToCache(const String &name, const SharedPtr<byte> &data, uint32 size) const;
+
 public:
-	ZipArchive(unzFile zipFile);
+	ZipArchive(unzFile zipFile, uint32 cacheSize, const ArchiveMemberPtr &file, uint32 streamThreshold);
 
 
 	~ZipArchive();
@@ -1453,7 +1526,9 @@ public:
 };
 */
 
-ZipArchive::ZipArchive(unzFile zipFile) : _zipFile(zipFile) {
+ZipArchive::ZipArchive(unzFile zipFile, uint32 cacheSize, const ArchiveMemberPtr &file, uint32 streamThreshold)
+	: _zipFile(zipFile), _file(file), _streamThreshold(streamThreshold),
+	  _cacheUsed(0), _cacheClock(0), _cacheSize(cacheSize) {
 	assert(_zipFile);
 }
 
@@ -1486,14 +1561,49 @@ const ArchiveMemberPtr ZipArchive::getMember(const String &name) const {
 }
 
 SeekableReadStream *ZipArchive::createReadStreamForMember(const String &name) const {
+	TRACE_SCOPE("io", "ZipArchive::createReadStreamForMember");
+	MemberCache::iterator cached = _cache.find(name);
+	if (cached != _cache.end()) {
+		cached->_value.lastUse = ++_cacheClock;
+		return new ZipMemoryReadStream(cached->_value.data, cached->_value.size);
+	}
+
 	if (unzLocateFile(_zipFile, name.c_str(), 2) != UNZ_OK)
 		return 0;
 
 	unz_file_info fileInfo;
+	if (unzGetCurrentFileInfo(_zipFile, &fileInfo, NULL, 0, NULL, 0, NULL, 0) != UNZ_OK)
+		return 0;
+
+	if (!_file || fileInfo.uncompressed_size <= _streamThreshold)
+		return decompressMember(name, fileInfo);
+
+	// Big members are read straight from the ZIP file, through a handle of
+	// their own
 	if (unzOpenCurrentFile(_zipFile) != UNZ_OK)
 		return 0;
 
-	if (unzGetCurrentFileInfo(_zipFile, &fileInfo, NULL, 0, NULL, 0, NULL, 0) != UNZ_OK)
+	const unz_s *const archive = (const unz_s *)_zipFile;
+	const file_in_zip_read_info_s *const member = archive->pfile_in_zip_read;
+	const uint32 begin = member->byte_before_the_zipfile + member->pos_in_zipfile;
+	const uLong method = member->compression_method;
+	unzCloseCurrentFile(_zipFile);
+
+	SeekableReadStream *zipStream = _file->createReadStream();
+	if (!zipStream || zipStream->size() != archive->_stream->size()) {
+		warning("ZipArchive: Could not open '%s' again to read '%s'", _file->getName().c_str(), name.c_str());
+		delete zipStream;
+		return decompressMember(name, fileInfo);
+	}
+
+	SeekableReadStream *stream = new SafeSeekableSubReadStream(zipStream, begin, begin + fileInfo.compressed_size, DisposeAfterUse::YES);
+	if (method == Z_DEFLATED)
+		stream = wrapDeflateReadStream(stream, fileInfo.uncompressed_size);
+	return stream;
+}
+
+SeekableReadStream *ZipArchive::decompressMember(const String &name, const unz_file_info &fileInfo) const {
+	if (unzOpenCurrentFile(_zipFile) != UNZ_OK)
 		return 0;
 
 	byte *buffer = (byte *)malloc(fileInfo.uncompressed_size);
@@ -1509,23 +1619,56 @@ SeekableReadStream *ZipArchive::createReadStreamForMember(const String &name) co
 		return 0;
 	}
 
-	return new MemoryReadStream(buffer, fileInfo.uncompressed_size, DisposeAfterUse::YES);
+	SharedPtr<byte> data(buffer, FreeDeleter());
+	addToCache(name, data, fileInfo.uncompressed_size);
+	return new ZipMemoryReadStream(data, fileInfo.uncompressed_size);
+}
 
-	// FIXME: instead of reading all into a memory stream, we could
-	// instead create a new ZipStream class. But then we have to be
-	// careful to handle the case where the client code opens multiple
-	// files in the archive and tries to use them independently.
+void ZipArchive::addToCache(const String &name, const SharedPtr<byte> &data, uint32 size) const {
+	if (size > _cacheSize)
+		return;
+
+	// Make room by dropping the least recently used members. Streams still
+	// using their data keep it alive.
+	while (_cacheUsed + size > _cacheSize) {
+		MemberCache::iterator oldest = _cache.begin();
+		for (MemberCache::iterator i = _cache.begin(); i != _cache.end(); ++i) {
+			if (i->_value.lastUse < oldest->_value.lastUse)
+				oldest = i;
+		}
+		_cacheUsed -= oldest->_value.size;
+		_cache.erase(oldest);
+	}
+
+	CacheEntry &entry = _cache[name];
+	entry.data = data;
+	entry.size = size;
+	entry.lastUse = ++_cacheClock;
+	_cacheUsed += size;
 }
 
-Archive *makeZipArchive(const String &name) {
-	return makeZipArchive(SearchMan.createReadStreamForMember(name));
+Archive *makeZipArchive(const String &name, uint32 cacheSize, uint32 streamThreshold) {
+	return makeZipArchive(ArchiveMemberPtr(new SearchManMember(name)), cacheSize, streamThreshold);
 }
 
-Archive *makeZipArchive(const FSNode &node) {
-	return makeZipArchive(node.createReadStream());
+Archive *makeZipArchive(const FSNode &node, uint32 cacheSize, uint32 streamThreshold) {
+	return makeZipArchive(ArchiveMemberPtr(new FSNode(node)), cacheSize, streamThreshold);
+}
+
+Archive *makeZipArchive(const ArchiveMemberPtr &member, uint32 cacheSize, uint32 streamThreshold) {
+	SeekableReadStream *stream = member->createReadStream();
+	if (!stream)
+		return 0;
+	unzFile zipFile = unzOpen(stream);
+	if (!zipFile) {
+		// stream gets deleted by unzOpen() call if something
+		// goes wrong.
+		return 0;
+	}
+	return new ZipArchive(zipFile, cacheSize, member, streamThreshold);
 }
 
-Archive *makeZipArchive(SeekableReadStream *stream) {
+Archive *makeZipArchive(SeekableReadStream *stream, uint32 cacheSize) {
 	if (!stream)
 		return 0;
 	unzFile zipFile = unzOpen(stream);
@@ -1534,7 +1677,7 @@ Archive *makeZipArchive(SeekableReadStream *stream) {
 		// goes wrong.
 		return 0;
 	}
-	return new ZipArchive(zipFile);
+	return new ZipArchive(zipFile, cacheSize, ArchiveMemberPtr(), 0);
 }
 
 } // End of namespace Common
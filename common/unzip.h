@@ -23,29 +23,72 @@
 #ifndef COMMON_UNZIP_H
 #define COMMON_UNZIP_H
 
+#include "common/archive.h"
 #include "common/str.h"
 
 namespace Common {
 
-class Archive;
 class FSNode;
 class SeekableReadStream;
 
+enum {
+	/**
+	 * Default budget in bytes for the decompressed members a ZIP archive
+	 * keeps in memory, to avoid decompressing them again when they are
+	 * reopened.
+	 */
+	kZipDefaultCacheSize = 1024 * 1024,
+
+	/**
+	 * Default size in bytes from which members are not decompressed into
+	 * memory as a whole, but read straight from the ZIP file and decompressed
+	 * on the fly, as they may not even be read completely. Each of these
+	 * streams opens the ZIP file again, so it can be read from another
+	 * thread, like the mixer, while the archive is used.
+	 */
+	kZipDefaultStreamThreshold = 1024 * 1024
+};
+
 /**
  * This factory method creates an Archive instance corresponding to the content
  * of the ZIP compressed file with the given name.
  *
+ * The archive keeps recently used members in memory, up to cacheSize bytes of
+ * decompressed data; pass 0 to disable this. Members bigger than
+ * streamThreshold bytes are not decompressed as a whole, but on the fly while
+ * reading them.
+ *
  * May return 0 in case of a failure.
  */
-Archive *makeZipArchive(const String &name);
+Archive *makeZipArchive(const String &name, uint32 cacheSize = kZipDefaultCacheSize, uint32 streamThreshold = kZipDefaultStreamThreshold);
 
 /**
  * This factory method creates an Archive instance corresponding to the content
  * of the ZIP compressed file with the given name.
  *
+ * The archive keeps recently used members in memory, up to cacheSize bytes of
+ * decompressed data; pass 0 to disable this. Members bigger than
+ * streamThreshold bytes are not decompressed as a whole, but on the fly while
+ * reading them.
+ *
+ * May return 0 in case of a failure.
+ */
+Archive *makeZipArchive(const FSNode &node, uint32 cacheSize = kZipDefaultCacheSize, uint32 streamThreshold = kZipDefaultStreamThreshold);
+
+/**
+ * This factory method creates an Archive instance corresponding to the content
+ * of the given ZIP compressed archive member. The member must keep being
+ * available while the archive is used, as it is opened again to read big
+ * members.
+ *
+ * The archive keeps recently used members in memory, up to cacheSize bytes of
+ * decompressed data; pass 0 to disable this. Members bigger than
+ * streamThreshold bytes are not decompressed as a whole, but on the fly while
+ * reading them.
+ *
  * May return 0 in case of a failure.
  */
-Archive *makeZipArchive(const FSNode &node);
+Archive *makeZipArchive(const ArchiveMemberPtr &member, uint32 cacheSize = kZipDefaultCacheSize, uint32 streamThreshold = kZipDefaultStreamThreshold);
 
 /**
  * This factory method creates an Archive instance corresponding to the content
@@ -53,9 +96,13 @@ Archive *makeZipArchive(const FSNode &node);
  * This takes ownership of the stream,  in particular, it is deleted when the
  * ZipArchive is deleted.
  *
+ * The archive keeps recently used members in memory, up to cacheSize bytes of
+ * decompressed data; pass 0 to disable this. As the stream can't be opened
+ * again, all members are decompressed into memory as a whole.
+ *
  * May return 0 in case of a failure. In this case stream will still be deleted.
  */
-Archive *makeZipArchive(SeekableReadStream *stream);
+Archive *makeZipArchive(SeekableReadStream *stream, uint32 cacheSize = kZipDefaultCacheSize);
 
 } // End of namespace Common
 
@@ -24,6 +24,7 @@
 #define FORBIDDEN_SYMBOL_ALLOW_ALL
 
 #include "common/zlib.h"
+#include "common/array.h"
 #include "common/ptr.h"
 #include "common/util.h"
 #include "common/stream.h"
@@ -145,56 +146,135 @@ bool inflateZlibInstallShield(byte *dst, uint dstLen, const byte *src, uint srcL
 static bool _shownBackwardSeekingWarning = false;
 #endif
 
+// inflateGetDictionary() was added in zlib 1.2.7.1. With it, we can record
+// checkpoints to restart decompression from when seeking backwards.
+#if ZLIB_VERNUM >= 0x1271
+#define GZIP_SEEK_INDEX
+#endif
+
 /**
  * A simple wrapper class which can be used to wrap around an arbitrary
  * other SeekableReadStream and will then provide on-the-fly decompression support.
- * Assumes the compressed data to be in gzip format.
+ * Assumes the compressed data to be in gzip or zlib format, or to be raw
+ * deflate data if requested.
  */
 class GZipReadStream : public SeekableReadStream {
 protected:
 	enum {
-		BUFSIZE = 16384		// 1 << MAX_WBITS
+		BUFSIZE = 16384,		// 1 << MAX_WBITS
+		WINDOWSIZE = 32768,
+		CHECKPOINT_INTERVAL = 512 * 1024
 	};
 
 	byte	_buf[BUFSIZE];
 
 	ScopedPtr<SeekableReadStream> _wrapped;
 	z_stream _stream;
+	int _windowBits;
 	int _zlibErr;
 	uint32 _pos;
 	uint32 _origSize;
 	bool _eos;
 
+#ifdef GZIP_SEEK_INDEX
+	/**
+	 * The decompressor state at the start of a deflate block. Decompression
+	 * can be restarted from there, instead of from the start of the stream.
+	 */
+	struct Checkpoint {
+		uint32 outPos;		///< position in the decompressed data
+		uint32 inPos;		///< position in the wrapped stream
+		int bits;			///< bits of the byte before inPos which are part of the block
+		uint windowSize;
+		byte window[WINDOWSIZE];
+	};
+
+	Array<Checkpoint *> _checkpoints;
+
+	void addCheckpoint(uint32 outPos) {
+		const uint32 lastPos = _checkpoints.empty() ? 0 : _checkpoints.back()->outPos;
+		if (outPos < lastPos + CHECKPOINT_INTERVAL)
+			return;
+
+		Checkpoint *checkpoint = new Checkpoint;
+		checkpoint->outPos = outPos;
+		checkpoint->inPos = _wrapped->pos() - _stream.avail_in;
+		checkpoint->bits = _stream.data_type & 7;
+		uInt windowSize = WINDOWSIZE;
+		inflateGetDictionary(&_stream, checkpoint->window, &windowSize);
+		checkpoint->windowSize = windowSize;
+		_checkpoints.push_back(checkpoint);
+	}
+
+	const Checkpoint *findCheckpoint(uint32 outPos) const {
+		const Checkpoint *checkpoint = 0;
+		for (uint i = 0; i < _checkpoints.size() && _checkpoints[i]->outPos <= outPos; ++i)
+			checkpoint = _checkpoints[i];
+		return checkpoint;
+	}
+
+	bool restartAt(const Checkpoint *checkpoint) {
+		// The checkpoints are inside the deflate data, so headers are gone
+		_zlibErr = inflateReset2(&_stream, -MAX_WBITS);
+		if (_zlibErr != Z_OK)
+			return false;
+
+		if (checkpoint->bits) {
+			_wrapped->seek(checkpoint->inPos - 1, SEEK_SET);
+			_zlibErr = inflatePrime(&_stream, checkpoint->bits, _wrapped->readByte() >> (8 - checkpoint->bits));
+		} else {
+			_wrapped->seek(checkpoint->inPos, SEEK_SET);
+		}
+		if (_zlibErr == Z_OK)
+			_zlibErr = inflateSetDictionary(&_stream, checkpoint->window, checkpoint->windowSize);
+		if (_zlibErr != Z_OK)
+			return false;
+
+		_pos = checkpoint->outPos;
+		_stream.next_in = _buf;
+		_stream.avail_in = 0;
+		return true;
+	}
+#endif
+
 public:
 
-	GZipReadStream(SeekableReadStream *w, uint32 knownSize = 0) : _wrapped(w), _stream() {
+	GZipReadStream(SeekableReadStream *w, uint32 knownSize = 0, bool raw = false) : _wrapped(w), _stream() {
 		assert(w != 0);
 
-		// Verify file header is correct
-		w->seek(0, SEEK_SET);
-		uint16 header = w->readUint16BE();
-		assert(header == 0x1F8B ||
-		       ((header & 0x0F00) == 0x0800 && header % 31 == 0));
-
-		if (header == 0x1F8B) {
-			// Retrieve the original file size
-			w->seek(-4, SEEK_END);
-			_origSize = w->readUint32LE();
-		} else {
-			// Original size not available in zlib format
-			// use an otherwise known size if supplied.
+		if (raw) {
+			// Raw deflate data has neither header nor size
 			_origSize = knownSize;
+			_windowBits = -MAX_WBITS;
+		} else {
+			// Verify file header is correct
+			w->seek(0, SEEK_SET);
+			uint16 header = w->readUint16BE();
+			assert(header == 0x1F8B ||
+			       ((header & 0x0F00) == 0x0800 && header % 31 == 0));
+
+			if (header == 0x1F8B) {
+				// Retrieve the original file size
+				w->seek(-4, SEEK_END);
+				_origSize = w->readUint32LE();
+			} else {
+				// Original size not available in zlib format
+				// use an otherwise known size if supplied.
+				_origSize = knownSize;
+			}
+
+			// Adding 32 to windowBits indicates to zlib that it is supposed to
+			// automatically detect whether gzip or zlib headers are used for
+			// the compressed file. This feature was added in zlib 1.2.0.4,
+			// released 10 August 2003.
+			// Note: This is *crucial* for savegame compatibility, do *not* remove!
+			_windowBits = MAX_WBITS + 32;
 		}
 		_pos = 0;
 		w->seek(0, SEEK_SET);
 		_eos = false;
 
-		// Adding 32 to windowBits indicates to zlib that it is supposed to
-		// automatically detect whether gzip or zlib headers are used for
-		// the compressed file. This feature was added in zlib 1.2.0.4,
-		// released 10 August 2003.
-		// Note: This is *crucial* for savegame compatibility, do *not* remove!
-		_zlibErr = inflateInit2(&_stream, MAX_WBITS + 32);
+		_zlibErr = inflateInit2(&_stream, _windowBits);
 		if (_zlibErr != Z_OK)
 			return;
 
@@ -205,6 +285,10 @@ public:
 
 	~GZipReadStream() {
 		inflateEnd(&_stream);
+#ifdef GZIP_SEEK_INDEX
+		for (uint i = 0; i < _checkpoints.size(); ++i)
+			delete _checkpoints[i];
+#endif
 	}
 
 	bool err() const { return (_zlibErr != Z_OK) && (_zlibErr != Z_STREAM_END); }
@@ -224,7 +308,16 @@ public:
 				_stream.next_in = _buf;
 				_stream.avail_in = _wrapped->read(_buf, BUFSIZE);
 			}
+#ifdef GZIP_SEEK_INDEX
+			// Stop at each block boundary, and remember some of them for
+			// seeking. Bit 7 of data_type is set at the start of a block,
+			// bit 6 if it is the last one.
+			_zlibErr = inflate(&_stream, Z_BLOCK);
+			if (_zlibErr == Z_OK && (_stream.data_type & 0xC0) == 0x80)
+				addCheckpoint(_pos + dataSize - _stream.avail_out);
+#else
 			_zlibErr = inflate(&_stream, Z_NO_FLUSH);
+#endif
 		}
 
 		// Update the position counter
@@ -262,6 +355,16 @@ public:
 
 		assert(newPos >= 0);
 
+#ifdef GZIP_SEEK_INDEX
+		// Jump to the closest checkpoint before the new position, if that
+		// saves us some decompression.
+		const Checkpoint *checkpoint = findCheckpoint(newPos);
+		if (checkpoint && ((uint32)newPos < _pos || checkpoint->outPos > _pos)) {
+			if (!restartAt(checkpoint))
+				return false;	// FIXME: STREAM REWRITE
+		}
+#endif
+
 		if ((uint32)newPos < _pos) {
 			// To search backward, we have to restart the whole decompression
 			// from the start of the file. A rather wasteful operation, best
@@ -279,7 +382,11 @@ public:
 
 			_pos = 0;
 			_wrapped->seek(0, SEEK_SET);
+#ifdef GZIP_SEEK_INDEX
+			_zlibErr = inflateReset2(&_stream, _windowBits);
+#else
 			_zlibErr = inflateReset(&_stream);
+#endif
 			if (_zlibErr != Z_OK)
 				return false;	// FIXME: STREAM REWRITE
 			_stream.next_in = _buf;
@@ -432,6 +539,18 @@ SeekableReadStream *wrapCompressedReadStream(SeekableReadStream *toBeWrapped, ui
 	return toBeWrapped;
 }
 
+SeekableReadStream *wrapDeflateReadStream(SeekableReadStream *toBeWrapped, uint32 knownSize) {
+	if (toBeWrapped) {
+#if defined(USE_ZLIB)
+		return new GZipReadStream(toBeWrapped, knownSize, true);
+#else
+		delete toBeWrapped;
+		return NULL;
+#endif
+	}
+	return NULL;
+}
+
 WriteStream *wrapCompressedWriteStream(WriteStream *toBeWrapped) {
 #if defined(USE_ZLIB)
 	if (toBeWrapped)
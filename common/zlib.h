@@ -121,6 +121,26 @@ bool inflateZlibInstallShield(byte *dst, uint dstLen, const byte *src, uint srcL
  */
 SeekableReadStream *wrapCompressedReadStream(SeekableReadStream *toBeWrapped, uint32 knownSize = 0);
 
+/**
+ * Take an arbitrary SeekableReadStream containing raw deflate data, without
+ * zlib or gzip header, and wrap it in a custom stream which provides
+ * transparent on-the-fly decompression, e.g. for the members of ZIP files.
+ * Unless there is no ZLIB support, in which case NULL is returned and the
+ * stream is destroyed.
+ *
+ * Seeking backwards is fast with zlib 1.2.7.1 and newer, as decompression
+ * then restarts from the last checkpoint recorded before the new position,
+ * rather than from the start of the data.
+ *
+ * The created stream becomes responsible for freeing the passed stream.
+ * It is safe to call this with a NULL parameter (in this case, NULL is
+ * returned).
+ *
+ * @param toBeWrapped	the stream with the compressed data
+ * @param knownSize		the size of the decompressed data, since raw deflate data does not contain it
+ */
+SeekableReadStream *wrapDeflateReadStream(SeekableReadStream *toBeWrapped, uint32 knownSize);
+
 /**
  * Take an arbitrary WriteStream and wrap it in a custom stream which provides
  * transparent on-the-fly compression. The compressed data is written in the
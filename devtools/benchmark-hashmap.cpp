@@ -0,0 +1,115 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+/*
+ * Microbenchmark comparing Common::HashMap and Common::FlatHashMap.
+ *
+ * Usage: benchmark-hashmap [entries] [rounds]
+ *
+ * Both maps are filled with Common::String keys, then every key is looked
+ * up (once present, once absent), and finally every key is erased again.
+ * The reported times are the totals over all rounds.
+ */
+
+// We use clock() and the C stdio functions
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+#include "common/flat-hashmap.h"
+#include "common/hashmap.h"
+#include "common/hash-str.h"
+#include "common/array.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+struct Timings {
+	double insert;
+	double findHit;
+	double findMiss;
+	double erase;
+	int checksum;
+
+	Timings() : insert(0), findHit(0), findMiss(0), erase(0), checksum(0) {}
+};
+
+static double elapsed(clock_t start) {
+	return (double)(clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+}
+
+template<class Map>
+static void runRound(const Common::Array<Common::String> &keys, const Common::Array<Common::String> &missing, Timings &t) {
+	Map map;
+	clock_t start;
+	const uint n = keys.size();
+
+	start = clock();
+	for (uint i = 0; i < n; ++i)
+		map[keys[i]] = (int)i;
+	t.insert += elapsed(start);
+
+	start = clock();
+	for (uint i = 0; i < n; ++i)
+		t.checksum += map.getVal(keys[i], -1);
+	t.findHit += elapsed(start);
+
+	start = clock();
+	for (uint i = 0; i < n; ++i)
+		t.checksum += map.contains(missing[i]) ? 1 : 0;
+	t.findMiss += elapsed(start);
+
+	start = clock();
+	for (uint i = 0; i < n; ++i)
+		map.erase(keys[i]);
+	t.erase += elapsed(start);
+
+	t.checksum += map.size();
+}
+
+static void printTimings(const char *name, const Timings &t) {
+	printf("%-14s %10.1f %10.1f %10.1f %10.1f   (checksum %d)\n", name, t.insert, t.findHit, t.findMiss, t.erase, t.checksum);
+}
+
+int main(int argc, char *argv[]) {
+	const uint entries = (argc > 1) ? atoi(argv[1]) : 100000;
+	const uint rounds = (argc > 2) ? atoi(argv[2]) : 10;
+
+	// Keys resembling config keys and file names, with a common prefix
+	Common::Array<Common::String> keys, missing;
+	for (uint i = 0; i < entries; ++i) {
+		keys.push_back(Common::String::format("game_%u_option.dat", i * 2654435761U));
+		missing.push_back(Common::String::format("game_%u_absent.dat", i * 2654435761U));
+	}
+
+	Timings hashMap, flatHashMap;
+	for (uint r = 0; r < rounds; ++r) {
+		runRound<Common::HashMap<Common::String, int> >(keys, missing, hashMap);
+		runRound<Common::FlatHashMap<Common::String, int> >(keys, missing, flatHashMap);
+	}
+
+	printf("%u entries, %u rounds, times in ms\n", entries, rounds);
+	printf("%-14s %10s %10s %10s %10s\n", "", "insert", "find hit", "find miss", "erase");
+	printTimings("HashMap", hashMap);
+	printTimings("FlatHashMap", flatHashMap);
+
+	return (hashMap.checksum == flatHashMap.checksum) ? 0 : 1;
+}
@@ -44,6 +44,11 @@ devtools/make-scumm-fontdata$(EXEEXT): $(srcdir)/devtools/make-scumm-fontdata.c
 	$(QUIET)$(MKDIR) devtools/$(DEPDIR)
 	$(QUIET_LINK)$(LD) $(CFLAGS) -Wall -o $@ $<
 
+# Not part of DEVTOOLS, since unlike the other tools it needs libcommon
+devtools/benchmark-hashmap$(EXEEXT): $(srcdir)/devtools/benchmark-hashmap.cpp common/libcommon.a
+	$(QUIET)$(MKDIR) devtools/$(DEPDIR)
+	$(QUIET_LINK)$(LD) $(CXXFLAGS) $(CPPFLAGS) -Wall -o $@ $+ $(LDFLAGS) $(LIBS)
+
 # Rule to explicitly rebuild the wwwroot archive
 wwwroot:
 	$(srcdir)/devtools/make-www-archive.py $(srcdir)/dists/networking/
@@ -20,6 +20,7 @@
  *
  */
 
+#include "common/atomic.h"
 #include "common/debug.h"
 #include "common/util.h"
 #include "common/file.h"
@@ -28,9 +29,11 @@
 #include "common/config-manager.h"
 #include "common/system.h"
 #include "common/textconsole.h"
+#include "common/thread.h"
 #include "common/translation.h"
 #include "gui/EventRecorder.h"
 #include "engines/advancedDetector.h"
+#include "engines/md5cache.h"
 #include "engines/obsolete.h"
 
 static GameDescriptor toGameDescriptor(const ADGameDescription &g, const PlainGameDescriptor *sg) {
@@ -405,16 +408,96 @@ bool AdvancedMetaEngine::getFileProperties(const Common::FSNode &parent, const F
 	if (!allFiles.contains(fname))
 		return false;
 
+	const Common::FSNode &node = allFiles[fname];
+	if (MD5CacheMan.lookup(node, _md5Bytes, fileProps.size, fileProps.md5))
+		return true;
+
 	Common::File testFile;
 
-	if (!testFile.open(allFiles[fname]))
+	if (!testFile.open(node))
 		return false;
 
 	fileProps.size = (int32)testFile.size();
 	fileProps.md5 = Common::computeStreamMD5AsString(testFile, _md5Bytes);
+	MD5CacheMan.store(node, _md5Bytes, fileProps.size, fileProps.md5);
 	return true;
 }
 
+namespace {
+
+enum {
+	/** The number of files hashed at the same time during detection, by default */
+	kDefaultHashThreads = 4,
+	/** The most files hashed at the same time, see "detection_threads" */
+	kMaxHashThreads = 16
+};
+
+/** A file which is not in the MD5 cache, see hashFiles() */
+struct ADFileHash {
+	Common::String fname;
+	const Common::FSNode *node;
+	bool opened;
+	ADFileProperties props;
+};
+
+struct ADHashPool {
+	Common::Array<ADFileHash> *files;
+	uint32 md5Bytes;
+	volatile uint32 next;
+};
+
+void hashFilesProc(void *param) {
+	ADHashPool &pool = *(ADHashPool *)param;
+
+	for (;;) {
+		uint32 i;
+		do {
+			i = pool.next;
+		} while (!Common::atomicCompareAndSwap(pool.next, i, i + 1));
+
+		if (i >= pool.files->size())
+			return;
+
+		ADFileHash &file = (*pool.files)[i];
+		Common::SeekableReadStream *stream = file.node->createReadStream();
+		file.opened = (stream != 0);
+		if (stream) {
+			file.props.size = (int32)stream->size();
+			file.props.md5 = Common::computeStreamMD5AsString(*stream, pool.md5Bytes);
+			delete stream;
+		}
+	}
+}
+
+/**
+ * Compute the sizes and MD5s of the given files. The files are read on
+ * several threads, which hides the latency of slow disks and network
+ * shares. Without threads, they are read one after another. The
+ * "detection_threads" setting limits how many files are read at once.
+ */
+void hashFiles(Common::Array<ADFileHash> &files, uint32 md5Bytes) {
+	ADHashPool pool;
+	pool.files = &files;
+	pool.md5Bytes = md5Bytes;
+	pool.next = 0;
+
+	int threadCount = ConfMan.hasKey("detection_threads") ? ConfMan.getInt("detection_threads") : kDefaultHashThreads;
+	threadCount = CLIP<int>(threadCount, 1, kMaxHashThreads);
+
+	Common::Thread threads[kMaxHashThreads - 1];
+	const uint count = MIN<uint>(files.size(), threadCount);
+	for (uint i = 1; i < count; ++i)
+		threads[i - 1].start(&hashFilesProc, &pool, "AdvancedDetector");
+
+	// The calling thread helps, and does all the work if no thread started
+	hashFilesProc(&pool);
+
+	for (uint i = 1; i < count; ++i)
+		threads[i - 1].join();
+}
+
+} // End of anonymous namespace
+
 ADGameDescList AdvancedMetaEngine::detectGame(const Common::FSNode &parent, const FileMap &allFiles, Common::Language language, Common::Platform platform, const Common::String &extra) const {
 	ADFilePropertiesMap filesProps;
 
@@ -425,7 +508,11 @@ ADGameDescList AdvancedMetaEngine::detectGame(const Common::FSNode &parent, cons
 	debug(3, "Starting detection in dir '%s'", parent.getPath().c_str());
 
 	// Check which files are included in some ADGameDescription *and* are present.
-	// Compute MD5s and file sizes for these files.
+	// Compute MD5s and file sizes for these files. Plain files which are not
+	// in the MD5 cache are read afterwards, all at once.
+	Common::Array<ADFileHash> hashes;
+	Common::HashMap<Common::String, bool, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> queued;
+
 	for (descPtr = _gameDescriptors; ((const ADGameDescription *)descPtr)->gameId != 0; descPtr += _descItemSize) {
 		g = (const ADGameDescription *)descPtr;
 
@@ -433,16 +520,40 @@ ADGameDescList AdvancedMetaEngine::detectGame(const Common::FSNode &parent, cons
 			Common::String fname = fileDesc->fileName;
 			ADFileProperties tmp;
 
-			if (filesProps.contains(fname))
+			if (filesProps.contains(fname) || queued.contains(fname))
 				continue;
 
-			if (getFileProperties(parent, allFiles, *g, fname, tmp)) {
+			if (!(g->flags & ADGF_MACRESFORK) && allFiles.contains(fname)) {
+				const Common::FSNode &node = allFiles[fname];
+				if (!MD5CacheMan.lookup(node, _md5Bytes, tmp.size, tmp.md5)) {
+					ADFileHash hash;
+					hash.fname = fname;
+					hash.node = &node;
+					hash.opened = false;
+					hashes.push_back(hash);
+					queued[fname] = true;
+					continue;
+				}
+
+				debug(3, "> '%s': '%s'", fname.c_str(), tmp.md5.c_str());
+				filesProps[fname] = tmp;
+			} else if (getFileProperties(parent, allFiles, *g, fname, tmp)) {
 				debug(3, "> '%s': '%s'", fname.c_str(), tmp.md5.c_str());
 				filesProps[fname] = tmp;
 			}
 		}
 	}
 
+	hashFiles(hashes, _md5Bytes);
+	for (uint i = 0; i < hashes.size(); ++i) {
+		if (!hashes[i].opened)
+			continue;
+
+		debug(3, "> '%s': '%s'", hashes[i].fname.c_str(), hashes[i].props.md5.c_str());
+		filesProps[hashes[i].fname] = hashes[i].props;
+		MD5CacheMan.store(*hashes[i].node, _md5Bytes, hashes[i].props.size, hashes[i].props.md5);
+	}
+
 	ADGameDescList matched;
 	int maxFilesMatched = 0;
 	bool gotAnyMatchesWithAllFiles = false;
@@ -0,0 +1,201 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "engines/md5cache.h"
+
+#include "common/algorithm.h"
+#include "common/array.h"
+#include "common/config-manager.h"
+#include "common/debug.h"
+#include "common/fs.h"
+#include "common/stream.h"
+#include "common/textconsole.h"
+#include "common/util.h"
+
+namespace Common {
+DECLARE_SINGLETON(MD5Cache);
+}
+
+static const char *const kMD5CacheFileName = "scummvm-md5.cache";
+
+enum {
+	kMD5CacheTag = MKTAG('M', 'D', '5', 'C'),
+	kMD5CacheVersion = 2
+};
+
+static Common::String readString(Common::ReadStream &in) {
+	Common::String str;
+	for (uint16 len = in.readUint16LE(); len > 0 && !in.eos(); --len)
+		str += (char)in.readByte();
+	return str;
+}
+
+static void writeString(Common::WriteStream &out, const Common::String &str) {
+	out.writeUint16LE(str.size());
+	out.write(str.c_str(), str.size());
+}
+
+MD5Cache::MD5Cache() : _clock(1), _loaded(false), _dirty(false) {
+}
+
+Common::String MD5Cache::makeKey(const Common::FSNode &node, uint32 md5Bytes, int32 size) {
+	return Common::String::format("%u:%d:", md5Bytes, size) + node.getPath();
+}
+
+Common::FSNode MD5Cache::getCacheFile() {
+	// The cache is kept next to the configuration file in use. It can be
+	// rebuilt at any time, so it does not belong with the saved games,
+	// which may be synced to the cloud.
+	Common::String path = ConfMan.getConfigFileName();
+	int i = path.size();
+	while (i > 0 && path[i - 1] != '/' && path[i - 1] != '\\')
+		--i;
+	return Common::FSNode(Common::String(path.c_str(), i) + kMD5CacheFileName);
+}
+
+bool MD5Cache::lookup(const Common::FSNode &node, uint32 md5Bytes, int32 &size, Common::String &md5) {
+	const uint32 mtime = node.getModificationTime();
+	const int32 fileSize = node.getFileSize();
+	if (!mtime || fileSize < 0)
+		return false;
+
+	load();
+
+	EntryMap::iterator entry = _entries.find(makeKey(node, md5Bytes, fileSize));
+	if (entry == _entries.end() || entry->_value.mtime != mtime)
+		return false;
+
+	if (entry->_value.lastUse != _clock) {
+		entry->_value.lastUse = _clock;
+		_dirty = true;
+	}
+
+	size = fileSize;
+	md5 = entry->_value.md5;
+	return true;
+}
+
+void MD5Cache::store(const Common::FSNode &node, uint32 md5Bytes, int32 size, const Common::String &md5) {
+	const uint32 mtime = node.getModificationTime();
+	if (!mtime || node.getFileSize() != size)
+		return;
+
+	load();
+
+	Entry &entry = _entries[makeKey(node, md5Bytes, size)];
+	entry.mtime = mtime;
+	entry.lastUse = _clock;
+	entry.md5 = md5;
+	_dirty = true;
+}
+
+void MD5Cache::load() {
+	if (_loaded)
+		return;
+	_loaded = true;
+
+	Common::SeekableReadStream *in = getCacheFile().createReadStream();
+	if (!in)
+		return;
+
+	if (in->readUint32BE() != kMD5CacheTag || in->readUint32LE() != kMD5CacheVersion) {
+		debug(2, "MD5Cache: Ignoring cache file with unknown format");
+		delete in;
+		return;
+	}
+
+	const uint32 count = in->readUint32LE();
+	for (uint32 i = 0; i < count && !in->eos() && !in->err(); ++i) {
+		const Common::String key = readString(*in);
+		Entry entry;
+		entry.mtime = in->readUint32LE();
+		entry.lastUse = in->readUint32LE();
+		entry.md5 = readString(*in);
+		if (in->eos() || in->err())
+			break;
+		_entries[key] = entry;
+
+		// Entries used in this run are newer than all the loaded ones
+		_clock = MAX(_clock, entry.lastUse + 1);
+	}
+
+	debug(2, "MD5Cache: Loaded %d entries", (int)_entries.size());
+	delete in;
+}
+
+void MD5Cache::trim() {
+	if (_entries.size() <= kMaxEntries)
+		return;
+
+	// Find the time of last use of the oldest entry to keep
+	Common::Array<uint32> lastUses;
+	lastUses.reserve(_entries.size());
+	for (EntryMap::const_iterator entry = _entries.begin(); entry != _entries.end(); ++entry)
+		lastUses.push_back(entry->_value.lastUse);
+	Common::sort(lastUses.begin(), lastUses.end());
+	const uint32 oldest = lastUses[lastUses.size() - kMaxEntries];
+
+	// Entries used at the same time as that one are dropped as long as
+	// there are too many
+	uint excess = _entries.size() - kMaxEntries;
+	for (EntryMap::iterator entry = _entries.begin(); entry != _entries.end() && excess; ++entry) {
+		if (entry->_value.lastUse < oldest) {
+			_entries.erase(entry);
+			--excess;
+		}
+	}
+	for (EntryMap::iterator entry = _entries.begin(); entry != _entries.end() && excess; ++entry) {
+		if (entry->_value.lastUse == oldest) {
+			_entries.erase(entry);
+			--excess;
+		}
+	}
+}
+
+void MD5Cache::flush() {
+	if (!_dirty)
+		return;
+
+	trim();
+
+	const Common::FSNode file = getCacheFile();
+	Common::WriteStream *out = file.createWriteStream();
+	if (!out)
+		return;
+
+	out->writeUint32BE(kMD5CacheTag);
+	out->writeUint32LE(kMD5CacheVersion);
+	out->writeUint32LE(_entries.size());
+	for (EntryMap::const_iterator entry = _entries.begin(); entry != _entries.end(); ++entry) {
+		writeString(*out, entry->_key);
+		out->writeUint32LE(entry->_value.mtime);
+		out->writeUint32LE(entry->_value.lastUse);
+		writeString(*out, entry->_value.md5);
+	}
+
+	out->finalize();
+	if (out->err())
+		warning("MD5Cache: Could not write '%s'", file.getPath().c_str());
+	else
+		_dirty = false;
+	delete out;
+}
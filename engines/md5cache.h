@@ -0,0 +1,106 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef ENGINES_MD5CACHE_H
+#define ENGINES_MD5CACHE_H
+
+#include "common/hashmap.h"
+#include "common/hash-str.h"
+#include "common/singleton.h"
+#include "common/str.h"
+
+namespace Common {
+class FSNode;
+}
+
+/**
+ * Cache for the partial MD5 checksums computed during game detection.
+ *
+ * Every AdvancedMetaEngine computes the MD5 of the candidate files on its
+ * own, and it does so again on every launch and for every directory visited
+ * by the mass add dialog. This cache remembers the results keyed by the file
+ * path, the file size and the number of hashed bytes, and validates them
+ * against the modification time of the file. Entries are kept on disk next
+ * to the configuration file, so subsequent runs do not need to read the
+ * files at all. The least recently used entries are dropped when there are
+ * more than kMaxEntries.
+ *
+ * Files for which the filesystem backend cannot report a modification time
+ * and a size are never cached. The cache must only be used from one thread.
+ */
+class MD5Cache : public Common::Singleton<MD5Cache> {
+public:
+	enum {
+		/** The most entries kept on disk */
+		kMaxEntries = 10000
+	};
+
+	MD5Cache();
+
+	/**
+	 * Look up the properties of a file.
+	 *
+	 * @param node      the file
+	 * @param md5Bytes  number of bytes the MD5 was computed over (0 = all)
+	 * @param size      set to the file size on success
+	 * @param md5       set to the MD5 checksum on success
+	 * @return true if a valid cache entry was found
+	 */
+	bool lookup(const Common::FSNode &node, uint32 md5Bytes, int32 &size, Common::String &md5);
+
+	/**
+	 * Store freshly computed properties of a file.
+	 *
+	 * @see lookup
+	 */
+	void store(const Common::FSNode &node, uint32 md5Bytes, int32 size, const Common::String &md5);
+
+	/**
+	 * Write the cache to disk if it changed since it was loaded.
+	 */
+	void flush();
+
+private:
+	struct Entry {
+		uint32 mtime;
+		/** The value of _clock when the entry was last used */
+		uint32 lastUse;
+		Common::String md5;
+	};
+
+	typedef Common::HashMap<Common::String, Entry> EntryMap;
+
+	EntryMap _entries;
+	uint32 _clock;
+	bool _loaded;
+	bool _dirty;
+
+	void load();
+	void trim();
+	static Common::String makeKey(const Common::FSNode &node, uint32 md5Bytes, int32 size);
+	static Common::FSNode getCacheFile();
+};
+
+/** Shortcut for accessing the detection MD5 cache. */
+#define MD5CacheMan MD5Cache::instance()
+
+#endif
@@ -90,13 +90,8 @@ void NeverhoodSmackerDecoder::forceSeekToFrame(uint frame) {
 		error("Failed to rewind");
 
 	SmackerVideoTrack *videoTrack = (SmackerVideoTrack *)getTrack(0);
-	uint32 offset = 0;
-	for (uint32 i = 0; i < frame; i++) {
-		videoTrack->increaseCurFrame();
-		offset += _frameSizes[i] & ~3;
-	}
-
-	_fileStream->seek(offset, SEEK_CUR);
+	videoTrack->setCurFrame((int)frame - 1);
+	_fileStream->seek(_frameOffsets[frame]);
 }
 
 // SmackerPlayer
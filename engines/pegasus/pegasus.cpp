@@ -1410,6 +1410,11 @@ void PegasusEngine::checkFlashlight() {
 bool PegasusEngine::playMovieScaled(Video::VideoDecoder *video, uint16 x, uint16 y) {
 	bool skipped = false;
 
+	// Big frames are shown as they are, which the backend may do straight
+	// from the YUV planes
+	if (video->getWidth() > 320 || video->getHeight() > 240)
+		video->setYUVOutputForScreen();
+
 	while (!shouldQuit() && !video->endOfVideo() && !skipped) {
 		if (video->needsUpdate()) {
 			const Graphics::Surface *frame = video->decodeNextFrame();
@@ -1418,7 +1423,7 @@ bool PegasusEngine::playMovieScaled(Video::VideoDecoder *video, uint16 x, uint16
 				if (frame->w <= 320 && frame->h <= 240) {
 					drawScaledFrame(frame, x, y);
 				} else {
-					_system->copyRectToScreen((const byte *)frame->getPixels(), frame->pitch, x, y, frame->w, frame->h);
+					video->copyFrameToScreen(frame, x, y);
 					_system->updateScreen();
 				}
 			}
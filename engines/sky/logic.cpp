@@ -23,6 +23,7 @@
 #include "common/endian.h"
 #include "common/rect.h"
 #include "common/textconsole.h"
+#include "common/trace.h"
 
 #include "sky/autoroute.h"
 #include "sky/compact.h"
@@ -129,6 +130,8 @@ bool Logic::checkProtection() {
 }
 
 void Logic::engine() {
+	TRACE_SCOPE("engine", "Sky::Logic::engine");
+
 	do {
 		uint16 *logicList = (uint16 *)_skyCompact->fetchCpt(_scriptVariables[LOGIC_LIST_NO]);
 
@@ -65,6 +65,11 @@ bool MoviePlayer::loadMovie(const Common::String &filename, uint z) {
 	_decoder.loadStream(in);
 	_decoder.start();
 
+	// Decoding a Theora frame can take longer than a frame of the engine
+	// lasts, so keep a few frames ready. Without threads on the backend,
+	// update() decodes them as before.
+	_decoder.setDecodeAhead(4);
+
 	GraphicEngine *pGfx = Kernel::getInstance()->getGfx();
 
 #ifdef THEORA_INDIRECT_RENDERING
@@ -42,17 +42,15 @@ bool ImgLoader::decodePNGImage(const byte *fileDataPtr, uint fileSize, Graphics:
 	assert(dest);
 	Common::MemoryReadStream *fileStr = new Common::MemoryReadStream(fileDataPtr, fileSize, DisposeAfterUse::NO);
 
-	::Image::PNGDecoder png;
-	if (!png.loadStream(*fileStr)) // the fileStr pointer, and thus pFileData will be deleted after this is done
+	// Decode straight into the destination, sized from the PNG header
+	if (fileSize < 24 || READ_BE_UINT32(fileDataPtr + 12) != MKTAG('I', 'H', 'D', 'R'))
 		error("Error while reading PNG image");
+	dest->create(READ_BE_UINT32(fileDataPtr + 16), READ_BE_UINT32(fileDataPtr + 20), Graphics::PixelFormat(4, 8, 8, 8, 8, 24, 16, 8, 0));
 
-	const Graphics::Surface *sourceSurface = png.getSurface();
-	Graphics::Surface *pngSurface = sourceSurface->convertTo(Graphics::PixelFormat(4, 8, 8, 8, 8, 24, 16, 8, 0), png.getPalette());
-
-	dest->copyFrom(*pngSurface);
+	::Image::PNGDecoder png;
+	if (!png.loadStream(*fileStr, *dest)) // the fileStr pointer, and thus pFileData will be deleted after this is done
+		error("Error while reading PNG image");
 
-	pngSurface->free();
-	delete pngSurface;
 	delete fileStr;
 
 	// Signal success
@@ -34,6 +34,7 @@
 #include "engines/wintermute/math/math_util.h"
 #include "engines/wintermute/base/base_game.h"
 #include "engines/wintermute/base/base_sprite.h"
+#include "engines/wintermute/wintermute.h"
 #include "common/system.h"
 #include "graphics/transparent_surface.h"
 #include "common/queue.h"
@@ -81,6 +82,9 @@ BaseRenderOSystem::~BaseRenderOSystem() {
 	delete _renderSurface;
 	_blankSurface->free();
 	delete _blankSurface;
+
+	debugC(kWintermuteDebugGeneral, "Image cache: %u hits, %u misses, %u evictions",
+	       _imageCache.getHits(), _imageCache.getMisses(), _imageCache.getEvictions());
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -34,6 +34,7 @@
 #include "graphics/surface.h"
 #include "common/list.h"
 #include "graphics/transform_struct.h"
+#include "image/image_cache.h"
 
 namespace Wintermute {
 class BaseSurfaceOSystem;
@@ -112,6 +113,13 @@ public:
 	void endSaveLoad();
 	void drawSurface(BaseSurfaceOSystem *owner, const Graphics::Surface *surf, Common::Rect *srcRect, Common::Rect *dstRect, Graphics::TransformStruct &transform);
 	BaseSurface *createSurface() override;
+	/**
+	 * The decoded images of the surfaces, in the screen format, so that
+	 * surfaces which are loaded again don't need to be decoded again.
+	 */
+	Image::ImageCache *getImageCache() {
+		return &_imageCache;
+	}
 private:
 	/**
 	 * Mark a specified rect of the screen as dirty.
@@ -147,6 +155,7 @@ private:
 
 	bool _skipThisFrame;
 	int _lastScreenChangeID; // previous value of OSystem::getScreenChangeID()
+	Image::ImageCache _imageCache;
 };
 
 } // End of namespace Wintermute
@@ -131,14 +131,53 @@ bool BaseSurfaceOSystem::create(const Common::String &filename, bool defaultCK,
 }
 
 bool BaseSurfaceOSystem::finishLoad() {
-	BaseImage *image = new BaseImage();
-	if (!image->loadFile(_filename)) {
+	Image::ImageCache *imageCache = static_cast<BaseRenderOSystem *>(_gameRef->_renderer)->getImageCache();
+	const Graphics::PixelFormat screenFormat = g_system->getScreenFormat();
+
+	// Savegame thumbnails change with every save, so they are not cached
+	const bool isCacheable = !_filename.hasPrefix("savegame:");
+
+	Image::CachedImagePtr cachedImage;
+	if (isCacheable) {
+		cachedImage = imageCache->get(_filename, screenFormat);
+	}
+
+	Graphics::Surface *surface;
+	Graphics::PixelFormat sourceFormat;
+	if (cachedImage) {
+		surface = new Graphics::Surface();
+		surface->copyFrom(cachedImage->surface);
+		sourceFormat = cachedImage->sourceFormat;
+	} else {
+		BaseImage *image = new BaseImage();
+		if (!image->loadFile(_filename)) {
+			delete image;
+			return false;
+		}
+
+		sourceFormat = image->getSurface()->format;
+		if (sourceFormat.bytesPerPixel == 1) {
+			if (!image->getPalette()) {
+				error("Missing palette while loading 8bit image %s", _filename.c_str());
+			}
+			surface = image->getSurface()->convertTo(screenFormat, image->getPalette());
+		} else if (sourceFormat != screenFormat) {
+			surface = image->getSurface()->convertTo(screenFormat);
+		} else {
+			surface = new Graphics::Surface();
+			surface->copyFrom(*image->getSurface());
+		}
+
 		delete image;
-		return false;
+
+		// The color key is applied below, as it depends on this surface
+		if (isCacheable) {
+			imageCache->add(_filename, *surface, sourceFormat);
+		}
 	}
 
-	_width = image->getSurface()->w;
-	_height = image->getSurface()->h;
+	_width = surface->w;
+	_height = surface->h;
 
 	bool isSaveGameGrayscale = _filename.matchString("savegame:*g", true);
 	if (isSaveGameGrayscale) {
@@ -148,28 +187,18 @@ bool BaseSurfaceOSystem::finishLoad() {
 
 	_surface->free();
 	delete _surface;
+	_surface = surface;
 
 	bool needsColorKey = false;
 	bool replaceAlpha = true;
-	if (image->getSurface()->format.bytesPerPixel == 1) {
-		if (!image->getPalette()) {
-			error("Missing palette while loading 8bit image %s", _filename.c_str());
-		}
-		_surface = image->getSurface()->convertTo(g_system->getScreenFormat(), image->getPalette());
+	if (sourceFormat.bytesPerPixel == 1) {
 		needsColorKey = true;
 	} else {
-		if (image->getSurface()->format != g_system->getScreenFormat()) {
-			_surface = image->getSurface()->convertTo(g_system->getScreenFormat());
-		} else {
-			_surface = new Graphics::Surface();
-			_surface->copyFrom(*image->getSurface());
-		}
-
-		if (_filename.hasSuffix(".bmp") && image->getSurface()->format.bytesPerPixel == 4) {
+		if (_filename.hasSuffix(".bmp") && sourceFormat.bytesPerPixel == 4) {
 			// 32 bpp BMPs have nothing useful in their alpha-channel -> color-key
 			needsColorKey = true;
 			replaceAlpha = false;
-		} else if (image->getSurface()->format.aBits() == 0) {
+		} else if (sourceFormat.aBits() == 0) {
 			needsColorKey = true;
 		}
 	}
@@ -184,8 +213,6 @@ bool BaseSurfaceOSystem::finishLoad() {
 
 	_gameRef->addMem(_width * _height * 4);
 
-	delete image;
-
 	_loaded = true;
 
 	return true;
@@ -32,6 +32,7 @@
 #include "engines/wintermute/base/base_file_manager.h"
 #include "engines/wintermute/wintermute.h"
 #include "audio/audiostream.h"
+#include "audio/decode_cache.h"
 #include "audio/mixer.h"
 #include "audio/decoders/vorbis.h"
 #include "audio/decoders/wave.h"
@@ -94,6 +95,16 @@ void BaseSoundBuffer::setStreaming(bool streamed, uint32 numBlocks, uint32 block
 bool BaseSoundBuffer::loadFromFile(const Common::String &filename, bool forceReload) {
 	debugC(kWintermuteDebugAudio, "BSoundBuffer::LoadFromFile(%s,%d)", filename.c_str(), forceReload);
 
+	// Sounds which are not streamed are short clips, like speech and effects,
+	// which tend to be played again and again
+	if (!_streamed && !forceReload) {
+		_stream = AudioDecodeCache.get(filename);
+		if (_stream) {
+			_filename = filename;
+			return STATUS_OK;
+		}
+	}
+
 	// Load a file, but avoid having the File-manager handle the disposal of it.
 	_file = BaseFileManager::getEngineInstance()->openFile(filename, true, false);
 	if (!_file) {
@@ -124,6 +135,11 @@ bool BaseSoundBuffer::loadFromFile(const Common::String &filename, bool forceRel
 	if (!_stream) {
 		return STATUS_FAILED;
 	}
+	if (!_streamed) {
+		// The file belongs to the stream, which the cache may drop
+		_stream = AudioDecodeCache.add(filename, _stream);
+		_file = nullptr;
+	}
 	_filename = filename;
 
 	return STATUS_OK;
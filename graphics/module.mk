@@ -29,6 +29,7 @@ MODULE_OBJS := \
 	screen.o \
 	sjis.o \
 	surface.o \
+	surface_pool.o \
 	transform_struct.o \
 	transform_tools.o \
 	transparent_surface.o \
@@ -45,7 +46,8 @@ MODULE_OBJS += \
 	scaler/downscaler.o \
 	scaler/scale2x.o \
 	scaler/scale3x.o \
-	scaler/scalebit.o
+	scaler/scalebit.o \
+	scaler/simd.o
 
 ifdef USE_ARM_SCALER_ASM
 MODULE_OBJS += \
@@ -0,0 +1,357 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+/*
+ * Vectorized parts of the HQ and AdvMame scalers.
+ *
+ * The HQ scalers spend most of their time deciding which of the eight
+ * neighbours of a pixel differ from it: that takes eight lookups in the
+ * 256 KB RGBtoYUV table and eight diffYUV() calls per pixel. Here, each
+ * source pixel is looked up only once per line it takes part in, and the
+ * comparisons are done for 4 (SSE2) or 8 (AVX2) pixels at a time. The
+ * interpolation of the output pixels stays in hq2x.cpp / hq3x.cpp, since
+ * which interpolation is used depends on the pattern of each pixel.
+ *
+ * For AdvMame3x, the Scale3x rules are evaluated with vector compares and
+ * selects instead of branches.
+ *
+ * All kernels must produce output identical to the C code; test/graphics/
+ * scaler.h verifies this.
+ */
+
+#include "graphics/scaler/simd.h"
+#include "graphics/scaler/scale3x.h"
+
+#include "common/cpudetect.h"
+#include "common/util.h"
+
+#ifdef USE_HQ_SCALERS
+extern "C" uint32 *RGBtoYUV;
+#endif
+
+#if defined(USE_HQ_SCALERS) && defined(SCUMMVM_SSE2)
+
+#pragma mark --- HQ patterns ---
+
+enum {
+	// Number of pixels handled per batch of YUV lookups. Must be a multiple
+	// of 16, the number of pixels the AVX2 kernel produces per iteration.
+	kHQChunkSize = 64
+};
+
+/**
+ * Look up the YUV values of the pixels src[-1] to src[count], and zero the
+ * remainder of the buffer so the vector loads past the end are harmless.
+ */
+static inline void loadYUVLine(const uint16 *src, int count, uint32 *yuv) {
+	int i;
+	for (i = 0; i < count + 2; ++i)
+		yuv[i] = RGBtoYUV[src[i - 1]];
+	for (; i < kHQChunkSize + 2; ++i)
+		yuv[i] = 0;
+}
+
+TARGET_ATTR("sse2")
+static inline __m128i diffYUVSSE2(__m128i yuv1, __m128i yuv2) {
+	// Same thresholds as diffYUV() in intern.h
+	const __m128i masks[3] = { _mm_set1_epi32(0x00FF0000), _mm_set1_epi32(0x0000FF00), _mm_set1_epi32(0x000000FF) };
+	const __m128i thresholds[3] = { _mm_set1_epi32(0x00300000), _mm_set1_epi32(0x00000700), _mm_set1_epi32(0x00000006) };
+
+	__m128i result = _mm_setzero_si128();
+	for (int c = 0; c < 3; ++c) {
+		__m128i diff = _mm_sub_epi32(_mm_and_si128(yuv1, masks[c]), _mm_and_si128(yuv2, masks[c]));
+		const __m128i sign = _mm_srai_epi32(diff, 31);
+		diff = _mm_sub_epi32(_mm_xor_si128(diff, sign), sign);
+		result = _mm_or_si128(result, _mm_cmpgt_epi32(diff, thresholds[c]));
+	}
+	return result;
+}
+
+TARGET_ATTR("sse2")
+static inline __m128i patternSSE2(const uint32 *up, const uint32 *line, const uint32 *down) {
+	// The comparison with identical pixels in the C code is only a shortcut,
+	// identical pixels never differ in YUV either.
+	const __m128i yuv5 = _mm_loadu_si128((const __m128i *)(line + 1));
+	__m128i pattern;
+	pattern =                        _mm_and_si128(diffYUVSSE2(yuv5, _mm_loadu_si128((const __m128i *)(up + 0))),   _mm_set1_epi32(0x01));
+	pattern = _mm_or_si128(pattern, _mm_and_si128(diffYUVSSE2(yuv5, _mm_loadu_si128((const __m128i *)(up + 1))),   _mm_set1_epi32(0x02)));
+	pattern = _mm_or_si128(pattern, _mm_and_si128(diffYUVSSE2(yuv5, _mm_loadu_si128((const __m128i *)(up + 2))),   _mm_set1_epi32(0x04)));
+	pattern = _mm_or_si128(pattern, _mm_and_si128(diffYUVSSE2(yuv5, _mm_loadu_si128((const __m128i *)(line + 0))), _mm_set1_epi32(0x08)));
+	pattern = _mm_or_si128(pattern, _mm_and_si128(diffYUVSSE2(yuv5, _mm_loadu_si128((const __m128i *)(line + 2))), _mm_set1_epi32(0x10)));
+	pattern = _mm_or_si128(pattern, _mm_and_si128(diffYUVSSE2(yuv5, _mm_loadu_si128((const __m128i *)(down + 0))), _mm_set1_epi32(0x20)));
+	pattern = _mm_or_si128(pattern, _mm_and_si128(diffYUVSSE2(yuv5, _mm_loadu_si128((const __m128i *)(down + 1))), _mm_set1_epi32(0x40)));
+	pattern = _mm_or_si128(pattern, _mm_and_si128(diffYUVSSE2(yuv5, _mm_loadu_si128((const __m128i *)(down + 2))), _mm_set1_epi32(0x80)));
+	return pattern;
+}
+
+TARGET_ATTR("sse2")
+static void computeHQPatternsSSE2(const uint16 *src, uint32 nextlineSrc, int width, uint8 *patterns) {
+	uint32 yuv[3][kHQChunkSize + 2];
+
+	for (int x = 0; x < width; x += kHQChunkSize) {
+		const int count = MIN<int>(kHQChunkSize, width - x);
+		loadYUVLine(src + x - nextlineSrc, count, yuv[0]);
+		loadYUVLine(src + x, count, yuv[1]);
+		loadYUVLine(src + x + nextlineSrc, count, yuv[2]);
+
+		for (int i = 0; i < count; i += 8) {
+			const __m128i lo = patternSSE2(yuv[0] + i, yuv[1] + i, yuv[2] + i);
+			const __m128i hi = patternSSE2(yuv[0] + i + 4, yuv[1] + i + 4, yuv[2] + i + 4);
+			const __m128i packed = _mm_packus_epi16(_mm_packs_epi32(lo, hi), _mm_setzero_si128());
+			_mm_storel_epi64((__m128i *)(patterns + x + i), packed);
+		}
+	}
+}
+
+#ifdef SCUMMVM_AVX2
+
+TARGET_ATTR("avx2")
+static inline __m256i diffYUVAVX2(__m256i yuv1, __m256i yuv2) {
+	const __m256i masks[3] = { _mm256_set1_epi32(0x00FF0000), _mm256_set1_epi32(0x0000FF00), _mm256_set1_epi32(0x000000FF) };
+	const __m256i thresholds[3] = { _mm256_set1_epi32(0x00300000), _mm256_set1_epi32(0x00000700), _mm256_set1_epi32(0x00000006) };
+
+	__m256i result = _mm256_setzero_si256();
+	for (int c = 0; c < 3; ++c) {
+		const __m256i diff = _mm256_abs_epi32(_mm256_sub_epi32(_mm256_and_si256(yuv1, masks[c]), _mm256_and_si256(yuv2, masks[c])));
+		result = _mm256_or_si256(result, _mm256_cmpgt_epi32(diff, thresholds[c]));
+	}
+	return result;
+}
+
+TARGET_ATTR("avx2")
+static inline __m256i patternAVX2(const uint32 *up, const uint32 *line, const uint32 *down) {
+	const __m256i yuv5 = _mm256_loadu_si256((const __m256i *)(line + 1));
+	__m256i pattern;
+	pattern =                           _mm256_and_si256(diffYUVAVX2(yuv5, _mm256_loadu_si256((const __m256i *)(up + 0))),   _mm256_set1_epi32(0x01));
+	pattern = _mm256_or_si256(pattern, _mm256_and_si256(diffYUVAVX2(yuv5, _mm256_loadu_si256((const __m256i *)(up + 1))),   _mm256_set1_epi32(0x02)));
+	pattern = _mm256_or_si256(pattern, _mm256_and_si256(diffYUVAVX2(yuv5, _mm256_loadu_si256((const __m256i *)(up + 2))),   _mm256_set1_epi32(0x04)));
+	pattern = _mm256_or_si256(pattern, _mm256_and_si256(diffYUVAVX2(yuv5, _mm256_loadu_si256((const __m256i *)(line + 0))), _mm256_set1_epi32(0x08)));
+	pattern = _mm256_or_si256(pattern, _mm256_and_si256(diffYUVAVX2(yuv5, _mm256_loadu_si256((const __m256i *)(line + 2))), _mm256_set1_epi32(0x10)));
+	pattern = _mm256_or_si256(pattern, _mm256_and_si256(diffYUVAVX2(yuv5, _mm256_loadu_si256((const __m256i *)(down + 0))), _mm256_set1_epi32(0x20)));
+	pattern = _mm256_or_si256(pattern, _mm256_and_si256(diffYUVAVX2(yuv5, _mm256_loadu_si256((const __m256i *)(down + 1))), _mm256_set1_epi32(0x40)));
+	pattern = _mm256_or_si256(pattern, _mm256_and_si256(diffYUVAVX2(yuv5, _mm256_loadu_si256((const __m256i *)(down + 2))), _mm256_set1_epi32(0x80)));
+	return pattern;
+}
+
+TARGET_ATTR("avx2")
+static void computeHQPatternsAVX2(const uint16 *src, uint32 nextlineSrc, int width, uint8 *patterns) {
+	uint32 yuv[3][kHQChunkSize + 2];
+
+	for (int x = 0; x < width; x += kHQChunkSize) {
+		const int count = MIN<int>(kHQChunkSize, width - x);
+		loadYUVLine(src + x - nextlineSrc, count, yuv[0]);
+		loadYUVLine(src + x, count, yuv[1]);
+		loadYUVLine(src + x + nextlineSrc, count, yuv[2]);
+
+		for (int i = 0; i < count; i += 16) {
+			const __m256i lo = patternAVX2(yuv[0] + i, yuv[1] + i, yuv[2] + i);
+			const __m256i hi = patternAVX2(yuv[0] + i + 8, yuv[1] + i + 8, yuv[2] + i + 8);
+			// packs works per 128 bit lane, so restore the pixel order first
+			const __m256i words = _mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi), 0xD8);
+			const __m128i packed = _mm_packus_epi16(_mm256_castsi256_si128(words), _mm256_extracti128_si256(words, 1));
+			_mm_storeu_si128((__m128i *)(patterns + x + i), packed);
+		}
+	}
+}
+
+#endif // SCUMMVM_AVX2
+
+#endif // USE_HQ_SCALERS && SCUMMVM_SSE2
+
+#ifdef SCUMMVM_SSE2
+
+#pragma mark --- Scale3x ---
+
+TARGET_ATTR("sse2")
+static inline __m128i selectSSE2(__m128i mask, __m128i a, __m128i b) {
+	return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+TARGET_ATTR("sse2")
+static inline __m128i notEqualSSE2(__m128i a, __m128i b) {
+	return _mm_xor_si128(_mm_cmpeq_epi16(a, b), _mm_set1_epi32(-1));
+}
+
+/**
+ * Interleave three vectors of eight pixels into 24 consecutive pixels.
+ */
+TARGET_ATTR("sse2")
+static inline void store3x16SSE2(uint16 *dst, __m128i a, __m128i b, __m128i c) {
+	uint16 ta[8], tb[8], tc[8];
+	_mm_storeu_si128((__m128i *)ta, a);
+	_mm_storeu_si128((__m128i *)tb, b);
+	_mm_storeu_si128((__m128i *)tc, c);
+	for (int i = 0; i < 8; ++i) {
+		dst[i * 3 + 0] = ta[i];
+		dst[i * 3 + 1] = tb[i];
+		dst[i * 3 + 2] = tc[i];
+	}
+}
+
+/**
+ * The outer lines of Scale3x; see scale3x_16_def_border().
+ */
+TARGET_ATTR("sse2")
+static inline void scale3xBorderSSE2(uint16 *dst, const uint16 *src0, const uint16 *src1, const uint16 *src2, __m128i active) {
+	const __m128i a0 = _mm_loadu_si128((const __m128i *)(src0 - 1));
+	const __m128i a = _mm_loadu_si128((const __m128i *)(src0));
+	const __m128i a1 = _mm_loadu_si128((const __m128i *)(src0 + 1));
+	const __m128i l = _mm_loadu_si128((const __m128i *)(src1 - 1));
+	const __m128i m = _mm_loadu_si128((const __m128i *)(src1));
+	const __m128i r = _mm_loadu_si128((const __m128i *)(src1 + 1));
+
+	const __m128i leftIsUp = _mm_and_si128(active, _mm_cmpeq_epi16(l, a));
+	const __m128i rightIsUp = _mm_and_si128(active, _mm_cmpeq_epi16(r, a));
+	const __m128i center = _mm_and_si128(active, _mm_or_si128(
+		_mm_and_si128(_mm_cmpeq_epi16(l, a), notEqualSSE2(m, a1)),
+		_mm_and_si128(_mm_cmpeq_epi16(r, a), notEqualSSE2(m, a0))));
+
+	store3x16SSE2(dst, selectSSE2(leftIsUp, l, m), selectSSE2(center, a, m), selectSSE2(rightIsUp, r, m));
+}
+
+/**
+ * The middle line of Scale3x; see scale3x_16_def_center().
+ */
+TARGET_ATTR("sse2")
+static inline void scale3xCenterSSE2(uint16 *dst, const uint16 *src0, const uint16 *src1, const uint16 *src2, __m128i active) {
+	const __m128i a0 = _mm_loadu_si128((const __m128i *)(src0 - 1));
+	const __m128i a = _mm_loadu_si128((const __m128i *)(src0));
+	const __m128i a1 = _mm_loadu_si128((const __m128i *)(src0 + 1));
+	const __m128i l = _mm_loadu_si128((const __m128i *)(src1 - 1));
+	const __m128i m = _mm_loadu_si128((const __m128i *)(src1));
+	const __m128i r = _mm_loadu_si128((const __m128i *)(src1 + 1));
+	const __m128i b0 = _mm_loadu_si128((const __m128i *)(src2 - 1));
+	const __m128i b = _mm_loadu_si128((const __m128i *)(src2));
+	const __m128i b1 = _mm_loadu_si128((const __m128i *)(src2 + 1));
+
+	const __m128i left = _mm_and_si128(active, _mm_or_si128(
+		_mm_and_si128(_mm_cmpeq_epi16(l, a), notEqualSSE2(m, b0)),
+		_mm_and_si128(_mm_cmpeq_epi16(l, b), notEqualSSE2(m, a0))));
+	const __m128i right = _mm_and_si128(active, _mm_or_si128(
+		_mm_and_si128(_mm_cmpeq_epi16(r, a), notEqualSSE2(m, b1)),
+		_mm_and_si128(_mm_cmpeq_epi16(r, b), notEqualSSE2(m, a1))));
+
+	store3x16SSE2(dst, selectSSE2(left, l, m), m, selectSSE2(right, r, m));
+}
+
+TARGET_ATTR("sse2")
+static void scale3x16SSE2(uint16 *dst0, uint16 *dst1, uint16 *dst2, const uint16 *src0, const uint16 *src1, const uint16 *src2, unsigned count) {
+	while (count >= 8) {
+		// The rules only apply where the pixels above and below, and the
+		// pixels left and right of the center differ.
+		const __m128i active = _mm_and_si128(
+			notEqualSSE2(_mm_loadu_si128((const __m128i *)src0), _mm_loadu_si128((const __m128i *)src2)),
+			notEqualSSE2(_mm_loadu_si128((const __m128i *)(src1 - 1)), _mm_loadu_si128((const __m128i *)(src1 + 1))));
+
+		scale3xBorderSSE2(dst0, src0, src1, src2, active);
+		scale3xCenterSSE2(dst1, src0, src1, src2, active);
+		scale3xBorderSSE2(dst2, src2, src1, src0, active);
+
+		src0 += 8;
+		src1 += 8;
+		src2 += 8;
+		dst0 += 24;
+		dst1 += 24;
+		dst2 += 24;
+		count -= 8;
+	}
+
+	if (count)
+		scale3x_16_def(dst0, dst1, dst2, src0, src1, src2, count);
+}
+
+#endif // SCUMMVM_SSE2
+
+#pragma mark --- Kernel selection ---
+
+bool isScalerKernelSupported(ScalerKernel kernel) {
+	switch (kernel) {
+	case kScalerKernelC:
+		return true;
+
+#ifdef SCUMMVM_SSE2
+	case kScalerKernelSSE2:
+		return Common::hasSSE2();
+#endif
+
+#ifdef SCUMMVM_AVX2
+	case kScalerKernelAVX2:
+		return Common::hasAVX2();
+#endif
+
+	default:
+		return false;
+	}
+}
+
+static ScalerKernel s_scalerKernel = kScalerKernelCount;
+
+bool setScalerKernel(ScalerKernel kernel) {
+	if (!isScalerKernelSupported(kernel))
+		return false;
+
+	s_scalerKernel = kernel;
+	return true;
+}
+
+ScalerKernel getScalerKernel() {
+	if (s_scalerKernel == kScalerKernelCount) {
+		// Pick the last supported kernel, the list is ordered by preference.
+		for (int i = kScalerKernelCount - 1; i >= kScalerKernelC; --i) {
+			if (setScalerKernel((ScalerKernel)i))
+				break;
+		}
+	}
+
+	return s_scalerKernel;
+}
+
+HQPatternProc getHQPatternProc() {
+	switch (getScalerKernel()) {
+#if defined(USE_HQ_SCALERS) && defined(SCUMMVM_SSE2)
+	case kScalerKernelSSE2:
+		return computeHQPatternsSSE2;
+#endif
+
+#if defined(USE_HQ_SCALERS) && defined(SCUMMVM_AVX2)
+	case kScalerKernelAVX2:
+		return computeHQPatternsAVX2;
+#endif
+
+	default:
+		return 0;
+	}
+}
+
+Scale3x16Proc getScale3x16Proc() {
+	switch (getScalerKernel()) {
+#ifdef SCUMMVM_SSE2
+	case kScalerKernelSSE2:
+	case kScalerKernelAVX2:
+		// There is no AVX2 version, the SSE2 one is memory bound already
+		return scale3x16SSE2;
+#endif
+
+	default:
+		return 0;
+	}
+}
@@ -0,0 +1,95 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef GRAPHICS_SCALER_SIMD_H
+#define GRAPHICS_SCALER_SIMD_H
+
+#include "common/scummsys.h"
+
+/**
+ * The implementations available for the vectorized parts of the HQ and
+ * AdvMame scalers.
+ *
+ * kScalerKernelC is the plain C code and is always available. The others
+ * are only usable if they have been compiled in and the CPU we are running
+ * on supports them. All of them produce identical output.
+ */
+enum ScalerKernel {
+	kScalerKernelC = 0,
+	kScalerKernelSSE2,
+	kScalerKernelAVX2,
+
+	kScalerKernelCount
+};
+
+/** Check whether a kernel is usable on this machine. */
+bool isScalerKernelSupported(ScalerKernel kernel);
+
+/**
+ * Select the kernel used by the scalers. By default the fastest supported
+ * one is used; this is mostly useful for testing.
+ *
+ * @return false if the kernel is not supported, in which case the
+ *         selection is left unchanged.
+ */
+bool setScalerKernel(ScalerKernel kernel);
+
+/** Return the kernel currently used by the scalers. */
+ScalerKernel getScalerKernel();
+
+/**
+ * Compute the neighbourhood patterns of the HQ scalers for one line.
+ *
+ * For each of the width pixels starting at src, bit n of the pattern is set
+ * if the YUV value of the n-th neighbour (in the order w1 w2 w3 w4 w6 w7 w8
+ * w9, see hq2x.cpp) differs noticeably from that of the pixel itself.
+ * Requires the RGBtoYUV table to be set up.
+ *
+ * The patterns array must have room for width + kHQPatternPadding entries.
+ */
+typedef void (*HQPatternProc)(const uint16 *src, uint32 nextlineSrc, int width, uint8 *patterns);
+
+enum {
+	kHQPatternPadding = 16,
+	/** The most pixels the HQ scalers compute the patterns of at once */
+	kHQPatternChunk = 256
+};
+
+/**
+ * Return the pattern procedure of the current kernel, or 0 if the HQ
+ * scalers should use their inline C code.
+ */
+HQPatternProc getHQPatternProc();
+
+/**
+ * Scale3x a line of 16 bit pixels. The parameters are those of
+ * scale3x_16_def().
+ */
+typedef void (*Scale3x16Proc)(uint16 *dst0, uint16 *dst1, uint16 *dst2, const uint16 *src0, const uint16 *src1, const uint16 *src2, unsigned count);
+
+/**
+ * Return the Scale3x procedure of the current kernel, or 0 if the C code
+ * should be used.
+ */
+Scale3x16Proc getScale3x16Proc();
+
+#endif
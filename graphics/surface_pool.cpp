@@ -0,0 +1,101 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "graphics/surface_pool.h"
+#include "graphics/surface.h"
+
+namespace Graphics {
+
+SurfacePool::SurfacePool(uint32 maxIdleSize) : _idleSize(0), _maxIdleSize(maxIdleSize) {
+}
+
+SurfacePool::~SurfacePool() {
+	assert(_used.empty());
+	clear();
+}
+
+void SurfacePool::create(Surface &surface, uint16 width, uint16 height, const PixelFormat &format) {
+	const uint32 size = width * height * format.bytesPerPixel;
+	if (!size) {
+		surface.init(width, height, width * format.bytesPerPixel, 0, format);
+		return;
+	}
+
+	// Take the smallest unused buffer which fits, but don't waste a big one
+	// on a small surface
+	int best = -1;
+	for (uint i = 0; i < _idle.size(); ++i) {
+		if (_idle[i].size >= size && _idle[i].size / 2 <= size && (best < 0 || _idle[i].size < _idle[best].size))
+			best = i;
+	}
+
+	Buffer buffer;
+	if (best >= 0) {
+		buffer = _idle[best];
+		_idle.remove_at(best);
+		_idleSize -= buffer.size;
+	} else {
+		buffer.pixels = malloc(size);
+		buffer.size = size;
+		assert(buffer.pixels);
+	}
+
+	_used.push_back(buffer);
+	surface.init(width, height, width * format.bytesPerPixel, buffer.pixels, format);
+}
+
+void SurfacePool::free(Surface &surface) {
+	if (surface.getPixels()) {
+		uint i = 0;
+		while (i < _used.size() && _used[i].pixels != surface.getPixels())
+			++i;
+		assert(i < _used.size());
+
+		// The unused buffers are kept from the oldest to the newest. Those
+		// which could never be kept don't push out the others.
+		if (_used[i].size <= _maxIdleSize) {
+			_idle.push_back(_used[i]);
+			_idleSize += _used[i].size;
+			trim(_maxIdleSize);
+		} else {
+			::free(_used[i].pixels);
+		}
+
+		_used.remove_at(i);
+	}
+
+	surface.init(0, 0, 0, 0, PixelFormat());
+}
+
+void SurfacePool::clear() {
+	trim(0);
+}
+
+void SurfacePool::trim(uint32 maxIdleSize) {
+	while (_idleSize > maxIdleSize) {
+		::free(_idle.front().pixels);
+		_idleSize -= _idle.front().size;
+		_idle.remove_at(0);
+	}
+}
+
+} // End of namespace Graphics
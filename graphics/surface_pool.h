@@ -0,0 +1,94 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef GRAPHICS_SURFACE_POOL_H
+#define GRAPHICS_SURFACE_POOL_H
+
+#include "common/array.h"
+#include "common/noncopyable.h"
+#include "graphics/pixelformat.h"
+
+namespace Graphics {
+
+struct Surface;
+
+/**
+ * A cache of pixel buffers for surfaces which are created and freed over and
+ * over, like those of the images loaded on a scene change.
+ *
+ * Surfaces are set up by create() and handed back with free(). Their
+ * buffers are kept around while the size of all unused buffers is below a
+ * limit, and are given to later surfaces which fit into them.
+ */
+class SurfacePool : Common::NonCopyable {
+public:
+	enum {
+		kDefaultMaxIdleSize = 8 * 1024 * 1024
+	};
+
+	/**
+	 * @param maxIdleSize	the maximum number of bytes kept in unused
+	 *						buffers
+	 */
+	explicit SurfacePool(uint32 maxIdleSize = kDefaultMaxIdleSize);
+
+	/**
+	 * Free the unused buffers. All surfaces created by the pool have to
+	 * be freed before.
+	 */
+	~SurfacePool();
+
+	/**
+	 * Set up an empty surface with the given size and format. Unlike
+	 * Surface::create(), the contents of the pixels are undefined.
+	 */
+	void create(Surface &surface, uint16 width, uint16 height, const PixelFormat &format);
+
+	/**
+	 * Free a surface set up by create(), giving its buffer back to the
+	 * pool. The surface is empty afterwards.
+	 */
+	void free(Surface &surface);
+
+	/** Free all unused buffers. */
+	void clear();
+
+	/** Return the number of bytes in unused buffers. */
+	uint32 getIdleSize() const { return _idleSize; }
+
+private:
+	struct Buffer {
+		void *pixels;
+		uint32 size;
+	};
+
+	void trim(uint32 maxIdleSize);
+
+	Common::Array<Buffer> _idle;
+	Common::Array<Buffer> _used;
+	uint32 _idleSize;
+	const uint32 _maxIdleSize;
+};
+
+} // End of namespace Graphics
+
+#endif
@@ -83,6 +83,10 @@
 // BASIS, AND BROWN UNIVERSITY HAS NO OBLIGATION TO PROVIDE MAINTENANCE,
 // SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
 
+#include "common/atomic.h"
+#include "common/cpudetect.h"
+#include "common/endian.h"
+
 #include "graphics/surface.h"
 #include "graphics/yuv_to_rgb.h"
 
@@ -158,7 +162,17 @@ YUVToRGBLookup::YUVToRGBLookup(Graphics::PixelFormat format, YUVToRGBManager::Lu
 }
 
 YUVToRGBManager::YUVToRGBManager() {
-	_lookup = 0;
+	_lookupCount = 0;
+	_lookupLock = 0;
+
+	// Pick the fastest kernel
+	_kernel = kKernelC;
+	for (int kernel = kKernelCount - 1; kernel > kKernelC; --kernel) {
+		if (isKernelSupported((Kernel)kernel)) {
+			_kernel = (Kernel)kernel;
+			break;
+		}
+	}
 
 	int16 *Cr_r_tab = &_colorTab[0 * 256];
 	int16 *Cr_g_tab = &_colorTab[1 * 256];
@@ -180,18 +194,519 @@ YUVToRGBManager::YUVToRGBManager() {
 }
 
 YUVToRGBManager::~YUVToRGBManager() {
-	delete _lookup;
+	for (uint32 i = 0; i < _lookupCount; ++i)
+		delete _lookups[i];
+}
+
+void YUVToRGBManager::prepare(const Graphics::PixelFormat &format, LuminanceScale scale) {
+	bool owned;
+	const YUVToRGBLookup *lookup = getLookup(format, scale, owned);
+	if (owned)
+		delete lookup;
+}
+
+const YUVToRGBLookup *YUVToRGBManager::findLookup(const Graphics::PixelFormat &format, YUVToRGBManager::LuminanceScale scale) const {
+	// Lookups are only ever added, so the ones counted can be read without
+	// the lock
+	const uint32 count = Common::atomicLoad(_lookupCount);
+	for (uint32 i = 0; i < count; ++i) {
+		if (_lookups[i]->getFormat() == format && _lookups[i]->getScale() == scale)
+			return _lookups[i];
+	}
+
+	return 0;
+}
+
+const YUVToRGBLookup *YUVToRGBManager::getLookup(const Graphics::PixelFormat &format, YUVToRGBManager::LuminanceScale scale, bool &owned) {
+	owned = false;
+	const YUVToRGBLookup *lookup = findLookup(format, scale);
+	if (lookup)
+		return lookup;
+
+	// Build the tables before taking the lock, which is only held to add
+	// them, so that threads converting other frames never wait for long
+	YUVToRGBLookup *created = new YUVToRGBLookup(format, scale);
+
+	while (!Common::atomicCompareAndSwap(_lookupLock, 0, 1))
+		;
+
+	lookup = findLookup(format, scale);
+	if (!lookup && _lookupCount < kMaxLookups) {
+		_lookups[_lookupCount] = created;
+		Common::atomicStore(_lookupCount, _lookupCount + 1);
+		lookup = created;
+	}
+
+	Common::atomicStore(_lookupLock, (uint32)0);
+
+	if (!lookup) {
+		// No room left, the tables only live for one conversion
+		owned = true;
+		return created;
+	}
+
+	// Another thread may have added the same tables in the meantime
+	if (lookup != created)
+		delete created;
+	return lookup;
+}
+
+bool YUVToRGBManager::isKernelSupported(Kernel kernel) {
+	switch (kernel) {
+	case kKernelC:
+		return true;
+
+#ifdef SCUMMVM_SSE2
+	case kKernelSSE2:
+		return Common::hasSSE2();
+#endif
+
+#ifdef SCUMMVM_AVX2
+	case kKernelAVX2:
+		return Common::hasAVX2();
+#endif
+
+#ifdef SCUMMVM_NEON
+	case kKernelNEON:
+		return Common::hasNEON();
+#endif
+
+	default:
+		return false;
+	}
+}
+
+bool YUVToRGBManager::setKernel(Kernel kernel) {
+	if (!isKernelSupported(kernel))
+		return false;
+
+	_kernel = kernel;
+	return true;
+}
+
+#pragma mark --- Vectorized conversion ---
+
+// The kernels compute the same values as the lookup tables: each chroma
+// term is the chroma value times a factor, truncated towards zero. For
+// the factors used, multiplying with their integer part plus their
+// fraction in 16 bits gives exactly the same results for all values.
+enum {
+	kCrRFraction = 26302, // 0.419 / 0.299 - 1
+	kCrGFraction = 46767, // 0.299 / 0.419
+	kCbGFraction = 22571, // 0.114 / 0.331
+	kCbBFraction = 50686, // 0.587 / 0.331 - 1
+
+	// (x - 16) * 255 / 219 is ((x - 16) * 2 * kITUFactor) >> 16
+	kITUFactor = 38155
+};
+
+/** The destination format, as needed by the kernels */
+struct YUVToRGBVectorFormat {
+	YUVToRGBVectorFormat(const Graphics::PixelFormat &format, YUVToRGBManager::LuminanceScale scale) {
+		itu = (scale == YUVToRGBManager::kScaleITU);
+		alpha = format.RGBToColor(0, 0, 0);
+		rLoss = format.rLoss;
+		gLoss = format.gLoss;
+		bLoss = format.bLoss;
+		rShift = format.rShift;
+		gShift = format.gShift;
+		bShift = format.bShift;
+	}
+
+	bool itu;
+	uint32 alpha;
+	int rLoss, gLoss, bLoss;
+	int rShift, gShift, bShift;
+};
+
+/**
+ * Convert one line. For halfChroma, there is one chroma value for each
+ * two pixels; otherwise one for each pixel.
+ */
+typedef void (*YUVToRGBRowProc)(byte *dst, const byte *ySrc, const byte *uSrc, const byte *vSrc, int width, const YUVToRGBVectorFormat &format);
+
+/**
+ * Convert a line in blocks of blockSize pixels. The remaining pixels are
+ * copied to a temporary block, so that the kernel can always work on
+ * whole blocks.
+ */
+template<typename PixelInt, bool halfChroma, int blockSize, void (*convertBlock)(PixelInt *, const byte *, const byte *, const byte *, const YUVToRGBVectorFormat &)>
+static void convertRowInBlocks(byte *dst, const byte *ySrc, const byte *uSrc, const byte *vSrc, int width, const YUVToRGBVectorFormat &format) {
+	const int chromaStep = halfChroma ? blockSize / 2 : blockSize;
+	PixelInt *dstPtr = (PixelInt *)dst;
+
+	int x = 0;
+	for (; x + blockSize <= width; x += blockSize) {
+		convertBlock(dstPtr, ySrc, uSrc, vSrc, format);
+		dstPtr += blockSize;
+		ySrc += blockSize;
+		uSrc += chromaStep;
+		vSrc += chromaStep;
+	}
+
+	if (x < width) {
+		const int count = width - x;
+		const int chromaCount = halfChroma ? (count + 1) / 2 : count;
+
+		byte yBlock[blockSize], uBlock[blockSize], vBlock[blockSize];
+		PixelInt dstBlock[blockSize];
+		memset(yBlock, 0, sizeof(yBlock));
+		memset(uBlock, 0, sizeof(uBlock));
+		memset(vBlock, 0, sizeof(vBlock));
+		memcpy(yBlock, ySrc, count);
+		memcpy(uBlock, uSrc, chromaCount);
+		memcpy(vBlock, vSrc, chromaCount);
+
+		convertBlock(dstBlock, yBlock, uBlock, vBlock, format);
+		memcpy(dstPtr, dstBlock, count * sizeof(PixelInt));
+	}
+}
+
+#ifdef SCUMMVM_SSE2
+
+/** Multiply a chroma value with a factor, truncating towards zero. */
+TARGET_ATTR("sse2")
+static inline __m128i chromaTermSSE2(__m128i chroma, bool wholeOne, uint16 fraction) {
+	const __m128i sign = _mm_srai_epi16(chroma, 15);
+	const __m128i abs = _mm_sub_epi16(_mm_xor_si128(chroma, sign), sign);
+
+	__m128i result = _mm_mulhi_epu16(abs, _mm_set1_epi16((int16)fraction));
+	if (wholeOne)
+		result = _mm_add_epi16(result, abs);
+
+	return _mm_sub_epi16(_mm_xor_si128(result, sign), sign);
+}
+
+TARGET_ATTR("sse2")
+static inline __m128i clampSSE2(__m128i value, bool itu) {
+	if (!itu)
+		return _mm_min_epi16(_mm_max_epi16(value, _mm_setzero_si128()), _mm_set1_epi16(255));
+
+	value = _mm_min_epi16(_mm_max_epi16(value, _mm_set1_epi16(16)), _mm_set1_epi16(235));
+	value = _mm_slli_epi16(_mm_sub_epi16(value, _mm_set1_epi16(16)), 1);
+	return _mm_mulhi_epu16(value, _mm_set1_epi16((int16)kITUFactor));
+}
+
+/**
+ * Convert 8 pixels to their color components, reduced to the bits the
+ * destination format keeps.
+ */
+TARGET_ATTR("sse2")
+static inline void convertComponentsSSE2(__m128i y, __m128i u, __m128i v, const YUVToRGBVectorFormat &format, __m128i &r, __m128i &g, __m128i &b) {
+	const __m128i zero = _mm_setzero_si128();
+	y = _mm_unpacklo_epi8(y, zero);
+	u = _mm_sub_epi16(_mm_unpacklo_epi8(u, zero), _mm_set1_epi16(128));
+	v = _mm_sub_epi16(_mm_unpacklo_epi8(v, zero), _mm_set1_epi16(128));
+
+	r = _mm_add_epi16(y, chromaTermSSE2(v, true, kCrRFraction));
+	g = _mm_sub_epi16(_mm_sub_epi16(y, chromaTermSSE2(v, false, kCrGFraction)), chromaTermSSE2(u, false, kCbGFraction));
+	b = _mm_add_epi16(y, chromaTermSSE2(u, true, kCbBFraction));
+
+	r = _mm_srl_epi16(clampSSE2(r, format.itu), _mm_cvtsi32_si128(format.rLoss));
+	g = _mm_srl_epi16(clampSSE2(g, format.itu), _mm_cvtsi32_si128(format.gLoss));
+	b = _mm_srl_epi16(clampSSE2(b, format.itu), _mm_cvtsi32_si128(format.bLoss));
+}
+
+template<bool halfChroma>
+TARGET_ATTR("sse2")
+static inline void loadBlockSSE2(const byte *ySrc, const byte *uSrc, const byte *vSrc, __m128i &y, __m128i &u, __m128i &v) {
+	y = _mm_loadl_epi64((const __m128i *)ySrc);
+
+	if (halfChroma) {
+		u = _mm_cvtsi32_si128(READ_UINT32(uSrc));
+		v = _mm_cvtsi32_si128(READ_UINT32(vSrc));
+		u = _mm_unpacklo_epi8(u, u);
+		v = _mm_unpacklo_epi8(v, v);
+	} else {
+		u = _mm_loadl_epi64((const __m128i *)uSrc);
+		v = _mm_loadl_epi64((const __m128i *)vSrc);
+	}
+}
+
+// The block functions are not static, since C++98 only allows functions
+// with external linkage as template arguments of convertRowInBlocks().
+template<bool halfChroma>
+TARGET_ATTR("sse2")
+void convertBlock16SSE2(uint16 *dst, const byte *ySrc, const byte *uSrc, const byte *vSrc, const YUVToRGBVectorFormat &format) {
+	__m128i y, u, v, r, g, b;
+	loadBlockSSE2<halfChroma>(ySrc, uSrc, vSrc, y, u, v);
+	convertComponentsSSE2(y, u, v, format, r, g, b);
+
+	__m128i pixels = _mm_set1_epi16((int16)format.alpha);
+	pixels = _mm_or_si128(pixels, _mm_sll_epi16(r, _mm_cvtsi32_si128(format.rShift)));
+	pixels = _mm_or_si128(pixels, _mm_sll_epi16(g, _mm_cvtsi32_si128(format.gShift)));
+	pixels = _mm_or_si128(pixels, _mm_sll_epi16(b, _mm_cvtsi32_si128(format.bShift)));
+	_mm_storeu_si128((__m128i *)dst, pixels);
+}
+
+template<bool halfChroma>
+TARGET_ATTR("sse2")
+void convertBlock32SSE2(uint32 *dst, const byte *ySrc, const byte *uSrc, const byte *vSrc, const YUVToRGBVectorFormat &format) {
+	__m128i y, u, v, r, g, b;
+	loadBlockSSE2<halfChroma>(ySrc, uSrc, vSrc, y, u, v);
+	convertComponentsSSE2(y, u, v, format, r, g, b);
+
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i rShift = _mm_cvtsi32_si128(format.rShift);
+	const __m128i gShift = _mm_cvtsi32_si128(format.gShift);
+	const __m128i bShift = _mm_cvtsi32_si128(format.bShift);
+
+	__m128i pixels = _mm_set1_epi32(format.alpha);
+	pixels = _mm_or_si128(pixels, _mm_sll_epi32(_mm_unpacklo_epi16(r, zero), rShift));
+	pixels = _mm_or_si128(pixels, _mm_sll_epi32(_mm_unpacklo_epi16(g, zero), gShift));
+	pixels = _mm_or_si128(pixels, _mm_sll_epi32(_mm_unpacklo_epi16(b, zero), bShift));
+	_mm_storeu_si128((__m128i *)dst, pixels);
+
+	pixels = _mm_set1_epi32(format.alpha);
+	pixels = _mm_or_si128(pixels, _mm_sll_epi32(_mm_unpackhi_epi16(r, zero), rShift));
+	pixels = _mm_or_si128(pixels, _mm_sll_epi32(_mm_unpackhi_epi16(g, zero), gShift));
+	pixels = _mm_or_si128(pixels, _mm_sll_epi32(_mm_unpackhi_epi16(b, zero), bShift));
+	_mm_storeu_si128((__m128i *)(dst + 4), pixels);
+}
+
+#endif // SCUMMVM_SSE2
+
+#ifdef SCUMMVM_AVX2
+
+TARGET_ATTR("avx2")
+static inline __m256i chromaTermAVX2(__m256i chroma, bool wholeOne, uint16 fraction) {
+	const __m256i sign = _mm256_srai_epi16(chroma, 15);
+	const __m256i abs = _mm256_sub_epi16(_mm256_xor_si256(chroma, sign), sign);
+
+	__m256i result = _mm256_mulhi_epu16(abs, _mm256_set1_epi16((int16)fraction));
+	if (wholeOne)
+		result = _mm256_add_epi16(result, abs);
+
+	return _mm256_sub_epi16(_mm256_xor_si256(result, sign), sign);
+}
+
+TARGET_ATTR("avx2")
+static inline __m256i clampAVX2(__m256i value, bool itu) {
+	if (!itu)
+		return _mm256_min_epi16(_mm256_max_epi16(value, _mm256_setzero_si256()), _mm256_set1_epi16(255));
+
+	value = _mm256_min_epi16(_mm256_max_epi16(value, _mm256_set1_epi16(16)), _mm256_set1_epi16(235));
+	value = _mm256_slli_epi16(_mm256_sub_epi16(value, _mm256_set1_epi16(16)), 1);
+	return _mm256_mulhi_epu16(value, _mm256_set1_epi16((int16)kITUFactor));
+}
+
+/** Convert 16 pixels, see convertComponentsSSE2(). */
+template<bool halfChroma>
+TARGET_ATTR("avx2")
+static inline void convertComponentsAVX2(const byte *ySrc, const byte *uSrc, const byte *vSrc, const YUVToRGBVectorFormat &format, __m256i &r, __m256i &g, __m256i &b) {
+	__m128i u8, v8;
+	if (halfChroma) {
+		u8 = _mm_loadl_epi64((const __m128i *)uSrc);
+		v8 = _mm_loadl_epi64((const __m128i *)vSrc);
+		u8 = _mm_unpacklo_epi8(u8, u8);
+		v8 = _mm_unpacklo_epi8(v8, v8);
+	} else {
+		u8 = _mm_loadu_si128((const __m128i *)uSrc);
+		v8 = _mm_loadu_si128((const __m128i *)vSrc);
+	}
+
+	const __m256i y = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)ySrc));
+	const __m256i u = _mm256_sub_epi16(_mm256_cvtepu8_epi16(u8), _mm256_set1_epi16(128));
+	const __m256i v = _mm256_sub_epi16(_mm256_cvtepu8_epi16(v8), _mm256_set1_epi16(128));
+
+	r = _mm256_add_epi16(y, chromaTermAVX2(v, true, kCrRFraction));
+	g = _mm256_sub_epi16(_mm256_sub_epi16(y, chromaTermAVX2(v, false, kCrGFraction)), chromaTermAVX2(u, false, kCbGFraction));
+	b = _mm256_add_epi16(y, chromaTermAVX2(u, true, kCbBFraction));
+
+	r = _mm256_srl_epi16(clampAVX2(r, format.itu), _mm_cvtsi32_si128(format.rLoss));
+	g = _mm256_srl_epi16(clampAVX2(g, format.itu), _mm_cvtsi32_si128(format.gLoss));
+	b = _mm256_srl_epi16(clampAVX2(b, format.itu), _mm_cvtsi32_si128(format.bLoss));
+}
+
+template<bool halfChroma>
+TARGET_ATTR("avx2")
+void convertBlock16AVX2(uint16 *dst, const byte *ySrc, const byte *uSrc, const byte *vSrc, const YUVToRGBVectorFormat &format) {
+	__m256i r, g, b;
+	convertComponentsAVX2<halfChroma>(ySrc, uSrc, vSrc, format, r, g, b);
+
+	__m256i pixels = _mm256_set1_epi16((int16)format.alpha);
+	pixels = _mm256_or_si256(pixels, _mm256_sll_epi16(r, _mm_cvtsi32_si128(format.rShift)));
+	pixels = _mm256_or_si256(pixels, _mm256_sll_epi16(g, _mm_cvtsi32_si128(format.gShift)));
+	pixels = _mm256_or_si256(pixels, _mm256_sll_epi16(b, _mm_cvtsi32_si128(format.bShift)));
+	_mm256_storeu_si256((__m256i *)dst, pixels);
+}
+
+template<bool halfChroma>
+TARGET_ATTR("avx2")
+void convertBlock32AVX2(uint32 *dst, const byte *ySrc, const byte *uSrc, const byte *vSrc, const YUVToRGBVectorFormat &format) {
+	__m256i r, g, b;
+	convertComponentsAVX2<halfChroma>(ySrc, uSrc, vSrc, format, r, g, b);
+
+	const __m128i rShift = _mm_cvtsi32_si128(format.rShift);
+	const __m128i gShift = _mm_cvtsi32_si128(format.gShift);
+	const __m128i bShift = _mm_cvtsi32_si128(format.bShift);
+
+	// Widen each half of the 16 bit components separately, as the AVX2
+	// unpack instructions work within 128 bit lanes
+	for (int half = 0; half < 2; ++half) {
+		const __m128i r16 = half ? _mm256_extracti128_si256(r, 1) : _mm256_castsi256_si128(r);
+		const __m128i g16 = half ? _mm256_extracti128_si256(g, 1) : _mm256_castsi256_si128(g);
+		const __m128i b16 = half ? _mm256_extracti128_si256(b, 1) : _mm256_castsi256_si128(b);
+
+		__m256i pixels = _mm256_set1_epi32(format.alpha);
+		pixels = _mm256_or_si256(pixels, _mm256_sll_epi32(_mm256_cvtepu16_epi32(r16), rShift));
+		pixels = _mm256_or_si256(pixels, _mm256_sll_epi32(_mm256_cvtepu16_epi32(g16), gShift));
+		pixels = _mm256_or_si256(pixels, _mm256_sll_epi32(_mm256_cvtepu16_epi32(b16), bShift));
+		_mm256_storeu_si256((__m256i *)(dst + half * 8), pixels);
+	}
+}
+
+#endif // SCUMMVM_AVX2
+
+#ifdef SCUMMVM_NEON
+
+/** Multiply unsigned values with a fraction in 16 bits, like _mm_mulhi_epu16(). */
+static inline uint16x8_t mulHighNEON(uint16x8_t value, uint16 fraction) {
+	const uint16x4_t factor = vdup_n_u16(fraction);
+	const uint32x4_t low = vmull_u16(vget_low_u16(value), factor);
+	const uint32x4_t high = vmull_u16(vget_high_u16(value), factor);
+	return vcombine_u16(vshrn_n_u32(low, 16), vshrn_n_u32(high, 16));
+}
+
+/** Multiply a chroma value with a factor, truncating towards zero. */
+static inline int16x8_t chromaTermNEON(int16x8_t chroma, bool wholeOne, uint16 fraction) {
+	const int16x8_t abs = vabsq_s16(chroma);
+
+	int16x8_t result = vreinterpretq_s16_u16(mulHighNEON(vreinterpretq_u16_s16(abs), fraction));
+	if (wholeOne)
+		result = vaddq_s16(result, abs);
+
+	return vbslq_s16(vcltq_s16(chroma, vdupq_n_s16(0)), vnegq_s16(result), result);
+}
+
+static inline uint16x8_t clampNEON(int16x8_t value, bool itu) {
+	if (!itu)
+		return vreinterpretq_u16_s16(vminq_s16(vmaxq_s16(value, vdupq_n_s16(0)), vdupq_n_s16(255)));
+
+	value = vminq_s16(vmaxq_s16(value, vdupq_n_s16(16)), vdupq_n_s16(235));
+	const uint16x8_t scaled = vshlq_n_u16(vreinterpretq_u16_s16(vsubq_s16(value, vdupq_n_s16(16))), 1);
+	return mulHighNEON(scaled, kITUFactor);
+}
+
+/**
+ * Convert 8 pixels to their color components, reduced to the bits the
+ * destination format keeps.
+ */
+static inline void convertComponentsNEON(uint8x8_t y8, uint8x8_t u8, uint8x8_t v8, const YUVToRGBVectorFormat &format, uint16x8_t &r, uint16x8_t &g, uint16x8_t &b) {
+	const int16x8_t y = vreinterpretq_s16_u16(vmovl_u8(y8));
+	const int16x8_t u = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(u8)), vdupq_n_s16(128));
+	const int16x8_t v = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(v8)), vdupq_n_s16(128));
+
+	const int16x8_t rSum = vaddq_s16(y, chromaTermNEON(v, true, kCrRFraction));
+	const int16x8_t gSum = vsubq_s16(vsubq_s16(y, chromaTermNEON(v, false, kCrGFraction)), chromaTermNEON(u, false, kCbGFraction));
+	const int16x8_t bSum = vaddq_s16(y, chromaTermNEON(u, true, kCbBFraction));
+
+	// Shifting left by a negative count shifts right
+	r = vshlq_u16(clampNEON(rSum, format.itu), vdupq_n_s16((int16)-format.rLoss));
+	g = vshlq_u16(clampNEON(gSum, format.itu), vdupq_n_s16((int16)-format.gLoss));
+	b = vshlq_u16(clampNEON(bSum, format.itu), vdupq_n_s16((int16)-format.bLoss));
+}
+
+template<bool halfChroma>
+static inline void loadBlockNEON(const byte *ySrc, const byte *uSrc, const byte *vSrc, uint8x8_t &y, uint8x8_t &u, uint8x8_t &v) {
+	y = vld1_u8(ySrc);
+
+	if (halfChroma) {
+		byte uBlock[8] = { 0 }, vBlock[8] = { 0 };
+		memcpy(uBlock, uSrc, 4);
+		memcpy(vBlock, vSrc, 4);
+		u = vld1_u8(uBlock);
+		v = vld1_u8(vBlock);
+		u = vzip_u8(u, u).val[0];
+		v = vzip_u8(v, v).val[0];
+	} else {
+		u = vld1_u8(uSrc);
+		v = vld1_u8(vSrc);
+	}
+}
+
+template<bool halfChroma>
+void convertBlock16NEON(uint16 *dst, const byte *ySrc, const byte *uSrc, const byte *vSrc, const YUVToRGBVectorFormat &format) {
+	uint8x8_t y, u, v;
+	uint16x8_t r, g, b;
+	loadBlockNEON<halfChroma>(ySrc, uSrc, vSrc, y, u, v);
+	convertComponentsNEON(y, u, v, format, r, g, b);
+
+	uint16x8_t pixels = vdupq_n_u16((uint16)format.alpha);
+	pixels = vorrq_u16(pixels, vshlq_u16(r, vdupq_n_s16((int16)format.rShift)));
+	pixels = vorrq_u16(pixels, vshlq_u16(g, vdupq_n_s16((int16)format.gShift)));
+	pixels = vorrq_u16(pixels, vshlq_u16(b, vdupq_n_s16((int16)format.bShift)));
+	vst1q_u16(dst, pixels);
 }
 
-const YUVToRGBLookup *YUVToRGBManager::getLookup(Graphics::PixelFormat format, YUVToRGBManager::LuminanceScale scale) {
-	if (_lookup && _lookup->getFormat() == format && _lookup->getScale() == scale)
-		return _lookup;
+template<bool halfChroma>
+void convertBlock32NEON(uint32 *dst, const byte *ySrc, const byte *uSrc, const byte *vSrc, const YUVToRGBVectorFormat &format) {
+	uint8x8_t y, u, v;
+	uint16x8_t r, g, b;
+	loadBlockNEON<halfChroma>(ySrc, uSrc, vSrc, y, u, v);
+	convertComponentsNEON(y, u, v, format, r, g, b);
+
+	const int32x4_t rShift = vdupq_n_s32(format.rShift);
+	const int32x4_t gShift = vdupq_n_s32(format.gShift);
+	const int32x4_t bShift = vdupq_n_s32(format.bShift);
+
+	uint32x4_t pixels = vdupq_n_u32(format.alpha);
+	pixels = vorrq_u32(pixels, vshlq_u32(vmovl_u16(vget_low_u16(r)), rShift));
+	pixels = vorrq_u32(pixels, vshlq_u32(vmovl_u16(vget_low_u16(g)), gShift));
+	pixels = vorrq_u32(pixels, vshlq_u32(vmovl_u16(vget_low_u16(b)), bShift));
+	vst1q_u32(dst, pixels);
+
+	pixels = vdupq_n_u32(format.alpha);
+	pixels = vorrq_u32(pixels, vshlq_u32(vmovl_u16(vget_high_u16(r)), rShift));
+	pixels = vorrq_u32(pixels, vshlq_u32(vmovl_u16(vget_high_u16(g)), gShift));
+	pixels = vorrq_u32(pixels, vshlq_u32(vmovl_u16(vget_high_u16(b)), bShift));
+	vst1q_u32(dst + 4, pixels);
+}
 
-	delete _lookup;
-	_lookup = new YUVToRGBLookup(format, scale);
-	return _lookup;
+#endif // SCUMMVM_NEON
+
+static YUVToRGBRowProc getRowProc(YUVToRGBManager::Kernel kernel, int bytesPerPixel, bool halfChroma) {
+	switch (kernel) {
+#ifdef SCUMMVM_SSE2
+	case YUVToRGBManager::kKernelSSE2:
+		if (bytesPerPixel == 2 && halfChroma)
+			return &convertRowInBlocks<uint16, true, 8, convertBlock16SSE2<true> >;
+		else if (bytesPerPixel == 2)
+			return &convertRowInBlocks<uint16, false, 8, convertBlock16SSE2<false> >;
+		else if (halfChroma)
+			return &convertRowInBlocks<uint32, true, 8, convertBlock32SSE2<true> >;
+		else
+			return &convertRowInBlocks<uint32, false, 8, convertBlock32SSE2<false> >;
+#endif
+#ifdef SCUMMVM_AVX2
+	case YUVToRGBManager::kKernelAVX2:
+		if (bytesPerPixel == 2 && halfChroma)
+			return &convertRowInBlocks<uint16, true, 16, convertBlock16AVX2<true> >;
+		else if (bytesPerPixel == 2)
+			return &convertRowInBlocks<uint16, false, 16, convertBlock16AVX2<false> >;
+		else if (halfChroma)
+			return &convertRowInBlocks<uint32, true, 16, convertBlock32AVX2<true> >;
+		else
+			return &convertRowInBlocks<uint32, false, 16, convertBlock32AVX2<false> >;
+#endif
+#ifdef SCUMMVM_NEON
+	case YUVToRGBManager::kKernelNEON:
+		if (bytesPerPixel == 2 && halfChroma)
+			return &convertRowInBlocks<uint16, true, 8, convertBlock16NEON<true> >;
+		else if (bytesPerPixel == 2)
+			return &convertRowInBlocks<uint16, false, 8, convertBlock16NEON<false> >;
+		else if (halfChroma)
+			return &convertRowInBlocks<uint32, true, 8, convertBlock32NEON<true> >;
+		else
+			return &convertRowInBlocks<uint32, false, 8, convertBlock32NEON<false> >;
+#endif
+	default:
+		return 0;
+	}
 }
 
+#pragma mark --- Lookup table conversion ---
+
 #define PUT_PIXEL(s, d) \
 	L = &rgbToPix[(s)]; \
 	*((PixelInt *)(d)) = (L[cr_r] | L[crb_g] | L[cb_b])
@@ -233,13 +748,33 @@ void YUVToRGBManager::convert444(Graphics::Surface *dst, YUVToRGBManager::Lumina
 	assert(dst->format.bytesPerPixel == 2 || dst->format.bytesPerPixel == 4);
 	assert(ySrc && uSrc && vSrc);
 
-	const YUVToRGBLookup *lookup = getLookup(dst->format, scale);
+	YUVToRGBRowProc rowProc = getRowProc(_kernel, dst->format.bytesPerPixel, false);
+	if (rowProc) {
+		const YUVToRGBVectorFormat format(dst->format, scale);
+		byte *dstPtr = (byte *)dst->getPixels();
+
+		for (int h = 0; h < yHeight; h++) {
+			rowProc(dstPtr, ySrc, uSrc, vSrc, yWidth, format);
+			dstPtr += dst->pitch;
+			ySrc += yPitch;
+			uSrc += uvPitch;
+			vSrc += uvPitch;
+		}
+
+		return;
+	}
+
+	bool owned;
+	const YUVToRGBLookup *lookup = getLookup(dst->format, scale, owned);
 
 	// Use a templated function to avoid an if check on every pixel
 	if (dst->format.bytesPerPixel == 2)
 		convertYUV444ToRGB<uint16>((byte *)dst->getPixels(), dst->pitch, lookup, _colorTab, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch);
 	else
 		convertYUV444ToRGB<uint32>((byte *)dst->getPixels(), dst->pitch, lookup, _colorTab, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch);
+
+	if (owned)
+		delete lookup;
 }
 
 template<typename PixelInt>
@@ -289,13 +824,40 @@ void YUVToRGBManager::convert420(Graphics::Surface *dst, YUVToRGBManager::Lumina
 	assert((yWidth & 1) == 0);
 	assert((yHeight & 1) == 0);
 
-	const YUVToRGBLookup *lookup = getLookup(dst->format, scale);
+	YUVToRGBRowProc rowProc = getRowProc(_kernel, dst->format.bytesPerPixel, true);
+	if (rowProc) {
+		const YUVToRGBVectorFormat format(dst->format, scale);
+		byte *dstPtr = (byte *)dst->getPixels();
+
+		for (int h = 0; h < yHeight; h++) {
+			rowProc(dstPtr, ySrc, uSrc, vSrc, yWidth, format);
+			dstPtr += dst->pitch;
+			ySrc += yPitch;
+
+			if (h & 1) {
+				uSrc += uvPitch;
+				vSrc += uvPitch;
+			}
+		}
+
+		return;
+	}
+
+	bool owned;
+	const YUVToRGBLookup *lookup = getLookup(dst->format, scale, owned);
 
 	// Use a templated function to avoid an if check on every pixel
 	if (dst->format.bytesPerPixel == 2)
 		convertYUV420ToRGB<uint16>((byte *)dst->getPixels(), dst->pitch, lookup, _colorTab, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch);
 	else
 		convertYUV420ToRGB<uint32>((byte *)dst->getPixels(), dst->pitch, lookup, _colorTab, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch);
+
+	if (owned)
+		delete lookup;
+}
+
+void YUVToRGBManager::convert420(Graphics::Surface *dst, const YUV420Frame &frame) {
+	convert420(dst, frame.scale, frame.y, frame.u, frame.v, frame.width, frame.height, frame.yPitch, frame.uvPitch);
 }
 
 #define READ_QUAD(ptr, prefix) \
@@ -366,6 +928,48 @@ void convertYUV410ToRGB(byte *dstPtr, int dstPitch, const YUVToRGBLookup *lookup
 #undef DO_INTERPOLATION
 #undef DO_YUV410_PIXEL
 
+/**
+ * Convert a YUV410 image with a vectorized kernel. The chroma of each line
+ * is interpolated the same way as in convertYUV410ToRGB() first, and then
+ * converted like YUV444.
+ */
+static void convertYUV410Vector(Graphics::Surface *dst, YUVToRGBRowProc rowProc, const YUVToRGBVectorFormat &format, const byte *ySrc, const byte *uSrc, const byte *vSrc, int yWidth, int yHeight, int yPitch, int uvPitch) {
+	const int quarterWidth = yWidth >> 2;
+
+	byte *uLine = new byte[yWidth * 2];
+	byte *vLine = uLine + yWidth;
+	uint16 *uColumns = new uint16[(quarterWidth + 1) * 2];
+	uint16 *vColumns = uColumns + quarterWidth + 1;
+
+	byte *dstPtr = (byte *)dst->getPixels();
+
+	for (int y = 0; y < yHeight; y++) {
+		const byte *uRow = uSrc + (y >> 2) * uvPitch;
+		const byte *vRow = vSrc + (y >> 2) * uvPitch;
+		const int yDiff = y & 3;
+
+		// Interpolate vertically, the horizontal neighbours share the result
+		for (int x = 0; x <= quarterWidth; x++) {
+			uColumns[x] = uRow[x] * (4 - yDiff) + uRow[x + uvPitch] * yDiff;
+			vColumns[x] = vRow[x] * (4 - yDiff) + vRow[x + uvPitch] * yDiff;
+		}
+
+		for (int x = 0; x < quarterWidth; x++) {
+			for (int xDiff = 0; xDiff < 4; xDiff++) {
+				uLine[x * 4 + xDiff] = (uColumns[x] * (4 - xDiff) + uColumns[x + 1] * xDiff) >> 4;
+				vLine[x * 4 + xDiff] = (vColumns[x] * (4 - xDiff) + vColumns[x + 1] * xDiff) >> 4;
+			}
+		}
+
+		rowProc(dstPtr, ySrc, uLine, vLine, yWidth, format);
+		dstPtr += dst->pitch;
+		ySrc += yPitch;
+	}
+
+	delete[] uColumns;
+	delete[] uLine;
+}
+
 void YUVToRGBManager::convert410(Graphics::Surface *dst, YUVToRGBManager::LuminanceScale scale, const byte *ySrc, const byte *uSrc, const byte *vSrc, int yWidth, int yHeight, int yPitch, int uvPitch) {
 	// Sanity checks
 	assert(dst && dst->getPixels());
@@ -374,13 +978,23 @@ void YUVToRGBManager::convert410(Graphics::Surface *dst, YUVToRGBManager::Lumina
 	assert((yWidth & 3) == 0);
 	assert((yHeight & 3) == 0);
 
-	const YUVToRGBLookup *lookup = getLookup(dst->format, scale);
+	YUVToRGBRowProc rowProc = getRowProc(_kernel, dst->format.bytesPerPixel, false);
+	if (rowProc) {
+		convertYUV410Vector(dst, rowProc, YUVToRGBVectorFormat(dst->format, scale), ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch);
+		return;
+	}
+
+	bool owned;
+	const YUVToRGBLookup *lookup = getLookup(dst->format, scale, owned);
 
 	// Use a templated function to avoid an if check on every pixel
 	if (dst->format.bytesPerPixel == 2)
 		convertYUV410ToRGB<uint16>((byte *)dst->getPixels(), dst->pitch, lookup, _colorTab, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch);
 	else
 		convertYUV410ToRGB<uint32>((byte *)dst->getPixels(), dst->pitch, lookup, _colorTab, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch);
+
+	if (owned)
+		delete lookup;
 }
 
 } // End of namespace Graphics
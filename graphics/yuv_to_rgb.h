@@ -45,6 +45,7 @@
 namespace Graphics {
 
 class YUVToRGBLookup;
+struct YUV420Frame;
 
 class YUVToRGBManager : public Common::Singleton<YUVToRGBManager> {
 public:
@@ -54,6 +55,48 @@ public:
 		kScaleITU   /** Luminance values range from [16, 235], the range from ITU-R BT.601 */
 	};
 
+	/**
+	 * The implementations of the conversion.
+	 *
+	 * kKernelC uses lookup tables and is always available. The others
+	 * are only usable if they have been compiled in and the CPU supports
+	 * them. They produce the same output as kKernelC.
+	 */
+	enum Kernel {
+		kKernelC = 0,
+		kKernelSSE2,
+		kKernelAVX2,
+		kKernelNEON,
+
+		kKernelCount
+	};
+
+	/** Check whether a kernel is usable on this machine. */
+	static bool isKernelSupported(Kernel kernel);
+
+	/**
+	 * Select the kernel used for the conversion. By default the fastest
+	 * supported one is used; this is mostly useful for testing.
+	 *
+	 * @return false if the kernel is not supported, in which case the
+	 *         selection is left unchanged.
+	 */
+	bool setKernel(Kernel kernel);
+
+	/** Return the kernel currently used for the conversion. */
+	Kernel getKernel() const { return _kernel; }
+
+	/**
+	 * Build the tables for converting to a format ahead of time. Conversions
+	 * may run on any thread, but the first one to a new format has to build
+	 * them, so decoders converting on a thread of their own call this from
+	 * the engine thread first. This also makes sure the manager exists.
+	 *
+	 * @param format the format of the destination surfaces
+	 * @param scale  the scale of the luminance values
+	 */
+	void prepare(const Graphics::PixelFormat &format, LuminanceScale scale);
+
 	/**
 	 * Convert a YUV444 image to an RGB surface
 	 *
@@ -84,6 +127,14 @@ public:
 	 */
 	void convert420(Graphics::Surface *dst, LuminanceScale scale, const byte *ySrc, const byte *uSrc, const byte *vSrc, int yWidth, int yHeight, int yPitch, int uvPitch);
 
+	/**
+	 * Convert a YUV420 frame to an RGB surface
+	 *
+	 * @param dst     the destination surface
+	 * @param frame   the frame, whose width and height must be divisible by 2
+	 */
+	void convert420(Graphics::Surface *dst, const YUV420Frame &frame);
+
 	/**
 	 * Convert a YUV410 image to an RGB surface
 	 *
@@ -110,10 +161,49 @@ private:
 	YUVToRGBManager();
 	~YUVToRGBManager();
 
-	const YUVToRGBLookup *getLookup(Graphics::PixelFormat format, LuminanceScale scale);
+	enum {
+		kMaxLookups = 16
+	};
+
+	const YUVToRGBLookup *findLookup(const Graphics::PixelFormat &format, LuminanceScale scale) const;
 
-	YUVToRGBLookup *_lookup;
+	/**
+	 * Return the tables for a format, building them if needed. If there is
+	 * no room left to keep them, they belong to the caller, and owned is set.
+	 */
+	const YUVToRGBLookup *getLookup(const Graphics::PixelFormat &format, LuminanceScale scale, bool &owned);
+
+	// The tables built so far. Conversions may run on several threads, like
+	// the engine thread and a thread decoding a video ahead, so they are
+	// kept until the manager goes away.
+	YUVToRGBLookup *_lookups[kMaxLookups];
+	volatile uint32 _lookupCount;
+	volatile uint32 _lookupLock;
 	int16 _colorTab[4 * 256]; // 2048 bytes
+	Kernel _kernel;
+};
+
+/**
+ * The planes of a YUV420 image, as handed out by video decoders which can
+ * leave the conversion to RGB to their caller.
+ *
+ * The u and v planes have half the width and height of the y plane. The
+ * planes are owned by whoever hands out the frame.
+ */
+struct YUV420Frame {
+	const byte *y;
+	const byte *u;
+	const byte *v;
+
+	/** The size of the y plane */
+	uint16 width;
+	uint16 height;
+
+	int yPitch;
+	int uvPitch;
+
+	/** The scale of the luminance values */
+	YUVToRGBManager::LuminanceScale scale;
 };
 
 } // End of namespace Graphics
@@ -30,6 +30,8 @@ DECLARE_SINGLETON(GUI::EventRecorder);
 }
 
 #include "common/debug-channels.h"
+#include "common/file.h"
+#include "common/json.h"
 #include "backends/timer/sdl/sdl-timer.h"
 #include "backends/mixer/sdl/sdl-mixer.h"
 #include "common/config-manager.h"
@@ -44,6 +46,10 @@ DECLARE_SINGLETON(GUI::EventRecorder);
 #include "graphics/surface.h"
 #include "graphics/scaler.h"
 
+#ifdef POSIX
+#include <sys/resource.h>
+#endif
+
 namespace GUI {
 
 
@@ -89,6 +95,12 @@ EventRecorder::EventRecorder() {
 	_screenshotPeriod = 0;
 	_playbackFile = 0;
 
+	_benchmark = false;
+	_benchmarkFinished = false;
+	_benchmarkFrameStart = 0;
+	_benchmarkScreenStart = 0;
+	_benchmarkMixTime = 0;
+
 	DebugMan.addDebugChannel(kDebugLevelEventRec, "EventRec", "Event recorder debug level");
 }
 
@@ -102,6 +114,11 @@ void EventRecorder::deinit() {
 	if (!_initialized) {
 		return;
 	}
+	if (_benchmark) {
+		finishBenchmark();
+		_benchmark = false;
+		_fastPlayback = false;
+	}
 	setFileHeader();
 	_needRedraw = false;
 	_initialized = false;
@@ -152,6 +169,16 @@ void EventRecorder::processMillis(uint32 &millis, bool skipRecord) {
 			_fakeTimer = _nextEvent.time;
 			_nextEvent = _playbackFile->getNextEvent();
 			_timerManager->handler();
+		} else if (_benchmark && (_nextEvent.type == Common::EVENT_RTL || _nextEvent.type == Common::EVENT_INVALID)) {
+			// End of the recording: write the report and quit cleanly
+			// instead of erroring out, so the exit code can be checked.
+			if (!_benchmarkFinished) {
+				finishBenchmark();
+				Common::Event quitEvent;
+				quitEvent.type = Common::EVENT_QUIT;
+				quitEvent.synthetic = true;
+				g_system->getEventManager()->pushEvent(quitEvent);
+			}
 		} else {
 			if (_nextEvent.type == Common::EVENT_RTL) {
 				error("playback:action=stopplayback");
@@ -262,6 +289,18 @@ Common::String EventRecorder::generateRecordFileName(const Common::String &targe
 
 
 void EventRecorder::init(Common::String recordFileName, RecordMode mode) {
+	// A benchmark replays the recording as fast as possible, the engine
+	// still sees the recorded time through getMillis().
+	_benchmark = (mode == kRecorderPlayback) && ConfMan.hasKey("benchmark");
+	_benchmarkFinished = false;
+	if (_benchmark) {
+		_fastPlayback = true;
+		_benchmarkFileName = ConfMan.get("benchmark_output");
+		_benchmarkFrames.clear();
+		_benchmarkMixTime = 0;
+		_benchmarkFrameStart = getBenchmarkMicros();
+		debugC(1, kDebugLevelEventRec, "benchmark:action=start filename=%s output=%s", recordFileName.c_str(), _benchmarkFileName.c_str());
+	}
 	_fakeMixerManager = new NullSdlMixerManager();
 	_fakeMixerManager->init();
 	_fakeMixerManager->suspendAudio();
@@ -430,7 +469,13 @@ void EventRecorder::updateSubsystems() {
 	}
 	RecordMode oldRecordMode = _recordMode;
 	_recordMode = kPassthrough;
-	_fakeMixerManager->update();
+	if (_benchmark) {
+		const uint64 mixStart = getBenchmarkMicros();
+		_fakeMixerManager->update();
+		_benchmarkMixTime += getBenchmarkMicros() - mixStart;
+	} else {
+		_fakeMixerManager->update();
+	}
 	_recordMode = oldRecordMode;
 }
 
@@ -557,6 +602,13 @@ Common::SaveFileManager *EventRecorder::getSaveManager(Common::SaveFileManager *
 }
 
 void EventRecorder::preDrawOverlayGui() {
+	if (_benchmark) {
+		// The control panel is not shown during benchmarks, so that only
+		// the engine's own screen update is measured.
+		if (_initialized)
+			_benchmarkScreenStart = getBenchmarkMicros();
+		return;
+	}
     if ((_initialized) || (_needRedraw)) {
 		RecordMode oldMode = _recordMode;
 		_recordMode = kPassthrough;
@@ -571,6 +623,23 @@ void EventRecorder::preDrawOverlayGui() {
 }
 
 void EventRecorder::postDrawOverlayGui() {
+	if (_benchmark) {
+		if (_initialized && !_benchmarkFinished) {
+			const uint64 now = getBenchmarkMicros();
+			const uint64 engineTime = _benchmarkScreenStart - _benchmarkFrameStart;
+
+			BenchmarkFrame frame;
+			frame.time = _fakeTimer;
+			frame.engine = engineTime > _benchmarkMixTime ? engineTime - _benchmarkMixTime : 0;
+			frame.updateScreen = now - _benchmarkScreenStart;
+			frame.mix = _benchmarkMixTime;
+			_benchmarkFrames.push_back(frame);
+
+			_benchmarkFrameStart = now;
+			_benchmarkMixTime = 0;
+		}
+		return;
+	}
     if ((_initialized) || (_needRedraw)) {
 		RecordMode oldMode = _recordMode;
 		_recordMode = kPassthrough;
@@ -664,6 +733,76 @@ bool EventRecorder::checkForContinueGame() {
 	return result;
 }
 
+uint64 EventRecorder::getBenchmarkMicros() const {
+#if SDL_VERSION_ATLEAST(2, 0, 0)
+	const uint64 counter = SDL_GetPerformanceCounter();
+	const uint64 frequency = SDL_GetPerformanceFrequency();
+	return (counter / frequency) * 1000000 + (counter % frequency) * 1000000 / frequency;
+#else
+	return (uint64)SDL_GetTicks() * 1000;
+#endif
+}
+
+static uint64 getPeakRSS() {
+#ifdef POSIX
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#ifdef MACOSX
+		return usage.ru_maxrss;
+#else
+		return (uint64)usage.ru_maxrss * 1024;
+#endif
+	}
+#endif
+	return 0;
+}
+
+void EventRecorder::finishBenchmark() {
+	if (_benchmarkFinished)
+		return;
+	_benchmarkFinished = true;
+
+	Common::JSONArray frames;
+	uint64 totalEngine = 0, totalUpdateScreen = 0, totalMix = 0;
+	for (uint i = 0; i < _benchmarkFrames.size(); ++i) {
+		const BenchmarkFrame &f = _benchmarkFrames[i];
+		Common::JSONObject frame;
+		frame.setVal("time", new Common::JSONValue((long long int)f.time));
+		frame.setVal("engine", new Common::JSONValue((long long int)f.engine));
+		frame.setVal("updateScreen", new Common::JSONValue((long long int)f.updateScreen));
+		frame.setVal("mix", new Common::JSONValue((long long int)f.mix));
+		frames.push_back(new Common::JSONValue(frame));
+
+		totalEngine += f.engine;
+		totalUpdateScreen += f.updateScreen;
+		totalMix += f.mix;
+	}
+
+	Common::JSONObject report;
+	report.setVal("target", new Common::JSONValue(ConfMan.getActiveDomainName()));
+	report.setVal("recording", new Common::JSONValue(ConfMan.get("record_file_name")));
+	report.setVal("frameCount", new Common::JSONValue((long long int)_benchmarkFrames.size()));
+	report.setVal("totalEngine", new Common::JSONValue((long long int)totalEngine));
+	report.setVal("totalUpdateScreen", new Common::JSONValue((long long int)totalUpdateScreen));
+	report.setVal("totalMix", new Common::JSONValue((long long int)totalMix));
+	report.setVal("peakRSS", new Common::JSONValue((long long int)getPeakRSS()));
+	report.setVal("frames", new Common::JSONValue(frames));
+
+	Common::JSONValue value(report);
+	const Common::String json = value.stringify(true);
+
+	Common::DumpFile out;
+	if (!out.open(_benchmarkFileName) || out.write(json.c_str(), json.size()) != json.size()) {
+		warning("Could not write benchmark report to '%s'", _benchmarkFileName.c_str());
+		return;
+	}
+	out.finalize();
+	out.close();
+
+	debugC(1, kDebugLevelEventRec, "benchmark:action=report filename=%s frames=%d", _benchmarkFileName.c_str(), (int)_benchmarkFrames.size());
+	_benchmarkFrames.clear();
+}
+
 void EventRecorder::deleteTemporarySave() {
 	if (_temporarySlot == -1) return;
 	const Common::String gameId = ConfMan.get("gameid");
@@ -175,6 +175,11 @@ public:
 	bool switchMode();
 	void switchFastMode();
 
+	/** Whether the current playback is a benchmark run */
+	bool isBenchmarking() const {
+		return _benchmark;
+	}
+
 private:
 	virtual Common::List<Common::Event> mapEvent(const Common::Event &ev, Common::EventSource *source);
 	bool notifyPoll();
@@ -229,6 +234,25 @@ private:
 	Common::String _recordFileName;
 	bool _fastPlayback;
 	bool _needRedraw;
+
+	/** Timings of a single frame of a benchmark run, in microseconds */
+	struct BenchmarkFrame {
+		uint32 time;		/**< virtual (recorded) time the frame was shown at, in ms */
+		uint32 engine;		/**< time spent by the engine since the previous frame, without mixing */
+		uint32 updateScreen;	/**< time spent in OSystem::updateScreen */
+		uint32 mix;		/**< time spent mixing audio since the previous frame */
+	};
+
+	bool _benchmark;
+	bool _benchmarkFinished;
+	Common::String _benchmarkFileName;
+	Common::Array<BenchmarkFrame> _benchmarkFrames;
+	uint64 _benchmarkFrameStart;
+	uint64 _benchmarkScreenStart;
+	uint32 _benchmarkMixTime;
+
+	uint64 getBenchmarkMicros() const;
+	void finishBenchmark();
 };
 
 } // End of namespace GUI
@@ -20,6 +20,7 @@
  *
  */
 
+#include "engines/md5cache.h"
 #include "engines/metaengine.h"
 #include "common/algorithm.h"
 #include "common/config-manager.h"
@@ -253,6 +254,9 @@ void MassAddDialog::handleTickle() {
 	Common::String buf;
 
 	if (_scanStack.empty()) {
+		// Keep the checksums of all scanned files for the next time
+		MD5CacheMan.flush();
+
 		// Enable the OK button
 		_okButton->setEnabled(true);
 
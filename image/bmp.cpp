@@ -25,6 +25,7 @@
 #include "common/stream.h"
 #include "common/substream.h"
 #include "common/textconsole.h"
+#include "common/trace.h"
 #include "graphics/pixelformat.h"
 #include "graphics/surface.h"
 #include "image/codecs/codec.h"
@@ -55,6 +56,7 @@ void BitmapDecoder::destroy() {
 }
 
 bool BitmapDecoder::loadStream(Common::SeekableReadStream &stream) {
+	TRACE_SCOPE("image", "BitmapDecoder::loadStream");
 	destroy();
 
 	if (stream.readByte() != 'B')
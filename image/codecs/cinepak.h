@@ -82,8 +82,11 @@ public:
 	bool canDither(DitherType type) const;
 	void setDither(DitherType type, const byte *palette);
 
+	const Common::List<Common::Rect> *getDirtyRects() const { return &_dirtyRects.getRects(); }
+
 private:
 	CinepakFrame _curFrame;
+	DirtyRectList _dirtyRects;
 	int32 _y;
 	int _bitsPerPixel;
 	Graphics::PixelFormat _pixelFormat;
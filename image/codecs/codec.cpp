@@ -48,6 +48,77 @@
 
 namespace Image {
 
+DirtyRectList::DirtyRectList() : _runOpen(false), _rowTop(0), _rowBottom(0) {
+}
+
+void DirtyRectList::clear() {
+	_rects.clear();
+	_runOpen = false;
+	_rowTop = _rowBottom = 0;
+	_previousRow.clear();
+	_currentRow.clear();
+}
+
+void DirtyRectList::add(const Common::Rect &rect) {
+	if (rect.isEmpty())
+		return;
+
+	// Grow the current run if the rect continues it
+	if (_runOpen) {
+		Common::Rect &run = _rects.back();
+		if (run.top == rect.top && run.bottom == rect.bottom && run.right == rect.left) {
+			run.right = rect.right;
+			return;
+		}
+	}
+
+	closeRun();
+
+	if (rect.top != _rowTop || rect.bottom != _rowBottom) {
+		// A new row starts. Only runs in a row adjacent to the previous
+		// one, above or below it, can be joined to rects ending there.
+		if (rect.top == _rowBottom || rect.bottom == _rowTop)
+			_previousRow = _currentRow;
+		else
+			_previousRow.clear();
+
+		_currentRow.clear();
+		_rowTop = rect.top;
+		_rowBottom = rect.bottom;
+	}
+
+	_rects.push_back(rect);
+	_runOpen = true;
+}
+
+const Common::List<Common::Rect> &DirtyRectList::getRects() const {
+	closeRun();
+	return _rects;
+}
+
+void DirtyRectList::closeRun() const {
+	if (!_runOpen)
+		return;
+
+	_runOpen = false;
+
+	RectIterator run = _rects.reverse_begin();
+
+	for (uint i = 0; i < _previousRow.size(); i++) {
+		Common::Rect &rect = *_previousRow[i];
+		if (rect.left == run->left && rect.right == run->right) {
+			rect.extend(*run);
+			_rects.erase(run);
+
+			_currentRow.push_back(_previousRow[i]);
+			_previousRow.remove_at(i);
+			return;
+		}
+	}
+
+	_currentRow.push_back(run);
+}
+
 namespace {
 
 /**
@@ -23,6 +23,10 @@
 #ifndef IMAGE_CODECS_CODEC_H
 #define IMAGE_CODECS_CODEC_H
 
+#include "common/array.h"
+#include "common/list.h"
+#include "common/rect.h"
+
 #include "graphics/surface.h"
 #include "graphics/pixelformat.h"
 
@@ -32,6 +36,49 @@ class SeekableReadStream;
 
 namespace Image {
 
+/**
+ * The areas of a frame changed by a codec, compared to the frame decoded
+ * before it.
+ *
+ * Codecs add the blocks they update in the order they decode them, row by
+ * row from the top or from the bottom. Adjacent blocks in a row are joined,
+ * and so are runs of blocks spanning the same columns in adjacent rows, so
+ * the list stays short for the typical large changed and unchanged areas.
+ */
+class DirtyRectList {
+public:
+	DirtyRectList();
+
+	/** Forget all areas, before decoding a new frame. */
+	void clear();
+
+	/** Mark an area as changed. */
+	void add(const Common::Rect &rect);
+
+	/** Get the changed areas, in no particular order. */
+	const Common::List<Common::Rect> &getRects() const;
+
+private:
+	typedef Common::List<Common::Rect>::iterator RectIterator;
+
+	// The last run is only joined to the row before when it is complete,
+	// which may be when the list is read
+	void closeRun() const;
+
+	mutable Common::List<Common::Rect> _rects;
+
+	/** Whether the last rect is a run which may still grow to the right */
+	mutable bool _runOpen;
+
+	/** The rows of the current and of the previous blocks */
+	int16 _rowTop, _rowBottom;
+
+	/** The rects ending at the previous row, which runs may be joined to */
+	mutable Common::Array<RectIterator> _previousRow;
+	/** The rects ending at the current row */
+	mutable Common::Array<RectIterator> _currentRow;
+};
+
 /**
  * An abstract representation of a image codec.
  *
@@ -111,6 +158,16 @@ public:
 	 */
 	virtual void setDither(DitherType type, const byte *palette) {}
 
+	/**
+	 * Get the areas of the surface changed by the last decodeFrame() call.
+	 * Callers which keep a copy of the previous frame only need to update
+	 * these areas.
+	 *
+	 * @return the changed areas, or 0 if the codec does not keep track of
+	 *         them, in which case the whole frame has to be assumed changed
+	 */
+	virtual const Common::List<Common::Rect> *getDirtyRects() const { return 0; }
+
 	/**
 	 * Create a dither table, as used by QuickTime codecs.
 	 */
@@ -28,9 +28,341 @@
 
 #include "image/codecs/indeo/indeo_dsp.h"
 
+#include "common/cpudetect.h"
+
 namespace Image {
 namespace Indeo {
 
+bool IndeoDSP::isKernelSupported(Kernel kernel) {
+	switch (kernel) {
+	case kKernelC:
+		return true;
+
+#ifdef SCUMMVM_SSE2
+	case kKernelSSE2:
+		return Common::hasSSE2();
+#endif
+
+	default:
+		return false;
+	}
+}
+
+static IndeoDSP::Kernel s_kernel = IndeoDSP::kKernelCount;
+
+bool IndeoDSP::setKernel(Kernel kernel) {
+	if (!isKernelSupported(kernel))
+		return false;
+
+	s_kernel = kernel;
+	return true;
+}
+
+IndeoDSP::Kernel IndeoDSP::getKernel() {
+	if (s_kernel == kKernelCount) {
+		// Pick the last supported kernel, the list is ordered by preference.
+		for (int i = kKernelCount - 1; i >= kKernelC; --i) {
+			if (setKernel((Kernel)i))
+				break;
+		}
+	}
+
+	return s_kernel;
+}
+
+/** The passes of the 8x8 transforms done by inverse8x8SIMD(). */
+enum {
+	kPassColumns = 1 << 0,
+	kPassRows    = 1 << 1
+};
+
+#ifdef SCUMMVM_SSE2
+
+/*
+ * The 8x8 transforms work on 32 bit lanes, with each block held as two
+ * vectors per line: columns 0-3 in lo[] and columns 4-7 in hi[]. The column
+ * transforms then handle four columns per vector directly; for the row
+ * transforms the block is transposed first, and back afterwards. The
+ * shortcuts for empty lines in the C code give the same result as the
+ * full transform, so they are not needed here.
+ */
+
+TARGET_ATTR("sse2")
+static inline void transpose4x4SSE2(__m128i &r0, __m128i &r1, __m128i &r2, __m128i &r3) {
+	const __m128i t0 = _mm_unpacklo_epi32(r0, r1);
+	const __m128i t1 = _mm_unpacklo_epi32(r2, r3);
+	const __m128i t2 = _mm_unpackhi_epi32(r0, r1);
+	const __m128i t3 = _mm_unpackhi_epi32(r2, r3);
+	r0 = _mm_unpacklo_epi64(t0, t1);
+	r1 = _mm_unpackhi_epi64(t0, t1);
+	r2 = _mm_unpacklo_epi64(t2, t3);
+	r3 = _mm_unpackhi_epi64(t2, t3);
+}
+
+TARGET_ATTR("sse2")
+static inline void transpose8x8SSE2(__m128i *lo, __m128i *hi) {
+	transpose4x4SSE2(lo[0], lo[1], lo[2], lo[3]);
+	transpose4x4SSE2(hi[0], hi[1], hi[2], hi[3]);
+	transpose4x4SSE2(lo[4], lo[5], lo[6], lo[7]);
+	transpose4x4SSE2(hi[4], hi[5], hi[6], hi[7]);
+
+	for (int i = 0; i < 4; i++) {
+		const __m128i t = hi[i];
+		hi[i] = lo[i + 4];
+		lo[i + 4] = t;
+	}
+}
+
+/** Butterfly of IVI_HAAR_BFLY. */
+TARGET_ATTR("sse2")
+static inline void haarBflySSE2(__m128i s1, __m128i s2, __m128i &o1, __m128i &o2) {
+	o1 = _mm_srai_epi32(_mm_add_epi32(s1, s2), 1);
+	o2 = _mm_srai_epi32(_mm_sub_epi32(s1, s2), 1);
+}
+
+/** INV_HAAR8 on the eight vectors in v, in the order of its arguments. */
+TARGET_ATTR("sse2")
+static inline void invHaar8SSE2(__m128i *v) {
+	__m128i t1, t2, t3, t4, t5, t6, t7, t8;
+
+	t1 = _mm_slli_epi32(v[0], 1);
+	t5 = _mm_slli_epi32(v[1], 1);
+	haarBflySSE2(t1, t5, t1, t5);
+	haarBflySSE2(t1, v[2], t1, t3);
+	haarBflySSE2(t5, v[3], t5, t7);
+	haarBflySSE2(t1, v[4], t1, t2);
+	haarBflySSE2(t3, v[5], t3, t4);
+	haarBflySSE2(t5, v[6], t5, t6);
+	haarBflySSE2(t7, v[7], t7, t8);
+
+	v[0] = t1; v[1] = t2; v[2] = t3; v[3] = t4;
+	v[4] = t5; v[5] = t6; v[6] = t7; v[7] = t8;
+}
+
+/** Butterfly of IVI_SLANT_BFLY. */
+TARGET_ATTR("sse2")
+static inline void slantBflySSE2(__m128i s1, __m128i s2, __m128i &o1, __m128i &o2) {
+	o1 = _mm_add_epi32(s1, s2);
+	o2 = _mm_sub_epi32(s1, s2);
+}
+
+/** Reflection of IVI_IREFLECT. */
+TARGET_ATTR("sse2")
+static inline void slantIReflectSSE2(__m128i s1, __m128i s2, __m128i &o1, __m128i &o2) {
+	const __m128i two = _mm_set1_epi32(2);
+	o1 = _mm_add_epi32(_mm_srai_epi32(_mm_add_epi32(_mm_add_epi32(s1, _mm_slli_epi32(s2, 1)), two), 2), s1);
+	o2 = _mm_sub_epi32(_mm_srai_epi32(_mm_add_epi32(_mm_sub_epi32(_mm_slli_epi32(s1, 1), s2), two), 2), s2);
+}
+
+/** IVI_INV_SLANT8 on the eight vectors in v, in the order of its arguments. */
+TARGET_ATTR("sse2")
+static inline void invSlant8SSE2(__m128i *v) {
+	const __m128i s1 = v[0], s4 = v[1], s8 = v[2], s5 = v[3];
+	const __m128i s2 = v[4], s6 = v[5], s3 = v[6], s7 = v[7];
+	const __m128i four = _mm_set1_epi32(4);
+	__m128i t1, t2, t3, t4, t5, t6, t7, t8;
+
+	// IVI_SLANT_PART4
+	t4 = _mm_add_epi32(s5, _mm_srai_epi32(_mm_add_epi32(_mm_sub_epi32(_mm_slli_epi32(s4, 2), s5), four), 3));
+	t5 = _mm_add_epi32(s4, _mm_srai_epi32(_mm_sub_epi32(_mm_sub_epi32(four, s4), _mm_slli_epi32(s5, 2)), 3));
+
+	slantBflySSE2(s1, t5, t1, t5);
+	slantBflySSE2(s2, s6, t2, t6);
+	slantBflySSE2(s7, s3, t7, t3);
+	slantBflySSE2(t4, s8, t4, t8);
+
+	slantBflySSE2(t1, t2, t1, t2);
+	slantIReflectSSE2(t4, t3, t4, t3);
+	slantBflySSE2(t5, t6, t5, t6);
+	slantIReflectSSE2(t8, t7, t8, t7);
+	slantBflySSE2(t1, t4, t1, t4);
+	slantBflySSE2(t2, t3, t2, t3);
+	slantBflySSE2(t5, t8, t5, t8);
+	slantBflySSE2(t6, t7, t6, t7);
+
+	v[0] = t1; v[1] = t2; v[2] = t3; v[3] = t4;
+	v[4] = t5; v[5] = t6; v[6] = t7; v[7] = t8;
+}
+
+/**
+ * The Haar or slant transforms on the columns and / or the rows of an 8x8
+ * block. When transforming both, the Haar transform pre-scales the top left
+ * quarter, and the slant transform only compensates after the rows.
+ */
+TARGET_ATTR("sse2")
+static void inverse8x8SSE2(const int32 *in, int16 *out, uint32 pitch, const uint8 *flags, bool slant, int passes) {
+	__m128i lo[8], hi[8];
+
+	for (int i = 0; i < 8; i++) {
+		lo[i] = _mm_loadu_si128((const __m128i *)(in + i * 8));
+		hi[i] = _mm_loadu_si128((const __m128i *)(in + i * 8 + 4));
+	}
+
+	if (passes & kPassColumns) {
+		if (!slant && (passes & kPassRows)) {
+			for (int i = 0; i < 4; i++)
+				lo[i] = _mm_slli_epi32(lo[i], 1);
+		}
+
+		if (slant) {
+			invSlant8SSE2(lo);
+			invSlant8SSE2(hi);
+		} else {
+			invHaar8SSE2(lo);
+			invHaar8SSE2(hi);
+		}
+
+		// Empty columns give zeroes, whatever their coefficients are
+		const __m128i maskLo = _mm_set_epi32(flags[3] ? -1 : 0, flags[2] ? -1 : 0, flags[1] ? -1 : 0, flags[0] ? -1 : 0);
+		const __m128i maskHi = _mm_set_epi32(flags[7] ? -1 : 0, flags[6] ? -1 : 0, flags[5] ? -1 : 0, flags[4] ? -1 : 0);
+		for (int i = 0; i < 8; i++) {
+			lo[i] = _mm_and_si128(lo[i], maskLo);
+			hi[i] = _mm_and_si128(hi[i], maskHi);
+		}
+	}
+
+	if (passes & kPassRows) {
+		transpose8x8SSE2(lo, hi);
+
+		if (slant) {
+			invSlant8SSE2(lo);
+			invSlant8SSE2(hi);
+		} else {
+			invHaar8SSE2(lo);
+			invHaar8SSE2(hi);
+		}
+
+		transpose8x8SSE2(lo, hi);
+	}
+
+	const __m128i one = _mm_set1_epi32(1);
+	for (int i = 0; i < 8; i++, out += pitch) {
+		__m128i l = lo[i], h = hi[i];
+
+		if (slant) {
+			// COMPENSATE(x) of the last pass
+			l = _mm_srai_epi32(_mm_add_epi32(l, one), 1);
+			h = _mm_srai_epi32(_mm_add_epi32(h, one), 1);
+		}
+
+		// Keep the low 16 bits like the C code does, instead of saturating
+		l = _mm_srai_epi32(_mm_slli_epi32(l, 16), 16);
+		h = _mm_srai_epi32(_mm_slli_epi32(h, 16), 16);
+		_mm_storeu_si128((__m128i *)out, _mm_packs_epi32(l, h));
+	}
+}
+
+/** Load one line of a block of 4 or 8 pixels. */
+TARGET_ATTR("sse2")
+static inline __m128i loadLineSSE2(const int16 *src, int size) {
+	return (size == 8) ? _mm_loadu_si128((const __m128i *)src) : _mm_loadl_epi64((const __m128i *)src);
+}
+
+TARGET_ATTR("sse2")
+static inline void storeLineSSE2(int16 *dst, __m128i v, int size) {
+	if (size == 8)
+		_mm_storeu_si128((__m128i *)dst, v);
+	else
+		_mm_storel_epi64((__m128i *)dst, v);
+}
+
+/** (a + b) >> 1 without leaving 16 bits. */
+TARGET_ATTR("sse2")
+static inline __m128i average2SSE2(__m128i a, __m128i b) {
+	const __m128i low = _mm_and_si128(_mm_and_si128(a, b), _mm_set1_epi16(1));
+	return _mm_add_epi16(_mm_add_epi16(_mm_srai_epi16(a, 1), _mm_srai_epi16(b, 1)), low);
+}
+
+/** (a + b + c + d) >> 2 without leaving 16 bits. */
+TARGET_ATTR("sse2")
+static inline __m128i average4SSE2(__m128i a, __m128i b, __m128i c, __m128i d) {
+	const __m128i three = _mm_set1_epi16(3);
+	const __m128i high = _mm_add_epi16(_mm_add_epi16(_mm_srai_epi16(a, 2), _mm_srai_epi16(b, 2)),
+	                                   _mm_add_epi16(_mm_srai_epi16(c, 2), _mm_srai_epi16(d, 2)));
+	const __m128i low = _mm_add_epi16(_mm_add_epi16(_mm_and_si128(a, three), _mm_and_si128(b, three)),
+	                                  _mm_add_epi16(_mm_and_si128(c, three), _mm_and_si128(d, three)));
+	return _mm_add_epi16(high, _mm_srai_epi16(low, 2));
+}
+
+/** The motion compensation of IVI_MC_TEMPLATE, one line per iteration. */
+TARGET_ATTR("sse2")
+static void mcSSE2(int16 *buf, uint32 dpitch, const int16 *refBuf, uint32 pitch, int mcType, int size, bool delta) {
+	if (mcType < 0 || mcType > 3)
+		return;
+
+	for (int i = 0; i < size; i++, buf += dpitch, refBuf += pitch) {
+		__m128i pred;
+
+		switch (mcType) {
+		case 0:
+			pred = loadLineSSE2(refBuf, size);
+			break;
+		case 1:
+			pred = average2SSE2(loadLineSSE2(refBuf, size), loadLineSSE2(refBuf + 1, size));
+			break;
+		case 2:
+			pred = average2SSE2(loadLineSSE2(refBuf, size), loadLineSSE2(refBuf + pitch, size));
+			break;
+		default:
+			pred = average4SSE2(loadLineSSE2(refBuf, size), loadLineSSE2(refBuf + 1, size),
+			                    loadLineSSE2(refBuf + pitch, size), loadLineSSE2(refBuf + pitch + 1, size));
+			break;
+		}
+
+		if (delta)
+			pred = _mm_add_epi16(pred, loadLineSSE2(buf, size));
+		storeLineSSE2(buf, pred, size);
+	}
+}
+
+/** The final averaging of IVI_MC_AVG_TEMPLATE. */
+TARGET_ATTR("sse2")
+static void mcAvgSSE2(int16 *buf, const int16 *tmp, uint32 pitch, int size, bool delta) {
+	for (int i = 0; i < size; i++, buf += pitch, tmp += size) {
+		__m128i pred = _mm_srai_epi16(loadLineSSE2(tmp, size), 1);
+		if (delta)
+			pred = _mm_add_epi16(pred, loadLineSSE2(buf, size));
+		storeLineSSE2(buf, pred, size);
+	}
+}
+
+#endif // SCUMMVM_SSE2
+
+/**
+ * Run the 8x8 transform with the vectorized kernel, if one is selected.
+ *
+ * @return true if the transform has been done
+ */
+static inline bool inverse8x8SIMD(const int32 *in, int16 *out, uint32 pitch, const uint8 *flags, bool slant, int passes) {
+#ifdef SCUMMVM_SSE2
+	if (IndeoDSP::getKernel() == IndeoDSP::kKernelSSE2) {
+		inverse8x8SSE2(in, out, pitch, flags, slant, passes);
+		return true;
+	}
+#endif
+	return false;
+}
+
+static inline bool mcSIMD(int16 *buf, uint32 dpitch, const int16 *refBuf, uint32 pitch, int mcType, int size, bool delta) {
+#ifdef SCUMMVM_SSE2
+	if (IndeoDSP::getKernel() == IndeoDSP::kKernelSSE2) {
+		mcSSE2(buf, dpitch, refBuf, pitch, mcType, size, delta);
+		return true;
+	}
+#endif
+	return false;
+}
+
+static inline bool mcAvgSIMD(int16 *buf, const int16 *tmp, uint32 pitch, int size, bool delta) {
+#ifdef SCUMMVM_SSE2
+	if (IndeoDSP::getKernel() == IndeoDSP::kKernelSSE2) {
+		mcAvgSSE2(buf, tmp, pitch, size, delta);
+		return true;
+	}
+#endif
+	return false;
+}
+
 /**
  * butterfly operation for the inverse Haar transform
  */
@@ -73,6 +405,9 @@ namespace Indeo {
 
 void IndeoDSP::ffIviInverseHaar8x8(const int32 *in, int16 *out, uint32 pitch,
 							 const uint8 *flags) {
+	if (inverse8x8SIMD(in, out, pitch, flags, false, kPassColumns | kPassRows))
+		return;
+
 	int32 tmp[64];
 	int t0, t1, t2, t3, t4, t5, t6, t7, t8;
 
@@ -125,6 +460,9 @@ void IndeoDSP::ffIviInverseHaar8x8(const int32 *in, int16 *out, uint32 pitch,
 
 void IndeoDSP::ffIviRowHaar8(const int32 *in, int16 *out, uint32 pitch,
 					  const uint8 *flags) {
+	if (inverse8x8SIMD(in, out, pitch, flags, false, kPassRows))
+		return;
+
 	int t0, t1, t2, t3, t4, t5, t6, t7, t8;
 
 	// apply the InvHaar8 to all rows
@@ -148,6 +486,9 @@ void IndeoDSP::ffIviRowHaar8(const int32 *in, int16 *out, uint32 pitch,
 
 void IndeoDSP::ffIviColHaar8(const int32 *in, int16 *out, uint32 pitch,
 					  const uint8 *flags) {
+	if (inverse8x8SIMD(in, out, pitch, flags, false, kPassColumns))
+		return;
+
 	int t0, t1, t2, t3, t4, t5, t6, t7, t8;
 
 	// apply the InvHaar8 to all columns
@@ -322,6 +663,9 @@ void IndeoDSP::ffIviDcHaar2d(const int32 *in, int16 *out, uint32 pitch,
 	d4 = COMPENSATE(t4);}
 
 void IndeoDSP::ffIviInverseSlant8x8(const int32 *in, int16 *out, uint32 pitch, const uint8 *flags) {
+	if (inverse8x8SIMD(in, out, pitch, flags, true, kPassColumns | kPassRows))
+		return;
+
 	int32 tmp[64];
 	int t0, t1, t2, t3, t4, t5, t6, t7, t8;
 
@@ -406,6 +750,9 @@ void IndeoDSP::ffIviDcSlant2d(const int32 *in, int16 *out, uint32 pitch,
 
 void IndeoDSP::ffIviRowSlant8(const int32 *in, int16 *out, uint32 pitch,
 		const uint8 *flags) {
+	if (inverse8x8SIMD(in, out, pitch, flags, true, kPassRows))
+		return;
+
 	int t0, t1, t2, t3, t4, t5, t6, t7, t8;
 
 #define COMPENSATE(x) (((x) + 1)>>1)
@@ -438,6 +785,9 @@ void IndeoDSP::ffIviDcRowSlant(const int32 *in, int16 *out, uint32 pitch, int bl
 }
 
 void IndeoDSP::ffIviColSlant8(const int32 *in, int16 *out, uint32 pitch, const uint8 *flags) {
+	if (inverse8x8SIMD(in, out, pitch, flags, true, kPassColumns))
+		return;
+
 	int t0, t1, t2, t3, t4, t5, t6, t7, t8;
 
 	int row2 = pitch << 1;
@@ -530,13 +880,16 @@ void IndeoDSP::ffIviPutDcPixel8x8(const int32 *in, int16 *out, uint32 pitch,
 		memset(out, 0, 8 * sizeof(out[0]));
 }
 
-#define IVI_MC_TEMPLATE(size, suffix, OP) \
+#define IVI_MC_TEMPLATE(size, suffix, OP, DELTA) \
 static void iviMc ## size ##x## size ## suffix(int16 *buf, \
 												 uint32 dpitch, \
 												 const int16 *refBuf, \
 												 uint32 pitch, int mcType) \
 { \
 	const int16 *wptr; \
+\
+	if (mcSIMD(buf, dpitch, refBuf, pitch, mcType, size, DELTA)) \
+		return; \
 \
 	switch (mcType) { \
 	case 0: /* fullpel (no interpolation) */ \
@@ -572,7 +925,7 @@ void IndeoDSP::ffIviMc ## size ##x## size ## suffix(int16 *buf, const int16 *ref
 	iviMc ## size ##x## size ## suffix(buf, pitch, refBuf, pitch, mcType); \
 }
 
-#define IVI_MC_AVG_TEMPLATE(size, suffix, OP) \
+#define IVI_MC_AVG_TEMPLATE(size, suffix, OP, DELTA) \
 void IndeoDSP::ffIviMcAvg ## size ##x## size ## suffix(int16 *buf, \
 												 const int16 *refBuf, \
 												 const int16 *refBuf2, \
@@ -583,6 +936,8 @@ void IndeoDSP::ffIviMcAvg ## size ##x## size ## suffix(int16 *buf, \
 \
 	iviMc ## size ##x## size ## NoDelta(tmp, size, refBuf, pitch, mcType); \
 	iviMc ## size ##x## size ## Delta(tmp, size, refBuf2, pitch, mcType2); \
+	if (mcAvgSIMD(buf, tmp, pitch, size, DELTA)) \
+		return; \
 	for (int i = 0; i < size; i++, buf += pitch) { \
 		for (int j = 0; j < size; j++) {\
 			OP(buf[j], tmp[i * size + j] >> 1); \
@@ -593,14 +948,14 @@ void IndeoDSP::ffIviMcAvg ## size ##x## size ## suffix(int16 *buf, \
 #define OP_PUT(a, b)  (a) = (b)
 #define OP_ADD(a, b)  (a) += (b)
 
-IVI_MC_TEMPLATE(8, NoDelta, OP_PUT)
-IVI_MC_TEMPLATE(8, Delta,   OP_ADD)
-IVI_MC_TEMPLATE(4, NoDelta, OP_PUT)
-IVI_MC_TEMPLATE(4, Delta,   OP_ADD)
-IVI_MC_AVG_TEMPLATE(8, NoDelta, OP_PUT)
-IVI_MC_AVG_TEMPLATE(8, Delta,   OP_ADD)
-IVI_MC_AVG_TEMPLATE(4, NoDelta, OP_PUT)
-IVI_MC_AVG_TEMPLATE(4, Delta,   OP_ADD)
+IVI_MC_TEMPLATE(8, NoDelta, OP_PUT, false)
+IVI_MC_TEMPLATE(8, Delta,   OP_ADD, true)
+IVI_MC_TEMPLATE(4, NoDelta, OP_PUT, false)
+IVI_MC_TEMPLATE(4, Delta,   OP_ADD, true)
+IVI_MC_AVG_TEMPLATE(8, NoDelta, OP_PUT, false)
+IVI_MC_AVG_TEMPLATE(8, Delta,   OP_ADD, true)
+IVI_MC_AVG_TEMPLATE(4, NoDelta, OP_PUT, false)
+IVI_MC_AVG_TEMPLATE(4, Delta,   OP_ADD, true)
 
 } // End of namespace Indeo
 } // End of namespace Image
@@ -38,6 +38,34 @@ namespace Indeo {
 
 class IndeoDSP {
 public:
+	/**
+	 * The implementations of the 8x8 transforms and motion compensation.
+	 * Besides the C code, vectorized kernels are only usable if they have
+	 * been compiled in and the CPU supports them. They produce the same
+	 * output as kKernelC.
+	 */
+	enum Kernel {
+		kKernelC = 0,
+		kKernelSSE2,
+
+		kKernelCount
+	};
+
+	/** Check whether a kernel is usable on this machine. */
+	static bool isKernelSupported(Kernel kernel);
+
+	/**
+	 * Select the kernel used by the DSP functions. By default the fastest
+	 * supported one is used; this is mostly useful for testing.
+	 *
+	 * @return false if the kernel is not supported, in which case the
+	 *         selection is left unchanged.
+	 */
+	static bool setKernel(Kernel kernel);
+
+	/** Return the kernel currently used by the DSP functions. */
+	static Kernel getKernel();
+
 	/**
 	 *  two-dimensional inverse Haar 8x8 transform for Indeo 4
 	 *
@@ -494,7 +494,12 @@ void Indeo3Decoder::decodeChunk(byte *cur, byte *ref, int width, int height,
 			bit_pos -= 2;
 			cmd = (bit_buf >> bit_pos) & 0x03;
 
-			if (cmd == 0 || ref_vectors != NULL) {
+			if ((cmd == 0 || ref_vectors != NULL) && blks_width * 4 <= width_tbl[4]) {
+				// Copy the whole strip line by line. As long as the lines
+				// don't overlap, this is the same as the copy by columns below.
+				for (i = 0, j = 0; i < blks_height; i++, j += width_tbl[4])
+					memcpy(cur_frm_pos + j, ref_frm_pos + j, blks_width * 4);
+			} else if (cmd == 0 || ref_vectors != NULL) {
 				for (lp1 = 0; lp1 < blks_width; lp1++) {
 					for (i = 0, j = 0; i < blks_height; i++, j += width_tbl[1])
 						((uint32 *)cur_frm_pos)[j] = READ_UINT32(((uint32 *)ref_frm_pos)+j);
@@ -120,6 +120,12 @@ void MSVideo1Decoder::decode8(Common::SeekableReadStream &stream) {
                 }
             }
 
+            if ((byte_b & 0xFC) != 0x84) {
+                uint16 x = (blocks_wide - block_x) * 4;
+                uint16 y = (block_y - 1) * 4;
+                _dirtyRects.add(Common::Rect(x, y, x + 4, y + 4));
+            }
+
             blockPtr += blockInc;
             totalBlocks--;
         }
@@ -207,6 +213,12 @@ void MSVideo1Decoder::decode16(Common::SeekableReadStream &stream) {
                 }
             }
 
+            if ((byte_b & 0xFC) != 0x84) {
+                int32 x = (blocks_wide - block_x) * 4;
+                int32 y = (block_y - 1) * 4;
+                _dirtyRects.add(Common::Rect(x, y, x + 4, y + 4));
+            }
+
             block_ptr += block_inc;
             total_blocks--;
         }
@@ -214,6 +226,8 @@ void MSVideo1Decoder::decode16(Common::SeekableReadStream &stream) {
 }
 
 const Graphics::Surface *MSVideo1Decoder::decodeFrame(Common::SeekableReadStream &stream) {
+	_dirtyRects.clear();
+
 	if (_bitsPerPixel == 8)
 		decode8(stream);
 	else
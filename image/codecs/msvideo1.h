@@ -40,10 +40,13 @@ public:
 	const Graphics::Surface *decodeFrame(Common::SeekableReadStream &stream);
 	Graphics::PixelFormat getPixelFormat() const { return _surface->format; }
 
+	const Common::List<Common::Rect> *getDirtyRects() const { return &_dirtyRects.getRects(); }
+
 private:
 	byte _bitsPerPixel;
 
 	Graphics::Surface *_surface;
+	DirtyRectList _dirtyRects;
 
 	void decode8(Common::SeekableReadStream &stream);
 	void decode16(Common::SeekableReadStream &stream);
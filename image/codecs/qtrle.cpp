@@ -427,6 +427,8 @@ const Graphics::Surface *QTRLEDecoder::decodeFrame(Common::SeekableReadStream &s
 	if (!_surface)
 		createSurface();
 
+	_dirtyRects.clear();
+
 	uint16 startLine = 0;
 	uint16 height = _height;
 
@@ -453,6 +455,11 @@ const Graphics::Surface *QTRLEDecoder::decodeFrame(Common::SeekableReadStream &s
 
 	uint32 rowPtr = _paddedWidth * startLine;
 
+	// Only the lines given by the header are coded, the others are kept
+	Common::Rect changedLines(0, startLine, _width, startLine + height);
+	changedLines.clip(_width, _height);
+	_dirtyRects.add(changedLines);
+
 	switch (_bitsPerPixel) {
 	case 1:
 	case 33:
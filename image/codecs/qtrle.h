@@ -47,9 +47,12 @@ public:
 	bool canDither(DitherType type) const;
 	void setDither(DitherType type, const byte *palette);
 
+	const Common::List<Common::Rect> *getDirtyRects() const { return &_dirtyRects.getRects(); }
+
 private:
 	byte _bitsPerPixel;
 	Graphics::Surface *_surface;
+	DirtyRectList _dirtyRects;
 	uint16 _width, _height;
 	uint32 _paddedWidth;
 	byte *_ditherPalette;
@@ -63,6 +63,15 @@ RPZADecoder::~RPZADecoder() {
 	if (totalBlocks < 0) \
 		error("rpza block counter just went negative (this should not happen)") \
 
+// Mark the block about to be advanced over as changed
+#define MARK_BLOCK_DIRTY() \
+	do { \
+		uint32 offset = blockPtr - ptr; \
+		Common::Rect blockRect(offset % pitch, offset / pitch, offset % pitch + 4, offset / pitch + 4); \
+		blockRect.clip(width, height); \
+		dirtyRects.add(blockRect); \
+	} while (0)
+
 struct BlockDecoderRaw {
 	static inline void drawFillBlock(uint16 *blockPtr, uint16 pitch, uint16 color, const byte *colorMap) {
 		blockPtr[0] = color;
@@ -206,7 +215,7 @@ struct BlockDecoderDither {
 };
 
 template<typename PixelInt, typename BlockDecoder>
-static inline void decodeFrameTmpl(Common::SeekableReadStream &stream, PixelInt *ptr, uint16 pitch, uint16 blockWidth, uint16 blockHeight, const byte *colorMap) {
+static inline void decodeFrameTmpl(Common::SeekableReadStream &stream, PixelInt *ptr, uint16 pitch, uint16 width, uint16 height, uint16 blockWidth, uint16 blockHeight, const byte *colorMap, DirtyRectList &dirtyRects) {
 	uint16 colorA = 0, colorB = 0;
 	uint16 color4[4];
 
@@ -263,6 +272,7 @@ static inline void decodeFrameTmpl(Common::SeekableReadStream &stream, PixelInt
 
 			while (numBlocks--) {
 				BlockDecoder::drawFillBlock(blockPtr, pitch, colorA, colorMap);
+				MARK_BLOCK_DIRTY();
 				ADVANCE_BLOCK();
 			}
 			break;
@@ -303,6 +313,7 @@ static inline void decodeFrameTmpl(Common::SeekableReadStream &stream, PixelInt
 				stream.read(indexes, 4);
 
 				BlockDecoder::drawBlendBlock(blockPtr, pitch, color4, indexes, colorMap);
+				MARK_BLOCK_DIRTY();
 				ADVANCE_BLOCK();
 			}
 			break;
@@ -316,6 +327,7 @@ static inline void decodeFrameTmpl(Common::SeekableReadStream &stream, PixelInt
 				colors[i + 1] = stream.readUint16BE();
 
 			BlockDecoder::drawRawBlock(blockPtr, pitch, colors, colorMap);
+			MARK_BLOCK_DIRTY();
 			ADVANCE_BLOCK();
 			break;
 		}
@@ -339,10 +351,12 @@ const Graphics::Surface *RPZADecoder::decodeFrame(Common::SeekableReadStream &st
 		_surface->h = _height;
 	}
 
+	_dirtyRects.clear();
+
 	if (_colorMap)
-		decodeFrameTmpl<byte, BlockDecoderDither>(stream, (byte *)_surface->getPixels(), _surface->pitch, _blockWidth, _blockHeight, _colorMap);
+		decodeFrameTmpl<byte, BlockDecoderDither>(stream, (byte *)_surface->getPixels(), _surface->pitch, _width, _height, _blockWidth, _blockHeight, _colorMap, _dirtyRects);
 	else
-		decodeFrameTmpl<uint16, BlockDecoderRaw>(stream, (uint16 *)_surface->getPixels(), _surface->pitch / 2, _blockWidth, _blockHeight, _colorMap);
+		decodeFrameTmpl<uint16, BlockDecoderRaw>(stream, (uint16 *)_surface->getPixels(), _surface->pitch / 2, _width, _height, _blockWidth, _blockHeight, _colorMap, _dirtyRects);
 
 	return _surface;
 }
@@ -47,9 +47,12 @@ public:
 	bool canDither(DitherType type) const;
 	void setDither(DitherType type, const byte *palette);
 
+	const Common::List<Common::Rect> *getDirtyRects() const { return &_dirtyRects.getRects(); }
+
 private:
 	Graphics::PixelFormat _format;
 	Graphics::Surface *_surface;
+	DirtyRectList _dirtyRects;
 	byte *_ditherPalette;
 	bool _dirtyPalette;
 	byte *_colorMap;
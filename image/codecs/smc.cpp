@@ -45,6 +45,14 @@ namespace Image {
 	} \
 }
 
+// Mark the block about to be advanced over as changed
+#define MARK_BLOCK_DIRTY() \
+	do { \
+		Common::Rect blockRect(pixelPtr, rowPtr / _surface->w, pixelPtr + 4, rowPtr / _surface->w + 4); \
+		blockRect.clip(_surface->w, _surface->h); \
+		_dirtyRects.add(blockRect); \
+	} while (0)
+
 SMCDecoder::SMCDecoder(uint16 width, uint16 height) {
 	_surface = new Graphics::Surface();
 	_surface->create(width, height, Graphics::PixelFormat::createFormatCLUT8());
@@ -83,6 +91,8 @@ const Graphics::Surface *SMCDecoder::decodeFrame(Common::SeekableReadStream &str
 
 	int32 totalBlocks = ((_surface->w + 3) / 4) * ((_surface->h + 3) / 4);
 
+	_dirtyRects.clear();
+
 	// traverse through the blocks
 	while (totalBlocks != 0) {
 		// sanity checks
@@ -137,6 +147,7 @@ const Graphics::Surface *SMCDecoder::decodeFrame(Common::SeekableReadStream &str
 					blockPtr += rowInc;
 					prevBlockPtr += rowInc;
 				}
+				MARK_BLOCK_DIRTY();
 				ADVANCE_BLOCK();
 			}
 			break;
@@ -184,6 +195,7 @@ const Graphics::Surface *SMCDecoder::decodeFrame(Common::SeekableReadStream &str
 					blockPtr += rowInc;
 					prevBlockPtr += rowInc;
 				}
+				MARK_BLOCK_DIRTY();
 				ADVANCE_BLOCK();
 			}
 			break;
@@ -202,6 +214,7 @@ const Graphics::Surface *SMCDecoder::decodeFrame(Common::SeekableReadStream &str
 
 					blockPtr += rowInc;
 				}
+				MARK_BLOCK_DIRTY();
 				ADVANCE_BLOCK();
 			}
 			break;
@@ -248,6 +261,7 @@ const Graphics::Surface *SMCDecoder::decodeFrame(Common::SeekableReadStream &str
 
 					blockPtr += rowInc;
 				}
+				MARK_BLOCK_DIRTY();
 				ADVANCE_BLOCK();
 			}
 			break;
@@ -292,6 +306,7 @@ const Graphics::Surface *SMCDecoder::decodeFrame(Common::SeekableReadStream &str
 					}
 					blockPtr += rowInc;
 				}
+				MARK_BLOCK_DIRTY();
 				ADVANCE_BLOCK();
 			}
 			break;
@@ -357,6 +372,7 @@ const Graphics::Surface *SMCDecoder::decodeFrame(Common::SeekableReadStream &str
 
 					blockPtr += rowInc;
 				}
+				MARK_BLOCK_DIRTY();
 				ADVANCE_BLOCK();
 			}
 			break;
@@ -373,6 +389,7 @@ const Graphics::Surface *SMCDecoder::decodeFrame(Common::SeekableReadStream &str
 
 					blockPtr += rowInc;
 				}
+				MARK_BLOCK_DIRTY();
 				ADVANCE_BLOCK();
 			}
 			break;
@@ -47,8 +47,11 @@ public:
 	const Graphics::Surface *decodeFrame(Common::SeekableReadStream &stream);
 	Graphics::PixelFormat getPixelFormat() const { return Graphics::PixelFormat::createFormatCLUT8(); }
 
+	const Common::List<Common::Rect> *getDirtyRects() const { return &_dirtyRects.getRects(); }
+
 private:
 	Graphics::Surface *_surface;
+	DirtyRectList _dirtyRects;
 
 	// SMC color tables
 	byte _colorPairs[COLORS_PER_TABLE * CPAIR];
@@ -0,0 +1,90 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "image/image_cache.h"
+
+namespace Image {
+
+namespace {
+
+/** Matches all formats of an image, for ImageCache::remove(). */
+struct NameEquals {
+	explicit NameEquals(const Common::String &name) : _name(name) {}
+
+	template<class Entry>
+	bool operator()(const Common::String &key, const Entry &entry) const {
+		return entry.name.equalsIgnoreCase(_name);
+	}
+
+	const Common::String &_name;
+};
+
+} // End of anonymous namespace
+
+ImageCache::ImageCache(uint32 maxSize) : _images(maxSize) {
+}
+
+Common::String ImageCache::makeKey(const Common::String &name, const Graphics::PixelFormat &format) {
+	// toString() leaves out padding bytes, so add the pixel size
+	return Common::String::format("%s|%d%s", name.c_str(), format.bytesPerPixel, format.toString().c_str());
+}
+
+CachedImagePtr ImageCache::get(const Common::String &name, const Graphics::PixelFormat &format) {
+	const Entry *entry = _images.get(makeKey(name, format));
+	return entry ? entry->image : CachedImagePtr();
+}
+
+CachedImagePtr ImageCache::add(const Common::String &name, const Graphics::Surface &surface,
+                               const Graphics::PixelFormat &sourceFormat,
+                               const byte *palette, uint16 paletteColorCount) {
+	CachedImage *image = new CachedImage();
+	image->surface.copyFrom(surface);
+	image->sourceFormat = sourceFormat;
+	if (palette && paletteColorCount) {
+		image->palette.resize(paletteColorCount * 3);
+		memcpy(image->palette.begin(), palette, paletteColorCount * 3);
+		image->paletteColorCount = paletteColorCount;
+	}
+
+	CachedImagePtr ptr(image);
+
+	Entry entry;
+	entry.name = name;
+	entry.image = ptr;
+
+	// Make room by dropping the least recently used images. Images bigger
+	// than the whole budget are returned, but not cached.
+	const uint32 size = surface.h * image->surface.pitch + image->palette.size();
+	_images.put(makeKey(name, surface.format), entry, size);
+
+	return ptr;
+}
+
+void ImageCache::remove(const Common::String &name) {
+	_images.removeIf(NameEquals(name));
+}
+
+void ImageCache::clear() {
+	_images.clear();
+}
+
+} // End of namespace Image
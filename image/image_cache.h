@@ -0,0 +1,141 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef IMAGE_IMAGE_CACHE_H
+#define IMAGE_IMAGE_CACHE_H
+
+#include "common/array.h"
+#include "common/hash-str.h"
+#include "common/lru-cache.h"
+#include "common/noncopyable.h"
+#include "common/ptr.h"
+#include "common/str.h"
+#include "graphics/pixelformat.h"
+#include "graphics/surface.h"
+
+namespace Image {
+
+/**
+ * A decoded image kept by an ImageCache.
+ */
+struct CachedImage : Common::NonCopyable {
+	CachedImage() : paletteColorCount(0) {}
+	~CachedImage() { surface.free(); }
+
+	/** The image, in the format it was cached in. */
+	Graphics::Surface surface;
+
+	/**
+	 * The format the image was decoded to, before it was converted to the
+	 * format of the surface. Callers may need it to know how to treat the
+	 * image, like whether it had an alpha channel.
+	 */
+	Graphics::PixelFormat sourceFormat;
+
+	/** The palette of the decoded image, as interleaved RGB values. */
+	Common::Array<byte> palette;
+	uint16 paletteColorCount;
+};
+
+typedef Common::SharedPtr<const CachedImage> CachedImagePtr;
+
+/**
+ * A cache of decoded images, for engines which load the same image files
+ * over and over, like each time a scene is entered again.
+ *
+ * Images are identified by the name of the file they come from and the
+ * pixel format they were cached in, so one file can be cached in several
+ * formats. Names are case insensitive. The least recently used images are
+ * dropped when the surfaces take up more than the memory budget. Images
+ * which have been handed out stay valid after being dropped, for as long
+ * as they are referenced.
+ */
+class ImageCache : Common::NonCopyable {
+public:
+	enum {
+		kDefaultMaxSize = 16 * 1024 * 1024
+	};
+
+	/**
+	 * @param maxSize	the maximum number of bytes taken by the cached
+	 *					surfaces and palettes
+	 */
+	explicit ImageCache(uint32 maxSize = kDefaultMaxSize);
+
+	/**
+	 * Look up an image, counting a hit or a miss.
+	 *
+	 * @return the image, or a null pointer if it is not cached
+	 */
+	CachedImagePtr get(const Common::String &name, const Graphics::PixelFormat &format);
+
+	/**
+	 * Add a copy of an image to the cache, replacing the one with the same
+	 * name and format. Images bigger than the memory budget are not cached,
+	 * but are returned all the same.
+	 *
+	 * @param name			the name of the file the image comes from
+	 * @param surface		the image, in the format it is cached in
+	 * @param sourceFormat	the format the image was decoded to
+	 * @param palette		the palette of the decoded image, if any
+	 * @param paletteColorCount	the number of colors in the palette
+	 * @return the cached image
+	 */
+	CachedImagePtr add(const Common::String &name, const Graphics::Surface &surface,
+	                   const Graphics::PixelFormat &sourceFormat,
+	                   const byte *palette = 0, uint16 paletteColorCount = 0);
+
+	/** Drop all formats of an image, for example because its file changed. */
+	void remove(const Common::String &name);
+
+	/** Drop all images. */
+	void clear();
+
+	/** Change the memory budget, dropping images which don't fit anymore. */
+	void setMaxSize(uint32 maxSize) { _images.setMaxSize(maxSize); }
+	uint32 getMaxSize() const { return _images.getMaxSize(); }
+
+	/** Return the number of bytes taken by the cached images. */
+	uint32 getSize() const { return _images.getSize(); }
+
+	/** Return the number of cached images. */
+	uint getCount() const { return _images.getCount(); }
+
+	uint32 getHits() const { return _images.getHits(); }
+	uint32 getMisses() const { return _images.getMisses(); }
+	uint32 getEvictions() const { return _images.getEvictions(); }
+	void resetStatistics() { _images.resetStatistics(); }
+
+private:
+	struct Entry {
+		Common::String name;
+		CachedImagePtr image;
+	};
+
+	static Common::String makeKey(const Common::String &name, const Graphics::PixelFormat &format);
+
+	Common::LRUCache<Common::String, Entry, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> _images;
+};
+
+} // End of namespace Image
+
+#endif
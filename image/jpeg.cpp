@@ -30,7 +30,9 @@
 #include "common/endian.h"
 #include "common/stream.h"
 #include "common/textconsole.h"
+#include "common/trace.h"
 #include "graphics/pixelformat.h"
+#include "graphics/surface_pool.h"
 
 #ifdef USE_JPEG
 // The original release of libjpeg v6b did not contain any extern "C" in case
@@ -44,7 +46,8 @@ extern "C" {
 
 namespace Image {
 
-JPEGDecoder::JPEGDecoder() : _surface(), _colorSpace(kColorSpaceRGBA) {
+JPEGDecoder::JPEGDecoder() : _surface(), _colorSpace(kColorSpaceRGBA),
+		_outputFormat(4, 8, 8, 8, 0, 24, 16, 8, 0), _downscale(1), _surfacePool(0) {
 }
 
 JPEGDecoder::~JPEGDecoder() {
@@ -56,7 +59,20 @@ const Graphics::Surface *JPEGDecoder::getSurface() const {
 }
 
 void JPEGDecoder::destroy() {
-	_surface.free();
+	if (_surfacePool)
+		_surfacePool->free(_surface);
+	else
+		_surface.free();
+}
+
+void JPEGDecoder::setOutputPixelFormat(const Graphics::PixelFormat &format) {
+	assert(format.bytesPerPixel == 2 || format.bytesPerPixel == 4);
+	_outputFormat = format;
+}
+
+void JPEGDecoder::setDownscale(uint factor) {
+	assert(factor == 1 || factor == 2 || factor == 4 || factor == 8);
+	_downscale = factor;
 }
 
 const Graphics::Surface *JPEGDecoder::decodeFrame(Common::SeekableReadStream &stream) {
@@ -175,6 +191,7 @@ void outputMessage(j_common_ptr cinfo) {
 #endif
 
 bool JPEGDecoder::loadStream(Common::SeekableReadStream &stream) {
+	TRACE_SCOPE("image", "JPEGDecoder::loadStream");
 #ifdef USE_JPEG
 	// Reset member variables from previous decodings
 	destroy();
@@ -207,65 +224,102 @@ bool JPEGDecoder::loadStream(Common::SeekableReadStream &stream) {
 		break;
 	}
 
+	// libjpeg can decode a smaller version of the image right away
+	cinfo.scale_num = 1;
+	cinfo.scale_denom = _downscale;
+
 	// Actually start decompressing the image
 	jpeg_start_decompress(&cinfo);
 
+	// The part of the image which ends up in the surface
+	Common::Rect area(cinfo.output_width, cinfo.output_height);
+	if (!_clipRect.isEmpty())
+		area.clip(_clipRect);
+
 	// Allocate buffers for the output data
+	Graphics::PixelFormat format;
 	switch (_colorSpace) {
 	case kColorSpaceRGBA:
-		// We use RGBA8888 in this scenario
-		_surface.create(cinfo.output_width, cinfo.output_height, Graphics::PixelFormat(4, 8, 8, 8, 0, 24, 16, 8, 0));
+		// We use RGBA8888 in this scenario, unless asked otherwise
+		format = _outputFormat;
 		break;
 
 	case kColorSpaceYUV:
 		// We use YUV with 3 bytes per pixel otherwise.
 		// This is pretty ugly since our PixelFormat cannot express YUV...
-		_surface.create(cinfo.output_width, cinfo.output_height, Graphics::PixelFormat(3, 0, 0, 0, 0, 0, 0, 0, 0));
+		format = Graphics::PixelFormat(3, 0, 0, 0, 0, 0, 0, 0, 0);
 		break;
 	}
 
+	if (_surfacePool)
+		_surfacePool->create(_surface, area.width(), area.height(), format);
+	else
+		_surface.create(area.width(), area.height(), format);
+
+	const bool isRGBA8888 = (format == Graphics::PixelFormat(4, 8, 8, 8, 0, 24, 16, 8, 0));
+
 	// Allocate buffer for one scanline
 	assert(cinfo.output_components == 3);
 	JDIMENSION pitch = cinfo.output_width * cinfo.output_components;
-	assert(_surface.pitch >= pitch);
 	JSAMPARRAY buffer = (*cinfo.mem->alloc_sarray)((j_common_ptr)&cinfo, JPOOL_IMAGE, pitch, 1);
 
-	// Go through the image data scanline by scanline
-	while (cinfo.output_scanline < cinfo.output_height) {
-		byte *dst = (byte *)_surface.getBasePtr(0, cinfo.output_scanline);
+	// Go through the image data scanline by scanline, up to the last one
+	// needed
+	while (cinfo.output_scanline < (JDIMENSION)area.bottom) {
+		const int y = cinfo.output_scanline;
 
 		jpeg_read_scanlines(&cinfo, buffer, 1);
 
-		const byte *src = buffer[0];
+		if (y < area.top)
+			continue;
+
+		byte *dst = (byte *)_surface.getBasePtr(0, y - area.top);
+		const byte *src = buffer[0] + area.left * cinfo.output_components;
+
 		switch (_colorSpace) {
-		case kColorSpaceRGBA: {
-			for (int remaining = cinfo.output_width; remaining > 0; --remaining) {
-				byte r = *src++;
-				byte g = *src++;
-				byte b = *src++;
-				// We need to insert a alpha value of 255 (opaque) here.
+		case kColorSpaceRGBA:
+			if (isRGBA8888) {
+				for (int remaining = area.width(); remaining > 0; --remaining) {
+					byte r = *src++;
+					byte g = *src++;
+					byte b = *src++;
+					// We need to insert a alpha value of 255 (opaque) here.
 #ifdef SCUMM_BIG_ENDIAN
-				*dst++ = r;
-				*dst++ = g;
-				*dst++ = b;
-				*dst++ = 0xFF;
+					*dst++ = r;
+					*dst++ = g;
+					*dst++ = b;
+					*dst++ = 0xFF;
 #else
-				*dst++ = 0xFF;
-				*dst++ = b;
-				*dst++ = g;
-				*dst++ = r;
+					*dst++ = 0xFF;
+					*dst++ = b;
+					*dst++ = g;
+					*dst++ = r;
 #endif
+				}
+			} else if (format.bytesPerPixel == 2) {
+				uint16 *dst16 = (uint16 *)dst;
+				for (int remaining = area.width(); remaining > 0; --remaining, src += 3)
+					*dst16++ = format.RGBToColor(src[0], src[1], src[2]);
+			} else {
+				uint32 *dst32 = (uint32 *)dst;
+				for (int remaining = area.width(); remaining > 0; --remaining, src += 3)
+					*dst32++ = format.RGBToColor(src[0], src[1], src[2]);
 			}
-			} break;
+			break;
 
 		case kColorSpaceYUV:
-			memcpy(dst, src, pitch);
+			memcpy(dst, src, area.width() * cinfo.output_components);
 			break;
 		}
 	}
 
+	// Skip the rest of the image if it is not needed
+	if (cinfo.output_scanline < cinfo.output_height)
+		jpeg_abort_decompress(&cinfo);
+	else
+		jpeg_finish_decompress(&cinfo);
+
 	// We are done with decompressing, thus free all the data
-	jpeg_finish_decompress(&cinfo);
 	jpeg_destroy_decompress(&cinfo);
 
 	return true;
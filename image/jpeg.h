@@ -33,6 +33,7 @@
 #ifndef IMAGE_JPEG_H
 #define IMAGE_JPEG_H
 
+#include "common/rect.h"
 #include "graphics/surface.h"
 #include "image/image_decoder.h"
 #include "image/codecs/codec.h"
@@ -41,6 +42,10 @@ namespace Common {
 class SeekableReadStream;
 }
 
+namespace Graphics {
+class SurfacePool;
+}
+
 namespace Image {
 
 class JPEGDecoder : public ImageDecoder, public Codec {
@@ -92,9 +97,43 @@ public:
 	 */
 	void setOutputColorSpace(ColorSpace outSpace) { _colorSpace = outSpace; }
 
+	/**
+	 * Request the pixel format of RGBA output, which needs to have 2 or 4
+	 * bytes per pixel. The pixels are converted while they are decoded.
+	 *
+	 * The decoder defaults to RGBA8888.
+	 */
+	void setOutputPixelFormat(const Graphics::PixelFormat &format);
+
+	/**
+	 * Only decode the given part of the image, in the coordinates of the
+	 * downscaled image. Decoding stops after its last row. An empty
+	 * rectangle, the default, stands for the whole image.
+	 */
+	void setClipRect(const Common::Rect &rect) { _clipRect = rect; }
+
+	/**
+	 * Decode a smaller version of the image, with the width and height
+	 * divided by the given factor and rounded up. This is done by libjpeg
+	 * while decoding, which is a lot faster than decoding the whole image.
+	 *
+	 * @param factor 1, 2, 4 or 8
+	 */
+	void setDownscale(uint factor);
+
+	/**
+	 * Take the decoded surface from the given pool, and hand it back to it
+	 * in destroy(). The pool has to outlive the decoder.
+	 */
+	void setSurfacePool(Graphics::SurfacePool *pool) { _surfacePool = pool; }
+
 private:
 	Graphics::Surface _surface;
 	ColorSpace _colorSpace;
+	Graphics::PixelFormat _outputFormat;
+	Common::Rect _clipRect;
+	uint _downscale;
+	Graphics::SurfacePool *_surfacePool;
 };
 
 } // End of namespace Image
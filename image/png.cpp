@@ -31,15 +31,19 @@
 
 #include "image/png.h"
 
+#include "graphics/conversion.h"
 #include "graphics/pixelformat.h"
 #include "graphics/surface.h"
+#include "graphics/surface_pool.h"
 
 #include "common/array.h"
 #include "common/stream.h"
+#include "common/trace.h"
 
 namespace Image {
 
-PNGDecoder::PNGDecoder() : _outputSurface(0), _palette(0), _paletteColorCount(0), _skipSignature(false) {
+PNGDecoder::PNGDecoder() : _outputSurface(0), _palette(0), _paletteColorCount(0), _skipSignature(false),
+		_hasOutputFormat(false), _downscale(1), _surfacePool(0) {
 }
 
 PNGDecoder::~PNGDecoder() {
@@ -48,7 +52,10 @@ PNGDecoder::~PNGDecoder() {
 
 void PNGDecoder::destroy() {
 	if (_outputSurface) {
-		_outputSurface->free();
+		if (_surfacePool)
+			_surfacePool->free(*_outputSurface);
+		else
+			_outputSurface->free();
 		delete _outputSurface;
 		_outputSurface = 0;
 	}
@@ -56,6 +63,17 @@ void PNGDecoder::destroy() {
 	_palette = NULL;
 }
 
+void PNGDecoder::setOutputPixelFormat(const Graphics::PixelFormat &format) {
+	assert(format.bytesPerPixel == 1 || format.bytesPerPixel == 2 || format.bytesPerPixel == 4);
+	_outputFormat = format;
+	_hasOutputFormat = true;
+}
+
+void PNGDecoder::setDownscale(uint factor) {
+	assert(factor >= 1);
+	_downscale = factor;
+}
+
 #ifdef USE_PNG
 // libpng-error-handling:
 void pngError(png_structp pngptr, png_const_charp errorMsg) {
@@ -84,6 +102,109 @@ void pngFlushStream(png_structp pngPtr) {
 	Common::WriteStream *stream = (Common::WriteStream *)writeIOptr;
 	stream->flush();
 }
+
+namespace {
+
+/**
+ * Writes the decoded rows of an image into the part of the output surface
+ * they end up in, downscaling and converting them on the way.
+ */
+class RowWriter {
+public:
+	RowWriter(Graphics::Surface &dst, const Common::Rect &area, uint downscale,
+	          uint width, uint height, const Graphics::PixelFormat &format);
+
+	/** Return whether rows from y on are still needed. */
+	bool needsRow(uint y) const { return y < _area.bottom * _downscale; }
+
+	void writeRow(uint y, const byte *src);
+
+private:
+	void outputRow(uint y, const byte *src);
+
+	Graphics::Surface &_dst;
+	const Common::Rect _area;
+	const uint _downscale;
+	const uint _width, _height;
+	const Graphics::PixelFormat _format;
+	Common::Array<byte> _row;
+	Common::Array<uint32> _sums;
+	uint _rowCount;
+};
+
+RowWriter::RowWriter(Graphics::Surface &dst, const Common::Rect &area, uint downscale,
+                     uint width, uint height, const Graphics::PixelFormat &format) :
+		_dst(dst), _area(area), _downscale(downscale), _width(width), _height(height), _format(format), _rowCount(0) {
+	if (_downscale != 1) {
+		_row.resize(_area.width() * _format.bytesPerPixel);
+		_sums.resize(_area.width() * _format.bytesPerPixel);
+	}
+}
+
+void RowWriter::writeRow(uint y, const byte *src) {
+	if (y < _area.top * _downscale || !needsRow(y))
+		return;
+
+	const uint bpp = _format.bytesPerPixel;
+
+	if (_downscale == 1) {
+		outputRow(y, src + _area.left * bpp);
+		return;
+	}
+
+	if (bpp == 1) {
+		// Palette indices can't be averaged
+		if (y % _downscale == 0) {
+			for (int x = 0; x < _area.width(); x++)
+				_row[x] = src[(_area.left + x) * _downscale];
+
+			outputRow(y / _downscale, _row.begin());
+		}
+		return;
+	}
+
+	// Add up the components of the pixels covered by each of the output
+	// pixels. They are all 8 bits, whatever their order.
+	for (int x = 0; x < _area.width(); x++) {
+		const uint left = (_area.left + x) * _downscale;
+		const uint right = MIN(left + _downscale, _width);
+		uint32 *sum = &_sums[x * bpp];
+
+		for (const byte *pixel = src + left * bpp; pixel < src + right * bpp; pixel += bpp) {
+			for (uint i = 0; i < bpp; i++)
+				sum[i] += pixel[i];
+		}
+	}
+
+	_rowCount++;
+	if (y % _downscale != _downscale - 1 && y != _height - 1)
+		return;
+
+	for (int x = 0; x < _area.width(); x++) {
+		const uint left = (_area.left + x) * _downscale;
+		const uint count = (MIN(left + _downscale, _width) - left) * _rowCount;
+
+		for (uint i = 0; i < bpp; i++)
+			_row[x * bpp + i] = (_sums[x * bpp + i] + count / 2) / count;
+	}
+
+	outputRow(y / _downscale, _row.begin());
+
+	memset(_sums.begin(), 0, _sums.size() * sizeof(uint32));
+	_rowCount = 0;
+}
+
+void RowWriter::outputRow(uint y, const byte *src) {
+	byte *dst = (byte *)_dst.getBasePtr(0, y - _area.top);
+
+	if (_dst.format == _format)
+		memcpy(dst, src, _area.width() * _format.bytesPerPixel);
+	else
+		Graphics::crossBlit(dst, src, _dst.pitch, _area.width() * _format.bytesPerPixel,
+		                    _area.width(), 1, _dst.format, _format);
+}
+
+} // End of anonymous namespace
 #endif
 
 /*
@@ -96,9 +217,23 @@ void pngFlushStream(png_structp pngPtr) {
  */
 
 bool PNGDecoder::loadStream(Common::SeekableReadStream &stream) {
+	return decode(stream, 0, Common::Point());
+}
+
+bool PNGDecoder::loadStream(Common::SeekableReadStream &stream, Graphics::Surface &dst, const Common::Point &pos) {
+	return decode(stream, &dst, pos);
+}
+
+bool PNGDecoder::decode(Common::SeekableReadStream &stream, Graphics::Surface *dst, const Common::Point &pos) {
+	TRACE_SCOPE("image", "PNGDecoder::loadStream");
 #ifdef USE_PNG
 	destroy();
 
+	// Decoding into a surface of the caller implies its format
+	const bool hasOutputFormat = dst || _hasOutputFormat;
+	const Graphics::PixelFormat requestedFormat = dst ? dst->format : _outputFormat;
+	assert(requestedFormat.bytesPerPixel == 1 || requestedFormat.bytesPerPixel == 2 || requestedFormat.bytesPerPixel == 4 || !hasOutputFormat);
+
 	// First, check the PNG signature (if not set to skip it)
 	if (!_skipSignature) {
 		if (stream.readUint32BE() != MKTAG(0x89, 'P', 'N', 'G')) {
@@ -146,13 +281,12 @@ bool PNGDecoder::loadStream(Common::SeekableReadStream &stream) {
 	width = w;
 	height = h;
 
-	// Allocate memory for the final image data.
-	// To keep memory framentation low this happens before allocating memory for temporary image data.
-	_outputSurface = new Graphics::Surface();
-
 	// Images of all color formats except PNG_COLOR_TYPE_PALETTE
-	// will be transformed into ARGB images
-	if (colorType == PNG_COLOR_TYPE_PALETTE && !png_get_valid(pngPtr, infoPtr, PNG_INFO_tRNS)) {
+	// will be transformed into ARGB images, and so are those if another
+	// output format was requested
+	Graphics::PixelFormat format;
+	if (colorType == PNG_COLOR_TYPE_PALETTE && !png_get_valid(pngPtr, infoPtr, PNG_INFO_tRNS) &&
+			(!hasOutputFormat || requestedFormat.bytesPerPixel == 1)) {
 		int numPalette = 0;
 		png_colorp palette = NULL;
 		uint32 success = png_get_PLTE(pngPtr, infoPtr, &palette, &numPalette);
@@ -168,22 +302,24 @@ bool PNGDecoder::loadStream(Common::SeekableReadStream &stream) {
 			_palette[(i * 3) + 2] = palette[i].blue;
 
 		}
-		_outputSurface->create(width, height, Graphics::PixelFormat::createFormatCLUT8());
+		format = Graphics::PixelFormat::createFormatCLUT8();
 		png_set_packing(pngPtr);
 	} else {
+		if (hasOutputFormat && requestedFormat.bytesPerPixel == 1) {
+			warning("PNGDecoder: Only images with a palette can be decoded to CLUT8");
+			png_destroy_read_struct(&pngPtr, &infoPtr, &endInfo);
+			return false;
+		}
+
 		bool isAlpha = (colorType & PNG_COLOR_MASK_ALPHA);
 		if (png_get_valid(pngPtr, infoPtr, PNG_INFO_tRNS)) {
 			isAlpha = true;
 			png_set_expand(pngPtr);
 		}
-		_outputSurface->create(width, height, Graphics::PixelFormat(4,
-		                       8, 8, 8, isAlpha ? 8 : 0, 24, 16, 8, 0));
-		if (!_outputSurface->getPixels()) {
-			error("Could not allocate memory for output image.");
-		}
+		format = Graphics::PixelFormat(4, 8, 8, 8, isAlpha ? 8 : 0, 24, 16, 8, 0);
 		if (bitDepth == 16)
 			png_set_strip_16(pngPtr);
-		if (bitDepth < 8)
+		if (bitDepth < 8 || colorType == PNG_COLOR_TYPE_PALETTE)
 			png_set_expand(pngPtr);
 		if (colorType == PNG_COLOR_TYPE_GRAY ||
 			colorType == PNG_COLOR_TYPE_GRAY_ALPHA)
@@ -209,14 +345,72 @@ bool PNGDecoder::loadStream(Common::SeekableReadStream &stream) {
 	width = w;
 	height = h;
 
-	if (interlaceType == PNG_INTERLACE_NONE) {
+	// The part of the (downscaled) image which ends up in the surface
+	Common::Rect area((width + _downscale - 1) / _downscale, (height + _downscale - 1) / _downscale);
+	if (!_clipRect.isEmpty())
+		area.clip(_clipRect);
+
+	const Graphics::PixelFormat outputFormat = hasOutputFormat ? requestedFormat : format;
+	Graphics::Surface *output;
+	Graphics::Surface dstArea;
+
+	if (dst) {
+		// Only decode the part which fits into the destination
+		Common::Rect dstRect(pos.x, pos.y, pos.x + area.width(), pos.y + area.height());
+		dstRect.clip(dst->w, dst->h);
+		if (dstRect.isEmpty()) {
+			png_destroy_read_struct(&pngPtr, &infoPtr, &endInfo);
+			return true;
+		}
+
+		area = Common::Rect(area.left + dstRect.left - pos.x, area.top + dstRect.top - pos.y,
+		                    area.left + dstRect.right - pos.x, area.top + dstRect.bottom - pos.y);
+		dstArea = dst->getSubArea(dstRect);
+		output = &dstArea;
+	} else {
+		// Allocate memory for the final image data.
+		// To keep memory framentation low this happens before allocating memory for temporary image data.
+		_outputSurface = new Graphics::Surface();
+		if (_surfacePool)
+			_surfacePool->create(*_outputSurface, area.width(), area.height(), outputFormat);
+		else
+			_outputSurface->create(area.width(), area.height(), outputFormat);
+
+		if (!_outputSurface->getPixels() && !area.isEmpty()) {
+			error("Could not allocate memory for output image.");
+		}
+		output = _outputSurface;
+	}
+
+	// Whether the whole image has been read
+	bool complete = true;
+
+	if (interlaceType == PNG_INTERLACE_NONE && outputFormat == format &&
+			area.width() == width && area.height() == height) {
 		// PNGs without interlacing can simply be read row by row.
 		for (int i = 0; i < height; i++) {
-			png_read_row(pngPtr, (png_bytep)_outputSurface->getBasePtr(0, i), NULL);
+			png_read_row(pngPtr, (png_bytep)output->getBasePtr(0, i), NULL);
+		}
+	} else if (interlaceType == PNG_INTERLACE_NONE) {
+		// Otherwise the rows are converted one by one, and reading stops
+		// after the last one needed.
+		RowWriter writer(*output, area, _downscale, width, height, format);
+		Common::Array<byte> row;
+		row.resize(width * format.bytesPerPixel);
+
+		for (int i = 0; i < height && (complete = writer.needsRow(i)); i++) {
+			png_read_row(pngPtr, row.begin(), NULL);
+			writer.writeRow(i, row.begin());
 		}
 	} else {
 		// PNGs with interlacing require us to allocate an auxillary
-		// buffer with pointers to all row starts.
+		// buffer with pointers to all row starts, and the whole image
+		// in case it is converted.
+		Graphics::Surface image;
+		if (outputFormat == format && area.width() == width && area.height() == height)
+			image = *output;
+		else
+			image.create(width, height, format);
 
 		// Allocate row pointer buffer
 		png_bytep *rowPtr = new png_bytep[height];
@@ -226,17 +420,26 @@ bool PNGDecoder::loadStream(Common::SeekableReadStream &stream) {
 
 		// Initialize row pointers
 		for (int i = 0; i < height; i++)
-			rowPtr[i] = (png_bytep)_outputSurface->getBasePtr(0, i);
+			rowPtr[i] = (png_bytep)image.getBasePtr(0, i);
 
 		// Read image data
 		png_read_image(pngPtr, rowPtr);
 
 		// Free row pointer buffer
 		delete[] rowPtr;
+
+		if (image.getPixels() != output->getPixels()) {
+			RowWriter writer(*output, area, _downscale, width, height, format);
+			for (int i = 0; i < height && writer.needsRow(i); i++)
+				writer.writeRow(i, (const byte *)image.getBasePtr(0, i));
+
+			image.free();
+		}
 	}
 
 	// Read additional data at the end.
-	png_read_end(pngPtr, NULL);
+	if (complete)
+		png_read_end(pngPtr, NULL);
 
 	// Destroy libpng structures
 	png_destroy_read_struct(&pngPtr, &infoPtr, &endInfo);
@@ -31,8 +31,10 @@
 #ifndef IMAGE_PNG_H
 #define IMAGE_PNG_H
 
+#include "common/rect.h"
 #include "common/scummsys.h"
 #include "common/textconsole.h"
+#include "graphics/pixelformat.h"
 #include "image/image_decoder.h"
 
 namespace Common {
@@ -42,6 +44,7 @@ class WriteStream;
 
 namespace Graphics {
 struct Surface;
+class SurfacePool;
 }
 
 namespace Image {
@@ -52,18 +55,70 @@ public:
 	~PNGDecoder();
 
 	bool loadStream(Common::SeekableReadStream &stream);
+
+	/**
+	 * Decode the image straight into the given surface, with its top left
+	 * corner at the given position, instead of into a surface of its own.
+	 * The rows are converted to the format of the surface, which has to be
+	 * one setOutputPixelFormat() accepts, and the parts which don't fit are
+	 * not decoded. The clip rectangle and downscaling apply as for the other
+	 * loadStream(), but getSurface() returns 0 afterwards.
+	 */
+	bool loadStream(Common::SeekableReadStream &stream, Graphics::Surface &dst, const Common::Point &pos = Common::Point());
+
 	void destroy();
 	const Graphics::Surface *getSurface() const { return _outputSurface; }
 	const byte *getPalette() const { return _palette; }
 	uint16 getPaletteColorCount() const { return _paletteColorCount; }
 	void setSkipSignature(bool skip) { _skipSignature = skip; }
+
+	/**
+	 * Request the pixel format of the decoded surface. The rows are
+	 * converted while they are decoded, so there's no need to convert
+	 * the whole surface afterwards.
+	 *
+	 * By default, images with a palette are decoded to CLUT8 and all
+	 * others to RGBA8888. CLUT8 can only be requested for the former, and
+	 * palettes are applied for the other formats, which need to have 2 or
+	 * 4 bytes per pixel.
+	 */
+	void setOutputPixelFormat(const Graphics::PixelFormat &format);
+
+	/**
+	 * Only decode the given part of the image, in the coordinates of the
+	 * downscaled image. The rows below it are not decoded at all. An empty
+	 * rectangle, the default, stands for the whole image.
+	 */
+	void setClipRect(const Common::Rect &rect) { _clipRect = rect; }
+
+	/**
+	 * Decode a smaller version of the image, with the width and height
+	 * divided by the given factor and rounded up. Each pixel is the
+	 * average of those it covers, or the top left one of them for CLUT8.
+	 */
+	void setDownscale(uint factor);
+
+	/**
+	 * Take the decoded surface from the given pool, and hand it back to it
+	 * in destroy(). The pool has to outlive the decoder.
+	 */
+	void setSurfacePool(Graphics::SurfacePool *pool) { _surfacePool = pool; }
+
 private:
+	bool decode(Common::SeekableReadStream &stream, Graphics::Surface *dst, const Common::Point &pos);
+
 	byte *_palette;
 	uint16 _paletteColorCount;
 
 	// flag to skip the png signature check for headless png files
 	bool _skipSignature;
 
+	Graphics::PixelFormat _outputFormat;
+	bool _hasOutputFormat;
+	Common::Rect _clipRect;
+	uint _downscale;
+	Graphics::SurfacePool *_surfacePool;
+
 	Graphics::Surface *_outputSurface;
 };
 
@@ -0,0 +1,151 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/array.h"
+#include "audio/softsynth/opl/dbopl_block.h"
+
+#ifndef DISABLE_DOSBOX_OPL
+
+namespace DBOPL = OPL::DOSBox::DBOPL;
+
+class DBOPLTestSuite : public CxxTest::TestSuite {
+	// A register write, made before generating the given number of samples
+	struct LogEntry {
+		uint32 reg;
+		uint8 val;
+		uint32 samples;
+	};
+
+	typedef Common::Array<LogEntry> RegisterLog;
+
+	static uint32 nextRandom(uint32 &seed) {
+		seed = seed * 1103515245 + 12345;
+		return (seed >> 16) & 0x7fff;
+	}
+
+	static void add(RegisterLog &log, uint32 reg, uint8 val, uint32 samples = 0) {
+		LogEntry entry = { reg, val, samples };
+		log.push_back(entry);
+	}
+
+	/**
+	 * Make up a register log which plays notes on all channels with random
+	 * operator settings, and switches between 2 and 4 operator channels and
+	 * percussion mode while doing so.
+	 */
+	static RegisterLog makeLog(bool opl3, uint32 seed) {
+		RegisterLog log;
+		const uint32 high = opl3 ? 0x100 : 0;
+
+		add(log, 0x01, 0x20);
+		if (opl3) {
+			add(log, 0x105, 0x01);
+			add(log, 0x104, 0x09);
+		}
+		add(log, 0xbd, 0xc0);
+
+		for (int step = 0; step < 300; ++step) {
+			const uint32 bank = (opl3 && (nextRandom(seed) & 1)) ? high : 0;
+			const uint32 channel = nextRandom(seed) % 9;
+			const uint32 op = (channel / 3) * 8 + channel % 3 + ((nextRandom(seed) & 1) ? 3 : 0);
+
+			add(log, bank + 0x20 + op, nextRandom(seed));
+			add(log, bank + 0x40 + op, nextRandom(seed) & 0x7f);
+			add(log, bank + 0x60 + op, nextRandom(seed));
+			add(log, bank + 0x80 + op, nextRandom(seed));
+			add(log, bank + 0xe0 + op, nextRandom(seed) & 7);
+			add(log, bank + 0xc0 + channel, nextRandom(seed));
+			add(log, bank + 0xa0 + channel, nextRandom(seed));
+			add(log, bank + 0xb0 + channel, nextRandom(seed) & 0x3f, nextRandom(seed) % 700);
+
+			if (step % 50 == 25)
+				add(log, 0xbd, 0xe0 | (nextRandom(seed) & 0x1f));
+			else if (step % 50 == 40)
+				add(log, 0xbd, nextRandom(seed) & 0xc0);
+
+			if (opl3 && step % 75 == 60)
+				add(log, 0x104, nextRandom(seed) & 0x3f);
+		}
+
+		// Let everything decay
+		for (uint32 channel = 0; channel < 9; ++channel) {
+			add(log, 0xb0 + channel, 0);
+			add(log, high + 0xb0 + channel, 0);
+		}
+		add(log, 0xbd, 0, 20000);
+
+		return log;
+	}
+
+	/** Replay a register log, in blocks of varying length. */
+	static Common::Array<int32> replay(const RegisterLog &log, bool opl3, DBOPL::BlockKernel kernel) {
+		DBOPL::Chip *chip = new DBOPL::Chip();
+		chip->Setup(44100);
+		TS_ASSERT(chip->SetBlockKernel(kernel));
+
+		Common::Array<int32> output;
+		int32 buffer[512 * 2];
+		uint32 seed = 1;
+
+		for (uint i = 0; i < log.size(); ++i) {
+			chip->WriteReg(log[i].reg, log[i].val);
+
+			for (uint32 left = log[i].samples; left > 0; ) {
+				const uint32 samples = MIN<uint32>(left, 1 + nextRandom(seed) % 512);
+				if (opl3)
+					chip->GenerateBlock3(samples, buffer);
+				else
+					chip->GenerateBlock2(samples, buffer);
+
+				for (uint32 j = 0; j < samples * (opl3 ? 2 : 1); ++j)
+					output.push_back(buffer[j]);
+				left -= samples;
+			}
+		}
+
+		delete chip;
+		return output;
+	}
+
+	static void compareKernels(bool opl3) {
+		DBOPL::InitTables();
+
+		const RegisterLog log = makeLog(opl3, opl3 ? 3 : 2);
+		const Common::Array<int32> reference = replay(log, opl3, DBOPL::kBlockKernelScalar);
+
+		// Make sure the log actually produces sound
+		uint nonZero = 0;
+		for (uint i = 0; i < reference.size(); ++i) {
+			if (reference[i])
+				++nonZero;
+		}
+		TS_ASSERT_LESS_THAN(reference.size() / 4, nonZero);
+
+		for (int kernel = DBOPL::kBlockKernelScalar + 1; kernel < DBOPL::kBlockKernelCount; ++kernel) {
+			if (!DBOPL::IsBlockKernelSupported((DBOPL::BlockKernel)kernel))
+				continue;
+
+			const Common::Array<int32> output = replay(log, opl3, (DBOPL::BlockKernel)kernel);
+			TS_ASSERT_EQUALS(output.size(), reference.size());
+
+			uint firstDifference = reference.size();
+			for (uint i = 0; i < reference.size() && i < output.size(); ++i) {
+				if (output[i] != reference[i]) {
+					firstDifference = i;
+					break;
+				}
+			}
+			TS_ASSERT_EQUALS(firstDifference, reference.size());
+		}
+	}
+
+public:
+	void test_opl2() {
+		compareKernels(false);
+	}
+
+	void test_opl3() {
+		compareKernels(true);
+	}
+};
+
+#endif
@@ -0,0 +1,123 @@
+#include <cxxtest/TestSuite.h>
+
+#include "audio/decode_cache.h"
+
+#include "helper.h"
+
+class DecodeCacheTestSuite : public CxxTest::TestSuite
+{
+	/** Read a whole stream and compare it to the expected samples. */
+	static void checkStream(Audio::SeekableAudioStream *stream, const int16 *comp, int samples) {
+		int16 *buffer = new int16[samples + 16];
+		int read = 0;
+		while (!stream->endOfData() && read < samples + 16) {
+			const int n = stream->readBuffer(buffer + read, MIN(1000, samples + 16 - read));
+			if (n <= 0)
+				break;
+			read += n;
+		}
+
+		TS_ASSERT_EQUALS(read, samples);
+		TS_ASSERT(stream->endOfData());
+		TS_ASSERT_EQUALS(memcmp(buffer, comp, samples * 2), 0);
+		delete[] buffer;
+	}
+
+public:
+	void test_get() {
+		Audio::DecodeCache cache;
+		TS_ASSERT(!cache.get("speech.ogg"));
+		TS_ASSERT_EQUALS(cache.getMisses(), 1U);
+
+		int16 *comp;
+		Audio::SeekableAudioStream *added = cache.add("speech.ogg", createSineStream<int16>(11025, 2, &comp, false, true));
+		TS_ASSERT_EQUALS(cache.getCount(), 1U);
+		TS_ASSERT_EQUALS(cache.getSize(), 11025U * 2 * 2 * 2);
+		TS_ASSERT_EQUALS(added->getLength().totalNumberOfFrames(), 11025 * 2);
+		TS_ASSERT(added->isStereo());
+		TS_ASSERT_EQUALS(added->getRate(), 11025);
+		checkStream(added, comp, 11025 * 2 * 2);
+
+		// Keys are case insensitive
+		Audio::SeekableAudioStream *stream = cache.get("SPEECH.OGG");
+		TS_ASSERT(stream);
+		TS_ASSERT_EQUALS(cache.getHits(), 1U);
+		checkStream(stream, comp, 11025 * 2 * 2);
+
+		// Streams keep playing after their clip was dropped
+		stream->rewind();
+		cache.remove("speech.ogg");
+		TS_ASSERT_EQUALS(cache.getCount(), 0U);
+		TS_ASSERT_EQUALS(cache.getSize(), 0U);
+		checkStream(stream, comp, 11025 * 2 * 2);
+
+		// Each stream has its own position
+		TS_ASSERT(added->seek(1000));
+		TS_ASSERT(stream->seek(Audio::Timestamp(0, 16538, 11025)));
+		checkStream(added, comp + 11025 * 2, 11025 * 2);
+		checkStream(stream, comp + 16538 * 2, (22050 - 16538) * 2);
+		TS_ASSERT(!stream->seek(2001));
+
+		delete stream;
+		delete added;
+		delete[] comp;
+
+		cache.resetStatistics();
+		TS_ASSERT_EQUALS(cache.getHits(), 0U);
+		TS_ASSERT_EQUALS(cache.getMisses(), 0U);
+	}
+
+	void test_long_clip() {
+		Audio::DecodeCache cache(1024 * 1024, 10000);
+
+		// Clips which are too long are handed back undecoded
+		int16 *comp;
+		Audio::SeekableAudioStream *original = createSineStream<int16>(22050, 1, &comp, true, false);
+		Audio::SeekableAudioStream *stream = cache.add("music.ogg", original);
+		TS_ASSERT_EQUALS(stream, original);
+		TS_ASSERT_EQUALS(cache.getCount(), 0U);
+		checkStream(stream, comp, 22050);
+
+		delete stream;
+		delete[] comp;
+	}
+
+	void test_eviction() {
+		// Room for two clips of 8820 bytes
+		Audio::DecodeCache cache(20000);
+		const char *names[] = { "a.wav", "b.wav", "c.wav" };
+
+		for (int i = 0; i < 2; ++i)
+			delete cache.add(names[i], createSineStream<int16>(4410, 1, 0, true, false));
+		TS_ASSERT_EQUALS(cache.getCount(), 2U);
+
+		// Use a.wav, so b.wav is dropped first
+		delete cache.get("a.wav");
+		delete cache.add(names[2], createSineStream<int16>(4410, 1, 0, true, false));
+		TS_ASSERT_EQUALS(cache.getCount(), 2U);
+		TS_ASSERT_EQUALS(cache.getEvictions(), 1U);
+		TS_ASSERT_EQUALS(cache.getSize(), 4410U * 2 * 2);
+
+		Audio::SeekableAudioStream *stream = cache.get("b.wav");
+		TS_ASSERT(!stream);
+		stream = cache.get("a.wav");
+		TS_ASSERT(stream);
+		delete stream;
+		stream = cache.get("c.wav");
+		TS_ASSERT(stream);
+		delete stream;
+
+		cache.setMaxSize(10000);
+		TS_ASSERT_EQUALS(cache.getCount(), 1U);
+		TS_ASSERT_EQUALS(cache.getEvictions(), 2U);
+
+		// Clips bigger than the budget are played, but not cached
+		cache.setMaxSize(1000);
+		TS_ASSERT_EQUALS(cache.getCount(), 0U);
+		stream = cache.add("d.wav", createSineStream<int16>(4410, 1, 0, true, false));
+		TS_ASSERT(stream);
+		TS_ASSERT_EQUALS(stream->getLength().totalNumberOfFrames(), 4410);
+		TS_ASSERT_EQUALS(cache.getCount(), 0U);
+		delete stream;
+	}
+};
@@ -0,0 +1,115 @@
+#include <cxxtest/TestSuite.h>
+
+#include "audio/softsynth/emumidi.h"
+#include "common/atomic.h"
+
+#include "../common/testsystem.h"
+
+class EmulatedMidiTestSuite : public CxxTest::TestSuite
+{
+	/**
+	 * A silent synth which records the sample each message was played at.
+	 * One of its timer callbacks sends a message itself, and then waits
+	 * until the test sent one from its own thread.
+	 */
+	class TestDriver : public MidiDriver_Emulated {
+	public:
+		enum {
+			kMaxPlayed = 16
+		};
+
+		TestDriver(uint blockingTick) : MidiDriver_Emulated(0), _rendered(0), _ticks(0),
+			_blockingTick(blockingTick), callbackPos(0), inCallback(0), sent(0), playedCount(0) {}
+
+		~TestDriver() { close(); }
+
+		int open() { return MidiDriver_Emulated::open(); }
+		void close() { setRenderAhead(0); _isOpen = false; }
+		void send(uint32 b) {
+			if (!queueEvent(b))
+				processEvent(b);
+		}
+
+		MidiChannel *allocateChannel() { return 0; }
+		MidiChannel *getPercussionChannel() { return 0; }
+
+		bool isStereo() const { return false; }
+		int getRate() const { return 22050; }
+
+		/** The sample at which the blocking timer callback ran */
+		uint32 callbackPos;
+		/** Set while the blocking timer callback waits for sent */
+		volatile uint32 inCallback;
+		volatile uint32 sent;
+
+		uint32 playedMsg[kMaxPlayed];
+		uint32 playedPos[kMaxPlayed];
+		volatile uint32 playedCount;
+
+	protected:
+		bool supportsRenderAhead() const { return true; }
+
+		void generateSamples(int16 *buf, int len) {
+			memset(buf, 0, len * sizeof(int16));
+			_rendered += len;
+		}
+
+		void processEvent(uint32 b) {
+			if (playedCount < kMaxPlayed) {
+				playedMsg[playedCount] = b;
+				playedPos[playedCount] = _rendered;
+				Common::atomicStore(playedCount, playedCount + 1);
+			}
+		}
+
+		void onTimer() {
+			if (++_ticks != _blockingTick)
+				return;
+
+			callbackPos = _rendered;
+			send(0x1090);
+
+			Common::atomicStore(inCallback, 1U);
+			while (!Common::atomicLoad(sent))
+				sched_yield();
+			Common::atomicStore(inCallback, 0U);
+		}
+
+	private:
+		uint32 _rendered;
+		uint _ticks;
+		const uint _blockingTick;
+	};
+
+public:
+#ifdef POSIX
+	void test_send_during_timer_callback() {
+		TestSystem testSystem;
+		TestDriver driver(3);
+		driver.open();
+
+		const uint32 frames = 22050 * 100 / 1000;
+		TS_ASSERT(driver.setRenderAhead(100));
+
+		// Send from this thread while the renderer is in the callback
+		while (!Common::atomicLoad(driver.inCallback))
+			sched_yield();
+		driver.send(0x2090);
+		Common::atomicStore(driver.sent, 1U);
+
+		int16 buffer[256];
+		for (uint32 read = 0; read < 2 * frames && Common::atomicLoad(driver.playedCount) < 2; read += ARRAYSIZE(buffer))
+			driver.readBuffer(buffer, ARRAYSIZE(buffer));
+
+		// The message of the callback plays where the renderer was, the
+		// other one the render ahead time after the start of the playback
+		TS_ASSERT_EQUALS(Common::atomicLoad(driver.playedCount), 2U);
+		TS_ASSERT_EQUALS(driver.playedMsg[0], 0x1090U);
+		TS_ASSERT_EQUALS(driver.playedPos[0], driver.callbackPos);
+		TS_ASSERT_EQUALS(driver.playedMsg[1], 0x2090U);
+		TS_ASSERT_EQUALS(driver.playedPos[1], frames);
+
+		driver.close();
+	}
+#endif
+};
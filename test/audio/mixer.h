@@ -0,0 +1,118 @@
+#include <cxxtest/TestSuite.h>
+
+#include "audio/audiostream.h"
+#include "audio/mixer_intern.h"
+#include "common/atomic.h"
+
+#include "../common/testsystem.h"
+
+class MixerTestSuite : public CxxTest::TestSuite
+{
+	/** An endless stream, which counts how many of its kind were deleted. */
+	class ConstantStream : public Audio::AudioStream {
+	public:
+		static volatile uint32 deleted;
+
+		~ConstantStream() {
+			uint32 count;
+			do {
+				count = deleted;
+			} while (!Common::atomicCompareAndSwap(deleted, count, count + 1));
+		}
+
+		int readBuffer(int16 *buffer, const int numSamples) {
+			for (int i = 0; i < numSamples; ++i)
+				buffer[i] = 1000;
+			return numSamples;
+		}
+
+		bool isStereo() const { return false; }
+		int getRate() const { return 22050; }
+		bool endOfData() const { return false; }
+	};
+
+#ifdef POSIX
+	struct MixThread {
+		Audio::MixerImpl *mixer;
+		volatile uint32 stop;
+		volatile uint32 callbacks;
+	};
+
+	static void *mixThread(void *arg) {
+		MixThread *state = (MixThread *)arg;
+		int16 buffer[512 * 2];
+		while (!Common::atomicLoad(state->stop)) {
+			state->mixer->mixCallback((byte *)buffer, sizeof(buffer));
+			Common::atomicStore(state->callbacks, state->callbacks + 1);
+		}
+		return 0;
+	}
+#endif
+
+public:
+	void test_mix() {
+		TestSystem testSystem;
+		Audio::MixerImpl *mixer = new Audio::MixerImpl(&testSystem, 22050);
+		mixer->setReady(true);
+		ConstantStream::deleted = 0;
+
+		Audio::SoundHandle handle;
+		static_cast<Audio::Mixer *>(mixer)->playStream(Audio::Mixer::kPlainSoundType, &handle, new ConstantStream());
+		TS_ASSERT(mixer->isSoundHandleActive(handle));
+
+		int16 buffer[64 * 2];
+		mixer->mixCallback((byte *)buffer, sizeof(buffer));
+		TS_ASSERT_DIFFERS(buffer[10], 0);
+		TS_ASSERT_EQUALS(buffer[10], buffer[11]);
+
+		mixer->stopHandle(handle);
+		TS_ASSERT(!mixer->isSoundHandleActive(handle));
+		TS_ASSERT_EQUALS(ConstantStream::deleted, 1U);
+
+		mixer->mixCallback((byte *)buffer, sizeof(buffer));
+		TS_ASSERT_EQUALS(buffer[10], 0);
+
+		delete mixer;
+	}
+
+#ifdef POSIX
+	void test_concurrent_commands() {
+		TestSystem testSystem;
+		Audio::MixerImpl *mixer = new Audio::MixerImpl(&testSystem, 22050);
+		mixer->setReady(true);
+		ConstantStream::deleted = 0;
+
+		MixThread state;
+		state.mixer = mixer;
+		state.stop = 0;
+		state.callbacks = 0;
+		pthread_t thread;
+		TS_ASSERT_EQUALS(pthread_create(&thread, 0, mixThread, &state), 0);
+		while (!Common::atomicLoad(state.callbacks))
+			sched_yield();
+
+		// Stopping sounds makes the engine thread process the commands
+		// itself, while the audio thread mixes
+		const uint32 kSounds = 2000;
+		for (uint32 i = 0; i < kSounds; ++i) {
+			Audio::SoundHandle handle;
+			static_cast<Audio::Mixer *>(mixer)->playStream(Audio::Mixer::kPlainSoundType, &handle, new ConstantStream(), i & 1);
+			if (i & 1)
+				mixer->stopHandle(handle);
+			if ((i & 7) == 7)
+				mixer->stopID(0);
+		}
+
+		mixer->stopAll();
+		TS_ASSERT(!mixer->hasActiveChannelOfType(Audio::Mixer::kPlainSoundType));
+		TS_ASSERT_EQUALS(Common::atomicLoad(ConstantStream::deleted), kSounds);
+
+		Common::atomicStore(state.stop, 1U);
+		pthread_join(thread, 0);
+
+		delete mixer;
+	}
+#endif
+};
+
+volatile uint32 MixerTestSuite::ConstantStream::deleted = 0;
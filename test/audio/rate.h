@@ -0,0 +1,262 @@
+#include <cxxtest/TestSuite.h>
+
+#include "audio/audiostream.h"
+#include "audio/mixer.h"
+#include "audio/rate.h"
+#include "audio/rate_mix.h"
+
+#include "helper.h"
+
+class RateTestSuite : public CxxTest::TestSuite
+{
+private:
+	enum {
+		kTestSamples = 1027 * 2
+	};
+
+	uint32 _seed;
+
+	int16 nextSample() {
+		// Plain LCG, we just need reproducible noise including both extremes
+		_seed = _seed * 1103515245 + 12345;
+		switch ((_seed >> 8) & 15) {
+		case 0:
+			return 32767;
+		case 1:
+			return -32768;
+		default:
+			return (int16)(_seed >> 16);
+		}
+	}
+
+	void fillNoise(int16 *buf, int len) {
+		for (int i = 0; i < len; ++i)
+			buf[i] = nextSample();
+	}
+
+	void testKernel(Audio::MixKernel kernel) {
+		Audio::MixStereoProc refStereo, stereo;
+		Audio::MixMonoProc refMono, mono;
+
+		TS_ASSERT(Audio::getMixKernelProcs(Audio::kMixKernelScalar, refStereo, refMono));
+		if (!Audio::getMixKernelProcs(kernel, stereo, mono))
+			return;
+
+		static const Audio::st_volume_t volumes[][2] = {
+			{ 0, 0 }, { 256, 256 }, { 255, 1 }, { 1, 255 }, { 128, 200 }, { 256, 0 }
+		};
+
+		int16 *input = new int16[kTestSamples];
+		int16 *expected = new int16[kTestSamples * 2];
+		int16 *result = new int16[kTestSamples * 2];
+
+		for (int v = 0; v < ARRAYSIZE(volumes); ++v) {
+			const Audio::st_volume_t volL = volumes[v][0], volR = volumes[v][1];
+
+			// Also check odd lengths and offsets to exercise the scalar tails
+			for (int len = kTestSamples - 3; len <= kTestSamples; ++len) {
+				for (int reverse = 0; reverse < 2; ++reverse) {
+					fillNoise(input, len);
+					fillNoise(expected, len);
+					memcpy(result, expected, len * sizeof(int16));
+
+					refStereo(expected, input, len / 2, volL, volR, reverse != 0);
+					stereo(result, input, len / 2, volL, volR, reverse != 0);
+					TS_ASSERT_EQUALS(memcmp(expected, result, len * sizeof(int16)), 0);
+				}
+
+				fillNoise(input, len);
+				fillNoise(expected, len * 2);
+				memcpy(result, expected, len * 2 * sizeof(int16));
+
+				refMono(expected, input + 1, len - 1, volL, volR);
+				mono(result, input + 1, len - 1, volL, volR);
+				TS_ASSERT_EQUALS(memcmp(expected, result, len * 2 * sizeof(int16)), 0);
+			}
+		}
+
+		delete[] input;
+		delete[] expected;
+		delete[] result;
+
+		Audio::DotProductProc refDot, dot;
+		TS_ASSERT(Audio::getMixKernelDotProduct(Audio::kMixKernelScalar, refDot));
+		TS_ASSERT(Audio::getMixKernelDotProduct(kernel, dot));
+
+		int16 samples[128], coefs[128];
+		for (int count = 16; count <= 128; count += 16) {
+			fillNoise(samples, count);
+			fillNoise(coefs, count);
+			// Keep the sum within 32 bits, like the sinc converter does
+			for (int i = 0; i < count; ++i)
+				coefs[i] >>= 6;
+			TS_ASSERT_EQUALS(dot(samples, coefs, count), refDot(samples, coefs, count));
+		}
+	}
+
+	/** Make a mono stream of a sine tone. */
+	static Audio::SeekableAudioStream *createToneStream(int rate, int frequency, int samples, int amplitude) {
+		byte *data = (byte *)malloc(samples * 2);
+		for (int i = 0; i < samples; ++i)
+			WRITE_LE_UINT16(data + i * 2, (int16)(sin(2 * M_PI * frequency * i / rate) * amplitude));
+		return Audio::makeRawStream(new Common::MemoryReadStream(data, samples * 2, DisposeAfterUse::YES), rate,
+		                            Audio::FLAG_16BITS | Audio::FLAG_LITTLE_ENDIAN);
+	}
+
+	/** Return the magnitude of one frequency in the left channel of a buffer. */
+	static double getMagnitude(const int16 *buffer, int start, int end, int rate, int frequency) {
+		double re = 0, im = 0;
+		for (int i = start; i < end; ++i) {
+			re += buffer[i * 2] * cos(2 * M_PI * frequency * i / rate);
+			im += buffer[i * 2] * sin(2 * M_PI * frequency * i / rate);
+		}
+		return sqrt(re * re + im * im) / (end - start);
+	}
+
+	/**
+	 * Upsample a tone and return the magnitude of its image above the
+	 * Nyquist frequency of the input, relative to the tone itself.
+	 */
+	static double getImageLevel(Audio::RateConverterQuality quality) {
+		const int inRate = 22050, outRate = 44100, tone = 7000;
+		Audio::SeekableAudioStream *s = createToneStream(inRate, tone, inRate, 16000);
+		Audio::RateConverter *converter = Audio::makeRateConverter(inRate, outRate, false, false, quality);
+
+		int16 *result = new int16[outRate * 2];
+		memset(result, 0, outRate * 2 * sizeof(int16));
+		const int pairs = converter->flow(*s, result, outRate, Audio::Mixer::kMaxMixerVolume, Audio::Mixer::kMaxMixerVolume);
+		TS_ASSERT_LESS_THAN(outRate - 100, pairs);
+
+		// Leave out the start and the end, where the filter sees silence
+		const double image = getMagnitude(result, 1000, pairs - 1000, outRate, inRate - tone);
+		const double signal = getMagnitude(result, 1000, pairs - 1000, outRate, tone);
+
+		delete converter;
+		delete s;
+		delete[] result;
+		return image / signal;
+	}
+
+	void testSincConstant(int inRate, int outRate, bool isStereo) {
+		const int inSamples = 4000 * (isStereo ? 2 : 1);
+		byte *data = (byte *)malloc(inSamples * 2);
+		for (int i = 0; i < inSamples; ++i)
+			WRITE_LE_UINT16(data + i * 2, (uint16)(isStereo && (i & 1) ? -20000 : 12345));
+		Audio::SeekableAudioStream *s = Audio::makeRawStream(new Common::MemoryReadStream(data, inSamples * 2, DisposeAfterUse::YES), inRate,
+		                                                     Audio::FLAG_16BITS | Audio::FLAG_LITTLE_ENDIAN | (isStereo ? Audio::FLAG_STEREO : 0));
+		Audio::RateConverter *converter = Audio::makeRateConverter(inRate, outRate, isStereo, false, Audio::kRateConverterSinc);
+
+		const int pairs = 4000 * outRate / inRate;
+		int16 *result = new int16[pairs * 2];
+		memset(result, 0, pairs * 2 * sizeof(int16));
+
+		// Use several calls, to check that the state carries over
+		int done = 0;
+		for (int step = 1; done < pairs; step = step * 3 + 1) {
+			const int n = converter->flow(*s, result + done * 2, MIN(step, pairs - done), Audio::Mixer::kMaxMixerVolume, Audio::Mixer::kMaxMixerVolume);
+			if (n <= 0)
+				break;
+			done += n;
+		}
+		TS_ASSERT_LESS_THAN(pairs - pairs / 50, done);
+
+		// A constant input is passed through unchanged once the filter is
+		// past the silence before it
+		for (int i = 100; i < done - 100; ++i) {
+			TS_ASSERT_EQUALS(result[i * 2], 12345);
+			TS_ASSERT_EQUALS(result[i * 2 + 1], isStereo ? -20000 : 12345);
+		}
+
+		delete converter;
+		delete s;
+		delete[] result;
+	}
+
+	void testCopyConverter(bool isStereo, bool reverseStereo) {
+		const int sampleRate = 22050;
+		int16 *sine;
+		Audio::SeekableAudioStream *s = createSineStream<int16>(sampleRate, 1, &sine, false, isStereo);
+		Audio::RateConverter *converter = Audio::makeRateConverter(sampleRate, sampleRate, isStereo, reverseStereo);
+
+		const Audio::st_volume_t volL = 200, volR = 100;
+		const int pairs = sampleRate;
+
+		int16 *expected = new int16[pairs * 2];
+		int16 *result = new int16[pairs * 2];
+		fillNoise(expected, pairs * 2);
+		memcpy(result, expected, pairs * 2 * sizeof(int16));
+
+		for (int i = 0; i < pairs; ++i) {
+			const int16 out0 = sine[isStereo ? i * 2 : i];
+			const int16 out1 = isStereo ? sine[i * 2 + 1] : out0;
+			Audio::clampedAdd(expected[i * 2 + (reverseStereo ? 1 : 0)], (out0 * (int)volL) / Audio::Mixer::kMaxMixerVolume);
+			Audio::clampedAdd(expected[i * 2 + (reverseStereo ? 0 : 1)], (out1 * (int)volR) / Audio::Mixer::kMaxMixerVolume);
+		}
+
+		TS_ASSERT_EQUALS(converter->flow(*s, result, pairs, volL, volR), pairs);
+		TS_ASSERT_EQUALS(memcmp(expected, result, pairs * 2 * sizeof(int16)), 0);
+
+		delete converter;
+		delete s;
+		delete[] sine;
+		delete[] expected;
+		delete[] result;
+	}
+
+public:
+	void setUp() {
+		_seed = 0x1234567;
+	}
+
+	void test_mix_kernel_sse2() {
+		testKernel(Audio::kMixKernelSSE2);
+	}
+
+	void test_mix_kernel_avx2() {
+		testKernel(Audio::kMixKernelAVX2);
+	}
+
+	void test_mix_kernel_neon() {
+		testKernel(Audio::kMixKernelNEON);
+	}
+
+	void test_active_kernel_supported() {
+		Audio::MixStereoProc stereo;
+		Audio::MixMonoProc mono;
+		TS_ASSERT(Audio::getMixKernelProcs(Audio::getActiveMixKernel(), stereo, mono));
+	}
+
+	void test_sinc_constant_upsampling() {
+		testSincConstant(11025, 44100, false);
+		testSincConstant(22050, 48000, true);
+	}
+
+	void test_sinc_constant_downsampling() {
+		testSincConstant(48000, 22050, false);
+		testSincConstant(44100, 11025, true);
+	}
+
+	void test_sinc_odd_ratio() {
+		// More phases than are tabulated
+		testSincConstant(11127, 44100, false);
+	}
+
+	void test_sinc_aliasing() {
+		// The image of the tone is well attenuated, unlike with linear
+		// interpolation
+		TS_ASSERT_LESS_THAN(getImageLevel(Audio::kRateConverterSinc), 0.01);
+		TS_ASSERT_LESS_THAN(0.1, getImageLevel(Audio::kRateConverterLinear));
+	}
+
+	void test_copy_converter_mono() {
+		testCopyConverter(false, false);
+	}
+
+	void test_copy_converter_stereo() {
+		testCopyConverter(true, false);
+	}
+
+	void test_copy_converter_stereo_reversed() {
+		testCopyConverter(true, true);
+	}
+};
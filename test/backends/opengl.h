@@ -0,0 +1,177 @@
+#include <cxxtest/TestSuite.h>
+
+#include "backends/graphics/opengl/opengl-graphics.h"
+#include "backends/graphics/opengl/opengl-sys.h"
+#include "graphics/surface.h"
+#include "graphics/yuv_to_rgb.h"
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include "../common/testsystem.h"
+
+/**
+ * Renders with the OpenGL graphics manager into an offscreen EGL surface,
+ * which Mesa provides without a display, using llvmpipe when there is no GPU.
+ */
+class OpenGLTestSuite : public CxxTest::TestSuite
+{
+	enum {
+		kWidth = 64,
+		kHeight = 48
+	};
+
+	class EGLGraphicsManager : public OpenGL::OpenGLGraphicsManager {
+	public:
+		EGLGraphicsManager() : _display(EGL_NO_DISPLAY), _surface(EGL_NO_SURFACE), _context(EGL_NO_CONTEXT) {}
+
+		~EGLGraphicsManager() {
+			if (_context == EGL_NO_CONTEXT)
+				return;
+
+			notifyContextDestroy();
+			eglMakeCurrent(_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+			eglDestroyContext(_display, _context);
+			eglDestroySurface(_display, _surface);
+			eglTerminate(_display);
+		}
+
+		bool createContext() {
+			PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+			if (!getPlatformDisplay)
+				return false;
+
+			_display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, 0);
+			if (_display == EGL_NO_DISPLAY || !eglInitialize(_display, 0, 0))
+				return false;
+
+			static const EGLint configAttribs[] = {
+				EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+				EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_ALPHA_SIZE, 8,
+				EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+				EGL_NONE
+			};
+			static const EGLint surfaceAttribs[] = {
+				EGL_WIDTH, kWidth, EGL_HEIGHT, kHeight,
+				EGL_NONE
+			};
+
+			EGLConfig config;
+			EGLint configCount;
+			if (!eglChooseConfig(_display, configAttribs, &config, 1, &configCount) || !configCount)
+				return false;
+
+			_surface = eglCreatePbufferSurface(_display, config, surfaceAttribs);
+			if (_surface == EGL_NO_SURFACE || !eglBindAPI(EGL_OPENGL_API))
+				return false;
+
+			_context = eglCreateContext(_display, config, EGL_NO_CONTEXT, 0);
+			if (_context == EGL_NO_CONTEXT || !eglMakeCurrent(_display, _surface, _surface, _context))
+				return false;
+
+			setContextType(OpenGL::kContextGL);
+			return true;
+		}
+
+		/** Read the drawn RGBA pixels, top row first */
+		void readPixels(byte *dst) {
+			for (int y = 0; y < kHeight; ++y)
+				OpenGL::g_context.glReadPixels(0, kHeight - 1 - y, kWidth, 1, GL_RGBA, GL_UNSIGNED_BYTE, dst + y * kWidth * 4);
+		}
+
+#ifdef USE_RGB_COLOR
+		Common::List<Graphics::PixelFormat> getSupportedFormats() const {
+			return Common::List<Graphics::PixelFormat>();
+		}
+#endif
+
+	protected:
+		void setInternalMousePosition(int x, int y) {}
+
+		void *getProcAddress(const char *name) const {
+			__eglMustCastToProperFunctionPointerType proc = eglGetProcAddress(name);
+			void *address;
+			memcpy(&address, &proc, sizeof(address));
+			return address;
+		}
+
+	private:
+		bool loadVideoMode(uint requestedWidth, uint requestedHeight, const Graphics::PixelFormat &format) {
+			const Graphics::PixelFormat rgba8888(4, 8, 8, 8, 8, 24, 16, 8, 0);
+			notifyContextCreate(rgba8888, rgba8888);
+			setActualScreenSize(kWidth, kHeight);
+			return true;
+		}
+
+		void refreshScreen() {}
+
+		EGLDisplay _display;
+		EGLSurface _surface;
+		EGLContext _context;
+	};
+
+public:
+	void test_yuv_frame() {
+		TestSystem testSystem;
+		EGLGraphicsManager graphics;
+		if (!graphics.createContext()) {
+			TS_WARN("No EGL context, skipping");
+			return;
+		}
+
+		graphics.beginGFXTransaction();
+		graphics.initSize(kWidth, kHeight, 0);
+		TS_ASSERT_EQUALS(graphics.endGFXTransaction(), (int)OSystem::kTransactionSuccess);
+		if (!graphics.hasFeature(OSystem::kFeatureYUVFrames)) {
+			TS_WARN("No YUV textures, skipping");
+			return;
+		}
+
+		byte yPlane[kWidth * kHeight], uPlane[kWidth * kHeight / 4], vPlane[kWidth * kHeight / 4];
+		for (int y = 0; y < kHeight; ++y)
+			for (int x = 0; x < kWidth; ++x)
+				yPlane[y * kWidth + x] = 16 + x * 3 + y;
+		for (int y = 0; y < kHeight / 2; ++y) {
+			for (int x = 0; x < kWidth / 2; ++x) {
+				uPlane[y * kWidth / 2 + x] = 16 + x * 7;
+				vPlane[y * kWidth / 2 + x] = 240 - y * 9;
+			}
+		}
+
+		Graphics::YUV420Frame frame;
+		frame.y = yPlane;
+		frame.u = uPlane;
+		frame.v = vPlane;
+		frame.width = kWidth;
+		frame.height = kHeight;
+		frame.yPitch = kWidth;
+		frame.uvPitch = kWidth / 2;
+		frame.scale = Graphics::YUVToRGBManager::kScaleITU;
+
+		graphics.copyYUVFrameToScreen(frame, 0, 0);
+		graphics.updateScreen();
+
+		byte pixels[kWidth * kHeight * 4];
+		graphics.readPixels(pixels);
+
+		// The shader converts like the software path, up to rounding
+		Graphics::Surface expected;
+		expected.create(kWidth, kHeight, Graphics::PixelFormat(4, 8, 8, 8, 8, 24, 16, 8, 0));
+		YUVToRGBMan.convert420(&expected, frame);
+
+		int maxDiff = 0;
+		for (int y = 0; y < kHeight; ++y) {
+			for (int x = 0; x < kWidth; ++x) {
+				uint8 r, g, b;
+				expected.format.colorToRGB(*(const uint32 *)expected.getBasePtr(x, y), r, g, b);
+				const byte *pixel = pixels + (y * kWidth + x) * 4;
+				maxDiff = MAX(maxDiff, ABS(pixel[0] - r));
+				maxDiff = MAX(maxDiff, ABS(pixel[1] - g));
+				maxDiff = MAX(maxDiff, ABS(pixel[2] - b));
+			}
+		}
+		TS_ASSERT_LESS_THAN_EQUALS(maxDiff, 4);
+
+		expected.free();
+	}
+};
@@ -0,0 +1,223 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/flat-hashmap.h"
+#include "common/hashmap.h"
+#include "common/hash-str.h"
+
+class FlatHashMapTestSuite : public CxxTest::TestSuite
+{
+	public:
+	void test_empty_clear() {
+		Common::FlatHashMap<int, int> container;
+		TS_ASSERT(container.empty());
+		container[0] = 17;
+		container[1] = 33;
+		TS_ASSERT(!container.empty());
+		container.clear();
+		TS_ASSERT(container.empty());
+
+		Common::FlatHashMap<Common::String, Common::String> container2;
+		TS_ASSERT(container2.empty());
+		container2["foo"] = "bar";
+		container2["quux"] = "blub";
+		TS_ASSERT(!container2.empty());
+		container2.clear();
+		TS_ASSERT(container2.empty());
+	}
+
+	void test_contains() {
+		Common::FlatHashMap<int, int> container;
+		container[0] = 17;
+		container[1] = 33;
+		TS_ASSERT(container.contains(0));
+		TS_ASSERT(container.contains(1));
+		TS_ASSERT(!container.contains(17));
+		TS_ASSERT(!container.contains(-1));
+
+		Common::FlatHashMap<Common::String, Common::String> container2;
+		container2["foo"] = "bar";
+		container2["quux"] = "blub";
+		TS_ASSERT(container2.contains("foo"));
+		TS_ASSERT(container2.contains("quux"));
+		TS_ASSERT(!container2.contains("bar"));
+		TS_ASSERT(!container2.contains("asdf"));
+	}
+
+	void test_add_remove() {
+		Common::FlatHashMap<int, int> container;
+		container[0] = 17;
+		container[1] = 33;
+		container[2] = 45;
+		container[3] = 12;
+		container[4] = 96;
+		TS_ASSERT(container.contains(1));
+		container.erase(1);
+		TS_ASSERT(!container.contains(1));
+		container[1] = 42;
+		TS_ASSERT(container.contains(1));
+		container.erase(0);
+		TS_ASSERT(!container.empty());
+		container.erase(1);
+		TS_ASSERT(!container.empty());
+		container.erase(2);
+		TS_ASSERT(!container.empty());
+		container.erase(3);
+		TS_ASSERT(!container.empty());
+		container.erase(4);
+		TS_ASSERT(container.empty());
+		container[1] = 33;
+		TS_ASSERT(container.contains(1));
+		TS_ASSERT(!container.empty());
+		container.erase(1);
+		TS_ASSERT(container.empty());
+	}
+
+	void test_lookup() {
+		Common::FlatHashMap<int, int> container;
+		container[0] = 17;
+		container[1] = -1;
+		container[2] = 45;
+		container[3] = 12;
+		container[4] = 96;
+
+		TS_ASSERT_EQUALS(container[0], 17);
+		TS_ASSERT_EQUALS(container[1], -1);
+		TS_ASSERT_EQUALS(container[2], 45);
+		TS_ASSERT_EQUALS(container[3], 12);
+		TS_ASSERT_EQUALS(container[4], 96);
+	}
+
+	void test_lookup_with_default() {
+		Common::FlatHashMap<int, int> container;
+		container[0] = 17;
+		container[1] = -1;
+		container[2] = 45;
+		container[3] = 12;
+		container[4] = 96;
+
+		// We take a const ref now to ensure that the map
+		// is not modified by getVal.
+		const Common::FlatHashMap<int, int> &containerRef = container;
+
+		TS_ASSERT_EQUALS(containerRef.getVal(0), 17);
+		TS_ASSERT_EQUALS(containerRef.getVal(17), 0);
+		TS_ASSERT_EQUALS(containerRef.getVal(0, -10), 17);
+		TS_ASSERT_EQUALS(containerRef.getVal(17, -10), -10);
+		TS_ASSERT_EQUALS(container.size(), 5u);
+	}
+
+	void test_iterator() {
+		Common::FlatHashMap<int, int> container;
+		container[0] = 17;
+		container[1] = 33;
+		container[2] = 45;
+		container[3] = 12;
+		container[4] = 96;
+
+		int sum = 0;
+		for (Common::FlatHashMap<int, int>::iterator i = container.begin(); i != container.end(); ++i) {
+			TS_ASSERT(i->_key >= 0 && i->_key < 5);
+			i->_value += 1;
+			sum += (*i)._value;
+		}
+		TS_ASSERT_EQUALS(sum, 17 + 33 + 45 + 12 + 96 + 5);
+
+		Common::FlatHashMap<int, int>::iterator found = container.find(2);
+		TS_ASSERT(found != container.end());
+		TS_ASSERT_EQUALS(found->_value, 46);
+		TS_ASSERT(container.find(5) == container.end());
+
+		const Common::FlatHashMap<int, int> &containerRef = container;
+		Common::FlatHashMap<int, int>::const_iterator cfound = containerRef.find(3);
+		TS_ASSERT(cfound != containerRef.end());
+		TS_ASSERT_EQUALS(cfound->_value, 13);
+
+		// Erasing the current element must not disturb the iteration
+		for (Common::FlatHashMap<int, int>::iterator i = container.begin(); i != container.end(); ++i) {
+			if (i->_key & 1)
+				container.erase(i);
+		}
+		TS_ASSERT_EQUALS(container.size(), 3u);
+		TS_ASSERT(!container.contains(1));
+		TS_ASSERT(!container.contains(3));
+	}
+
+	void test_copy() {
+		Common::FlatHashMap<Common::String, int> map1, container2;
+		map1["one"] = 1;
+		map1["two"] = 2;
+		map1["three"] = 3;
+		map1.erase("two");
+		container2 = map1;
+		Common::FlatHashMap<Common::String, int> container3(map1);
+		map1["four"] = 4;
+
+		TS_ASSERT_EQUALS(container2.size(), 2u);
+		TS_ASSERT_EQUALS(container3.size(), 2u);
+		TS_ASSERT_EQUALS(container2["one"], 1);
+		TS_ASSERT_EQUALS(container3["three"], 3);
+		TS_ASSERT(!container2.contains("two"));
+		TS_ASSERT(!container3.contains("four"));
+	}
+
+	void test_collisions() {
+		// Use a hash function which maps everything to the same value, so
+		// all keys share the same hash fragment and probe sequence.
+		Common::FlatHashMap<int, int, ConstantHash> container;
+		for (int i = 0; i < 100; ++i)
+			container[i] = i * 3;
+		for (int i = 0; i < 100; i += 2)
+			container.erase(i);
+
+		TS_ASSERT_EQUALS(container.size(), 50u);
+		for (int i = 0; i < 100; ++i) {
+			TS_ASSERT_EQUALS(container.contains(i), (i & 1) != 0);
+			TS_ASSERT_EQUALS(container.getVal(i, -1), (i & 1) ? i * 3 : -1);
+		}
+	}
+
+	void test_against_hashmap() {
+		// Mix insertions and deletions at random and compare the
+		// result with the regular HashMap. The key range is small enough
+		// that many slots end up being reused after an erase.
+		Common::HashMap<Common::String, int> reference;
+		Common::FlatHashMap<Common::String, int> container;
+		uint32 seed = 0x1234567;
+
+		for (int i = 0; i < 20000; ++i) {
+			seed = seed * 1103515245 + 12345;
+			const Common::String key = Common::String::format("key%u", (seed >> 8) % 1500);
+
+			if ((seed >> 28) < 6) {
+				reference.erase(key);
+				container.erase(key);
+			} else {
+				reference[key] = i;
+				container[key] = i;
+			}
+
+			TS_ASSERT_EQUALS(container.size(), reference.size());
+		}
+
+		for (Common::HashMap<Common::String, int>::const_iterator i = reference.begin(); i != reference.end(); ++i)
+			TS_ASSERT_EQUALS(container.getVal(i->_key, -1), i->_value);
+
+		uint count = 0;
+		for (Common::FlatHashMap<Common::String, int>::const_iterator i = container.begin(); i != container.end(); ++i) {
+			TS_ASSERT_EQUALS(reference.getVal(i->_key, -1), i->_value);
+			count++;
+		}
+		TS_ASSERT_EQUALS(count, reference.size());
+
+		container.clear(true);
+		TS_ASSERT(container.empty());
+		TS_ASSERT(container.begin() == container.end());
+		container["foo"] = 1;
+		TS_ASSERT_EQUALS(container.size(), 1u);
+	}
+
+	private:
+	struct ConstantHash {
+		uint operator()(int) const { return 42; }
+	};
+};
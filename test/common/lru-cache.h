@@ -0,0 +1,92 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/lru-cache.h"
+
+class LRUCacheTestSuite : public CxxTest::TestSuite
+{
+	struct IsOdd {
+		bool operator()(int key, int value) const { return key & 1; }
+	};
+
+public:
+	void test_get_put() {
+		Common::LRUCache<int, int> cache(100);
+		TS_ASSERT(!cache.get(1));
+		TS_ASSERT_EQUALS(cache.getMisses(), 1U);
+
+		TS_ASSERT(cache.put(1, 10, 40));
+		TS_ASSERT(cache.put(2, 20, 40));
+		TS_ASSERT_EQUALS(cache.getSize(), 80U);
+		TS_ASSERT_EQUALS(cache.getCount(), 2U);
+
+		int *value = cache.get(1);
+		TS_ASSERT(value);
+		TS_ASSERT_EQUALS(*value, 10);
+		TS_ASSERT_EQUALS(cache.getHits(), 1U);
+
+		// Replacing a value updates its size
+		TS_ASSERT(cache.put(1, 11, 30));
+		TS_ASSERT_EQUALS(*cache.get(1), 11);
+		TS_ASSERT_EQUALS(cache.getSize(), 70U);
+		TS_ASSERT_EQUALS(cache.getCount(), 2U);
+		TS_ASSERT_EQUALS(cache.getEvictions(), 0U);
+
+		// Values bigger than the budget are not kept
+		TS_ASSERT(!cache.put(3, 30, 101));
+		TS_ASSERT(!cache.get(3));
+		TS_ASSERT_EQUALS(cache.getCount(), 2U);
+
+		cache.remove(2);
+		TS_ASSERT(!cache.get(2));
+		TS_ASSERT_EQUALS(cache.getSize(), 30U);
+
+		cache.resetStatistics();
+		TS_ASSERT_EQUALS(cache.getHits(), 0U);
+		TS_ASSERT_EQUALS(cache.getMisses(), 0U);
+
+		cache.clear();
+		TS_ASSERT_EQUALS(cache.getCount(), 0U);
+		TS_ASSERT_EQUALS(cache.getSize(), 0U);
+	}
+
+	void test_eviction() {
+		Common::LRUCache<int, int> cache(100);
+		for (int i = 0; i < 4; ++i)
+			cache.put(i, i, 25);
+
+		// Using 0 and 1 leaves 2 as the least recently used value
+		cache.get(1);
+		cache.get(0);
+		cache.put(4, 4, 25);
+		TS_ASSERT_EQUALS(cache.getEvictions(), 1U);
+		TS_ASSERT(!cache.get(2));
+
+		// Making room for a big value drops several
+		cache.put(5, 5, 60);
+		TS_ASSERT_EQUALS(cache.getEvictions(), 4U);
+		TS_ASSERT(!cache.get(3));
+		TS_ASSERT(!cache.get(1));
+		TS_ASSERT(!cache.get(0));
+		TS_ASSERT(cache.get(4));
+		TS_ASSERT(cache.get(5));
+		TS_ASSERT_EQUALS(cache.getSize(), 85U);
+
+		cache.setMaxSize(70);
+		TS_ASSERT_EQUALS(cache.getEvictions(), 5U);
+		TS_ASSERT_EQUALS(cache.getCount(), 1U);
+		TS_ASSERT(cache.get(5));
+	}
+
+	void test_remove_if() {
+		Common::LRUCache<int, int> cache(1000);
+		for (int i = 0; i < 10; ++i)
+			cache.put(i, i, 10);
+
+		cache.removeIf(IsOdd());
+		TS_ASSERT_EQUALS(cache.getCount(), 5U);
+		TS_ASSERT_EQUALS(cache.getSize(), 50U);
+		TS_ASSERT_EQUALS(cache.getEvictions(), 0U);
+		for (int i = 0; i < 10; ++i)
+			TS_ASSERT_EQUALS(cache.get(i) != 0, !(i & 1));
+	}
+};
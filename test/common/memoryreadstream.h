@@ -104,4 +104,20 @@ class MemoryReadStreamTestSuite : public CxxTest::TestSuite {
 		ms.seek(0, SEEK_SET);
 		TS_ASSERT(!ms.eos());
 	}
+
+	void test_data_view() {
+		byte contents[] = { 1, 2, 3, 4, 5, 6, 7 };
+		Common::MemoryReadStream ms(contents, sizeof(contents));
+
+		ms.seek(3);
+		TS_ASSERT_EQUALS(ms.getDataView(0, 7), contents);
+		TS_ASSERT_EQUALS(ms.getDataView(2, 5), contents + 2);
+		TS_ASSERT_EQUALS(ms.getDataView(7, 0), contents + 7);
+		TS_ASSERT_EQUALS(ms.pos(), 3);
+
+		// Ranges reaching past the end
+		TS_ASSERT(!ms.getDataView(0, 8));
+		TS_ASSERT(!ms.getDataView(8, 0));
+		TS_ASSERT(!ms.getDataView(6, 0xFFFFFFFF));
+	}
 };
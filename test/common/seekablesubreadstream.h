@@ -70,4 +70,18 @@ class SeekableSubReadStreamTestSuite : public CxxTest::TestSuite {
 		b = ssrs.readByte();
 		TS_ASSERT_EQUALS(b, 1);
 	}
+
+	void test_data_view() {
+		byte contents[10] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+		Common::MemoryReadStream ms(contents, 10);
+
+		Common::SeekableSubReadStream ssrs(&ms, 1, 9);
+
+		TS_ASSERT_EQUALS(ssrs.getDataView(0, 8), contents + 1);
+		TS_ASSERT_EQUALS(ssrs.getDataView(3, 2), contents + 4);
+
+		// Ranges outside of the substream, even if inside the parent
+		TS_ASSERT(!ssrs.getDataView(0, 9));
+		TS_ASSERT(!ssrs.getDataView(8, 1));
+	}
 };
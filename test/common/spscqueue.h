@@ -0,0 +1,110 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/spscqueue.h"
+
+#ifdef POSIX
+#include <pthread.h>
+#endif
+
+class SPSCQueueTestSuite : public CxxTest::TestSuite
+{
+	typedef Common::SPSCQueue<uint32, 8> SmallQueue;
+
+#ifdef POSIX
+	enum {
+		kStressCount = 1000000
+	};
+
+	typedef Common::SPSCQueue<uint32, 64> StressQueue;
+
+	static void *producer(void *arg) {
+		StressQueue *queue = (StressQueue *)arg;
+		for (uint32 i = 1; i <= kStressCount; ) {
+			if (queue->push(i))
+				++i;
+		}
+		return 0;
+	}
+#endif
+
+public:
+	void test_empty() {
+		SmallQueue queue;
+		uint32 value = 42;
+
+		TS_ASSERT(queue.empty());
+		TS_ASSERT(!queue.pop(value));
+		TS_ASSERT_EQUALS(value, 42U);
+	}
+
+	void test_order() {
+		SmallQueue queue;
+		uint32 value;
+
+		TS_ASSERT(queue.push(1));
+		TS_ASSERT(queue.push(2));
+		TS_ASSERT(queue.push(3));
+		TS_ASSERT(!queue.empty());
+
+		TS_ASSERT(queue.pop(value));
+		TS_ASSERT_EQUALS(value, 1U);
+		TS_ASSERT(queue.pop(value));
+		TS_ASSERT_EQUALS(value, 2U);
+		TS_ASSERT(queue.pop(value));
+		TS_ASSERT_EQUALS(value, 3U);
+		TS_ASSERT(queue.empty());
+	}
+
+	void test_full() {
+		SmallQueue queue;
+		uint32 value;
+
+		for (uint32 i = 0; i < 7; ++i)
+			TS_ASSERT(queue.push(i));
+		TS_ASSERT(!queue.push(7));
+
+		TS_ASSERT(queue.pop(value));
+		TS_ASSERT_EQUALS(value, 0U);
+		TS_ASSERT(queue.push(7));
+		TS_ASSERT(!queue.push(8));
+	}
+
+	void test_wraparound() {
+		SmallQueue queue;
+		uint32 value;
+
+		for (uint32 i = 0; i < 100; ++i) {
+			TS_ASSERT(queue.push(i));
+			TS_ASSERT(queue.push(i + 1000));
+			TS_ASSERT(queue.pop(value));
+			TS_ASSERT_EQUALS(value, i);
+			TS_ASSERT(queue.pop(value));
+			TS_ASSERT_EQUALS(value, i + 1000);
+		}
+		TS_ASSERT(queue.empty());
+	}
+
+#ifdef POSIX
+	void test_threads() {
+		StressQueue queue;
+
+		pthread_t thread;
+		TS_ASSERT_EQUALS(pthread_create(&thread, 0, producer, &queue), 0);
+
+		// Everything has to arrive once, in order
+		uint32 expected = 1;
+		bool ok = true;
+		while (expected <= kStressCount) {
+			uint32 value;
+			if (queue.pop(value)) {
+				ok = ok && (value == expected);
+				++expected;
+			}
+		}
+		TS_ASSERT(ok);
+
+		pthread_join(thread, 0);
+		TS_ASSERT(queue.empty());
+	}
+#endif
+};
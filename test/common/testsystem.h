@@ -0,0 +1,192 @@
+#ifndef TEST_COMMON_TESTSYSTEM_H
+#define TEST_COMMON_TESTSYSTEM_H
+
+#include "common/system.h"
+#include "graphics/pixelformat.h"
+
+#ifdef POSIX
+#include <pthread.h>
+#endif
+
+/**
+ * An OSystem without graphics, events or sound, for tests of code which needs
+ * the time, mutexes or threads. It is installed as g_system while it exists.
+ *
+ * The time only passes when waiting with delayMillis(), which just yields the
+ * processor. Threads can be turned off, to test the code used on backends
+ * without them.
+ */
+class TestSystem : public OSystem {
+public:
+	explicit TestSystem(bool threads = true) : _previous(g_system), _millis(0), _threads(threads) {
+		g_system = this;
+	}
+
+	~TestSystem() {
+		g_system = _previous;
+	}
+
+	const GraphicsMode *getSupportedGraphicsModes() const {
+		static const GraphicsMode modes[] = { { 0, 0, 0 } };
+		return modes;
+	}
+	int getDefaultGraphicsMode() const { return 0; }
+	bool setGraphicsMode(int mode) { return mode == 0; }
+	int getGraphicsMode() const { return 0; }
+	Graphics::PixelFormat getScreenFormat() const { return Graphics::PixelFormat::createFormatCLUT8(); }
+	Common::List<Graphics::PixelFormat> getSupportedFormats() const { return Common::List<Graphics::PixelFormat>(); }
+	void initSize(uint width, uint height, const Graphics::PixelFormat *format) {}
+	int16 getHeight() { return 0; }
+	int16 getWidth() { return 0; }
+	PaletteManager *getPaletteManager() { return 0; }
+	void copyRectToScreen(const void *buf, int pitch, int x, int y, int w, int h) {}
+	Graphics::Surface *lockScreen() { return 0; }
+	void unlockScreen() {}
+	void fillScreen(uint32 col) {}
+	void updateScreen() {}
+	void setShakePos(int shakeOffset) {}
+	void showOverlay() {}
+	void hideOverlay() {}
+	Graphics::PixelFormat getOverlayFormat() const { return Graphics::PixelFormat::createFormatCLUT8(); }
+	void clearOverlay() {}
+	void grabOverlay(void *buf, int pitch) {}
+	void copyRectToOverlay(const void *buf, int pitch, int x, int y, int w, int h) {}
+	int16 getOverlayHeight() { return 0; }
+	int16 getOverlayWidth() { return 0; }
+	bool showMouse(bool visible) { return false; }
+	void warpMouse(int x, int y) {}
+	void setMouseCursor(const void *buf, uint w, uint h, int hotspotX, int hotspotY, uint32 keycolor, bool dontScale, const Graphics::PixelFormat *format) {}
+	void getTimeAndDate(TimeDate &t) const { memset(&t, 0, sizeof(t)); }
+	Audio::Mixer *getMixer() { return 0; }
+	void quit() {}
+	void displayMessageOnOSD(const char *msg) {}
+	void displayActivityIconOnOSD(const Graphics::Surface *icon) {}
+	void logMessage(LogMessageType::Type type, const char *message) {}
+
+	uint32 getMillis(bool skipRecord) { return _millis; }
+
+#ifdef POSIX
+	void delayMillis(uint msecs) {
+		_millis += msecs;
+		sched_yield();
+	}
+
+	MutexRef createMutex() {
+		pthread_mutexattr_t attributes;
+		pthread_mutexattr_init(&attributes);
+		pthread_mutexattr_settype(&attributes, PTHREAD_MUTEX_RECURSIVE);
+		pthread_mutex_t *mutex = new pthread_mutex_t;
+		pthread_mutex_init(mutex, &attributes);
+		pthread_mutexattr_destroy(&attributes);
+		return (MutexRef)mutex;
+	}
+
+	void lockMutex(MutexRef mutex) { pthread_mutex_lock((pthread_mutex_t *)mutex); }
+	void unlockMutex(MutexRef mutex) { pthread_mutex_unlock((pthread_mutex_t *)mutex); }
+
+	void deleteMutex(MutexRef mutex) {
+		pthread_mutex_destroy((pthread_mutex_t *)mutex);
+		delete (pthread_mutex_t *)mutex;
+	}
+
+	ThreadRef createThread(ThreadProc proc, void *param, const char *name) {
+		if (!_threads)
+			return 0;
+
+		Thread *thread = new Thread;
+		thread->proc = proc;
+		thread->param = param;
+		if (pthread_create(&thread->thread, 0, threadEntry, thread)) {
+			delete thread;
+			return 0;
+		}
+		return (ThreadRef)thread;
+	}
+
+	void joinThread(ThreadRef thread) {
+		pthread_join(((Thread *)thread)->thread, 0);
+		delete (Thread *)thread;
+	}
+
+	SemaphoreRef createSemaphore(uint value) {
+		Semaphore *semaphore = new Semaphore;
+		pthread_mutex_init(&semaphore->mutex, 0);
+		pthread_cond_init(&semaphore->cond, 0);
+		semaphore->count = value;
+		return (SemaphoreRef)semaphore;
+	}
+
+	bool waitSemaphore(SemaphoreRef semaphoreRef, int timeout) {
+		Semaphore *semaphore = (Semaphore *)semaphoreRef;
+
+		// Timeouts just yield a few times, as the time does not pass
+		for (int i = 0; timeout >= 0 && i <= timeout && !semaphore->count; ++i)
+			sched_yield();
+
+		pthread_mutex_lock(&semaphore->mutex);
+		while (timeout < 0 && !semaphore->count)
+			pthread_cond_wait(&semaphore->cond, &semaphore->mutex);
+		const bool acquired = (semaphore->count != 0);
+		if (acquired)
+			--semaphore->count;
+		pthread_mutex_unlock(&semaphore->mutex);
+		return acquired;
+	}
+
+	void postSemaphore(SemaphoreRef semaphoreRef) {
+		Semaphore *semaphore = (Semaphore *)semaphoreRef;
+		pthread_mutex_lock(&semaphore->mutex);
+		++semaphore->count;
+		pthread_cond_signal(&semaphore->cond);
+		pthread_mutex_unlock(&semaphore->mutex);
+	}
+
+	void deleteSemaphore(SemaphoreRef semaphoreRef) {
+		Semaphore *semaphore = (Semaphore *)semaphoreRef;
+		pthread_cond_destroy(&semaphore->cond);
+		pthread_mutex_destroy(&semaphore->mutex);
+		delete semaphore;
+	}
+
+	uint64 getCurrentThreadId() {
+		if (!_threads)
+			return 0;
+
+		// pthread_t is an integer or a pointer, depending on the system
+		return (uint64)(size_t)pthread_self();
+	}
+#else
+	void delayMillis(uint msecs) { _millis += msecs; }
+	MutexRef createMutex() { return 0; }
+	void lockMutex(MutexRef mutex) {}
+	void unlockMutex(MutexRef mutex) {}
+	void deleteMutex(MutexRef mutex) {}
+#endif
+
+private:
+#ifdef POSIX
+	struct Thread {
+		pthread_t thread;
+		ThreadProc proc;
+		void *param;
+	};
+
+	struct Semaphore {
+		pthread_mutex_t mutex;
+		pthread_cond_t cond;
+		volatile uint count;
+	};
+
+	static void *threadEntry(void *param) {
+		Thread *thread = (Thread *)param;
+		thread->proc(thread->param);
+		return 0;
+	}
+#endif
+
+	OSystem *const _previous;
+	volatile uint32 _millis;
+	const bool _threads;
+};
+
+#endif
@@ -0,0 +1,290 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/archive.h"
+#include "common/memstream.h"
+#include "common/unzip.h"
+#include "common/zlib.h"
+
+#ifdef USE_ZLIB
+
+class ZipTestSuite : public CxxTest::TestSuite
+{
+	enum {
+		kSmallSize = 3000,
+		kBigSize = 3 * 1024 * 1024
+	};
+
+	byte *_data;
+
+	/** Fill _data with something that compresses, but not too well. */
+	void makeData() {
+		uint32 seed = 0x2468ACE;
+		for (uint32 i = 0; i < kBigSize; ++i) {
+			seed = seed * 1103515245 + 12345;
+			_data[i] = "ScummVM "[(seed >> 16) & 7] + (i >> 18);
+		}
+	}
+
+	/**
+	 * Compress the given data with gzip. The caller has to free() the
+	 * result.
+	 */
+	static byte *gzip(const byte *data, uint32 size, uint32 &gzipSize) {
+		Common::MemoryWriteStreamDynamic *buffer = new Common::MemoryWriteStreamDynamic(DisposeAfterUse::NO);
+		Common::WriteStream *gzipStream = Common::wrapCompressedWriteStream(buffer);
+		gzipStream->write(data, size);
+		gzipStream->finalize();
+
+		byte *result = buffer->getData();
+		gzipSize = buffer->size();
+		delete gzipStream;
+		return result;
+	}
+
+	/**
+	 * Build a ZIP file with the given members, stored or deflated. The data
+	 * of each member is taken from the start of _data.
+	 */
+	byte *makeZip(int count, const char *const *names, const uint32 *sizes, const bool *deflate, uint32 &zipSize) {
+		Common::MemoryWriteStreamDynamic zip(DisposeAfterUse::NO);
+		Common::MemoryWriteStreamDynamic centralDir(DisposeAfterUse::YES);
+
+		for (int i = 0; i < count; ++i) {
+			uint32 gzipSize;
+			byte *gzipData = gzip(_data, sizes[i], gzipSize);
+
+			// The gzip trailer has the CRC, and a header of 10 bytes
+			// comes before the deflate data.
+			const uint32 crc = READ_LE_UINT32(gzipData + gzipSize - 8);
+			const byte *data = deflate[i] ? gzipData + 10 : _data;
+			const uint32 dataSize = deflate[i] ? gzipSize - 18 : sizes[i];
+			const uint32 nameLength = strlen(names[i]);
+			const uint32 offset = zip.pos();
+
+			zip.writeUint32LE(0x04034B50);
+			zip.writeUint16LE(20);
+			zip.writeUint16LE(0);
+			zip.writeUint16LE(deflate[i] ? 8 : 0);
+			zip.writeUint32LE(0);
+			zip.writeUint32LE(crc);
+			zip.writeUint32LE(dataSize);
+			zip.writeUint32LE(sizes[i]);
+			zip.writeUint16LE(nameLength);
+			zip.writeUint16LE(0);
+			zip.write(names[i], nameLength);
+			zip.write(data, dataSize);
+
+			centralDir.writeUint32LE(0x02014B50);
+			centralDir.writeUint16LE(20);
+			centralDir.writeUint16LE(20);
+			centralDir.writeUint16LE(0);
+			centralDir.writeUint16LE(deflate[i] ? 8 : 0);
+			centralDir.writeUint32LE(0);
+			centralDir.writeUint32LE(crc);
+			centralDir.writeUint32LE(dataSize);
+			centralDir.writeUint32LE(sizes[i]);
+			centralDir.writeUint16LE(nameLength);
+			centralDir.writeUint16LE(0);
+			centralDir.writeUint16LE(0);
+			centralDir.writeUint16LE(0);
+			centralDir.writeUint16LE(0);
+			centralDir.writeUint32LE(0);
+			centralDir.writeUint32LE(offset);
+			centralDir.write(names[i], nameLength);
+
+			free(gzipData);
+		}
+
+		const uint32 centralDirOffset = zip.pos();
+		zip.write(centralDir.getData(), centralDir.size());
+
+		zip.writeUint32LE(0x06054B50);
+		zip.writeUint16LE(0);
+		zip.writeUint16LE(0);
+		zip.writeUint16LE(count);
+		zip.writeUint16LE(count);
+		zip.writeUint32LE(centralDir.size());
+		zip.writeUint32LE(centralDirOffset);
+		zip.writeUint16LE(0);
+
+		zipSize = zip.size();
+		return zip.getData();
+	}
+
+	/** A ZIP file in memory, which counts how often it is opened. */
+	class ZipFile : public Common::ArchiveMember {
+		byte *_data;
+		uint32 _size;
+
+	public:
+		mutable int opened;
+
+		ZipFile(byte *data, uint32 size) : _data(data), _size(size), opened(0) {}
+		~ZipFile() { free(_data); }
+
+		Common::SeekableReadStream *createReadStream() const {
+			++opened;
+			return new Common::MemoryReadStream(_data, _size);
+		}
+
+		Common::String getName() const { return "test.zip"; }
+	};
+
+	ZipFile *makeZipFile() {
+		static const char *const names[] = { "small.txt", "small.bin", "big.txt", "big.bin" };
+		static const uint32 sizes[] = { kSmallSize, kSmallSize, kBigSize, kBigSize };
+		static const bool deflate[] = { true, false, true, false };
+
+		uint32 zipSize;
+		byte *zip = makeZip(ARRAYSIZE(names), names, sizes, deflate, zipSize);
+		return new ZipFile(zip, zipSize);
+	}
+
+	Common::Archive *makeArchive(uint32 cacheSize) {
+		return Common::makeZipArchive(Common::ArchiveMemberPtr(makeZipFile()), cacheSize);
+	}
+
+	bool checkContents(Common::SeekableReadStream *stream, uint32 pos, uint32 size) {
+		byte buffer[1000];
+		assert(size <= sizeof(buffer));
+
+		stream->seek(pos);
+		return stream->read(buffer, size) == size && !memcmp(buffer, _data + pos, size);
+	}
+
+public:
+	void setUp() {
+		_data = new byte[kBigSize];
+		makeData();
+	}
+
+	void tearDown() {
+		delete[] _data;
+	}
+
+	void test_members() {
+		Common::Archive *archive = makeArchive(Common::kZipDefaultCacheSize);
+		TS_ASSERT(archive);
+
+		Common::ArchiveMemberList list;
+		TS_ASSERT_EQUALS(archive->listMembers(list), 4);
+		TS_ASSERT(archive->hasFile("BIG.TXT"));
+		TS_ASSERT(!archive->hasFile("big"));
+
+		static const char *const names[] = { "small.txt", "small.bin", "big.txt", "big.bin" };
+		for (int i = 0; i < ARRAYSIZE(names); ++i) {
+			Common::SeekableReadStream *stream = archive->createReadStreamForMember(names[i]);
+			TS_ASSERT(stream);
+
+			const int32 size = (i < 2) ? kSmallSize : kBigSize;
+			TS_ASSERT_EQUALS(stream->size(), size);
+			TS_ASSERT(checkContents(stream, 0, 1000));
+			TS_ASSERT(checkContents(stream, size - 1000, 1000));
+
+			delete stream;
+		}
+
+		delete archive;
+	}
+
+	void test_cache() {
+		Common::Archive *archive = makeArchive(kSmallSize);
+
+		// Opening a cached member again gives the same data
+		Common::SeekableReadStream *first = archive->createReadStreamForMember("small.txt");
+		Common::SeekableReadStream *second = archive->createReadStreamForMember("small.txt");
+		TS_ASSERT(first->getDataView(0, kSmallSize));
+		TS_ASSERT_EQUALS(first->getDataView(0, kSmallSize), second->getDataView(0, kSmallSize));
+		delete second;
+
+		// Another member pushes it out of the cache, but the first stream
+		// keeps its data
+		Common::SeekableReadStream *other = archive->createReadStreamForMember("small.bin");
+		second = archive->createReadStreamForMember("small.txt");
+		TS_ASSERT_DIFFERS(first->getDataView(0, kSmallSize), second->getDataView(0, kSmallSize));
+		TS_ASSERT(checkContents(first, 0, 1000));
+		TS_ASSERT(checkContents(second, 0, 1000));
+
+		delete other;
+		delete second;
+		delete first;
+		delete archive;
+	}
+
+	void test_no_cache() {
+		Common::Archive *archive = makeArchive(0);
+
+		Common::SeekableReadStream *first = archive->createReadStreamForMember("small.txt");
+		Common::SeekableReadStream *second = archive->createReadStreamForMember("small.txt");
+		TS_ASSERT_DIFFERS(first->getDataView(0, kSmallSize), second->getDataView(0, kSmallSize));
+		TS_ASSERT(checkContents(second, 0, 1000));
+
+		delete second;
+		delete first;
+		delete archive;
+	}
+
+	void test_stream_threshold() {
+		ZipFile *file = makeZipFile();
+		Common::ArchiveMemberPtr member(file);
+		Common::Archive *archive = Common::makeZipArchive(member, 0, kSmallSize);
+		TS_ASSERT_EQUALS(file->opened, 1);
+
+		// Members above the threshold get a file handle of their own
+		Common::SeekableReadStream *small = archive->createReadStreamForMember("small.bin");
+		TS_ASSERT(small->getDataView(0, kSmallSize));
+		TS_ASSERT_EQUALS(file->opened, 1);
+		Common::SeekableReadStream *big = archive->createReadStreamForMember("big.txt");
+		TS_ASSERT(!big->getDataView(0, kSmallSize));
+		TS_ASSERT_EQUALS(file->opened, 2);
+		TS_ASSERT(checkContents(big, kBigSize - 1000, 1000));
+		delete big;
+		delete small;
+		delete archive;
+
+		// Archives of a stream can't open it again, so they decompress all
+		// members into memory
+		Common::SeekableReadStream *stream = member->createReadStream();
+		archive = Common::makeZipArchive(stream, 0);
+		big = archive->createReadStreamForMember("big.txt");
+		TS_ASSERT(big->getDataView(0, kBigSize));
+		TS_ASSERT(checkContents(big, kBigSize - 1000, 1000));
+		delete big;
+		delete archive;
+	}
+
+	void test_seek_big_member() {
+		Common::ArchiveMemberPtr file(makeZipFile());
+		Common::Archive *archive = Common::makeZipArchive(file);
+		Common::SeekableReadStream *stream = archive->createReadStreamForMember("big.txt");
+
+		// Several streams of the same archive may be used at the same time,
+		// and outlive the archive, as long as the ZIP file stays around
+		Common::SeekableReadStream *stored = archive->createReadStreamForMember("big.bin");
+		delete archive;
+
+		static const uint32 positions[] = { 2500000, 10, 1800000, 1799000, 600000, 3000000, 0, 1234567 };
+		for (int i = 0; i < ARRAYSIZE(positions); ++i) {
+			TS_ASSERT(checkContents(stream, positions[i], 1000));
+			TS_ASSERT(checkContents(stored, positions[i], 1000));
+		}
+
+		delete stored;
+		delete stream;
+	}
+
+	void test_gzip_seek() {
+		uint32 gzipSize;
+		byte *gzipData = gzip(_data, kBigSize, gzipSize);
+		Common::SeekableReadStream *stream = Common::wrapCompressedReadStream(new Common::MemoryReadStream(gzipData, gzipSize, DisposeAfterUse::YES));
+		TS_ASSERT_EQUALS(stream->size(), kBigSize);
+
+		static const uint32 positions[] = { 2000000, 5, 2999000, 1000000, 1000001, 999999, 3144000, 0 };
+		for (int i = 0; i < ARRAYSIZE(positions); ++i)
+			TS_ASSERT(checkContents(stream, positions[i], 1000));
+
+		delete stream;
+	}
+};
+
+#endif
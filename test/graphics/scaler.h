@@ -0,0 +1,125 @@
+#include <cxxtest/TestSuite.h>
+
+#include "graphics/scaler.h"
+#include "graphics/scaler/simd.h"
+
+#ifdef USE_SCALERS
+
+class ScalerTestSuite : public CxxTest::TestSuite
+{
+private:
+	enum {
+		// Wider than kHQPatternChunk, so the HQ patterns are computed in parts
+		kWidth = 283,
+		kHeight = 29,
+		kSrcPitch = (kWidth + 2) * 2,
+		kFrameCount = 4
+	};
+
+	uint32 _seed;
+	uint16 _src[(kWidth + 2) * (kHeight + 2)];
+	uint16 _expected[kWidth * 3 * kHeight * 3];
+	uint16 _result[kWidth * 3 * kHeight * 3];
+
+	uint32 nextRandom() {
+		_seed = _seed * 1103515245 + 12345;
+		return _seed >> 8;
+	}
+
+	/**
+	 * Generate one of the reference frames. Including the border, since the
+	 * scalers read one pixel around the area they scale.
+	 */
+	void makeFrame(int frame) {
+		static const uint16 palette[] = { 0x0000, 0xFFFF, 0xF800, 0x07E0, 0x001F, 0x8410, 0x8430, 0x7BEF };
+
+		for (int y = 0; y < kHeight + 2; ++y) {
+			for (int x = 0; x < kWidth + 2; ++x) {
+				uint16 &pixel = _src[y * (kWidth + 2) + x];
+				switch (frame) {
+				case 0:
+					// Noise
+					pixel = nextRandom();
+					break;
+				case 1:
+					// Smooth gradients, which are close in YUV
+					pixel = (x * 65536 / (kWidth + 2)) ^ (y << 5);
+					break;
+				case 2:
+					// Blocks and lines in few colors, like typical game graphics
+					pixel = palette[((x / 3) ^ (y / 2) ^ (x == y ? 7 : 0)) & 7];
+					break;
+				default:
+					// Few colors scattered at random
+					pixel = palette[nextRandom() & 7] ^ (nextRandom() & 0x0821);
+					break;
+				}
+			}
+		}
+	}
+
+	void testScaler(ScalerProc *scaler, int factor) {
+		const uint8 *src = (const uint8 *)(_src + kWidth + 2 + 1);
+		const int dstSize = kWidth * factor * kHeight * factor * 2;
+
+		for (int format = 0; format < 2; ++format) {
+			InitScalers(format ? 565 : 555);
+
+			for (int frame = 0; frame < kFrameCount; ++frame) {
+				makeFrame(frame);
+
+				TS_ASSERT(setScalerKernel(kScalerKernelC));
+				memset(_expected, 0, dstSize);
+				scaler(src, kSrcPitch, (uint8 *)_expected, kWidth * factor * 2, kWidth, kHeight);
+
+				for (int kernel = kScalerKernelC + 1; kernel < kScalerKernelCount; ++kernel) {
+					if (!setScalerKernel((ScalerKernel)kernel))
+						continue;
+
+					memset(_result, 0, dstSize);
+					scaler(src, kSrcPitch, (uint8 *)_result, kWidth * factor * 2, kWidth, kHeight);
+					TS_ASSERT_EQUALS(memcmp(_expected, _result, dstSize), 0);
+				}
+			}
+		}
+
+		DestroyScalers();
+	}
+
+public:
+	void setUp() {
+		_seed = 0x1234567;
+	}
+
+	void tearDown() {
+		// Go back to the default selection
+		for (int kernel = kScalerKernelCount - 1; kernel >= kScalerKernelC; --kernel) {
+			if (setScalerKernel((ScalerKernel)kernel))
+				break;
+		}
+	}
+
+	void test_kernel_c_supported() {
+		TS_ASSERT(isScalerKernelSupported(kScalerKernelC));
+	}
+
+	void test_advmame2x() {
+		testScaler(AdvMame2x, 2);
+	}
+
+	void test_advmame3x() {
+		testScaler(AdvMame3x, 3);
+	}
+
+#ifdef USE_HQ_SCALERS
+	void test_hq2x() {
+		testScaler(HQ2x, 2);
+	}
+
+	void test_hq3x() {
+		testScaler(HQ3x, 3);
+	}
+#endif
+};
+
+#endif
@@ -0,0 +1,100 @@
+#include <cxxtest/TestSuite.h>
+
+#include "graphics/surface.h"
+#include "graphics/surface_pool.h"
+
+class SurfacePoolTestSuite : public CxxTest::TestSuite
+{
+public:
+	void test_reuse() {
+		const Graphics::PixelFormat format(2, 5, 6, 5, 0, 11, 5, 0, 0);
+		Graphics::SurfacePool pool;
+		Graphics::Surface first, second;
+
+		pool.create(first, 100, 50, format);
+		TS_ASSERT_EQUALS(first.w, 100);
+		TS_ASSERT_EQUALS(first.h, 50);
+		TS_ASSERT_EQUALS(first.pitch, 200);
+		TS_ASSERT(first.format == format);
+		void *pixels = first.getPixels();
+
+		pool.free(first);
+		TS_ASSERT(!first.getPixels());
+		TS_ASSERT_EQUALS(pool.getIdleSize(), 10000U);
+
+		// A surface of another shape which fits gets the same buffer
+		pool.create(second, 120, 60, Graphics::PixelFormat::createFormatCLUT8());
+		TS_ASSERT_EQUALS(second.getPixels(), pixels);
+		TS_ASSERT_EQUALS(second.pitch, 120);
+		TS_ASSERT_EQUALS(pool.getIdleSize(), 0U);
+
+		// The buffer is in use, so there's a new one
+		pool.create(first, 100, 50, format);
+		TS_ASSERT_DIFFERS(first.getPixels(), pixels);
+
+		pool.free(first);
+		pool.free(second);
+		TS_ASSERT_EQUALS(pool.getIdleSize(), 20000U);
+
+		pool.clear();
+		TS_ASSERT_EQUALS(pool.getIdleSize(), 0U);
+	}
+
+	void test_no_waste() {
+		const Graphics::PixelFormat format = Graphics::PixelFormat::createFormatCLUT8();
+		Graphics::SurfacePool pool;
+		Graphics::Surface big, small;
+
+		pool.create(big, 100, 100, format);
+		void *pixels = big.getPixels();
+		pool.free(big);
+
+		// A big buffer isn't used for a small surface
+		pool.create(small, 10, 10, format);
+		TS_ASSERT_DIFFERS(small.getPixels(), pixels);
+		pool.free(small);
+		TS_ASSERT_EQUALS(pool.getIdleSize(), 10100U);
+
+		// But the surface that fits best is
+		pool.create(small, 8, 8, format);
+		TS_ASSERT_EQUALS(pool.getIdleSize(), 10000U);
+		pool.free(small);
+	}
+
+	void test_max_idle_size() {
+		const Graphics::PixelFormat format = Graphics::PixelFormat::createFormatCLUT8();
+		Graphics::SurfacePool pool(2500);
+		Graphics::Surface surfaces[3];
+
+		for (int i = 0; i < 3; ++i)
+			pool.create(surfaces[i], 100, 10, format);
+
+		// The oldest unused buffers are freed first
+		void *pixels = surfaces[2].getPixels();
+		for (int i = 0; i < 3; ++i)
+			pool.free(surfaces[i]);
+		TS_ASSERT_EQUALS(pool.getIdleSize(), 2000U);
+
+		pool.create(surfaces[0], 100, 10, format);
+		pool.create(surfaces[1], 100, 10, format);
+		TS_ASSERT(surfaces[0].getPixels() == pixels || surfaces[1].getPixels() == pixels);
+		pool.free(surfaces[0]);
+		pool.free(surfaces[1]);
+
+		// Buffers bigger than the limit are never kept
+		pool.create(surfaces[0], 100, 30, format);
+		pool.free(surfaces[0]);
+		TS_ASSERT_EQUALS(pool.getIdleSize(), 2000U);
+	}
+
+	void test_empty() {
+		Graphics::SurfacePool pool;
+		Graphics::Surface surface;
+
+		pool.create(surface, 0, 10, Graphics::PixelFormat::createFormatCLUT8());
+		TS_ASSERT(!surface.getPixels());
+		TS_ASSERT_EQUALS(surface.h, 10);
+		pool.free(surface);
+		TS_ASSERT_EQUALS(pool.getIdleSize(), 0U);
+	}
+};
@@ -0,0 +1,200 @@
+#include <cxxtest/TestSuite.h>
+
+#include "graphics/yuv_to_rgb.h"
+
+#ifdef POSIX
+#include <pthread.h>
+#endif
+
+class YUVToRGBTestSuite : public CxxTest::TestSuite
+{
+private:
+	enum {
+		// Not a multiple of the block sizes of the kernels, so the end of
+		// each line is converted separately
+		kWidth = 92,
+		kHeight = 12,
+		kPitch = kWidth + 5
+	};
+
+	byte _y[kPitch * kHeight];
+	byte _u[kPitch * (kHeight + 1)];
+	byte _v[kPitch * (kHeight + 1)];
+	uint32 _seed;
+
+	uint32 nextRandom() {
+		_seed = _seed * 1103515245 + 12345;
+		return _seed >> 16;
+	}
+
+	/** Random planes, with the extremes of the ranges mixed in. */
+	void makePlanes() {
+		static const byte extremes[] = { 0, 16, 235, 255 };
+
+		for (int i = 0; i < kPitch * kHeight; ++i)
+			_y[i] = (nextRandom() & 7) ? nextRandom() : extremes[nextRandom() & 3];
+
+		for (int i = 0; i < kPitch * (kHeight + 1); ++i) {
+			_u[i] = (nextRandom() & 7) ? nextRandom() : extremes[nextRandom() & 3];
+			_v[i] = (nextRandom() & 7) ? nextRandom() : extremes[nextRandom() & 3];
+		}
+	}
+
+	void convert(int type, Graphics::Surface &dst, Graphics::YUVToRGBManager::LuminanceScale scale) {
+		switch (type) {
+		case 0:
+			YUVToRGBMan.convert444(&dst, scale, _y, _u, _v, kWidth, kHeight, kPitch, kPitch);
+			break;
+		case 1:
+			YUVToRGBMan.convert420(&dst, scale, _y, _u, _v, kWidth, kHeight, kPitch, kPitch);
+			break;
+		default:
+			YUVToRGBMan.convert410(&dst, scale, _y, _u, _v, kWidth, kHeight, kPitch, kPitch);
+			break;
+		}
+	}
+
+	/** Check that all color components are within 1 of those expected. */
+	bool isClose(const Graphics::Surface &expected, const Graphics::Surface &result) {
+		for (int y = 0; y < kHeight; ++y) {
+			for (int x = 0; x < kWidth; ++x) {
+				const uint32 expectedColor = (expected.format.bytesPerPixel == 2) ? *(const uint16 *)expected.getBasePtr(x, y) : *(const uint32 *)expected.getBasePtr(x, y);
+				const uint32 resultColor = (result.format.bytesPerPixel == 2) ? *(const uint16 *)result.getBasePtr(x, y) : *(const uint32 *)result.getBasePtr(x, y);
+
+				uint8 a1, r1, g1, b1, a2, r2, g2, b2;
+				expected.format.colorToARGB(expectedColor, a1, r1, g1, b1);
+				result.format.colorToARGB(resultColor, a2, r2, g2, b2);
+
+				if (a1 != a2 || ABS(r1 - r2) > 1 || ABS(g1 - g2) > 1 || ABS(b1 - b2) > 1)
+					return false;
+			}
+		}
+
+		return true;
+	}
+
+	void testFormat(const Graphics::PixelFormat &format) {
+		const Graphics::YUVToRGBManager::Kernel defaultKernel = YUVToRGBMan.getKernel();
+
+		Graphics::Surface expected, result;
+		expected.create(kWidth, kHeight, format);
+		result.create(kWidth, kHeight, format);
+
+		for (int type = 0; type < 3; ++type) {
+			for (int scale = 0; scale < 2; ++scale) {
+				makePlanes();
+
+				TS_ASSERT(YUVToRGBMan.setKernel(Graphics::YUVToRGBManager::kKernelC));
+				convert(type, expected, (Graphics::YUVToRGBManager::LuminanceScale)scale);
+
+				for (int kernel = Graphics::YUVToRGBManager::kKernelC + 1; kernel < Graphics::YUVToRGBManager::kKernelCount; ++kernel) {
+					if (!YUVToRGBMan.setKernel((Graphics::YUVToRGBManager::Kernel)kernel))
+						continue;
+
+					memset(result.getPixels(), 0, result.pitch * result.h);
+					convert(type, result, (Graphics::YUVToRGBManager::LuminanceScale)scale);
+					TS_ASSERT(isClose(expected, result));
+				}
+			}
+		}
+
+		expected.free();
+		result.free();
+		YUVToRGBMan.setKernel(defaultKernel);
+	}
+
+#ifdef POSIX
+	enum {
+		kThreads = 4,
+		// More than the manager keeps tables for
+		kFormats = 24
+	};
+
+	/** The 32 bit formats with all orders of the components. */
+	static Graphics::PixelFormat getPermutedFormat(int index) {
+		int shifts[4] = { 24, 16, 8, 0 };
+		for (int i = 0; i < 3; ++i) {
+			const int j = i + index % (4 - i);
+			index /= 4 - i;
+			SWAP(shifts[i], shifts[j]);
+		}
+		return Graphics::PixelFormat(4, 8, 8, 8, 8, shifts[0], shifts[1], shifts[2], shifts[3]);
+	}
+
+	struct ConvertThread {
+		YUVToRGBTestSuite *suite;
+		int first;
+		Graphics::Surface results[kFormats];
+	};
+
+	static void *convertThread(void *arg) {
+		ConvertThread *state = (ConvertThread *)arg;
+		for (int i = 0; i < kFormats; ++i) {
+			const int format = (state->first + i) % kFormats;
+			state->suite->convert(1, state->results[format], Graphics::YUVToRGBManager::kScaleITU);
+		}
+		return 0;
+	}
+#endif
+
+public:
+	void setUp() {
+		_seed = 0x7654321;
+	}
+
+	void test_kernel_c_supported() {
+		TS_ASSERT(Graphics::YUVToRGBManager::isKernelSupported(Graphics::YUVToRGBManager::kKernelC));
+	}
+
+	void test_rgba8888() {
+		testFormat(Graphics::PixelFormat(4, 8, 8, 8, 8, 24, 16, 8, 0));
+	}
+
+	void test_argb8888() {
+		testFormat(Graphics::PixelFormat(4, 8, 8, 8, 8, 16, 8, 0, 24));
+	}
+
+	void test_rgb565() {
+		testFormat(Graphics::PixelFormat(2, 5, 6, 5, 0, 11, 5, 0, 0));
+	}
+
+	void test_rgba5551() {
+		testFormat(Graphics::PixelFormat(2, 5, 5, 5, 1, 11, 6, 1, 0));
+	}
+
+#ifdef POSIX
+	void test_concurrent_formats() {
+		// The C kernel is the one using tables built for each format
+		const Graphics::YUVToRGBManager::Kernel defaultKernel = YUVToRGBMan.getKernel();
+		TS_ASSERT(YUVToRGBMan.setKernel(Graphics::YUVToRGBManager::kKernelC));
+		makePlanes();
+
+		ConvertThread states[kThreads];
+		pthread_t threads[kThreads];
+		for (int t = 0; t < kThreads; ++t) {
+			states[t].suite = this;
+			states[t].first = t * kFormats / kThreads;
+			for (int i = 0; i < kFormats; ++i)
+				states[t].results[i].create(kWidth, kHeight, getPermutedFormat(i));
+		}
+
+		for (int t = 0; t < kThreads; ++t)
+			TS_ASSERT_EQUALS(pthread_create(&threads[t], 0, convertThread, &states[t]), 0);
+		for (int t = 0; t < kThreads; ++t)
+			pthread_join(threads[t], 0);
+
+		Graphics::Surface expected;
+		for (int i = 0; i < kFormats; ++i) {
+			expected.create(kWidth, kHeight, getPermutedFormat(i));
+			convert(1, expected, Graphics::YUVToRGBManager::kScaleITU);
+			for (int t = 0; t < kThreads; ++t) {
+				TS_ASSERT_EQUALS(memcmp(expected.getPixels(), states[t].results[i].getPixels(), expected.pitch * kHeight), 0);
+				states[t].results[i].free();
+			}
+			expected.free();
+		}
+
+		YUVToRGBMan.setKernel(defaultKernel);
+	}
+#endif
+};
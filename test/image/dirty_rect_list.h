@@ -0,0 +1,83 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/memstream.h"
+#include "image/codecs/codec.h"
+#include "image/codecs/msvideo1.h"
+
+class DirtyRectListTestSuite : public CxxTest::TestSuite
+{
+	static Common::Array<Common::Rect> toArray(const Common::List<Common::Rect> &list) {
+		Common::Array<Common::Rect> rects;
+		for (Common::List<Common::Rect>::const_iterator i = list.begin(); i != list.end(); ++i)
+			rects.push_back(*i);
+		return rects;
+	}
+
+	static void addBlocks(Image::DirtyRectList &list, int y, const char *row) {
+		for (int x = 0; row[x]; x++) {
+			if (row[x] == 'x')
+				list.add(Common::Rect(x * 4, y, x * 4 + 4, y + 4));
+		}
+	}
+
+public:
+	void test_join() {
+		Image::DirtyRectList list;
+
+		// Runs in a row are joined, and so are runs spanning the same
+		// columns in the next row
+		addBlocks(list, 0, "xx.x");
+		addBlocks(list, 4, "xx..");
+		addBlocks(list, 8, "xx.x");
+
+		Common::Array<Common::Rect> rects = toArray(list.getRects());
+		TS_ASSERT_EQUALS(rects.size(), 3U);
+		TS_ASSERT(rects[0] == Common::Rect(0, 0, 8, 12));
+		TS_ASSERT(rects[1] == Common::Rect(12, 0, 16, 4));
+		TS_ASSERT(rects[2] == Common::Rect(12, 8, 16, 12));
+
+		list.clear();
+		TS_ASSERT(list.getRects().empty());
+	}
+
+	void test_bottom_up() {
+		Image::DirtyRectList list;
+
+		addBlocks(list, 8, ".xx");
+		addBlocks(list, 4, ".xx");
+		// Not adjacent to the rows before
+		addBlocks(list, 16, ".xx");
+
+		Common::Array<Common::Rect> rects = toArray(list.getRects());
+		TS_ASSERT_EQUALS(rects.size(), 2U);
+		TS_ASSERT(rects[0] == Common::Rect(4, 4, 12, 12));
+		TS_ASSERT(rects[1] == Common::Rect(4, 16, 12, 20));
+	}
+
+	void test_msvideo1() {
+		Image::MSVideo1Decoder decoder(8, 8, 8);
+
+		// Fill all four blocks with one color each
+		static const byte fullFrame[] = { 1, 0x80, 2, 0x80, 3, 0x80, 4, 0x80, 0, 0 };
+		Common::MemoryReadStream full(fullFrame, sizeof(fullFrame));
+		const Graphics::Surface *surface = decoder.decodeFrame(full);
+
+		TS_ASSERT(decoder.getDirtyRects());
+		Common::Array<Common::Rect> rects = toArray(*decoder.getDirtyRects());
+		TS_ASSERT_EQUALS(rects.size(), 1U);
+		TS_ASSERT(rects[0] == Common::Rect(0, 0, 8, 8));
+
+		// The blocks are stored from the bottom left, so only change that
+		// one and skip the other three
+		static const byte partialFrame[] = { 5, 0x80, 3, 0x84 };
+		Common::MemoryReadStream partial(partialFrame, sizeof(partialFrame));
+		surface = decoder.decodeFrame(partial);
+
+		rects = toArray(*decoder.getDirtyRects());
+		TS_ASSERT_EQUALS(rects.size(), 1U);
+		TS_ASSERT(rects[0] == Common::Rect(0, 4, 4, 8));
+		TS_ASSERT_EQUALS(*(const byte *)surface->getBasePtr(0, 7), 5);
+		TS_ASSERT_EQUALS(*(const byte *)surface->getBasePtr(4, 7), 2);
+		TS_ASSERT_EQUALS(*(const byte *)surface->getBasePtr(0, 0), 3);
+	}
+};
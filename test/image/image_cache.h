@@ -0,0 +1,117 @@
+#include <cxxtest/TestSuite.h>
+
+#include "graphics/surface.h"
+#include "image/image_cache.h"
+
+class ImageCacheTestSuite : public CxxTest::TestSuite
+{
+	static Graphics::PixelFormat getRGBA() {
+		return Graphics::PixelFormat(4, 8, 8, 8, 8, 24, 16, 8, 0);
+	}
+
+	static Graphics::PixelFormat getRGB565() {
+		return Graphics::PixelFormat(2, 5, 6, 5, 0, 11, 5, 0, 0);
+	}
+
+	/** Add a 10x10 image with the given pixel format to the cache. */
+	static Image::CachedImagePtr add(Image::ImageCache &cache, const char *name, const Graphics::PixelFormat &format) {
+		Graphics::Surface surface;
+		surface.create(10, 10, format);
+		surface.fillRect(Common::Rect(10, 10), 0x1234);
+		Image::CachedImagePtr image = cache.add(name, surface, getRGBA());
+		surface.free();
+		return image;
+	}
+
+public:
+	void test_get() {
+		Image::ImageCache cache;
+		TS_ASSERT(!cache.get("scene.png", getRGBA()));
+		TS_ASSERT_EQUALS(cache.getMisses(), 1U);
+
+		Image::CachedImagePtr added = add(cache, "scene.png", getRGBA());
+		TS_ASSERT_EQUALS(cache.getSize(), 400U);
+
+		// Names are case insensitive
+		Image::CachedImagePtr image = cache.get("SCENE.PNG", getRGBA());
+		TS_ASSERT_EQUALS(image.get(), added.get());
+		TS_ASSERT_EQUALS(image->surface.w, 10);
+		TS_ASSERT_EQUALS(*(const uint32 *)image->surface.getBasePtr(9, 9), 0x1234U);
+		TS_ASSERT(image->sourceFormat == getRGBA());
+		TS_ASSERT_EQUALS(cache.getHits(), 1U);
+
+		// Each format is cached separately
+		TS_ASSERT(!cache.get("scene.png", getRGB565()));
+		add(cache, "scene.png", getRGB565());
+		TS_ASSERT(cache.get("scene.png", getRGB565()));
+		TS_ASSERT_EQUALS(cache.getCount(), 2U);
+		TS_ASSERT_EQUALS(cache.getSize(), 600U);
+
+		TS_ASSERT_EQUALS(cache.getHits(), 2U);
+		TS_ASSERT_EQUALS(cache.getMisses(), 2U);
+		cache.resetStatistics();
+		TS_ASSERT_EQUALS(cache.getHits(), 0U);
+		TS_ASSERT_EQUALS(cache.getMisses(), 0U);
+
+		cache.remove("Scene.png");
+		TS_ASSERT_EQUALS(cache.getCount(), 0U);
+		TS_ASSERT_EQUALS(cache.getSize(), 0U);
+	}
+
+	void test_replace() {
+		Image::ImageCache cache;
+		add(cache, "a.png", getRGBA());
+		Image::CachedImagePtr image = add(cache, "a.png", getRGBA());
+		TS_ASSERT_EQUALS(cache.getCount(), 1U);
+		TS_ASSERT_EQUALS(cache.getSize(), 400U);
+		TS_ASSERT_EQUALS(cache.get("a.png", getRGBA()).get(), image.get());
+	}
+
+	void test_palette() {
+		Image::ImageCache cache;
+		Graphics::Surface surface;
+		surface.create(4, 4, Graphics::PixelFormat::createFormatCLUT8());
+		const byte palette[] = { 1, 2, 3, 4, 5, 6 };
+
+		cache.add("a.bmp", surface, surface.format, palette, 2);
+		surface.free();
+
+		Image::CachedImagePtr image = cache.get("a.bmp", Graphics::PixelFormat::createFormatCLUT8());
+		TS_ASSERT(image);
+		TS_ASSERT_EQUALS(image->paletteColorCount, 2);
+		TS_ASSERT_EQUALS(image->palette.size(), 6U);
+		TS_ASSERT_EQUALS(image->palette[5], 6);
+		TS_ASSERT_EQUALS(cache.getSize(), 22U);
+	}
+
+	void test_eviction() {
+		Image::ImageCache cache(1000);
+		add(cache, "a.png", getRGBA());
+		add(cache, "b.png", getRGBA());
+
+		// Using a makes b the least recently used image
+		TS_ASSERT(cache.get("a.png", getRGBA()));
+		Image::CachedImagePtr b = cache.get("b.png", getRGBA());
+		TS_ASSERT(cache.get("a.png", getRGBA()));
+
+		add(cache, "c.png", getRGBA());
+		TS_ASSERT_EQUALS(cache.getSize(), 800U);
+		TS_ASSERT_EQUALS(cache.getEvictions(), 1U);
+		TS_ASSERT(cache.get("a.png", getRGBA()));
+		TS_ASSERT(!cache.get("b.png", getRGBA()));
+		TS_ASSERT(cache.get("c.png", getRGBA()));
+
+		// Images handed out stay valid
+		TS_ASSERT_EQUALS(*(const uint32 *)b->surface.getBasePtr(0, 0), 0x1234U);
+
+		cache.setMaxSize(500);
+		TS_ASSERT_EQUALS(cache.getCount(), 1U);
+		TS_ASSERT(cache.get("c.png", getRGBA()));
+
+		// Images bigger than the budget are not cached
+		cache.setMaxSize(100);
+		TS_ASSERT(add(cache, "d.png", getRGBA()));
+		TS_ASSERT_EQUALS(cache.getCount(), 0U);
+		TS_ASSERT_EQUALS(cache.getSize(), 0U);
+	}
+};
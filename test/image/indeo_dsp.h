@@ -0,0 +1,163 @@
+#include <cxxtest/TestSuite.h>
+
+#include "image/codecs/indeo/indeo_dsp.h"
+
+class IndeoDSPTestSuite : public CxxTest::TestSuite
+{
+private:
+	typedef Image::Indeo::IndeoDSP IndeoDSP;
+
+	typedef void (*TransformProc)(const int32 *in, int16 *out, uint32 pitch, const uint8 *flags);
+	typedef void (*MCProc)(int16 *buf, const int16 *refBuf, uint32 pitch, int mcType);
+	typedef void (*MCAvgProc)(int16 *buf, const int16 *refBuf, const int16 *refBuf2, uint32 pitch, int mcType, int mcType2);
+
+	enum {
+		kPitch = 21,
+		kBlockCount = 500
+	};
+
+	uint32 _seed;
+	int32 _coeffs[64];
+	uint8 _flags[8];
+	int16 _ref[kPitch * 10];
+	int16 _ref2[kPitch * 10];
+	int16 _expected[kPitch * 8];
+	int16 _result[kPitch * 8];
+
+	uint32 nextRandom() {
+		_seed = _seed * 1103515245 + 12345;
+		return _seed >> 8;
+	}
+
+	/**
+	 * Coefficients like those of real blocks: mostly small and sparse, with
+	 * empty columns and lines, and now and then one far out of range.
+	 */
+	void makeCoeffs() {
+		for (int i = 0; i < 8; i++)
+			_flags[i] = nextRandom() & 3;
+
+		const uint32 emptyLines = nextRandom();
+		for (int i = 0; i < 64; i++) {
+			if (!_flags[i & 7] || (emptyLines & (1 << (i >> 3))) || (nextRandom() & 3))
+				_coeffs[i] = 0;
+			else if (nextRandom() & 31)
+				_coeffs[i] = (int32)(nextRandom() & 0x3FF) - 0x200;
+			else
+				_coeffs[i] = (int32)(nextRandom() & 0xFFFFF) - 0x80000;
+		}
+	}
+
+	/** Reference pixels; the full 16 bit range for some of the blocks. */
+	void makeRef(int16 *ref, bool fullRange) {
+		for (int i = 0; i < kPitch * 10; i++)
+			ref[i] = fullRange ? (int16)nextRandom() : (int16)((nextRandom() & 0x1FF) - 0x100);
+	}
+
+	void makeDelta(int16 *buf) {
+		for (int i = 0; i < kPitch * 8; i++)
+			buf[i] = (int16)((nextRandom() & 0xFF) - 0x80);
+	}
+
+	/**
+	 * Run the transform over random blocks with every kernel. All of them
+	 * must give exactly the output of the C kernel.
+	 */
+	void testTransform(TransformProc transform) {
+		for (int block = 0; block < kBlockCount; block++) {
+			makeCoeffs();
+
+			TS_ASSERT(IndeoDSP::setKernel(IndeoDSP::kKernelC));
+			memset(_expected, 0x55, sizeof(_expected));
+			transform(_coeffs, _expected, kPitch, _flags);
+
+			for (int kernel = IndeoDSP::kKernelC + 1; kernel < IndeoDSP::kKernelCount; kernel++) {
+				if (!IndeoDSP::setKernel((IndeoDSP::Kernel)kernel))
+					continue;
+
+				memset(_result, 0x55, sizeof(_result));
+				transform(_coeffs, _result, kPitch, _flags);
+				TS_ASSERT_EQUALS(memcmp(_expected, _result, sizeof(_result)), 0);
+			}
+		}
+	}
+
+	void testMC(MCProc mc, MCAvgProc mcAvg) {
+		for (int block = 0; block < kBlockCount; block++) {
+			makeRef(_ref, block & 1);
+			makeRef(_ref2, block & 2);
+			makeDelta(_expected);
+			const int mcType = block & 3;
+			const int mcType2 = (block >> 2) & 3;
+			const bool avg = block & 16;
+
+			memcpy(_result, _expected, sizeof(_result));
+
+			TS_ASSERT(IndeoDSP::setKernel(IndeoDSP::kKernelC));
+			if (avg)
+				mcAvg(_expected, _ref, _ref2, kPitch, mcType, mcType2);
+			else
+				mc(_expected, _ref, kPitch, mcType);
+
+			int16 delta[kPitch * 8];
+			memcpy(delta, _result, sizeof(delta));
+
+			for (int kernel = IndeoDSP::kKernelC + 1; kernel < IndeoDSP::kKernelCount; kernel++) {
+				if (!IndeoDSP::setKernel((IndeoDSP::Kernel)kernel))
+					continue;
+
+				memcpy(_result, delta, sizeof(_result));
+				if (avg)
+					mcAvg(_result, _ref, _ref2, kPitch, mcType, mcType2);
+				else
+					mc(_result, _ref, kPitch, mcType);
+				TS_ASSERT_EQUALS(memcmp(_expected, _result, sizeof(_result)), 0);
+			}
+		}
+	}
+
+public:
+	void setUp() {
+		_seed = 0x1357924;
+	}
+
+	void tearDown() {
+		// Go back to the default selection
+		for (int kernel = IndeoDSP::kKernelCount - 1; kernel >= IndeoDSP::kKernelC; --kernel) {
+			if (IndeoDSP::setKernel((IndeoDSP::Kernel)kernel))
+				break;
+		}
+	}
+
+	void test_kernel_c_supported() {
+		TS_ASSERT(IndeoDSP::isKernelSupported(IndeoDSP::kKernelC));
+
+		bool vectorized = false;
+		for (int kernel = IndeoDSP::kKernelC + 1; kernel < IndeoDSP::kKernelCount; kernel++)
+			vectorized |= IndeoDSP::isKernelSupported((IndeoDSP::Kernel)kernel);
+		if (!vectorized)
+			TS_WARN("No vectorized Indeo DSP kernel is supported, the comparisons are skipped");
+	}
+
+	void test_haar8x8() {
+		testTransform(IndeoDSP::ffIviInverseHaar8x8);
+		testTransform(IndeoDSP::ffIviRowHaar8);
+		testTransform(IndeoDSP::ffIviColHaar8);
+	}
+
+	void test_slant8x8() {
+		testTransform(IndeoDSP::ffIviInverseSlant8x8);
+		testTransform(IndeoDSP::ffIviRowSlant8);
+		testTransform(IndeoDSP::ffIviColSlant8);
+	}
+
+	void test_mc8x8() {
+		testMC(IndeoDSP::ffIviMc8x8NoDelta, IndeoDSP::ffIviMcAvg8x8NoDelta);
+		testMC(IndeoDSP::ffIviMc8x8Delta, IndeoDSP::ffIviMcAvg8x8Delta);
+	}
+
+	void test_mc4x4() {
+		testMC(IndeoDSP::ffIviMc4x4NoDelta, IndeoDSP::ffIviMcAvg4x4NoDelta);
+		testMC(IndeoDSP::ffIviMc4x4Delta, IndeoDSP::ffIviMcAvg4x4Delta);
+	}
+};
@@ -0,0 +1,131 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/memstream.h"
+#include "graphics/surface.h"
+#include "graphics/surface_pool.h"
+#include "image/jpeg.h"
+
+#ifdef USE_JPEG
+
+class JPEGTestSuite : public CxxTest::TestSuite
+{
+	/** A 24x16 gradient. */
+	static const byte *getJPEG(uint32 &size) {
+		static const byte jpeg[] = {
+		0xff, 0xd8, 0xff, 0xe0, 0x00, 0x10, 0x4a, 0x46, 0x49, 0x46, 0x00, 0x01,
+		0x01, 0x00, 0x00, 0x01, 0x00, 0x01, 0x00, 0x00, 0xff, 0xdb, 0x00, 0x43,
+		0x00, 0x08, 0x06, 0x06, 0x07, 0x06, 0x05, 0x08, 0x07, 0x07, 0x07, 0x09,
+		0x09, 0x08, 0x0a, 0x0c, 0x14, 0x0d, 0x0c, 0x0b, 0x0b, 0x0c, 0x19, 0x12,
+		0x13, 0x0f, 0x14, 0x1d, 0x1a, 0x1f, 0x1e, 0x1d, 0x1a, 0x1c, 0x1c, 0x20,
+		0x24, 0x2e, 0x27, 0x20, 0x22, 0x2c, 0x23, 0x1c, 0x1c, 0x28, 0x37, 0x29,
+		0x2c, 0x30, 0x31, 0x34, 0x34, 0x34, 0x1f, 0x27, 0x39, 0x3d, 0x38, 0x32,
+		0x3c, 0x2e, 0x33, 0x34, 0x32, 0xff, 0xdb, 0x00, 0x43, 0x01, 0x09, 0x09,
+		0x09, 0x0c, 0x0b, 0x0c, 0x18, 0x0d, 0x0d, 0x18, 0x32, 0x21, 0x1c, 0x21,
+		0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32,
+		0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32,
+		0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32,
+		0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32,
+		0x32, 0x32, 0xff, 0xc0, 0x00, 0x11, 0x08, 0x00, 0x10, 0x00, 0x18, 0x03,
+		0x01, 0x22, 0x00, 0x02, 0x11, 0x01, 0x03, 0x11, 0x01, 0xff, 0xc4, 0x00,
+		0x17, 0x00, 0x00, 0x03, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x05, 0x06, 0x07, 0xff, 0xc4,
+		0x00, 0x18, 0x10, 0x00, 0x02, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x04, 0x05, 0x22, 0x31,
+		0xff, 0xc4, 0x00, 0x17, 0x01, 0x00, 0x03, 0x01, 0x00, 0x00, 0x00, 0x00,
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x04, 0x05,
+		0x06, 0xff, 0xc4, 0x00, 0x1c, 0x11, 0x00, 0x01, 0x03, 0x05, 0x00, 0x00,
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x04,
+		0x05, 0x21, 0x01, 0x02, 0x03, 0x22, 0x31, 0xff, 0xda, 0x00, 0x0c, 0x03,
+		0x01, 0x00, 0x02, 0x11, 0x03, 0x11, 0x00, 0x3f, 0x00, 0xcb, 0x54, 0x82,
+		0xca, 0x0f, 0x54, 0x82, 0xca, 0x15, 0xea, 0x41, 0x65, 0x07, 0xaa, 0x41,
+		0x65, 0x01, 0xe2, 0x50, 0x20, 0xda, 0xf7, 0xc9, 0x24, 0x54, 0x82, 0xca,
+		0x01, 0xa6, 0x29, 0x05, 0x94, 0x02, 0x85, 0xaa, 0x20, 0xdb, 0xa7, 0x7b,
+		0xd2, 0x92, 0x7f, 0xff, 0xd9
+		};
+
+		size = sizeof(jpeg);
+		return jpeg;
+	}
+
+	bool load(Image::JPEGDecoder &decoder) {
+		uint32 size;
+		const byte *jpeg = getJPEG(size);
+		Common::MemoryReadStream stream(jpeg, size);
+		return decoder.loadStream(stream);
+	}
+
+	static bool isEqual(const Graphics::Surface &a, const Graphics::Surface &b) {
+		if (a.w != b.w || a.h != b.h || a.format != b.format)
+			return false;
+
+		for (int y = 0; y < a.h; ++y) {
+			if (memcmp(a.getBasePtr(0, y), b.getBasePtr(0, y), a.w * a.format.bytesPerPixel))
+				return false;
+		}
+
+		return true;
+	}
+
+public:
+	void test_output_format() {
+		Image::JPEGDecoder reference;
+		TS_ASSERT(load(reference));
+		TS_ASSERT_EQUALS(reference.getSurface()->w, 24);
+		TS_ASSERT_EQUALS(reference.getSurface()->h, 16);
+
+		const Graphics::PixelFormat format(2, 5, 6, 5, 0, 11, 5, 0, 0);
+		Graphics::Surface *expected = reference.getSurface()->convertTo(format);
+
+		Image::JPEGDecoder decoder;
+		decoder.setOutputPixelFormat(format);
+		TS_ASSERT(load(decoder));
+		TS_ASSERT(isEqual(*decoder.getSurface(), *expected));
+
+		expected->free();
+		delete expected;
+	}
+
+	void test_clip() {
+		Image::JPEGDecoder reference;
+		TS_ASSERT(load(reference));
+
+		const Common::Rect rect(5, 3, 17, 11);
+		Image::JPEGDecoder decoder;
+		decoder.setClipRect(rect);
+		TS_ASSERT(load(decoder));
+		TS_ASSERT(isEqual(*decoder.getSurface(), reference.getSurface()->getSubArea(rect)));
+	}
+
+	void test_downscale() {
+		Image::JPEGDecoder reference;
+		reference.setDownscale(2);
+		TS_ASSERT(load(reference));
+		TS_ASSERT_EQUALS(reference.getSurface()->w, 12);
+		TS_ASSERT_EQUALS(reference.getSurface()->h, 8);
+
+		// The clip rectangle is in the coordinates of the downscaled image
+		const Common::Rect rect(2, 1, 9, 5);
+		Image::JPEGDecoder decoder;
+		decoder.setDownscale(2);
+		decoder.setClipRect(rect);
+		TS_ASSERT(load(decoder));
+		TS_ASSERT(isEqual(*decoder.getSurface(), reference.getSurface()->getSubArea(rect)));
+	}
+
+	void test_surface_pool() {
+		Graphics::SurfacePool pool;
+		Image::JPEGDecoder decoder;
+		decoder.setSurfacePool(&pool);
+
+		TS_ASSERT(load(decoder));
+		const void *pixels = decoder.getSurface()->getPixels();
+
+		TS_ASSERT(load(decoder));
+		TS_ASSERT_EQUALS(decoder.getSurface()->getPixels(), pixels);
+
+		decoder.destroy();
+		TS_ASSERT_EQUALS(pool.getIdleSize(), 24U * 16U * 4U);
+	}
+};
+
+#endif
@@ -0,0 +1,182 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/memstream.h"
+#include "graphics/surface.h"
+#include "graphics/surface_pool.h"
+#include "image/png.h"
+
+#ifdef USE_PNG
+
+class PNGTestSuite : public CxxTest::TestSuite
+{
+	enum {
+		kWidth = 37,
+		kHeight = 23
+	};
+
+	Graphics::Surface _image;
+	byte *_png;
+	uint32 _pngSize;
+
+	/** The format of the decoded images. */
+	static Graphics::PixelFormat getFormat() {
+		return Graphics::PixelFormat(4, 8, 8, 8, 8, 24, 16, 8, 0);
+	}
+
+	bool load(Image::PNGDecoder &decoder) {
+		Common::MemoryReadStream stream(_png, _pngSize);
+		return decoder.loadStream(stream);
+	}
+
+	static bool isEqual(const Graphics::Surface &a, const Graphics::Surface &b) {
+		if (a.w != b.w || a.h != b.h || a.format != b.format)
+			return false;
+
+		for (int y = 0; y < a.h; ++y) {
+			if (memcmp(a.getBasePtr(0, y), b.getBasePtr(0, y), a.w * a.format.bytesPerPixel))
+				return false;
+		}
+
+		return true;
+	}
+
+public:
+	void setUp() {
+		_image.create(kWidth, kHeight, getFormat());
+
+		uint32 seed = 0x1234567;
+		for (int y = 0; y < kHeight; ++y) {
+			for (int x = 0; x < kWidth; ++x) {
+				seed = seed * 1103515245 + 12345;
+				*(uint32 *)_image.getBasePtr(x, y) = getFormat().ARGBToColor(seed >> 24, x * 7, y * 11, seed >> 16);
+			}
+		}
+
+		Common::MemoryWriteStreamDynamic png(DisposeAfterUse::NO);
+		Image::writePNG(png, _image);
+		_png = png.getData();
+		_pngSize = png.size();
+	}
+
+	void tearDown() {
+		_image.free();
+		free(_png);
+	}
+
+	void test_load() {
+		Image::PNGDecoder decoder;
+		TS_ASSERT(load(decoder));
+		TS_ASSERT(isEqual(*decoder.getSurface(), _image));
+	}
+
+	void test_output_format() {
+		const Graphics::PixelFormat format(2, 5, 6, 5, 0, 11, 5, 0, 0);
+		Graphics::Surface *expected = _image.convertTo(format);
+
+		Image::PNGDecoder decoder;
+		decoder.setOutputPixelFormat(format);
+		TS_ASSERT(load(decoder));
+		TS_ASSERT(isEqual(*decoder.getSurface(), *expected));
+
+		// True color images can't be decoded to CLUT8
+		decoder.setOutputPixelFormat(Graphics::PixelFormat::createFormatCLUT8());
+		TS_ASSERT(!load(decoder));
+
+		expected->free();
+		delete expected;
+	}
+
+	void test_clip() {
+		const Common::Rect rect(5, 3, 30, 14);
+
+		Image::PNGDecoder decoder;
+		decoder.setClipRect(rect);
+		TS_ASSERT(load(decoder));
+		TS_ASSERT(isEqual(*decoder.getSurface(), _image.getSubArea(rect)));
+
+		// Clipped to the image
+		decoder.setClipRect(Common::Rect(30, 20, 100, 100));
+		TS_ASSERT(load(decoder));
+		TS_ASSERT(isEqual(*decoder.getSurface(), _image.getSubArea(Common::Rect(30, 20, kWidth, kHeight))));
+	}
+
+	void test_downscale() {
+		const int scale = 3;
+		const int width = (kWidth + scale - 1) / scale;
+		const int height = (kHeight + scale - 1) / scale;
+
+		Graphics::Surface expected;
+		expected.create(width, height, getFormat());
+		for (int y = 0; y < height; ++y) {
+			for (int x = 0; x < width; ++x) {
+				uint32 sums[4] = { 0, 0, 0, 0 };
+				uint32 count = 0;
+				for (int sy = y * scale; sy < MIN(y * scale + scale, (int)kHeight); ++sy) {
+					for (int sx = x * scale; sx < MIN(x * scale + scale, (int)kWidth); ++sx, ++count) {
+						const byte *pixel = (const byte *)_image.getBasePtr(sx, sy);
+						for (int i = 0; i < 4; ++i)
+							sums[i] += pixel[i];
+					}
+				}
+
+				byte *pixel = (byte *)expected.getBasePtr(x, y);
+				for (int i = 0; i < 4; ++i)
+					pixel[i] = (sums[i] + count / 2) / count;
+			}
+		}
+
+		Image::PNGDecoder decoder;
+		decoder.setDownscale(scale);
+		TS_ASSERT(load(decoder));
+		TS_ASSERT(isEqual(*decoder.getSurface(), expected));
+
+		// The clip rectangle is in the coordinates of the downscaled image
+		const Common::Rect rect(2, 1, 11, 7);
+		decoder.setClipRect(rect);
+		TS_ASSERT(load(decoder));
+		TS_ASSERT(isEqual(*decoder.getSurface(), expected.getSubArea(rect)));
+
+		expected.free();
+	}
+
+	void test_destination() {
+		Graphics::Surface dst;
+		dst.create(kWidth + 10, kHeight + 4, getFormat());
+		memset(dst.getPixels(), 0xAB, dst.pitch * dst.h);
+
+		Image::PNGDecoder decoder;
+		Common::MemoryReadStream stream(_png, _pngSize);
+		TS_ASSERT(decoder.loadStream(stream, dst, Common::Point(6, 2)));
+		TS_ASSERT(!decoder.getSurface());
+		TS_ASSERT(isEqual(dst.getSubArea(Common::Rect(6, 2, kWidth + 6, kHeight + 2)), _image));
+		TS_ASSERT_EQUALS(*(const uint32 *)dst.getBasePtr(5, 2), 0xABABABABU);
+		TS_ASSERT_EQUALS(*(const uint32 *)dst.getBasePtr(6, 1), 0xABABABABU);
+
+		// Clipped to the destination, with the clip rectangle applied first
+		decoder.setClipRect(Common::Rect(5, 3, 30, 14));
+		stream.seek(0);
+		TS_ASSERT(decoder.loadStream(stream, dst, Common::Point(-2, kHeight)));
+		TS_ASSERT(isEqual(dst.getSubArea(Common::Rect(0, kHeight, 23, kHeight + 4)), _image.getSubArea(Common::Rect(7, 3, 30, 7))));
+
+		dst.free();
+	}
+
+	void test_surface_pool() {
+		Graphics::SurfacePool pool;
+		Image::PNGDecoder decoder;
+		decoder.setSurfacePool(&pool);
+
+		TS_ASSERT(load(decoder));
+		const void *pixels = decoder.getSurface()->getPixels();
+		TS_ASSERT(isEqual(*decoder.getSurface(), _image));
+
+		TS_ASSERT(load(decoder));
+		TS_ASSERT_EQUALS(decoder.getSurface()->getPixels(), pixels);
+		TS_ASSERT(isEqual(*decoder.getSurface(), _image));
+
+		decoder.destroy();
+		TS_ASSERT_EQUALS(pool.getIdleSize(), (uint32)(kWidth * kHeight * 4));
+	}
+};
+
+#endif
@@ -5,20 +5,40 @@
 #
 ######################################################################
 
-TESTS        := $(srcdir)/test/common/*.h $(srcdir)/test/audio/*.h
-TEST_LIBS    := audio/libaudio.a common/libcommon.a
+TESTS        := $(srcdir)/test/common/*.h $(srcdir)/test/audio/*.h $(srcdir)/test/graphics/*.h $(srcdir)/test/image/*.h $(srcdir)/test/video/*.h
+TEST_LIBS    := video/libvideo.a audio/libaudio.a image/libimage.a graphics/libgraphics.a common/libcommon.a
 
 ifeq ($(ENABLE_WINTERMUTE), STATIC_PLUGIN)
 	TESTS += $(srcdir)/test/engines/wintermute/*.h
 	TEST_LIBS += engines/wintermute/libwintermute.a
 endif
 
+# test/backends/opengl.h renders offscreen through EGL, which needs Mesa's
+# surfaceless platform. Enable it with 'make test TEST_OPENGL=1'.
+ifdef USE_OPENGL
+ifdef TEST_OPENGL
+	TESTS += $(srcdir)/test/backends/*.h
+	TEST_LIBS := backends/libbackends.a $(TEST_LIBS)
+endif
+endif
+
 #
 TEST_FLAGS   := --runner=StdioPrinter --no-std --no-eh --include=$(srcdir)/test/cxxtest_mingw.h
 TEST_CFLAGS  := $(CFLAGS) -I$(srcdir)/test/cxxtest
 TEST_LDFLAGS := $(LDFLAGS) $(LIBS)
 TEST_CXXFLAGS := $(filter-out -Wglobal-constructors,$(CXXFLAGS))
 
+ifdef POSIX
+# test/common/spscqueue.h, test/common/testsystem.h and test/audio/mixer.h use threads
+TEST_LDFLAGS += -lpthread
+endif
+
+ifdef USE_OPENGL
+ifdef TEST_OPENGL
+TEST_LDFLAGS += -lEGL
+endif
+endif
+
 ifdef N64
 TEST_LDFLAGS := $(filter-out -mno-crt0,$(TEST_LDFLAGS))
 endif
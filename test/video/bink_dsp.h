@@ -0,0 +1,134 @@
+#include <cxxtest/TestSuite.h>
+
+#include "video/bink_dsp.h"
+
+#ifdef USE_BINK
+
+class BinkDSPTestSuite : public CxxTest::TestSuite
+{
+private:
+	typedef Video::BinkDSP BinkDSP;
+
+	enum {
+		kPitch = 21,
+		kBlockCount = 1000
+	};
+
+	enum Op {
+		kOpPut,
+		kOpAdd,
+		kOpResidue
+	};
+
+	uint32 _seed;
+	int16 _block[64];
+	byte _pixels[kPitch * 8];
+	byte _expected[kPitch * 8];
+	byte _result[kPitch * 8];
+
+	uint32 nextRandom() {
+		_seed = _seed * 1103515245 + 12345;
+		return _seed >> 8;
+	}
+
+	/**
+	 * Coefficients like those of real blocks: mostly small and sparse, and
+	 * now and then over the full 16 bit range, which overflows the 16 bit
+	 * intermediate values of the IDCT.
+	 */
+	void makeBlock(int index) {
+		const bool fullRange = !(index % 7);
+		const bool dcOnly = !(index % 5);
+
+		for (int i = 0; i < 64; i++) {
+			if (fullRange)
+				_block[i] = (int16)nextRandom();
+			else if ((i && dcOnly) || (nextRandom() & 3))
+				_block[i] = 0;
+			else
+				_block[i] = (int16)((nextRandom() & 0xFFF) - 0x800);
+		}
+
+		for (int i = 0; i < kPitch * 8; i++)
+			_pixels[i] = (byte)nextRandom();
+	}
+
+	void run(Op op, byte *dest) {
+		int16 block[64];
+		memcpy(block, _block, sizeof(block));
+		memcpy(dest, _pixels, sizeof(_pixels));
+
+		switch (op) {
+		case kOpPut:
+			BinkDSP::idctPut(dest, kPitch, block);
+			break;
+		case kOpAdd:
+			BinkDSP::idctAdd(dest, kPitch, block);
+			break;
+		case kOpResidue:
+			BinkDSP::addResidue(dest, kPitch, block);
+			break;
+		}
+	}
+
+	/**
+	 * Run an operation over random blocks with every kernel. All of them
+	 * must give the output of the C kernel, whose checksum is returned.
+	 */
+	uint32 testOp(Op op) {
+		uint32 sum = 0;
+
+		for (int block = 0; block < kBlockCount; block++) {
+			makeBlock(block);
+
+			TS_ASSERT(BinkDSP::setKernel(BinkDSP::kKernelC));
+			run(op, _expected);
+			for (int i = 0; i < kPitch * 8; i++)
+				sum = (sum * 31) ^ _expected[i];
+
+			for (int kernel = BinkDSP::kKernelC + 1; kernel < BinkDSP::kKernelCount; kernel++) {
+				if (!BinkDSP::setKernel((BinkDSP::Kernel)kernel))
+					continue;
+
+				run(op, _result);
+				TS_ASSERT_EQUALS(memcmp(_expected, _result, sizeof(_result)), 0);
+			}
+		}
+
+		return sum;
+	}
+
+public:
+	void setUp() {
+		_seed = 0x2468ACE;
+	}
+
+	void tearDown() {
+		// Go back to the default selection
+		for (int kernel = BinkDSP::kKernelCount - 1; kernel >= BinkDSP::kKernelC; --kernel) {
+			if (BinkDSP::setKernel((BinkDSP::Kernel)kernel))
+				break;
+		}
+	}
+
+	void test_kernel_c_supported() {
+		TS_ASSERT(BinkDSP::isKernelSupported(BinkDSP::kKernelC));
+	}
+
+	// The checksums are those of the C code, so they also catch changes to
+	// the C kernel.
+
+	void test_idct_put() {
+		TS_ASSERT_EQUALS(testOp(kOpPut), 4242951902U);
+	}
+
+	void test_idct_add() {
+		TS_ASSERT_EQUALS(testOp(kOpAdd), 2745200U);
+	}
+
+	void test_residue() {
+		TS_ASSERT_EQUALS(testOp(kOpResidue), 1377471608U);
+	}
+};
+
+#endif
@@ -0,0 +1,442 @@
+#include <cxxtest/TestSuite.h>
+
+#include "audio/mixer_intern.h"
+#include "common/array.h"
+#include "common/memstream.h"
+#include "video/avi_decoder.h"
+#include "video/qt_decoder.h"
+#include "video/smk_decoder.h"
+
+#include "../common/testsystem.h"
+
+/**
+ * Seeks in small generated AVI, QuickTime and Smacker files. They hold 12
+ * frames at 10 fps, a keyframe every 4 frames, and 16 bit mono audio at
+ * 8000 Hz, in which each sample holds its own position. So the first
+ * sample mixed after seeking tells where the audio restarted.
+ */
+class VideoSeekTestSuite : public CxxTest::TestSuite
+{
+	enum {
+		kFrameCount = 12,
+		kFrameRate = 10,
+		kKeyFrameInterval = 4,
+		kSampleRate = 8000,
+		kSamplesPerFrame = kSampleRate / kFrameRate,
+		kWidth = 4,
+		kHeight = 4
+	};
+
+	/** Plays the audio of the decoders into a mixer of the same rate. */
+	class MixerSystem : public TestSystem {
+	public:
+		MixerSystem() : _mixer(this, kSampleRate) {
+			_mixer.setReady(true);
+		}
+
+		Audio::Mixer *getMixer() { return &_mixer; }
+
+		/** Mix some audio and return the first sample. */
+		int16 mixFirstSample() {
+			int16 buffer[64 * 2];
+			_mixer.mixCallback((byte *)buffer, sizeof(buffer));
+			return buffer[0];
+		}
+
+	private:
+		Audio::MixerImpl _mixer;
+	};
+
+	/** Builds a file in memory, patching the sizes of nested chunks. */
+	class Writer {
+	public:
+		void writeByte(byte value) { _data.push_back(value); }
+		void writeUint16LE(uint16 value) { writeByte(value & 0xFF); writeByte(value >> 8); }
+		void writeUint16BE(uint16 value) { writeByte(value >> 8); writeByte(value & 0xFF); }
+		void writeUint32LE(uint32 value) { writeUint16LE(value & 0xFFFF); writeUint16LE(value >> 16); }
+		void writeUint32BE(uint32 value) { writeUint16BE(value >> 16); writeUint16BE(value & 0xFFFF); }
+		void writeTag(uint32 tag) { writeUint32BE(tag); }
+		void writeZeros(uint32 count) { while (count--) writeByte(0); }
+
+		/** Write samples counting up from the given position. */
+		void writeSamples(uint32 start, uint32 count, bool bigEndian) {
+			for (uint32 i = start; i < start + count; i++) {
+				if (bigEndian)
+					writeUint16BE(i);
+				else
+					writeUint16LE(i);
+			}
+		}
+
+		uint32 pos() const { return _data.size(); }
+
+		/** Start a RIFF chunk, whose size excludes its header. */
+		void beginRIFF(uint32 tag) { writeTag(tag); _chunks.push_back(pos()); writeUint32LE(0); }
+		void endRIFF() { patch(_chunks.back(), pos() - _chunks.back() - 4, false); _chunks.pop_back(); }
+
+		/** Start a QuickTime atom, whose size includes its header. */
+		void beginAtom(uint32 tag) { _chunks.push_back(pos()); writeUint32BE(0); writeTag(tag); }
+		void endAtom() { patch(_chunks.back(), pos() - _chunks.back(), true); _chunks.pop_back(); }
+
+		void patch(uint32 offset, uint32 value, bool bigEndian) {
+			for (int i = 0; i < 4; i++)
+				_data[offset + i] = bigEndian ? (value >> (24 - i * 8)) & 0xFF : (value >> (i * 8)) & 0xFF;
+		}
+
+		Common::SeekableReadStream *createStream() const {
+			byte *data = (byte *)malloc(_data.size());
+			memcpy(data, _data.begin(), _data.size());
+			return new Common::MemoryReadStream(data, _data.size(), DisposeAfterUse::YES);
+		}
+
+	private:
+		Common::Array<byte> _data;
+		Common::Array<uint32> _chunks;
+	};
+
+	static bool isKeyFrame(uint frame) {
+		return frame % kKeyFrameInterval == 0;
+	}
+
+	/** Uncompressed 24 bit frames, and one audio chunk per frame. */
+	static Common::SeekableReadStream *createAVI() {
+		Writer w;
+		w.beginRIFF(MKTAG('R', 'I', 'F', 'F'));
+		w.writeTag(MKTAG('A', 'V', 'I', ' '));
+
+		w.beginRIFF(MKTAG('L', 'I', 'S', 'T'));
+		w.writeTag(MKTAG('h', 'd', 'r', 'l'));
+		w.beginRIFF(MKTAG('a', 'v', 'i', 'h'));
+		w.writeUint32LE(1000000 / kFrameRate);
+		w.writeZeros(8);
+		w.writeUint32LE(0x10); // Has an index
+		w.writeUint32LE(kFrameCount);
+		w.writeUint32LE(0);
+		w.writeUint32LE(2);
+		w.writeUint32LE(0);
+		w.writeUint32LE(kWidth);
+		w.writeUint32LE(kHeight);
+		w.writeZeros(16);
+		w.endRIFF();
+
+		w.beginRIFF(MKTAG('L', 'I', 'S', 'T'));
+		w.writeTag(MKTAG('s', 't', 'r', 'l'));
+		w.beginRIFF(MKTAG('s', 't', 'r', 'h'));
+		w.writeTag(MKTAG('v', 'i', 'd', 's'));
+		w.writeZeros(16);
+		w.writeUint32LE(1);
+		w.writeUint32LE(kFrameRate);
+		w.writeUint32LE(0);
+		w.writeUint32LE(kFrameCount);
+		w.writeZeros(20);
+		w.endRIFF();
+		w.beginRIFF(MKTAG('s', 't', 'r', 'f'));
+		w.writeUint32LE(40);
+		w.writeUint32LE(kWidth);
+		w.writeUint32LE(kHeight);
+		w.writeUint16LE(1);
+		w.writeUint16LE(24);
+		w.writeUint32LE(0); // Uncompressed
+		w.writeUint32LE(kWidth * kHeight * 3);
+		w.writeZeros(16);
+		w.endRIFF();
+		w.endRIFF();
+
+		w.beginRIFF(MKTAG('L', 'I', 'S', 'T'));
+		w.writeTag(MKTAG('s', 't', 'r', 'l'));
+		w.beginRIFF(MKTAG('s', 't', 'r', 'h'));
+		w.writeTag(MKTAG('a', 'u', 'd', 's'));
+		w.writeZeros(16);
+		w.writeUint32LE(1);
+		w.writeUint32LE(kSampleRate);
+		w.writeUint32LE(0);
+		w.writeUint32LE(kFrameCount * kSamplesPerFrame);
+		w.writeZeros(8);
+		w.writeUint32LE(2);
+		w.writeZeros(8);
+		w.endRIFF();
+		w.beginRIFF(MKTAG('s', 't', 'r', 'f'));
+		w.writeUint16LE(1); // PCM
+		w.writeUint16LE(1);
+		w.writeUint32LE(kSampleRate);
+		w.writeUint32LE(kSampleRate * 2);
+		w.writeUint16LE(2);
+		w.writeUint16LE(16);
+		w.endRIFF();
+		w.endRIFF();
+		w.endRIFF();
+
+		w.beginRIFF(MKTAG('L', 'I', 'S', 'T'));
+		w.writeTag(MKTAG('m', 'o', 'v', 'i'));
+		Common::Array<uint32> offsets;
+		for (uint i = 0; i < kFrameCount; i++) {
+			offsets.push_back(w.pos());
+			w.beginRIFF(MKTAG('0', '0', 'd', 'c'));
+			w.writeZeros(kWidth * kHeight * 3);
+			w.endRIFF();
+
+			offsets.push_back(w.pos());
+			w.beginRIFF(MKTAG('0', '1', 'w', 'b'));
+			w.writeSamples(i * kSamplesPerFrame, kSamplesPerFrame, false);
+			w.endRIFF();
+		}
+		w.endRIFF();
+
+		// With absolute offsets
+		w.beginRIFF(MKTAG('i', 'd', 'x', '1'));
+		for (uint i = 0; i < kFrameCount; i++) {
+			w.writeTag(MKTAG('0', '0', 'd', 'c'));
+			w.writeUint32LE(isKeyFrame(i) ? 0x10 : 0);
+			w.writeUint32LE(offsets[i * 2]);
+			w.writeUint32LE(kWidth * kHeight * 3);
+
+			w.writeTag(MKTAG('0', '1', 'w', 'b'));
+			w.writeUint32LE(0x10);
+			w.writeUint32LE(offsets[i * 2 + 1]);
+			w.writeUint32LE(kSamplesPerFrame * 2);
+		}
+		w.endRIFF();
+
+		w.endRIFF();
+		return w.createStream();
+	}
+
+	static void writeQuickTimeTrack(Writer &w, bool video, uint32 timeScale, uint32 sampleCount, uint32 sampleDuration, uint32 sampleSize, uint32 samplesPerChunk, const Common::Array<uint32> &chunkOffsets) {
+		w.beginAtom(MKTAG('t', 'r', 'a', 'k'));
+
+		w.beginAtom(MKTAG('t', 'k', 'h', 'd'));
+		w.writeZeros(12);
+		w.writeUint32BE(video ? 1 : 2);
+		w.writeUint32BE(0);
+		w.writeUint32BE(kFrameCount * 60); // In the movie time scale
+		w.writeZeros(16);
+		w.writeUint32BE(0x10000);
+		w.writeZeros(12);
+		w.writeUint32BE(0x10000);
+		w.writeZeros(16);
+		w.writeUint32BE(kWidth << 16);
+		w.writeUint32BE(kHeight << 16);
+		w.endAtom();
+
+		w.beginAtom(MKTAG('m', 'd', 'i', 'a'));
+		w.beginAtom(MKTAG('m', 'd', 'h', 'd'));
+		w.writeZeros(12);
+		w.writeUint32BE(timeScale);
+		w.writeUint32BE(sampleCount * sampleDuration);
+		w.writeZeros(4);
+		w.endAtom();
+
+		w.beginAtom(MKTAG('h', 'd', 'l', 'r'));
+		w.writeZeros(4);
+		w.writeTag(MKTAG('m', 'h', 'l', 'r'));
+		w.writeTag(video ? MKTAG('v', 'i', 'd', 'e') : MKTAG('s', 'o', 'u', 'n'));
+		w.writeZeros(12);
+		w.endAtom();
+
+		w.beginAtom(MKTAG('m', 'i', 'n', 'f'));
+		w.beginAtom(MKTAG('s', 't', 'b', 'l'));
+
+		w.beginAtom(MKTAG('s', 't', 's', 'd'));
+		w.writeZeros(4);
+		w.writeUint32BE(1);
+		w.beginAtom(video ? MKTAG('r', 'l', 'e', ' ') : MKTAG('t', 'w', 'o', 's'));
+		w.writeZeros(6);
+		w.writeUint16BE(1);
+		if (video) {
+			w.writeZeros(16);
+			w.writeUint16BE(kWidth);
+			w.writeUint16BE(kHeight);
+			w.writeZeros(14);
+			w.writeZeros(32);
+			w.writeUint16BE(24);
+			w.writeUint16BE(0xFFFF);
+		} else {
+			w.writeZeros(8);
+			w.writeUint16BE(1);
+			w.writeUint16BE(16);
+			w.writeZeros(4);
+			w.writeUint32BE(kSampleRate << 16);
+		}
+		w.endAtom();
+		w.endAtom();
+
+		w.beginAtom(MKTAG('s', 't', 't', 's'));
+		w.writeZeros(4);
+		w.writeUint32BE(1);
+		w.writeUint32BE(sampleCount);
+		w.writeUint32BE(sampleDuration);
+		w.endAtom();
+
+		if (video) {
+			w.beginAtom(MKTAG('s', 't', 's', 's'));
+			w.writeZeros(4);
+			w.writeUint32BE((kFrameCount + kKeyFrameInterval - 1) / kKeyFrameInterval);
+			for (uint i = 0; i < kFrameCount; i += kKeyFrameInterval)
+				w.writeUint32BE(i + 1);
+			w.endAtom();
+		}
+
+		w.beginAtom(MKTAG('s', 't', 's', 'c'));
+		w.writeZeros(4);
+		w.writeUint32BE(1);
+		w.writeUint32BE(1);
+		w.writeUint32BE(samplesPerChunk);
+		w.writeUint32BE(1);
+		w.endAtom();
+
+		w.beginAtom(MKTAG('s', 't', 's', 'z'));
+		w.writeZeros(4);
+		w.writeUint32BE(sampleSize);
+		w.writeUint32BE(sampleCount);
+		w.endAtom();
+
+		w.beginAtom(MKTAG('s', 't', 'c', 'o'));
+		w.writeZeros(4);
+		w.writeUint32BE(chunkOffsets.size());
+		for (uint i = 0; i < chunkOffsets.size(); i++)
+			w.writeUint32BE(chunkOffsets[i]);
+		w.endAtom();
+
+		w.endAtom();
+		w.endAtom();
+		w.endAtom();
+		w.endAtom();
+	}
+
+	/**
+	 * QuickTime RLE frames too short to change the picture, and one chunk
+	 * of audio per frame.
+	 */
+	static Common::SeekableReadStream *createQuickTime() {
+		Writer w;
+		Common::Array<uint32> videoOffsets, audioOffsets;
+
+		w.beginAtom(MKTAG('m', 'd', 'a', 't'));
+		for (uint i = 0; i < kFrameCount; i++) {
+			videoOffsets.push_back(w.pos());
+			w.writeUint32BE(4);
+
+			audioOffsets.push_back(w.pos());
+			w.writeSamples(i * kSamplesPerFrame, kSamplesPerFrame, true);
+		}
+		w.endAtom();
+
+		w.beginAtom(MKTAG('m', 'o', 'o', 'v'));
+		w.beginAtom(MKTAG('m', 'v', 'h', 'd'));
+		w.writeZeros(12);
+		w.writeUint32BE(600);
+		w.writeUint32BE(kFrameCount * 60);
+		w.writeZeros(16);
+		w.writeUint32BE(0x10000);
+		w.writeZeros(12);
+		w.writeUint32BE(0x10000);
+		w.writeZeros(44);
+		w.endAtom();
+
+		writeQuickTimeTrack(w, true, 600, kFrameCount, 600 / kFrameRate, 4, 1, videoOffsets);
+		writeQuickTimeTrack(w, false, kSampleRate, kFrameCount * kSamplesPerFrame, 1, 1, kSamplesPerFrame, audioOffsets);
+		w.endAtom();
+
+		return w.createStream();
+	}
+
+	/**
+	 * Smacker frames without video data, and uncompressed audio with a
+	 * lead of 2 frames: the first frame holds the audio of 3 frames, and
+	 * the last 2 frames hold none.
+	 */
+	static Common::SeekableReadStream *createSmacker() {
+		enum {
+			kLead = 2
+		};
+
+		Writer w;
+		w.writeTag(MKTAG('S', 'M', 'K', '2'));
+		w.writeUint32LE(kWidth);
+		w.writeUint32LE(kHeight);
+		w.writeUint32LE(kFrameCount);
+		w.writeUint32LE(1000 / kFrameRate);
+		w.writeUint32LE(0);
+		w.writeZeros(7 * 4);
+		w.writeUint32LE(4); // Trees size
+		w.writeZeros(4 * 4);
+		w.writeUint32LE(0x60000000 | kSampleRate); // 16 bit audio present
+		w.writeZeros(6 * 4);
+		w.writeUint32LE(0);
+
+		uint32 audioSamples[kFrameCount];
+		for (uint i = 0; i < kFrameCount; i++) {
+			if (i == 0)
+				audioSamples[i] = (kLead + 1) * kSamplesPerFrame;
+			else if (i < kFrameCount - kLead)
+				audioSamples[i] = kSamplesPerFrame;
+			else
+				audioSamples[i] = 0;
+		}
+
+		for (uint i = 0; i < kFrameCount; i++)
+			w.writeUint32LE((audioSamples[i] ? 4 + audioSamples[i] * 2 : 0) | (isKeyFrame(i) ? 1 : 0));
+		for (uint i = 0; i < kFrameCount; i++)
+			w.writeByte(audioSamples[i] ? 2 : 0);
+
+		// Empty trees
+		w.writeZeros(4);
+
+		uint32 sample = 0;
+		for (uint i = 0; i < kFrameCount; i++) {
+			if (!audioSamples[i])
+				continue;
+
+			w.writeUint32LE(4 + audioSamples[i] * 2);
+			w.writeSamples(sample, audioSamples[i], true);
+			sample += audioSamples[i];
+		}
+
+		return w.createStream();
+	}
+
+	/**
+	 * Seek to the time of the frame, and check that it is shown next with the audio
+	 * starting at its time.
+	 */
+	static void checkSeek(MixerSystem &system, Video::VideoDecoder &decoder, uint frame) {
+		TS_ASSERT(decoder.seek(Audio::Timestamp(0, frame, kFrameRate)));
+		TS_ASSERT(decoder.decodeNextFrame());
+		TS_ASSERT_EQUALS(decoder.getCurFrame(), (int)frame);
+		TS_ASSERT_EQUALS(system.mixFirstSample(), (int16)(frame * kSamplesPerFrame));
+	}
+
+	static void testSeek(MixerSystem &system, Video::VideoDecoder &decoder, Common::SeekableReadStream *stream) {
+		TS_ASSERT(decoder.loadStream(stream));
+		TS_ASSERT(decoder.isSeekable());
+		TS_ASSERT_EQUALS(decoder.getFrameCount(), (int)kFrameCount);
+		decoder.start();
+
+		// A keyframe, frames after one, and back to the start
+		checkSeek(system, decoder, kKeyFrameInterval);
+		checkSeek(system, decoder, kKeyFrameInterval * 2 + 3);
+		checkSeek(system, decoder, 1);
+		checkSeek(system, decoder, 0);
+
+		decoder.close();
+	}
+
+public:
+	void test_avi() {
+		MixerSystem system;
+		Video::AVIDecoder decoder;
+		testSeek(system, decoder, createAVI());
+	}
+
+	void test_quicktime() {
+		MixerSystem system;
+		Video::QuickTimeDecoder decoder;
+		testSeek(system, decoder, createQuickTime());
+	}
+
+	void test_smacker() {
+		MixerSystem system;
+		Video::SmackerDecoder decoder;
+		testSeek(system, decoder, createSmacker());
+	}
+};
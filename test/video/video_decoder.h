@@ -0,0 +1,201 @@
+#include <cxxtest/TestSuite.h>
+
+#include "graphics/surface.h"
+#include "graphics/yuv_to_rgb.h"
+#include "video/video_decoder.h"
+
+#include "../common/testsystem.h"
+
+class VideoDecoderTestSuite : public CxxTest::TestSuite
+{
+	enum {
+		kFrameCount = 50
+	};
+
+	/** A video with frames filled with their number. */
+	class CountingDecoder : public Video::VideoDecoder {
+		class CountingTrack : public FixedRateVideoTrack {
+		public:
+			CountingTrack() : _curFrame(-1), _yuvOutput(false) {
+				_surface.create(16, 8, Graphics::PixelFormat::createFormatCLUT8());
+
+				memset(_planes, 0, sizeof(_planes));
+				_yuvFrame.y = _planes;
+				_yuvFrame.u = _planes + 16 * 8;
+				_yuvFrame.v = _planes + 16 * 8;
+				_yuvFrame.width = 16;
+				_yuvFrame.height = 8;
+				_yuvFrame.yPitch = 16;
+				_yuvFrame.uvPitch = 8;
+				_yuvFrame.scale = Graphics::YUVToRGBManager::kScaleFull;
+			}
+
+			~CountingTrack() {
+				_surface.free();
+			}
+
+			bool endOfTrack() const { return _curFrame + 1 >= kFrameCount; }
+			bool isSeekable() const { return true; }
+
+			bool seek(const Audio::Timestamp &time) {
+				_curFrame = (int)getFrameAtTime(time) - 1;
+				return true;
+			}
+
+			uint16 getWidth() const { return _surface.w; }
+			uint16 getHeight() const { return _surface.h; }
+			Graphics::PixelFormat getPixelFormat() const { return _surface.format; }
+			int getCurFrame() const { return _curFrame; }
+			int getFrameCount() const { return kFrameCount; }
+
+			const Graphics::Surface *decodeNextFrame() {
+				++_curFrame;
+				if (_yuvOutput)
+					memset(_planes, _curFrame, 16 * 8);
+				else
+					_surface.fillRect(Common::Rect(_surface.w, _surface.h), _curFrame);
+				return &_surface;
+			}
+
+			bool canOutputYUV() const { return true; }
+			void setYUVOutput(bool yuvOutput) { _yuvOutput = yuvOutput; }
+			const Graphics::YUV420Frame *getYUVFrame() const { return _yuvOutput ? &_yuvFrame : 0; }
+
+		protected:
+			Common::Rational getFrameRate() const { return 10; }
+
+		private:
+			Graphics::Surface _surface;
+			int _curFrame;
+
+			bool _yuvOutput;
+			byte _planes[16 * 8 + 8 * 4];
+			Graphics::YUV420Frame _yuvFrame;
+		};
+
+	public:
+		bool loadStream(Common::SeekableReadStream *stream) {
+			addTrack(new CountingTrack());
+			return true;
+		}
+	};
+
+	/** A screen of 320x200, which records the frames copied to it. */
+	class ScreenSystem : public TestSystem {
+	public:
+		explicit ScreenSystem(bool yuvFrames) : yuvCopies(0), rectCopies(0), lastValue(0), lastWidth(0), _yuvFrames(yuvFrames) {}
+
+		bool hasFeature(Feature f) { return f == kFeatureYUVFrames && _yuvFrames; }
+		int16 getHeight() { return 200; }
+		int16 getWidth() { return 320; }
+
+		void copyRectToScreen(const void *buf, int pitch, int x, int y, int w, int h) {
+			++rectCopies;
+			lastValue = *(const byte *)buf;
+			lastWidth = w;
+		}
+
+		void copyYUVFrameToScreen(const Graphics::YUV420Frame &frame, int x, int y) {
+			++yuvCopies;
+			lastValue = frame.y[0];
+			lastWidth = frame.width;
+		}
+
+		int yuvCopies;
+		int rectCopies;
+		byte lastValue;
+		int lastWidth;
+
+	private:
+		const bool _yuvFrames;
+	};
+
+	/** Check that the next frame has the given number, as far as the caller can tell. */
+	static bool checkNextFrame(CountingDecoder &decoder, int frame) {
+		const Graphics::Surface *surface = decoder.decodeNextFrame();
+		return surface && *(const byte *)surface->getBasePtr(15, 7) == frame &&
+		       decoder.getCurFrame() == frame &&
+		       decoder.endOfVideo() == (frame + 1 == kFrameCount);
+	}
+
+public:
+	void test_decode_ahead() {
+		TestSystem testSystem;
+		CountingDecoder decoder;
+		decoder.loadStream(0);
+
+		TS_ASSERT(decoder.setDecodeAhead(4));
+		TS_ASSERT_EQUALS(decoder.getDecodeAhead(), 4U);
+		TS_ASSERT(!decoder.setDecodeAhead(Video::VideoDecoder::kMaxDecodeAheadFrames + 1));
+
+		for (int i = 0; i < 20; ++i)
+			TS_ASSERT(checkNextFrame(decoder, i));
+
+		// Seeking drops the frames decoded ahead
+		TS_ASSERT(decoder.seekToFrame(40));
+		for (int i = 40; i < kFrameCount; ++i)
+			TS_ASSERT(checkNextFrame(decoder, i));
+		TS_ASSERT(decoder.endOfVideo());
+
+		TS_ASSERT(decoder.seekToFrame(5));
+		TS_ASSERT(checkNextFrame(decoder, 5));
+		TS_ASSERT(checkNextFrame(decoder, 6));
+
+		// The frames decoded ahead are still returned after turning it off,
+		// up to the first call which finds none left
+		TS_ASSERT(decoder.setDecodeAhead(0));
+		TS_ASSERT_EQUALS(decoder.getDecodeAhead(), 0U);
+		int frame = 7;
+		while (!decoder.setDecodeAhead(2))
+			TS_ASSERT(checkNextFrame(decoder, frame++));
+		TS_ASSERT_LESS_THAN_EQUALS(frame, 7 + 5);
+
+		// Turn it off and seek, which drops the frames decoded ahead
+		TS_ASSERT(decoder.setDecodeAhead(0));
+		TS_ASSERT(decoder.seekToFrame(30));
+		TS_ASSERT(!decoder.setDecodeAhead(3));
+		TS_ASSERT(checkNextFrame(decoder, 30));
+		TS_ASSERT(decoder.setDecodeAhead(3));
+		for (int i = 31; i < kFrameCount; ++i)
+			TS_ASSERT(checkNextFrame(decoder, i));
+	}
+
+	void test_no_threads() {
+		TestSystem testSystem(false);
+		CountingDecoder decoder;
+		decoder.loadStream(0);
+
+		// Without threads, each frame is decoded when it is asked for
+		TS_ASSERT(!decoder.setDecodeAhead(4));
+		TS_ASSERT_EQUALS(decoder.getDecodeAhead(), 0U);
+		for (int i = 0; i < kFrameCount; ++i)
+			TS_ASSERT(checkNextFrame(decoder, i));
+	}
+
+	void test_copy_frame_to_screen() {
+		ScreenSystem rgbSystem(false);
+		CountingDecoder rgbDecoder;
+		rgbDecoder.loadStream(0);
+
+		// Without backend support, the frames are converted
+		TS_ASSERT(!rgbDecoder.setYUVOutputForScreen());
+		rgbDecoder.decodeNextFrame();
+		rgbDecoder.copyFrameToScreen(rgbDecoder.decodeNextFrame(), 310, 0);
+		TS_ASSERT_EQUALS(rgbSystem.rectCopies, 1);
+		TS_ASSERT_EQUALS(rgbSystem.yuvCopies, 0);
+		TS_ASSERT_EQUALS(rgbSystem.lastValue, 1);
+		TS_ASSERT_EQUALS(rgbSystem.lastWidth, 10);
+
+		ScreenSystem yuvSystem(true);
+		CountingDecoder yuvDecoder;
+		yuvDecoder.loadStream(0);
+
+		TS_ASSERT(yuvDecoder.setYUVOutputForScreen());
+		yuvDecoder.decodeNextFrame();
+		yuvDecoder.copyFrameToScreen(yuvDecoder.decodeNextFrame(), 0, 0);
+		TS_ASSERT_EQUALS(yuvSystem.rectCopies, 0);
+		TS_ASSERT_EQUALS(yuvSystem.yuvCopies, 1);
+		TS_ASSERT_EQUALS(yuvSystem.lastValue, 1);
+		TS_ASSERT_EQUALS(yuvSystem.lastWidth, 16);
+	}
+};
@@ -380,6 +380,8 @@ bool AVIDecoder::loadStream(Common::SeekableReadStream *stream) {
 		return false;
 	}
 
+	_indexEntries.buildStreamIndex();
+
 	// Create the status entries
 	uint32 index = 0;
 	for (TrackListIterator it = getTrackListBegin(); it != getTrackListEnd(); it++, index++) {
@@ -409,6 +411,8 @@ bool AVIDecoder::loadStream(Common::SeekableReadStream *stream) {
 	if (_transparencyTrack.track)
 		eraseTrack(_transparencyTrack.track);
 
+	buildSeekIndex();
+
 	// Check if this is a special Duck Truemotion video
 	checkTruemotion1();
 
@@ -426,6 +430,9 @@ void AVIDecoder::close() {
 	_movieListEnd = 0;
 
 	_indexEntries.clear();
+	_videoFrameEntries.clear();
+	_paletteEntries.clear();
+	_keyFrames.clear();
 	memset(&_header, 0, sizeof(_header));
 
 	_videoTracks.clear();
@@ -598,7 +605,6 @@ bool AVIDecoder::seekIntern(const Audio::Timestamp &time) {
 
 	// Get our video
 	AVIVideoTrack *videoTrack = (AVIVideoTrack *)_videoTracks[0].track;
-	uint32 videoIndex = _videoTracks[0].index;
 
 	if (time == getDuration()) {
 		videoTrack->setCurFrame(videoTrack->getFrameCount() - 1);
@@ -618,58 +624,30 @@ bool AVIDecoder::seekIntern(const Audio::Timestamp &time) {
 		frame = videoTrack->getFrameAtTime(time);
 	}
 
-	// Reset any palette, if necessary
-	videoTrack->useInitialPalette();
-
-	int lastKeyFrame = -1;
-	int frameIndex = -1;
-	uint curFrame = 0;
-
-	// Go through and figure out where we should be
-	// If there's a palette, we need to find the palette too
-	for (uint32 i = 0; i < _indexEntries.size(); i++) {
-		const OldIndex &index = _indexEntries[i];
+	if (frame >= _videoFrameEntries.size()) // This shouldn't happen.
+		return false;
 
-		// We don't care about RECs
-		if (index.id == ID_REC)
-			continue;
+	const uint32 frameIndex = _videoFrameEntries[frame];
+	const uint32 keyFrame = findKeyFrame(frame);
 
-		// We're only looking at entries for this track
-		if (getStreamIndex(index.id) != videoIndex)
-			continue;
-
-		uint16 streamType = getStreamType(index.id);
+	// Reset any palette, if necessary
+	videoTrack->useInitialPalette();
 
-		if (streamType == kStreamTypePaletteChange) {
-			// We need to handle any palette change we see since there's no
-			// flag to tell if this is a "key" palette.
-			// Decode the palette
-			_fileStream->seek(_indexEntries[i].offset + 8);
-			Common::SeekableReadStream *chunk = 0;
+	// We need to handle any palette change before the frame since there's
+	// no flag to tell if this is a "key" palette.
+	for (uint32 i = 0; i < _paletteEntries.size() && _paletteEntries[i] < frameIndex; i++) {
+		const OldIndex &index = _indexEntries[_paletteEntries[i]];
 
-			if (_indexEntries[i].size != 0)
-				chunk = _fileStream->readStream(_indexEntries[i].size);
+		// Decode the palette
+		_fileStream->seek(index.offset + 8);
+		Common::SeekableReadStream *chunk = 0;
 
-			videoTrack->loadPaletteFromChunk(chunk);
-		} else {
-			// Check to see if this is a keyframe
-			// The first frame has to be a keyframe
-			if ((_indexEntries[i].flags & AVIIF_INDEX) || curFrame == 0)
-				lastKeyFrame = i;
-
-			// Did we find the target frame?
-			if (frame == curFrame) {
-				frameIndex = i;
-				break;
-			}
+		if (index.size != 0)
+			chunk = _fileStream->readStream(index.size);
 
-			curFrame++;
-		}
+		videoTrack->loadPaletteFromChunk(chunk);
 	}
 
-	if (frameIndex < 0) // This shouldn't happen.
-		return false;
-
 	// Update all the audio tracks
 	for (uint32 i = 0; i < _audioTracks.size(); i++) {
 		AVIAudioTrack *audioTrack = (AVIAudioTrack *)_audioTracks[i].track;
@@ -680,51 +658,28 @@ bool AVIDecoder::seekIntern(const Audio::Timestamp &time) {
 		// Set the chunk index for the track
 		audioTrack->setCurChunk(frame);
 
-		uint32 chunksFound = 0;
-		for (uint32 j = 0; j < _indexEntries.size(); j++) {
+		const int j = _indexEntries.findPosition(_audioTracks[i].index, frame);
+		if (j >= 0) {
 			const OldIndex &index = _indexEntries[j];
-
-			// Continue ignoring RECs
-			if (index.id == ID_REC)
-				continue;
-
-			if (getStreamIndex(index.id) == _audioTracks[i].index) {
-				if (chunksFound == frame) {
-					_fileStream->seek(index.offset + 8);
-					Common::SeekableReadStream *audioChunk = _fileStream->readStream(index.size);
-					audioTrack->queueSound(audioChunk);
-					_audioTracks[i].chunkSearchOffset = (j == _indexEntries.size() - 1) ? _movieListEnd : _indexEntries[j + 1].offset;
-					break;
-				}
-
-				chunksFound++;
-			}
+			_fileStream->seek(index.offset + 8);
+			Common::SeekableReadStream *audioChunk = _fileStream->readStream(index.size);
+			audioTrack->queueSound(audioChunk);
+			_audioTracks[i].chunkSearchOffset = ((uint32)j == _indexEntries.size() - 1) ? _movieListEnd : _indexEntries[j + 1].offset;
 		}
 
 		// Skip any audio to bring us to the right time
 		audioTrack->skipAudio(time, videoTrack->getFrameTime(frame));
 	}
 
-	// Decode from keyFrame to curFrame - 1
-	for (int i = lastKeyFrame; i < frameIndex; i++) {
-		if (_indexEntries[i].id == ID_REC)
-			continue;
-
-		if (getStreamIndex(_indexEntries[i].id) != videoIndex)
-			continue;
-
-		uint16 streamType = getStreamType(_indexEntries[i].id);
-
-		// Ignore palettes, they were already handled
-		if (streamType == kStreamTypePaletteChange)
-			continue;
+	// Decode from keyFrame to frame - 1
+	for (uint32 i = keyFrame; i < frame; i++) {
+		const OldIndex &index = _indexEntries[_videoFrameEntries[i]];
 
-		// Frame, hopefully
-		_fileStream->seek(_indexEntries[i].offset + 8);
+		_fileStream->seek(index.offset + 8);
 		Common::SeekableReadStream *chunk = 0;
 
-		if (_indexEntries[i].size != 0)
-			chunk = _fileStream->readStream(_indexEntries[i].size);
+		if (index.size != 0)
+			chunk = _fileStream->readStream(index.size);
 
 		videoTrack->decodeFrame(chunk);
 	}
@@ -741,6 +696,44 @@ bool AVIDecoder::seekIntern(const Audio::Timestamp &time) {
 	return true;
 }
 
+void AVIDecoder::buildSeekIndex() {
+	if (_videoTracks.empty())
+		return;
+
+	const Common::Array<uint32> &entries = _indexEntries.getStreamEntries(_videoTracks[0].index);
+
+	for (uint32 i = 0; i < entries.size(); i++) {
+		const OldIndex &index = _indexEntries[entries[i]];
+
+		if (getStreamType(index.id) == kStreamTypePaletteChange) {
+			_paletteEntries.push_back(entries[i]);
+			continue;
+		}
+
+		// The first frame has to be a keyframe
+		if ((index.flags & AVIIF_INDEX) || _videoFrameEntries.empty())
+			_keyFrames.push_back(_videoFrameEntries.size());
+
+		_videoFrameEntries.push_back(entries[i]);
+	}
+}
+
+uint32 AVIDecoder::findKeyFrame(uint32 frame) const {
+	// The first frame is always in the list
+	uint32 low = 0, high = _keyFrames.size();
+
+	while (high - low > 1) {
+		const uint32 mid = (low + high) / 2;
+
+		if (_keyFrames[mid] <= frame)
+			low = mid;
+		else
+			high = mid;
+	}
+
+	return _keyFrames[low];
+}
+
 void AVIDecoder::seekTransparencyFrame(int frame) {
 	TrackStatus &status = _transparencyTrack;
 	AVIVideoTrack *transTrack = static_cast<AVIVideoTrack *>(status.track);
@@ -872,6 +865,7 @@ AVIDecoder::AVIVideoTrack::AVIVideoTrack(int frameCount, const AVIStreamHeader &
 		: _frameCount(frameCount), _vidsHeader(streamHeader), _bmInfo(bitmapInfoHeader), _initialPalette(initialPalette) {
 	_videoCodec = createCodec();
 	_lastFrame = 0;
+	_emptyFrame = false;
 	_curFrame = -1;
 	_reversed = false;
 
@@ -887,9 +881,11 @@ void AVIDecoder::AVIVideoTrack::decodeFrame(Common::SeekableReadStream *stream)
 	if (stream) {
 		if (_videoCodec)
 			_lastFrame = _videoCodec->decodeFrame(*stream);
+		_emptyFrame = false;
 	} else {
 		// Empty frame
 		_lastFrame = 0;
+		_emptyFrame = true;
 	}
 
 	delete stream;
@@ -955,6 +951,7 @@ bool AVIDecoder::AVIVideoTrack::rewind() {
 	delete _videoCodec;
 	_videoCodec = createCodec();
 	_lastFrame = 0;
+	_emptyFrame = false;
 	return true;
 }
 
@@ -1007,6 +1004,22 @@ void AVIDecoder::AVIVideoTrack::setDither(const byte *palette) {
 	_videoCodec->setDither(Image::Codec::kDitherTypeVFW, palette);
 }
 
+const Common::List<Common::Rect> *AVIDecoder::AVIVideoTrack::getDirtyRects() const {
+	// In reverse, each frame is decoded starting from a key frame, so the
+	// codec's changes are not relative to the frame shown before
+	if (_reversed || !_videoCodec)
+		return 0;
+
+	// An empty chunk repeats the frame before it, so nothing changed. When
+	// the codec failed to decode the chunk, its changes are not known.
+	if (_emptyFrame)
+		return &_noDirtyRects;
+	if (!_lastFrame)
+		return 0;
+
+	return _videoCodec->getDirtyRects();
+}
+
 AVIDecoder::AVIAudioTrack::AVIAudioTrack(const AVIStreamHeader &streamHeader, const PCMWaveFormat &waveFormat, Audio::Mixer::SoundType soundType) :
 		AudioTrack(soundType),
 		_audsHeader(streamHeader),
@@ -1109,15 +1122,38 @@ AVIDecoder::TrackStatus::TrackStatus() : track(0), chunkSearchOffset(0) {
 }
 
 AVIDecoder::OldIndex *AVIDecoder::IndexEntries::find(uint index, uint frameNumber) {
-	for (uint idx = 0, frameCtr = 0; idx < size(); ++idx) {
-		if ((*this)[idx].id != ID_REC &&
-				AVIDecoder::getStreamIndex((*this)[idx].id) == index) {
-			if (frameCtr++ == frameNumber)
-				return &(*this)[idx];
-		}
+	const int position = findPosition(index, frameNumber);
+	return (position >= 0) ? &(*this)[position] : nullptr;
+}
+
+int AVIDecoder::IndexEntries::findPosition(uint index, uint frameNumber) const {
+	const Common::Array<uint32> &entries = getStreamEntries(index);
+	return (frameNumber < entries.size()) ? (int)entries[frameNumber] : -1;
+}
+
+void AVIDecoder::IndexEntries::buildStreamIndex() {
+	_streamEntries.clear();
+
+	for (uint idx = 0; idx < size(); ++idx) {
+		if ((*this)[idx].id == ID_REC)
+			continue;
+
+		const uint index = AVIDecoder::getStreamIndex((*this)[idx].id);
+		if (index >= _streamEntries.size())
+			_streamEntries.resize(index + 1);
+
+		_streamEntries[index].push_back(idx);
 	}
+}
+
+const Common::Array<uint32> &AVIDecoder::IndexEntries::getStreamEntries(uint index) const {
+	static const Common::Array<uint32> empty;
+	return (index < _streamEntries.size()) ? _streamEntries[index] : empty;
+}
 
-	return nullptr;
+void AVIDecoder::IndexEntries::clear() {
+	Common::Array<OldIndex>::clear();
+	_streamEntries.clear();
 }
 
 } // End of namespace Video
@@ -203,6 +203,7 @@ protected:
 		void useInitialPalette();
 		bool canDither() const;
 		void setDither(const byte *palette);
+		const Common::List<Common::Rect> *getDirtyRects() const;
 
 		bool isTruemotion1() const;
 		void forceDimensions(uint16 width, uint16 height);
@@ -253,6 +254,8 @@ protected:
 
 		Image::Codec *_videoCodec;
 		const Graphics::Surface *_lastFrame;
+		bool _emptyFrame;
+		Common::List<Common::Rect> _noDirtyRects;
 		Image::Codec *createCodec();
 	};
 
@@ -303,6 +306,27 @@ protected:
 	class IndexEntries : public Common::Array<OldIndex> {
 	public:
 		OldIndex *find(uint index, uint frameNumber);
+
+		/**
+		 * Find the position of the given chunk of a stream.
+		 *
+		 * @return the position in the index, or -1 if there's no such chunk
+		 */
+		int findPosition(uint index, uint frameNumber) const;
+
+		/**
+		 * Sort the positions of the entries by stream, for find(). This has
+		 * to be called once all entries have been added.
+		 */
+		void buildStreamIndex();
+
+		/** The positions of the entries of a stream, in file order. */
+		const Common::Array<uint32> &getStreamEntries(uint index) const;
+
+		void clear();
+
+	private:
+		Common::Array<Common::Array<uint32> > _streamEntries;
 	};
 
 	AVIHeader _header;
@@ -310,6 +334,18 @@ protected:
 	void readOldIndex(uint32 size);
 	IndexEntries _indexEntries;
 
+	/**
+	 * Lookup tables for seeking in the first video track, built from the
+	 * index when loading: the index positions of its frames and of its
+	 * palette changes, and which frames are keyframes.
+	 */
+	Common::Array<uint32> _videoFrameEntries;
+	Common::Array<uint32> _paletteEntries;
+	Common::Array<uint32> _keyFrames;
+
+	void buildSeekIndex();
+	uint32 findKeyFrame(uint32 frame) const;
+
 	Common::SeekableReadStream *_fileStream;
 	bool _decodedHeader;
 	bool _foundMovieList;
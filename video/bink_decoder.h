@@ -134,6 +134,8 @@ private:
 		uint32 size;
 
 		Common::BitStream32LELSB *bits;
+		/** The video packet, while it is decoded. */
+		const byte *data;
 
 		VideoFrame();
 		~VideoFrame();
@@ -158,9 +160,12 @@ private:
 		Common::Rational getFrameRate() const { return _frameRate; }
 
 	private:
+		struct BundleSet;
+
 		/** A decoder state. */
 		struct DecodeContext {
 			VideoFrame *video;
+			BundleSet *bundles;
 
 			uint32 planeIdx;
 
@@ -231,6 +236,34 @@ private:
 			byte *curPtr; ///< Pointer to the data that wasn't yet read.
 		};
 
+		/**
+		 * The bundles and the color nibble state. The Y plane and the
+		 * chroma planes each have their own set, as they may be decoded
+		 * at the same time.
+		 */
+		struct BundleSet {
+			Bundle bundles[kSourceMAX]; ///< Bundles for decoding all data types.
+
+			/** Huffman codebooks to use for decoding high nibbles in color data types. */
+			Huffman colHighHuffman[16];
+			/** Value of the last decoded high nibble in color data types. */
+			int colLastVal;
+		};
+
+		/** The chroma planes to decode on a thread. */
+		struct ChromaJob {
+			BinkVideoTrack *track;
+			VideoFrame *video;
+		};
+
+		/** How BIKi frames give the start of the chroma planes. */
+		enum ChromaOffset {
+			kChromaOffsetUnknown,  ///< Not checked yet
+			kChromaOffsetAbsolute, ///< From the start of the video packet
+			kChromaOffsetRelative, ///< From the start of the Y plane
+			kChromaOffsetNone      ///< Not usable, decode the planes in order
+		};
+
 		int _curFrame;
 		int _frameCount;
 
@@ -245,15 +278,11 @@ private:
 
 		Common::Rational _frameRate;
 
-		Bundle _bundles[kSourceMAX]; ///< Bundles for decoding all data types.
+		BundleSet _bundleSets[2]; ///< Bundles for the Y and the chroma planes.
+		ChromaOffset _chromaOffset;
 
 		Common::Huffman *_huffman[16]; ///< The 16 Huffman codebooks used in Bink decoding.
 
-		/** Huffman codebooks to use for decoding high nibbles in color data types. */
-		Huffman _colHighHuffman[16];
-		/** Value of the last decoded high nibble in color data types. */
-		int _colLastVal;
-
 		byte *_curPlanes[4]; ///< The 4 color planes, YUVA, current frame.
 		byte *_oldPlanes[4]; ///< The 4 color planes, YUVA, last frame.
 
@@ -266,10 +295,14 @@ private:
 		void initHuffman();
 
 		/** Decode a plane. */
-		void decodePlane(VideoFrame &video, int planeIdx, bool isChroma);
+		void decodePlane(VideoFrame &video, BundleSet &bundles, int planeIdx, bool isChroma);
+		/** Decode the two chroma planes. */
+		void decodeChroma(VideoFrame &video);
+		/** Decode the chroma planes of a BIKi frame on a thread, see decodePacket(). */
+		static void decodeChromaThread(void *param);
 
 		/** Read/Initialize a bundle for decoding a plane. */
-		void readBundle(VideoFrame &video, Source source);
+		void readBundle(VideoFrame &video, BundleSet &bundles, Source source);
 
 		/** Read the symbols for a Huffman code. */
 		void readHuffman(VideoFrame &video, Huffman &huffman);
@@ -280,7 +313,7 @@ private:
 		byte getHuffmanSymbol(VideoFrame &video, Huffman &huffman);
 
 		/** Get a direct value out of a bundle. */
-		int32 getBundleValue(Source source);
+		int32 getBundleValue(DecodeContext &ctx, Source source);
 		/** Read a count value out of a bundle. */
 		uint32 readBundleCount(VideoFrame &video, Bundle &bundle);
 
@@ -307,15 +340,10 @@ private:
 		void readMotionValues(VideoFrame &video, Bundle &bundle);
 		void readBlockTypes  (VideoFrame &video, Bundle &bundle);
 		void readPatterns    (VideoFrame &video, Bundle &bundle);
-		void readColors      (VideoFrame &video, Bundle &bundle);
+		void readColors      (VideoFrame &video, BundleSet &bundles);
 		void readDCS         (VideoFrame &video, Bundle &bundle, int startBits, bool hasSign);
 		void readDCTCoeffs   (VideoFrame &video, int16 *block, bool isIntra);
 		void readResidue     (VideoFrame &video, int16 *block, int masksCount);
-
-		// Bink video IDCT
-		void IDCT(int16 *block);
-		void IDCTPut(DecodeContext &ctx, int16 *block);
-		void IDCTAdd(DecodeContext &ctx, int16 *block);
 	};
 
 	class BinkAudioTrack : public AudioTrack {
@@ -0,0 +1,324 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+
+// Based on eos' Bink decoder which is in turn
+// based quite heavily on the Bink decoder found in FFmpeg.
+// Many thanks to Kostya Shishkov for doing the hard work.
+
+#include "common/scummsys.h"
+
+#ifdef USE_BINK
+
+#include "video/bink_dsp.h"
+
+#include "common/cpudetect.h"
+
+namespace Video {
+
+bool BinkDSP::isKernelSupported(Kernel kernel) {
+	switch (kernel) {
+	case kKernelC:
+		return true;
+
+#ifdef SCUMMVM_SSE2
+	case kKernelSSE2:
+		return Common::hasSSE2();
+#endif
+
+#ifdef SCUMMVM_AVX2
+	case kKernelAVX2:
+		return Common::hasAVX2();
+#endif
+
+	default:
+		return false;
+	}
+}
+
+static BinkDSP::Kernel s_kernel = BinkDSP::kKernelCount;
+
+bool BinkDSP::setKernel(Kernel kernel) {
+	if (!isKernelSupported(kernel))
+		return false;
+
+	s_kernel = kernel;
+	return true;
+}
+
+BinkDSP::Kernel BinkDSP::getKernel() {
+	if (s_kernel == kKernelCount) {
+		// Pick the last supported kernel, the list is ordered by preference.
+		for (int i = kKernelCount - 1; i >= kKernelC; --i) {
+			if (setKernel((Kernel)i))
+				break;
+		}
+	}
+
+	return s_kernel;
+}
+
+#define A1  2896 /* (1/sqrt(2))<<12 */
+#define A2  2217
+#define A3  3784
+#define A4 -5352
+
+#define IDCT_TRANSFORM(dest,s0,s1,s2,s3,s4,s5,s6,s7,d0,d1,d2,d3,d4,d5,d6,d7,munge,src) {\
+    const int a0 = (src)[s0] + (src)[s4]; \
+    const int a1 = (src)[s0] - (src)[s4]; \
+    const int a2 = (src)[s2] + (src)[s6]; \
+    const int a3 = (A1*((src)[s2] - (src)[s6])) >> 11; \
+    const int a4 = (src)[s5] + (src)[s3]; \
+    const int a5 = (src)[s5] - (src)[s3]; \
+    const int a6 = (src)[s1] + (src)[s7]; \
+    const int a7 = (src)[s1] - (src)[s7]; \
+    const int b0 = a4 + a6; \
+    const int b1 = (A3*(a5 + a7)) >> 11; \
+    const int b2 = ((A4*a5) >> 11) - b0 + b1; \
+    const int b3 = (A1*(a6 - a4) >> 11) - b2; \
+    const int b4 = ((A2*a7) >> 11) + b3 - b1; \
+    (dest)[d0] = munge(a0+a2   +b0); \
+    (dest)[d1] = munge(a1+a3-a2+b2); \
+    (dest)[d2] = munge(a1-a3+a2+b3); \
+    (dest)[d3] = munge(a0-a2   -b4); \
+    (dest)[d4] = munge(a0-a2   +b4); \
+    (dest)[d5] = munge(a1-a3+a2-b3); \
+    (dest)[d6] = munge(a1+a3-a2-b2); \
+    (dest)[d7] = munge(a0+a2   -b0); \
+}
+/* end IDCT_TRANSFORM macro */
+
+#define MUNGE_NONE(x) (x)
+#define IDCT_COL(dest,src) IDCT_TRANSFORM(dest,0,8,16,24,32,40,48,56,0,8,16,24,32,40,48,56,MUNGE_NONE,src)
+
+#define MUNGE_ROW(x) (((x) + 0x7F)>>8)
+#define IDCT_ROW(dest,src) IDCT_TRANSFORM(dest,0,1,2,3,4,5,6,7,0,1,2,3,4,5,6,7,MUNGE_ROW,src)
+
+static inline void IDCTCol(int16 *dest, const int16 *src) {
+	if ((src[8] | src[16] | src[24] | src[32] | src[40] | src[48] | src[56]) == 0) {
+		dest[ 0] =
+		dest[ 8] =
+		dest[16] =
+		dest[24] =
+		dest[32] =
+		dest[40] =
+		dest[48] =
+		dest[56] = src[0];
+	} else {
+		IDCT_COL(dest, src);
+	}
+}
+
+#ifdef SCUMMVM_AVX2
+
+/** One pass of IDCT_TRANSFORM, on 8 columns at once. */
+TARGET_ATTR("avx2")
+static inline void IDCTTransformAVX2(const __m256i *s, __m256i *d) {
+	const __m256i a0 = _mm256_add_epi32(s[0], s[4]);
+	const __m256i a1 = _mm256_sub_epi32(s[0], s[4]);
+	const __m256i a2 = _mm256_add_epi32(s[2], s[6]);
+	const __m256i a3 = _mm256_srai_epi32(_mm256_mullo_epi32(_mm256_set1_epi32(A1), _mm256_sub_epi32(s[2], s[6])), 11);
+	const __m256i a4 = _mm256_add_epi32(s[5], s[3]);
+	const __m256i a5 = _mm256_sub_epi32(s[5], s[3]);
+	const __m256i a6 = _mm256_add_epi32(s[1], s[7]);
+	const __m256i a7 = _mm256_sub_epi32(s[1], s[7]);
+	const __m256i b0 = _mm256_add_epi32(a4, a6);
+	const __m256i b1 = _mm256_srai_epi32(_mm256_mullo_epi32(_mm256_set1_epi32(A3), _mm256_add_epi32(a5, a7)), 11);
+	const __m256i b2 = _mm256_add_epi32(_mm256_sub_epi32(_mm256_srai_epi32(_mm256_mullo_epi32(_mm256_set1_epi32(A4), a5), 11), b0), b1);
+	const __m256i b3 = _mm256_sub_epi32(_mm256_srai_epi32(_mm256_mullo_epi32(_mm256_set1_epi32(A1), _mm256_sub_epi32(a6, a4)), 11), b2);
+	const __m256i b4 = _mm256_sub_epi32(_mm256_add_epi32(_mm256_srai_epi32(_mm256_mullo_epi32(_mm256_set1_epi32(A2), a7), 11), b3), b1);
+
+	const __m256i a0a2 = _mm256_add_epi32(a0, a2);
+	const __m256i a0s2 = _mm256_sub_epi32(a0, a2);
+	const __m256i a1a3s2 = _mm256_sub_epi32(_mm256_add_epi32(a1, a3), a2);
+	const __m256i a1s3a2 = _mm256_add_epi32(_mm256_sub_epi32(a1, a3), a2);
+
+	d[0] = _mm256_add_epi32(a0a2, b0);
+	d[1] = _mm256_add_epi32(a1a3s2, b2);
+	d[2] = _mm256_add_epi32(a1s3a2, b3);
+	d[3] = _mm256_sub_epi32(a0s2, b4);
+	d[4] = _mm256_add_epi32(a0s2, b4);
+	d[5] = _mm256_sub_epi32(a1s3a2, b3);
+	d[6] = _mm256_sub_epi32(a1a3s2, b2);
+	d[7] = _mm256_sub_epi32(a0a2, b0);
+}
+
+TARGET_ATTR("avx2")
+static inline void transpose8x8AVX2(__m256i *r) {
+	const __m256i t0 = _mm256_unpacklo_epi32(r[0], r[1]);
+	const __m256i t1 = _mm256_unpackhi_epi32(r[0], r[1]);
+	const __m256i t2 = _mm256_unpacklo_epi32(r[2], r[3]);
+	const __m256i t3 = _mm256_unpackhi_epi32(r[2], r[3]);
+	const __m256i t4 = _mm256_unpacklo_epi32(r[4], r[5]);
+	const __m256i t5 = _mm256_unpackhi_epi32(r[4], r[5]);
+	const __m256i t6 = _mm256_unpacklo_epi32(r[6], r[7]);
+	const __m256i t7 = _mm256_unpackhi_epi32(r[6], r[7]);
+
+	const __m256i u0 = _mm256_unpacklo_epi64(t0, t2);
+	const __m256i u1 = _mm256_unpackhi_epi64(t0, t2);
+	const __m256i u2 = _mm256_unpacklo_epi64(t1, t3);
+	const __m256i u3 = _mm256_unpackhi_epi64(t1, t3);
+	const __m256i u4 = _mm256_unpacklo_epi64(t4, t6);
+	const __m256i u5 = _mm256_unpackhi_epi64(t4, t6);
+	const __m256i u6 = _mm256_unpacklo_epi64(t5, t7);
+	const __m256i u7 = _mm256_unpackhi_epi64(t5, t7);
+
+	r[0] = _mm256_permute2x128_si256(u0, u4, 0x20);
+	r[1] = _mm256_permute2x128_si256(u1, u5, 0x20);
+	r[2] = _mm256_permute2x128_si256(u2, u6, 0x20);
+	r[3] = _mm256_permute2x128_si256(u3, u7, 0x20);
+	r[4] = _mm256_permute2x128_si256(u0, u4, 0x31);
+	r[5] = _mm256_permute2x128_si256(u1, u5, 0x31);
+	r[6] = _mm256_permute2x128_si256(u2, u6, 0x31);
+	r[7] = _mm256_permute2x128_si256(u3, u7, 0x31);
+}
+
+/**
+ * The IDCT of a block, with each row in one vector. The results are the
+ * same as with the C code, including its truncation of the intermediate
+ * values to 16 bits.
+ */
+TARGET_ATTR("avx2")
+static void IDCTAVX2(const int16 *block, __m256i *rows) {
+	__m256i temp[8];
+	for (int i = 0; i < 8; i++)
+		temp[i] = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)(block + i * 8)));
+
+	IDCTTransformAVX2(temp, rows);
+
+	for (int i = 0; i < 8; i++)
+		rows[i] = _mm256_srai_epi32(_mm256_slli_epi32(rows[i], 16), 16);
+
+	transpose8x8AVX2(rows);
+	IDCTTransformAVX2(rows, temp);
+
+	for (int i = 0; i < 8; i++)
+		rows[i] = _mm256_srai_epi32(_mm256_add_epi32(temp[i], _mm256_set1_epi32(0x7F)), 8);
+
+	transpose8x8AVX2(rows);
+}
+
+/** Store a row of 8 pixels, keeping the low byte of each value. */
+TARGET_ATTR("avx2")
+static inline void storeRowAVX2(byte *dest, __m256i row) {
+	row = _mm256_and_si256(row, _mm256_set1_epi32(0xFF));
+	const __m128i words = _mm_packus_epi32(_mm256_castsi256_si128(row), _mm256_extracti128_si256(row, 1));
+	_mm_storel_epi64((__m128i *)dest, _mm_packus_epi16(words, words));
+}
+
+TARGET_ATTR("avx2")
+static void IDCTPutAVX2(byte *dest, uint32 pitch, const int16 *block) {
+	__m256i rows[8];
+	IDCTAVX2(block, rows);
+
+	for (int i = 0; i < 8; i++, dest += pitch)
+		storeRowAVX2(dest, rows[i]);
+}
+
+TARGET_ATTR("avx2")
+static void IDCTAddAVX2(byte *dest, uint32 pitch, const int16 *block) {
+	__m256i rows[8];
+	IDCTAVX2(block, rows);
+
+	for (int i = 0; i < 8; i++, dest += pitch)
+		storeRowAVX2(dest, _mm256_add_epi32(rows[i], _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)dest))));
+}
+
+#endif // SCUMMVM_AVX2
+
+#ifdef SCUMMVM_SSE2
+
+TARGET_ATTR("sse2")
+static void addResidueSSE2(byte *dest, uint32 pitch, const int16 *block) {
+	// Add the residue to 8 pixels at once. Only the low byte of each sum
+	// is kept, so the result wraps around like in the C code.
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i lowByte = _mm_set1_epi16(0xFF);
+	for (int i = 0; i < 8; i++, dest += pitch, block += 8) {
+		__m128i sum = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)dest), zero);
+		sum = _mm_add_epi16(sum, _mm_loadu_si128((const __m128i *)block));
+		_mm_storel_epi64((__m128i *)dest, _mm_packus_epi16(_mm_and_si128(sum, lowByte), zero));
+	}
+}
+
+#endif // SCUMMVM_SSE2
+
+void BinkDSP::idct(int16 *block) {
+	int i;
+	int16 temp[64];
+
+	for (i = 0; i < 8; i++)
+		IDCTCol(&temp[i], &block[i]);
+	for (i = 0; i < 8; i++) {
+		IDCT_ROW( (&block[8*i]), (&temp[8*i]) );
+	}
+}
+
+void BinkDSP::idctPut(byte *dest, uint32 pitch, const int16 *block) {
+#ifdef SCUMMVM_AVX2
+	if (getKernel() == kKernelAVX2) {
+		IDCTPutAVX2(dest, pitch, block);
+		return;
+	}
+#endif
+
+	int i;
+	int16 temp[64];
+	for (i = 0; i < 8; i++)
+		IDCTCol(&temp[i], &block[i]);
+	for (i = 0; i < 8; i++) {
+		IDCT_ROW( (&dest[i*pitch]), (&temp[8*i]) );
+	}
+}
+
+void BinkDSP::idctAdd(byte *dest, uint32 pitch, int16 *block) {
+#ifdef SCUMMVM_AVX2
+	if (getKernel() == kKernelAVX2) {
+		IDCTAddAVX2(dest, pitch, block);
+		return;
+	}
+#endif
+
+	int i, j;
+
+	idct(block);
+	for (i = 0; i < 8; i++, dest += pitch, block += 8)
+		for (j = 0; j < 8; j++)
+			 dest[j] += block[j];
+}
+
+void BinkDSP::addResidue(byte *dest, uint32 pitch, const int16 *block) {
+#ifdef SCUMMVM_SSE2
+	if (getKernel() != kKernelC) {
+		addResidueSSE2(dest, pitch, block);
+		return;
+	}
+#endif
+
+	for (int i = 0; i < 8; i++, dest += pitch, block += 8)
+		for (int j = 0; j < 8; j++)
+			dest[j] += block[j];
+}
+
+} // End of namespace Video
+
+#endif // USE_BINK
@@ -0,0 +1,97 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+
+// Based on eos' Bink decoder which is in turn
+// based quite heavily on the Bink decoder found in FFmpeg.
+// Many thanks to Kostya Shishkov for doing the hard work.
+
+#include "common/scummsys.h"
+
+#ifdef USE_BINK
+
+#ifndef VIDEO_BINK_DSP_H
+#define VIDEO_BINK_DSP_H
+
+namespace Video {
+
+/**
+ * The block transforms of the Bink video decoder.
+ */
+class BinkDSP {
+public:
+	/**
+	 * The implementations of the IDCT and the residue addition. Besides
+	 * the C code, vectorized kernels are only usable if they have been
+	 * compiled in and the CPU supports them. They produce the same output
+	 * as kKernelC.
+	 *
+	 * kKernelSSE2 adds the residue with SSE2. kKernelAVX2 does that too,
+	 * and runs the IDCT with AVX2.
+	 */
+	enum Kernel {
+		kKernelC = 0,
+		kKernelSSE2,
+		kKernelAVX2,
+
+		kKernelCount
+	};
+
+	/** Check whether a kernel is usable on this machine. */
+	static bool isKernelSupported(Kernel kernel);
+
+	/**
+	 * Select the kernel used by the block transforms. By default the
+	 * fastest supported one is used; this is mostly useful for testing.
+	 *
+	 * @return false if the kernel is not supported, in which case the
+	 *         selection is left unchanged.
+	 */
+	static bool setKernel(Kernel kernel);
+
+	/** Return the kernel currently used by the block transforms. */
+	static Kernel getKernel();
+
+	/** The IDCT of an 8x8 block, in place. Always uses the C code. */
+	static void idct(int16 *block);
+
+	/**
+	 * Store the IDCT of an 8x8 block of coefficients. Only the low byte of
+	 * each result is kept.
+	 */
+	static void idctPut(byte *dest, uint32 pitch, const int16 *block);
+
+	/**
+	 * Add the IDCT of an 8x8 block of coefficients to the pixels, which
+	 * wrap around on overflow. The block is used as scratch space.
+	 */
+	static void idctAdd(byte *dest, uint32 pitch, int16 *block);
+
+	/** Add an 8x8 block of residue to the pixels, which wrap around. */
+	static void addResidue(byte *dest, uint32 pitch, const int16 *block);
+};
+
+} // End of namespace Video
+
+#endif // VIDEO_BINK_DSP_H
+
+#endif // USE_BINK
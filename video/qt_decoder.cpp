@@ -285,6 +285,8 @@ Audio::SeekableAudioStream *QuickTimeDecoder::AudioTrackHandler::getSeekableAudi
 }
 
 QuickTimeDecoder::VideoTrackHandler::VideoTrackHandler(QuickTimeDecoder *decoder, Common::QuickTimeParser::Track *parent) : _decoder(decoder), _parent(parent) {
+	buildFrameIndex();
+
 	_curEdit = 0;
 	enterNewEditList(false);
 
@@ -294,6 +296,8 @@ QuickTimeDecoder::VideoTrackHandler::VideoTrackHandler(QuickTimeDecoder *decoder
 	_curPalette = 0;
 	_dirtyPalette = false;
 	_reversed = false;
+	_curCodec = 0;
+	_dirtyRects = 0;
 	_forcedDitherPalette = 0;
 	_ditherTable = 0;
 	_ditherFrame = 0;
@@ -428,9 +432,14 @@ uint32 QuickTimeDecoder::VideoTrackHandler::getNextFrameStartTime() const {
 }
 
 const Graphics::Surface *QuickTimeDecoder::VideoTrackHandler::decodeNextFrame() {
+	_dirtyRects = 0;
+
 	if (endOfTrack())
 		return 0;
 
+	const int32 prevFrame = _curFrame;
+	const Image::Codec *prevCodec = _curCodec;
+
 	if (_reversed) {
 		// Subtract one to place us on the frame before the current displayed frame.
 		_curFrame--;
@@ -462,6 +471,12 @@ const Graphics::Surface *QuickTimeDecoder::VideoTrackHandler::decodeNextFrame()
 
 	const Graphics::Surface *frame = bufferNextFrame();
 
+	// The codec's changes can only be passed on when it decoded this frame
+	// right after the one shown before it, and the frame is not scaled
+	if (frame && !_reversed && _curFrame == prevFrame + 1 && _curCodec == prevCodec &&
+	        _parent->scaleFactorX == 1 && _parent->scaleFactorY == 1)
+		_dirtyRects = _curCodec->getDirtyRects();
+
 	if (_reversed) {
 		if (_durationOverride >= 0) {
 			// Use our own duration overridden from a media seek
@@ -572,60 +587,61 @@ Common::Rational QuickTimeDecoder::VideoTrackHandler::getScaledHeight() const {
 	return Common::Rational(_parent->height) / _parent->scaleFactorY;
 }
 
-Common::SeekableReadStream *QuickTimeDecoder::VideoTrackHandler::getNextFramePacket(uint32 &descId) {
-	// First, we have to track down which chunk holds the sample and which sample in the chunk contains the frame we are looking for.
-	int32 totalSampleCount = 0;
-	int32 sampleInChunk = 0;
-	int32 actualChunk = -1;
+void QuickTimeDecoder::VideoTrackHandler::buildFrameIndex() {
+	// Track down which chunk holds each sample, and where in the chunk it is
+	uint32 frame = 0;
 	uint32 sampleToChunkIndex = 0;
 
-	for (uint32 i = 0; i < _parent->chunkCount; i++) {
+	_framePackets.reserve(_parent->frameCount);
+
+	for (uint32 i = 0; i < _parent->chunkCount && frame < _parent->frameCount; i++) {
 		if (sampleToChunkIndex < _parent->sampleToChunkCount && i >= _parent->sampleToChunk[sampleToChunkIndex].first)
 			sampleToChunkIndex++;
 
-		totalSampleCount += _parent->sampleToChunk[sampleToChunkIndex - 1].count;
+		if (sampleToChunkIndex == 0)
+			continue;
 
-		if (totalSampleCount > _curFrame) {
-			actualChunk = i;
-			descId = _parent->sampleToChunk[sampleToChunkIndex - 1].id;
-			sampleInChunk = _parent->sampleToChunk[sampleToChunkIndex - 1].count - totalSampleCount + _curFrame;
-			break;
+		const Common::QuickTimeParser::SampleToChunkEntry &entry = _parent->sampleToChunk[sampleToChunkIndex - 1];
+		uint32 offset = _parent->chunkOffsets[i];
+
+		for (uint32 j = 0; j < entry.count && frame < _parent->frameCount; j++, frame++) {
+			if (_parent->sampleSize == 0 && frame >= _parent->sampleCount)
+				break;
+
+			FramePacket packet;
+			packet.offset = offset;
+			packet.size = (_parent->sampleSize != 0) ? _parent->sampleSize : _parent->sampleSizes[frame];
+			packet.descId = entry.id;
+			_framePackets.push_back(packet);
+
+			offset += packet.size;
 		}
 	}
 
-	if (actualChunk < 0)
-		error("Could not find data for frame %d", _curFrame);
+	_frameDurations.reserve(_parent->frameCount);
 
-	// Next seek to that frame
-	Common::SeekableReadStream *stream = _decoder->_fd;
-	stream->seek(_parent->chunkOffsets[actualChunk]);
+	for (int32 i = 0; i < _parent->timeToSampleCount; i++)
+		for (int32 j = 0; j < _parent->timeToSample[i].count; j++)
+			_frameDurations.push_back(_parent->timeToSample[i].duration);
+}
 
-	// Then, if the chunk holds more than one frame, seek to where the frame we want is located
-	for (int32 i = _curFrame - sampleInChunk; i < _curFrame; i++) {
-		if (_parent->sampleSize != 0)
-			stream->skip(_parent->sampleSize);
-		else
-			stream->skip(_parent->sampleSizes[i]);
-	}
+Common::SeekableReadStream *QuickTimeDecoder::VideoTrackHandler::getNextFramePacket(uint32 &descId) {
+	if (_curFrame < 0 || (uint32)_curFrame >= _framePackets.size())
+		error("Could not find data for frame %d", _curFrame);
 
-	// Finally, read in the raw data for the frame
-	//debug("Frame Data[%d]: Offset = %d, Size = %d", _curFrame, stream->pos(), _parent->sampleSizes[_curFrame]);
+	const FramePacket &packet = _framePackets[_curFrame];
+	descId = packet.descId;
 
-	if (_parent->sampleSize != 0)
-		return stream->readStream(_parent->sampleSize);
+	//debug("Frame Data[%d]: Offset = %d, Size = %d", _curFrame, packet.offset, packet.size);
 
-	return stream->readStream(_parent->sampleSizes[_curFrame]);
+	Common::SeekableReadStream *stream = _decoder->_fd;
+	stream->seek(packet.offset);
+	return stream->readStream(packet.size);
 }
 
 uint32 QuickTimeDecoder::VideoTrackHandler::getFrameDuration() {
-	uint32 curFrameIndex = 0;
-	for (int32 i = 0; i < _parent->timeToSampleCount; i++) {
-		curFrameIndex += _parent->timeToSample[i].count;
-		if ((uint32)_curFrame < curFrameIndex) {
-			// Ok, now we have what duration this frame has.
-			return _parent->timeToSample[i].duration;
-		}
-	}
+	if ((uint32)_curFrame < _frameDurations.size())
+		return _frameDurations[_curFrame];
 
 	// This should never occur
 	error("Cannot find duration for frame %d", _curFrame);
@@ -633,9 +649,20 @@ uint32 QuickTimeDecoder::VideoTrackHandler::getFrameDuration() {
 }
 
 uint32 QuickTimeDecoder::VideoTrackHandler::findKeyFrame(uint32 frame) const {
-	for (int i = _parent->keyframeCount - 1; i >= 0; i--)
-		if (_parent->keyframes[i] <= frame)
-			return _parent->keyframes[i];
+	// The keyframes are in ascending order, find the last one up to frame
+	uint32 low = 0, high = _parent->keyframeCount;
+
+	while (low < high) {
+		const uint32 mid = (low + high) / 2;
+
+		if (_parent->keyframes[mid] <= frame)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	if (low > 0)
+		return _parent->keyframes[low - 1];
 
 	// If none found, we'll assume the requested frame is a key frame
 	return frame;
@@ -715,6 +742,8 @@ const Graphics::Surface *QuickTimeDecoder::VideoTrackHandler::bufferNextFrame()
 	const Graphics::Surface *frame = entry->_videoCodec->decodeFrame(*frameData);
 	delete frameData;
 
+	_curCodec = entry->_videoCodec;
+
 	// Update the palette
 	if (entry->_videoCodec->containsPalette()) {
 		// The codec itself contains a palette
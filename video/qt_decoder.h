@@ -72,6 +72,10 @@ public:
 	Audio::Timestamp getDuration() const { return Audio::Timestamp(0, _duration, _timeScale); }
 
 protected:
+	// decodeNextFrame() refills the audio tracks, which could race with
+	// the frames being decoded ahead
+	bool supportsDecodeAhead() const { return false; }
+
 	Common::QuickTimeParser::SampleDesc *readSampleDesc(Common::QuickTimeParser::Track *track, uint32 format, uint32 descSize);
 
 private:
@@ -142,6 +146,7 @@ private:
 		bool isReversed() const { return _reversed; }
 		bool canDither() const;
 		void setDither(const byte *palette);
+		const Common::List<Common::Rect> *getDirtyRects() const { return _dirtyRects; }
 
 		Common::Rational getScaledWidth() const;
 		Common::Rational getScaledHeight() const;
@@ -158,12 +163,32 @@ private:
 		mutable bool _dirtyPalette;
 		bool _reversed;
 
+		// The codec which decoded the last frame, and the areas of the
+		// last returned frame which changed, if known
+		Image::Codec *_curCodec;
+		const Common::List<Common::Rect> *_dirtyRects;
+
 		// Forced dithering of frames
 		byte *_forcedDitherPalette;
 		byte *_ditherTable;
 		Graphics::Surface *_ditherFrame;
 		const Graphics::Surface *forceDither(const Graphics::Surface &frame);
 
+		/**
+		 * Where each frame is in the file, and its duration. These are built
+		 * from the sample tables when loading, so that finding a frame
+		 * doesn't have to walk through them.
+		 */
+		struct FramePacket {
+			uint32 offset;
+			uint32 size;
+			uint32 descId;
+		};
+
+		Common::Array<FramePacket> _framePackets;
+		Common::Array<uint32> _frameDurations;
+		void buildFrameIndex();
+
 		Common::SeekableReadStream *getNextFramePacket(uint32 &descId);
 		uint32 getFrameDuration();
 		uint32 findKeyFrame(uint32 frame) const;
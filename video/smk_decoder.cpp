@@ -166,6 +166,9 @@ private:
 
 BigHuffmanTree::BigHuffmanTree(Common::BitStreamMemory8LSB &bs, int allocSize)
 	: _bs(bs) {
+	for (uint32 i = 0; i < 256; ++i)
+		_prefixtree[i] = _prefixlength[i] = 0;
+
 	uint32 bit = _bs.getBit();
 	if (!bit) {
 		_tree = new uint32[1];
@@ -174,9 +177,6 @@ BigHuffmanTree::BigHuffmanTree(Common::BitStreamMemory8LSB &bs, int allocSize)
 		return;
 	}
 
-	for (uint32 i = 0; i < 256; ++i)
-		_prefixtree[i] = _prefixlength[i] = 0;
-
 	_loBytes = new SmallHuffmanTree(_bs);
 	_hiBytes = new SmallHuffmanTree(_bs);
 
@@ -281,6 +281,7 @@ SmackerDecoder::SmackerDecoder() {
 	_firstFrameStart = 0;
 	_frameTypes = 0;
 	_frameSizes = 0;
+	_audioIndexed = false;
 }
 
 SmackerDecoder::~SmackerDecoder() {
@@ -390,6 +391,20 @@ bool SmackerDecoder::loadStream(Common::SeekableReadStream *stream) {
 
 	_firstFrameStart = _fileStream->pos();
 
+	// Index the frames, so seeking doesn't have to walk through the file
+	_frameOffsets.reserve(frameCount + 1);
+	uint32 offset = _firstFrameStart;
+	for (i = 0; i < frameCount; ++i) {
+		_frameOffsets.push_back(offset);
+		offset += _frameSizes[i] & ~3;
+
+		// Bit 0 of the frame size marks keyframes. The first frame has to
+		// be one anyway.
+		if (i == 0 || (_frameSizes[i] & 1))
+			_keyFrames.push_back(i);
+	}
+	_frameOffsets.push_back(offset);
+
 	return true;
 }
 
@@ -404,6 +419,13 @@ void SmackerDecoder::close() {
 
 	delete[] _frameSizes;
 	_frameSizes = 0;
+
+	_frameOffsets.clear();
+	_keyFrames.clear();
+
+	for (int i = 0; i < 7; i++)
+		_audioOffsets[i].clear();
+	_audioIndexed = false;
 }
 
 bool SmackerDecoder::rewind() {
@@ -416,6 +438,163 @@ bool SmackerDecoder::rewind() {
 	return true;
 }
 
+bool SmackerDecoder::isSeekable() const {
+	// The audio is primed from the chunks before the frame sought to, see
+	// seekIntern()
+	return isVideoLoaded();
+}
+
+bool SmackerDecoder::seekIntern(const Audio::Timestamp &time) {
+	SmackerVideoTrack *videoTrack = (SmackerVideoTrack *)getTrack(0);
+
+	if (time > videoTrack->getDuration())
+		return false;
+
+	for (TrackListIterator it = getTrackListBegin(); it != getTrackListEnd(); it++)
+		if ((*it)->getTrackType() == Track::kTrackTypeAudio)
+			((SmackerAudioTrack *)*it)->rewind();
+
+	const uint32 frame = videoTrack->getFrameAtTime(time);
+
+	if (frame >= (uint32)videoTrack->getFrameCount()) {
+		// At the end, there's nothing left to decode
+		videoTrack->setCurFrame(videoTrack->getFrameCount() - 1);
+		_fileStream->seek(_frameOffsets.back());
+		return true;
+	}
+
+	primeAudio(time, frame);
+
+	// The palette records only hold the changes to the previous palette, so
+	// all of them up to the keyframe have to be applied again.
+	const uint32 keyFrame = findKeyFrame(frame);
+	videoTrack->resetPalette();
+
+	for (uint32 i = 0; i < keyFrame; i++) {
+		if (_frameTypes[i] & 1) {
+			_fileStream->seek(_frameOffsets[i]);
+			videoTrack->unpackPalette(_fileStream);
+		}
+	}
+
+	// Decode from the keyframe to the frame before the one sought to
+	videoTrack->setCurFrame(keyFrame - 1);
+	_fileStream->seek(_frameOffsets[keyFrame]);
+
+	while (videoTrack->getCurFrame() < (int)frame - 1) {
+		videoTrack->increaseCurFrame();
+		readFramePacket(false);
+	}
+
+	return true;
+}
+
+void SmackerDecoder::primeAudio(const Audio::Timestamp &time, uint32 frame) {
+	// Smacker files usually store the audio ahead of the video: the first
+	// frame holds a lead of up to a second, and each following frame the
+	// audio for its own duration. So the audio playing at a frame is in the
+	// chunks of earlier frames, and those are queued again, starting at the
+	// sample for the time sought to.
+	if (!_audioIndexed)
+		indexAudio();
+
+	for (byte track = 0; track < 7; track++) {
+		const Common::Array<uint32> &offsets = _audioOffsets[track];
+		if (offsets.empty())
+			continue;
+
+		const AudioInfo &info = _header.audioInfo[track];
+		const uint32 sampleSize = (info.is16Bits ? 2 : 1) * (info.isStereo ? 2 : 1);
+		const uint32 start = time.convertToFramerate(info.sampleRate).totalNumberOfFrames() * sampleSize;
+
+		// Find the frame whose chunk holds the first sample. If the audio
+		// lags behind instead, skip it from the chunks still to come.
+		uint32 first = frame;
+		while (first > 0 && offsets[first] > start)
+			first--;
+
+		SmackerAudioTrack *audioTrack = (SmackerAudioTrack *)getTrack(track + 1);
+		audioTrack->skipBytes(start - offsets[first]);
+
+		for (uint32 i = first; i < frame; i++) {
+			uint32 chunkSize, unpackedSize;
+			if (findAudioChunk(i, track, chunkSize, unpackedSize))
+				handleAudioTrack(track, chunkSize, unpackedSize);
+		}
+	}
+}
+
+void SmackerDecoder::indexAudio() {
+	const uint32 frameCount = _frameOffsets.size() - 1;
+
+	for (byte track = 0; track < 7; track++) {
+		const AudioInfo &info = _header.audioInfo[track];
+		if (!info.hasAudio || info.compression == kCompressionRDFT || info.compression == kCompressionDCT)
+			continue;
+
+		Common::Array<uint32> &offsets = _audioOffsets[track];
+		offsets.reserve(frameCount + 1);
+
+		uint32 offset = 0;
+		for (uint32 i = 0; i < frameCount; i++) {
+			offsets.push_back(offset);
+
+			uint32 chunkSize, unpackedSize;
+			if (findAudioChunk(i, track, chunkSize, unpackedSize))
+				offset += unpackedSize;
+		}
+		offsets.push_back(offset);
+	}
+
+	_audioIndexed = true;
+}
+
+bool SmackerDecoder::findAudioChunk(uint32 frame, byte track, uint32 &chunkSize, uint32 &unpackedSize) {
+	if (!(_frameTypes[frame] & (2 << track)))
+		return false;
+
+	_fileStream->seek(_frameOffsets[frame]);
+
+	// Skip the palette record, whose first byte is its size / 4
+	if (_frameTypes[frame] & 1)
+		_fileStream->seek(_frameOffsets[frame] + 4 * _fileStream->readByte());
+
+	for (byte i = 0; i <= track; ++i) {
+		if (!(_frameTypes[frame] & (2 << i)))
+			continue;
+
+		chunkSize = _fileStream->readUint32LE() - 4;
+
+		if (_header.audioInfo[i].compression == kCompressionNone) {
+			unpackedSize = chunkSize;
+		} else {
+			unpackedSize = _fileStream->readUint32LE();
+			chunkSize -= 4;
+		}
+
+		if (i != track)
+			_fileStream->skip(chunkSize);
+	}
+
+	return true;
+}
+
+uint32 SmackerDecoder::findKeyFrame(uint32 frame) const {
+	// The first frame is always in the list
+	uint32 low = 0, high = _keyFrames.size();
+
+	while (high - low > 1) {
+		const uint32 mid = (low + high) / 2;
+
+		if (_keyFrames[mid] <= frame)
+			low = mid;
+		else
+			high = mid;
+	}
+
+	return _keyFrames[low];
+}
+
 void SmackerDecoder::readNextPacket() {
 	SmackerVideoTrack *videoTrack = (SmackerVideoTrack *)getTrack(0);
 
@@ -423,6 +602,11 @@ void SmackerDecoder::readNextPacket() {
 		return;
 
 	videoTrack->increaseCurFrame();
+	readFramePacket(true);
+}
+
+void SmackerDecoder::readFramePacket(bool queueAudio) {
+	SmackerVideoTrack *videoTrack = (SmackerVideoTrack *)getTrack(0);
 
 	uint i;
 	uint32 chunkSize = 0;
@@ -451,7 +635,10 @@ void SmackerDecoder::readNextPacket() {
 			chunkSize -= 4;    // subtract the next 4 bytes (unpacked data size)
 		}
 
-		handleAudioTrack(i, chunkSize, dataSizeUnpacked);
+		if (queueAudio)
+			handleAudioTrack(i, chunkSize, dataSizeUnpacked);
+		else
+			_fileStream->skip(chunkSize);
 	}
 
 	uint32 frameSize = _frameSizes[videoTrack->getCurFrame()] & ~3;
@@ -700,6 +887,11 @@ void SmackerDecoder::SmackerVideoTrack::decodeFrame(Common::BitStreamMemory8LSB
 	}
 }
 
+void SmackerDecoder::SmackerVideoTrack::resetPalette() {
+	memset(_palette, 0, 3 * 256);
+	_dirtyPalette = true;
+}
+
 void SmackerDecoder::SmackerVideoTrack::unpackPalette(Common::SeekableReadStream *stream) {
 	uint startPos = stream->pos();
 	uint32 len = 4 * stream->readByte();
@@ -754,7 +946,8 @@ void SmackerDecoder::SmackerVideoTrack::unpackPalette(Common::SeekableReadStream
 
 SmackerDecoder::SmackerAudioTrack::SmackerAudioTrack(const AudioInfo &audioInfo, Audio::Mixer::SoundType soundType) :
 		AudioTrack(soundType),
-		_audioInfo(audioInfo) {
+		_audioInfo(audioInfo),
+		_skipBytes(0) {
 	_audioStream = Audio::makeQueuingAudioStream(_audioInfo.sampleRate, _audioInfo.isStereo);
 }
 
@@ -765,6 +958,7 @@ SmackerDecoder::SmackerAudioTrack::~SmackerAudioTrack() {
 bool SmackerDecoder::SmackerAudioTrack::rewind() {
 	delete _audioStream;
 	_audioStream = Audio::makeQueuingAudioStream(_audioInfo.sampleRate, _audioInfo.isStereo);
+	_skipBytes = 0;
 	return true;
 }
 
@@ -855,6 +1049,16 @@ void SmackerDecoder::SmackerAudioTrack::queueCompressedBuffer(byte *buffer, uint
 }
 
 void SmackerDecoder::SmackerAudioTrack::queuePCM(byte *buffer, uint32 bufferSize) {
+	if (_skipBytes >= bufferSize) {
+		_skipBytes -= bufferSize;
+		free(buffer);
+		return;
+	} else if (_skipBytes) {
+		bufferSize -= _skipBytes;
+		memmove(buffer, buffer + _skipBytes, bufferSize);
+		_skipBytes = 0;
+	}
+
 	byte flags = 0;
 	if (_audioInfo.is16Bits)
 		flags |= Audio::FLAG_16BITS;
@@ -66,9 +66,11 @@ public:
 	void close();
 
 	bool rewind();
+	bool isSeekable() const;
 
 protected:
 	void readNextPacket();
+	bool seekIntern(const Audio::Timestamp &time);
 	bool supportsAudioTrackSwitching() const { return true; }
 	AudioTrack *getAudioTrack(int index);
 
@@ -81,6 +83,7 @@ protected:
 
 		bool isRewindable() const { return true; }
 		bool rewind() { _curFrame = -1; return true; }
+		void setCurFrame(int frame) { _curFrame = frame; }
 
 		uint16 getWidth() const;
 		uint16 getHeight() const;
@@ -95,6 +98,7 @@ protected:
 		void increaseCurFrame() { _curFrame++; }
 		void decodeFrame(Common::BitStreamMemory8LSB &bs);
 		void unpackPalette(Common::SeekableReadStream *stream);
+		void resetPalette();
 
 	protected:
 		Common::Rational getFrameRate() const { return _frameRate; }
@@ -154,7 +158,29 @@ protected:
 
 	uint32 *_frameSizes;
 
+	/**
+	 * The offset of each frame in the file, built from the frame sizes when
+	 * loading. There is one extra entry for the end of the last frame.
+	 */
+	Common::Array<uint32> _frameOffsets;
+
+	/** The frames flagged as keyframes, in ascending order. */
+	Common::Array<uint32> _keyFrames;
+
+	/**
+	 * The amount of unpacked audio before each frame, for each audio track,
+	 * with one extra entry for the end. Built on the first seek.
+	 */
+	Common::Array<uint32> _audioOffsets[7];
+	bool _audioIndexed;
+
 private:
+	void readFramePacket(bool queueAudio);
+	uint32 findKeyFrame(uint32 frame) const;
+
+	void primeAudio(const Audio::Timestamp &time, uint32 frame);
+	void indexAudio();
+	bool findAudioChunk(uint32 frame, byte track, uint32 &chunkSize, uint32 &unpackedSize);
 
 	class SmackerAudioTrack : public AudioTrack {
 	public:
@@ -167,12 +193,16 @@ private:
 		void queueCompressedBuffer(byte *buffer, uint32 bufferSize, uint32 unpackedSize);
 		void queuePCM(byte *buffer, uint32 bufferSize);
 
+		/** Drop the given amount of audio from the next chunks queued. */
+		void skipBytes(uint32 bytes) { _skipBytes = bytes; }
+
 	protected:
 		Audio::AudioStream *getAudioStream() const;
 
 	private:
 		Audio::QueuingAudioStream *_audioStream;
 		AudioInfo _audioInfo;
+		uint32 _skipBytes;
 	};
 
 	// The FrameTypes section of a Smacker file contains an array of bytes, where
@@ -268,6 +268,16 @@ TheoraDecoder::TheoraVideoTrack::TheoraVideoTrack(const Graphics::PixelFormat &f
 	// Set the frame rate
 	_frameRate = Common::Rational(theoraInfo.fps_numerator, theoraInfo.fps_denominator);
 
+	_pictureX = theoraInfo.pic_x;
+	_pictureY = theoraInfo.pic_y;
+	_needsConversion = false;
+
+	// Frames may be converted on the decode-ahead thread, which must not be
+	// the first to use the converter
+	YUVToRGBMan.prepare(format, Graphics::YUVToRGBManager::kScaleITU);
+	_yuvOutput = false;
+	memset(&_yuvFrame, 0, sizeof(_yuvFrame));
+
 	_endOfVideo = false;
 	_nextFrameStartTime = 0.0;
 	_curFrame = -1;
@@ -284,10 +294,9 @@ bool TheoraDecoder::TheoraVideoTrack::decodePacket(ogg_packet &oggPacket) {
 	if (th_decode_packetin(_theoraDecode, &oggPacket, 0) == 0) {
 		_curFrame++;
 
-		// Convert YUV data to RGB data
-		th_ycbcr_buffer yuv;
-		th_decode_ycbcr_out(_theoraDecode, yuv);
-		translateYUVtoRGBA(yuv);
+		// The planes stay valid until the next packet is decoded
+		th_decode_ycbcr_out(_theoraDecode, _yuvBuffer);
+		_needsConversion = true;
 
 		double time = th_granule_time(_theoraDecode, oggPacket.granulepos);
 
@@ -312,6 +321,36 @@ enum TheoraYUVBuffers {
 	kBufferV = 2
 };
 
+const Graphics::Surface *TheoraDecoder::TheoraVideoTrack::decodeNextFrame() {
+	if (!_needsConversion)
+		return &_displaySurface;
+
+	_needsConversion = false;
+
+	if (_yuvOutput) {
+		// Hand out the visible part of the planes
+		_yuvFrame.y = _yuvBuffer[kBufferY].data + _pictureY * _yuvBuffer[kBufferY].stride + _pictureX;
+		_yuvFrame.u = _yuvBuffer[kBufferU].data + _pictureY / 2 * _yuvBuffer[kBufferU].stride + _pictureX / 2;
+		_yuvFrame.v = _yuvBuffer[kBufferV].data + _pictureY / 2 * _yuvBuffer[kBufferV].stride + _pictureX / 2;
+		_yuvFrame.width = _displaySurface.w;
+		_yuvFrame.height = _displaySurface.h;
+		_yuvFrame.yPitch = _yuvBuffer[kBufferY].stride;
+		_yuvFrame.uvPitch = _yuvBuffer[kBufferU].stride;
+		_yuvFrame.scale = Graphics::YUVToRGBManager::kScaleITU;
+	} else {
+		// Convert YUV data to RGB data
+		translateYUVtoRGBA(_yuvBuffer);
+	}
+
+	return &_displaySurface;
+}
+
+bool TheoraDecoder::TheoraVideoTrack::canOutputYUV() const {
+	// The chroma planes can only be cropped along with the luma plane at
+	// even offsets
+	return ((_pictureX | _pictureY | _displaySurface.w | _displaySurface.h) & 1) == 0;
+}
+
 void TheoraDecoder::TheoraVideoTrack::translateYUVtoRGBA(th_ycbcr_buffer &YUVBuffer) {
 	// Width and height of all buffers have to be divisible by 2.
 	assert((YUVBuffer[kBufferY].width & 1) == 0);
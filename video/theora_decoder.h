@@ -31,6 +31,7 @@
 #include "video/video_decoder.h"
 #include "audio/mixer.h"
 #include "graphics/surface.h"
+#include "graphics/yuv_to_rgb.h"
 
 #include <theora/theoradec.h>
 
@@ -86,7 +87,11 @@ private:
 		Graphics::PixelFormat getPixelFormat() const { return _displaySurface.format; }
 		int getCurFrame() const { return _curFrame; }
 		uint32 getNextFrameStartTime() const { return (uint32)(_nextFrameStartTime * 1000); }
-		const Graphics::Surface *decodeNextFrame() { return &_displaySurface; }
+		const Graphics::Surface *decodeNextFrame();
+
+		bool canOutputYUV() const;
+		void setYUVOutput(bool yuvOutput) { _yuvOutput = yuvOutput; }
+		const Graphics::YUV420Frame *getYUVFrame() const { return _yuvOutput ? &_yuvFrame : 0; }
 
 		bool decodePacket(ogg_packet &oggPacket);
 		void setEndOfVideo() { _endOfVideo = true; }
@@ -100,6 +105,16 @@ private:
 		Graphics::Surface _surface;
 		Graphics::Surface _displaySurface;
 
+		// The planes of the last decoded packet. They are only converted
+		// in decodeNextFrame(), so that this can be done on the decode-ahead
+		// thread, and not at all for YUV output.
+		th_ycbcr_buffer _yuvBuffer;
+		bool _needsConversion;
+
+		bool _yuvOutput;
+		Graphics::YUV420Frame _yuvFrame;
+		int _pictureX, _pictureY;
+
 		th_dec_ctx *_theoraDecode;
 
 		void translateYUVtoRGBA(th_ycbcr_buffer &YUVBuffer);
@@ -26,13 +26,107 @@
 #include "audio/mixer.h" // for kMaxChannelVolume
 
 #include "common/rational.h"
+#include "common/atomic.h"
 #include "common/file.h"
+#include "common/mutex.h"
+#include "common/rect.h"
+#include "common/spscqueue.h"
 #include "common/system.h"
+#include "common/thread.h"
+#include "common/trace.h"
 
 #include "graphics/palette.h"
+#include "graphics/surface.h"
 
 namespace Video {
 
+struct VideoDecoder::DecodeAhead {
+	/** A decoded frame, and the state of the track after decoding it */
+	struct Frame {
+		Frame() : hasSurface(false), curFrame(-1), nextFrameStartTime(0), endOfTrack(false), dirtyPalette(false) {}
+
+		Graphics::Surface surface;
+		bool hasSurface;
+		int curFrame;
+		uint32 nextFrameStartTime;
+		bool endOfTrack;
+		bool dirtyPalette;
+		byte palette[3 * 256];
+	};
+
+	DecodeAhead(VideoTrack *videoTrack, uint count) : track(videoTrack), frameCount(count), shown(0), finished(false), draining(false), quit(0) {
+		// Allocate the surfaces up front, decoding then only copies
+		for (uint i = 0; i < frameCount; ++i) {
+			frames[i].surface.create(track->getWidth(), track->getHeight(), track->getPixelFormat());
+			freeFrames.push(&frames[i]);
+		}
+
+		finished = endOfTrack = track->endOfTrack();
+		curFrame = track->getCurFrame();
+		nextFrameStartTime = track->getNextFrameStartTime();
+	}
+
+	~DecodeAhead() {
+		for (uint i = 0; i < frameCount; ++i)
+			frames[i].surface.free();
+	}
+
+	VideoTrack *track;
+
+	/** The frame last returned by decodeNextFrame(), and the ones decoded ahead */
+	Frame frames[kMaxDecodeAheadFrames + 1];
+	uint frameCount;
+
+	/** Frames decoded ahead, for decodeNextFrame() */
+	Common::SPSCQueue<Frame *, kMaxDecodeAheadFrames + 2> decodedFrames;
+	/** Frames available for decoding */
+	Common::SPSCQueue<Frame *, kMaxDecodeAheadFrames + 2> freeFrames;
+	Frame *shown;
+
+	/** Whether the track has been decoded to its end */
+	bool finished;
+	/** Whether only the frames already decoded are used, see setDecodeAhead() */
+	bool draining;
+
+	// The state of the track as of the frame last returned
+	int curFrame;
+	uint32 nextFrameStartTime;
+	bool endOfTrack;
+	byte palette[3 * 256];
+
+	/** The thread decoding the frames */
+	Common::Thread thread;
+	/** Posted when a frame becomes free, or the thread has to quit */
+	Common::Semaphore wakeUp;
+	volatile uint32 quit;
+
+	/**
+	 * Held by the thread while it decodes a frame, and by the engine thread
+	 * while it changes the state of the tracks, e.g. by seeking
+	 */
+	Common::Mutex mutex;
+};
+
+namespace {
+
+class DecodeAheadLock {
+public:
+	explicit DecodeAheadLock(Common::Mutex *mutex) : _mutex(mutex) {
+		if (_mutex)
+			_mutex->lock();
+	}
+
+	~DecodeAheadLock() {
+		if (_mutex)
+			_mutex->unlock();
+	}
+
+private:
+	Common::Mutex *_mutex;
+};
+
+} // End of anonymous namespace
+
 VideoDecoder::VideoDecoder() {
 	_startTime = 0;
 	_dirtyPalette = false;
@@ -49,6 +143,10 @@ VideoDecoder::VideoDecoder() {
 	_nextVideoTrack = 0;
 	_mainAudioTrack = 0;
 	_canSetDither = true;
+	_yuvOutput = false;
+	_yuvFrame = 0;
+	resetDirtyRects();
+	_decodeAhead = 0;
 
 	// Find the best format for output
 	_defaultHighColorFormat = g_system->getScreenFormat();
@@ -57,7 +155,16 @@ VideoDecoder::VideoDecoder() {
 		_defaultHighColorFormat = Graphics::PixelFormat(4, 8, 8, 8, 8, 8, 16, 24, 0);
 }
 
+VideoDecoder::~VideoDecoder() {
+	unregisterDecodeAhead();
+	delete _decodeAhead;
+}
+
 void VideoDecoder::close() {
+	unregisterDecodeAhead();
+	delete _decodeAhead;
+	_decodeAhead = 0;
+
 	if (isPlaying())
 		stop();
 
@@ -80,6 +187,9 @@ void VideoDecoder::close() {
 	_nextVideoTrack = 0;
 	_mainAudioTrack = 0;
 	_canSetDither = true;
+	_yuvOutput = false;
+	_yuvFrame = 0;
+	resetDirtyRects();
 }
 
 bool VideoDecoder::loadFile(const Common::String &filename) {
@@ -98,6 +208,8 @@ bool VideoDecoder::needsUpdate() const {
 }
 
 void VideoDecoder::pauseVideo(bool pause) {
+	DecodeAheadLock lock(getDecodeAheadMutex());
+
 	if (pause) {
 		_pauseLevel++;
 
@@ -182,9 +294,18 @@ Graphics::PixelFormat VideoDecoder::getPixelFormat() const {
 }
 
 const Graphics::Surface *VideoDecoder::decodeNextFrame() {
+	TRACE_SCOPE("video", "VideoDecoder::decodeNextFrame");
+
 	_needsUpdate = false;
 	_canSetDither = false;
 
+	const Graphics::Surface *frame;
+	if (_decodeAhead && nextDecodedFrame(frame)) {
+		// Frames decoded ahead are copies, without the changed areas
+		resetDirtyRects();
+		return frame;
+	}
+
 	readNextPacket();
 
 	// If we have no next video track at this point, there shouldn't be
@@ -192,7 +313,22 @@ const Graphics::Surface *VideoDecoder::decodeNextFrame() {
 	if (!_nextVideoTrack)
 		return 0;
 
-	const Graphics::Surface *frame = _nextVideoTrack->decodeNextFrame();
+	{
+		// Apart from reading the packets, the time the codec takes
+		TRACE_SCOPE("video", "VideoTrack::decodeNextFrame");
+		frame = _nextVideoTrack->decodeNextFrame();
+	}
+
+	if (_yuvOutput && frame)
+		_yuvFrame = _nextVideoTrack->getYUVFrame();
+
+	if (frame) {
+		_dirtyRects = (_nextVideoTrack == _dirtyRectsTrack) ? _nextVideoTrack->getDirtyRects() : 0;
+		_dirtyRectsTrack = _nextVideoTrack;
+	} else if (_nextVideoTrack == _dirtyRectsTrack) {
+		// The frame shown before stays, which the track may report as unchanged
+		_dirtyRects = _nextVideoTrack->getDirtyRects();
+	}
 
 	if (_nextVideoTrack->hasDirtyPalette()) {
 		_palette = _nextVideoTrack->getPalette();
@@ -205,11 +341,20 @@ const Graphics::Surface *VideoDecoder::decodeNextFrame() {
 	return frame;
 }
 
+void VideoDecoder::resetDirtyRects() {
+	_dirtyRects = 0;
+	_dirtyRectsTrack = 0;
+}
+
 bool VideoDecoder::setReverse(bool reverse) {
 	// Can only reverse video-only videos
 	if (reverse && hasAudio())
 		return false;
 
+	// Frames are only decoded ahead in forward direction
+	if (reverse && _decodeAhead)
+		return false;
+
 	// Attempt to make sure all the tracks are in the requested direction
 	for (TrackList::iterator it = _tracks.begin(); it != _tracks.end(); it++) {
 		if ((*it)->getTrackType() == Track::kTrackTypeVideo && ((VideoTrack *)*it)->isReversed() != reverse) {
@@ -217,6 +362,7 @@ bool VideoDecoder::setReverse(bool reverse) {
 				return false;
 
 			_needsUpdate = true; // force an update
+			resetDirtyRects();
 		}
 	}
 
@@ -234,7 +380,7 @@ int VideoDecoder::getCurFrame() const {
 
 	for (TrackList::const_iterator it = _tracks.begin(); it != _tracks.end(); it++)
 		if ((*it)->getTrackType() == Track::kTrackTypeVideo)
-			frame += ((VideoTrack *)*it)->getCurFrame() + 1;
+			frame += getTrackCurFrame((VideoTrack *)*it) + 1;
 
 	return frame;
 }
@@ -275,7 +421,7 @@ uint32 VideoDecoder::getTimeToNextFrame() const {
 		return 0;
 
 	uint32 currentTime = getTime();
-	uint32 nextFrameStartTime = _nextVideoTrack->getNextFrameStartTime();
+	uint32 nextFrameStartTime = getTrackNextFrameStartTime(_nextVideoTrack);
 
 	if (_nextVideoTrack->isReversed()) {
 		// For reversed videos, we need to handle the time difference the opposite way.
@@ -294,7 +440,7 @@ uint32 VideoDecoder::getTimeToNextFrame() const {
 
 bool VideoDecoder::endOfVideo() const {
 	for (TrackList::const_iterator it = _tracks.begin(); it != _tracks.end(); it++)
-		if (!(*it)->endOfTrack() && (!isPlaying() || (*it)->getTrackType() != Track::kTrackTypeVideo || !_endTimeSet || ((VideoTrack *)*it)->getNextFrameStartTime() < (uint)_endTime.msecs()))
+		if (!isTrackFinished(*it) && (!isPlaying() || (*it)->getTrackType() != Track::kTrackTypeVideo || !_endTimeSet || getTrackNextFrameStartTime((VideoTrack *)*it) < (uint)_endTime.msecs()))
 			return false;
 
 	return true;
@@ -315,6 +461,8 @@ bool VideoDecoder::rewind() {
 	if (!isRewindable())
 		return false;
 
+	DecodeAheadLock lock(getDecodeAheadMutex());
+
 	// Stop all tracks so they can be rewound
 	if (isPlaying())
 		stopAudio();
@@ -327,9 +475,13 @@ bool VideoDecoder::rewind() {
 	if (isPlaying())
 		startAudio();
 
+	if (_decodeAhead)
+		resetDecodeAhead();
+
 	_lastTimeChange = 0;
 	_startTime = g_system->getMillis();
 	resetPauseStartTime();
+	resetDirtyRects();
 	findNextVideoTrack();
 	return true;
 }
@@ -349,6 +501,8 @@ bool VideoDecoder::seek(const Audio::Timestamp &time) {
 	if (!isSeekable())
 		return false;
 
+	DecodeAheadLock lock(getDecodeAheadMutex());
+
 	// Stop all tracks so they can be seeked
 	if (isPlaying())
 		stopAudio();
@@ -362,6 +516,9 @@ bool VideoDecoder::seek(const Audio::Timestamp &time) {
 		if (!(*it)->seek(time))
 			return false;
 
+	if (_decodeAhead)
+		resetDecodeAhead();
+
 	_lastTimeChange = time;
 
 	// Now that we've seeked, start all tracks again
@@ -372,6 +529,7 @@ bool VideoDecoder::seek(const Audio::Timestamp &time) {
 	}
 
 	resetPauseStartTime();
+	resetDirtyRects();
 	findNextVideoTrack();
 	_needsUpdate = true;
 	return true;
@@ -415,6 +573,8 @@ void VideoDecoder::stop() {
 	if (!isPlaying())
 		return;
 
+	DecodeAheadLock lock(getDecodeAheadMutex());
+
 	// Stop audio here so we don't have it affect getTime()
 	stopAudio();
 
@@ -450,6 +610,8 @@ void VideoDecoder::setRate(const Common::Rational &rate) {
 		return;
 	}
 
+	DecodeAheadLock lock(getDecodeAheadMutex());
+
 	Common::Rational targetRate = rate;
 
 	// Attempt to set the reverse
@@ -518,6 +680,58 @@ bool VideoDecoder::setDitheringPalette(const byte *palette) {
 	return result;
 }
 
+bool VideoDecoder::setYUVOutput(bool yuvOutput) {
+	// If a frame was already decoded, or frames are decoded ahead, we
+	// can't set it now.
+	if (!_canSetDither)
+		return false;
+
+	// All video tracks need to support it, or the caller would get frames
+	// in both forms
+	bool hasVideoTrack = false;
+	for (TrackList::iterator it = _tracks.begin(); it != _tracks.end(); it++) {
+		if ((*it)->getTrackType() == Track::kTrackTypeVideo) {
+			if (!((VideoTrack *)*it)->canOutputYUV())
+				return false;
+
+			hasVideoTrack = true;
+		}
+	}
+
+	if (!hasVideoTrack)
+		return false;
+
+	for (TrackList::iterator it = _tracks.begin(); it != _tracks.end(); it++)
+		if ((*it)->getTrackType() == Track::kTrackTypeVideo)
+			((VideoTrack *)*it)->setYUVOutput(yuvOutput);
+
+	_yuvOutput = yuvOutput;
+	return true;
+}
+
+bool VideoDecoder::setYUVOutputForScreen() {
+	if (!g_system->hasFeature(OSystem::kFeatureYUVFrames))
+		return false;
+
+	// The backend shows YUV frames as they are, without clipping them
+	if (getWidth() > (uint16)g_system->getWidth() || getHeight() > (uint16)g_system->getHeight())
+		return false;
+
+	return setYUVOutput(true);
+}
+
+void VideoDecoder::copyFrameToScreen(const Graphics::Surface *frame, int x, int y) const {
+	if (_yuvFrame) {
+		g_system->copyYUVFrameToScreen(*_yuvFrame, x, y);
+		return;
+	}
+
+	const int width = MIN<int>(frame->w, g_system->getWidth() - x);
+	const int height = MIN<int>(frame->h, g_system->getHeight() - y);
+	if (width > 0 && height > 0)
+		g_system->copyRectToScreen(frame->getPixels(), frame->pitch, x, y, width, height);
+}
+
 VideoDecoder::Track::Track() {
 	_paused = false;
 }
@@ -756,6 +970,8 @@ bool VideoDecoder::addStreamFileTrack(const Common::String &baseName) {
 
 	bool result = track->loadFromFile(baseName);
 
+	DecodeAheadLock lock(getDecodeAheadMutex());
+
 	if (result)
 		addTrack(track, true);
 	else
@@ -776,6 +992,8 @@ bool VideoDecoder::setAudioTrack(int index) {
 	if (_mainAudioTrack == audioTrack)
 		return true;
 
+	DecodeAheadLock lock(getDecodeAheadMutex());
+
 	_mainAudioTrack->setMute(true);
 	audioTrack->setMute(false);
 	_mainAudioTrack = audioTrack;
@@ -793,6 +1011,8 @@ uint VideoDecoder::getAudioTrackCount() const {
 }
 
 void VideoDecoder::setEndTime(const Audio::Timestamp &endTime) {
+	DecodeAheadLock lock(getDecodeAheadMutex());
+
 	Audio::Timestamp startTime = 0;
 
 	if (isPlaying()) {
@@ -867,9 +1087,9 @@ VideoDecoder::VideoTrack *VideoDecoder::findNextVideoTrack() {
 	uint32 bestTime = 0xFFFFFFFF;
 
 	for (TrackList::iterator it = _tracks.begin(); it != _tracks.end(); it++) {
-		if ((*it)->getTrackType() == Track::kTrackTypeVideo && !(*it)->endOfTrack()) {
+		if ((*it)->getTrackType() == Track::kTrackTypeVideo && !isTrackFinished(*it)) {
 			VideoTrack *track = (VideoTrack *)*it;
-			uint32 time = track->getNextFrameStartTime();
+			uint32 time = getTrackNextFrameStartTime(track);
 
 			if (time < bestTime) {
 				bestTime = time;
@@ -911,7 +1131,7 @@ bool VideoDecoder::hasFramesLeft() const {
 	// This is only used for needsUpdate() atm so that setEndTime() works properly
 	// And unlike endOfVideoTracks(), this takes into account _endTime
 	for (TrackList::const_iterator it = _tracks.begin(); it != _tracks.end(); it++)
-		if ((*it)->getTrackType() == Track::kTrackTypeVideo && !(*it)->endOfTrack() && (!isPlaying() || !_endTimeSet || ((VideoTrack *)*it)->getNextFrameStartTime() < (uint)_endTime.msecs()))
+		if ((*it)->getTrackType() == Track::kTrackTypeVideo && !isTrackFinished(*it) && (!isPlaying() || !_endTimeSet || getTrackNextFrameStartTime((VideoTrack *)*it) < (uint)_endTime.msecs()))
 			return true;
 
 	return false;
@@ -942,4 +1162,205 @@ void VideoDecoder::eraseTrack(Track *track) {
 	}
 }
 
+bool VideoDecoder::setDecodeAhead(uint frames) {
+	if (frames == getDecodeAhead())
+		return true;
+
+	if (frames == 0) {
+		unregisterDecodeAhead();
+		return true;
+	}
+
+	// The frames decoded ahead before have to be used up first
+	if (frames > kMaxDecodeAheadFrames || _decodeAhead || !isVideoLoaded() || !supportsDecodeAhead())
+		return false;
+
+	// The queued frames only hold the surfaces
+	if (_yuvOutput)
+		return false;
+
+	VideoTrack *videoTrack = 0;
+	for (TrackList::iterator it = _tracks.begin(); it != _tracks.end(); it++) {
+		if ((*it)->getTrackType() == Track::kTrackTypeVideo) {
+			if (videoTrack)
+				return false;
+
+			videoTrack = (VideoTrack *)*it;
+		}
+	}
+
+	if (!videoTrack || videoTrack->isReversed())
+		return false;
+
+	// One more frame than decoded ahead is needed for the one shown
+	_decodeAhead = new DecodeAhead(videoTrack, frames + 1);
+
+	// Without threads, decodeNextFrame() keeps decoding the frames itself
+	if (!_decodeAhead->thread.start(&decodeAheadThread, this, "VideoDecoder")) {
+		delete _decodeAhead;
+		_decodeAhead = 0;
+		return false;
+	}
+
+	_canSetDither = false;
+	return true;
+}
+
+uint VideoDecoder::getDecodeAhead() const {
+	return isDecodingAhead() ? _decodeAhead->frameCount - 1 : 0;
+}
+
+bool VideoDecoder::isDecodingAhead() const {
+	return _decodeAhead && !_decodeAhead->draining;
+}
+
+Common::Mutex *VideoDecoder::getDecodeAheadMutex() const {
+	return isDecodingAhead() ? &_decodeAhead->mutex : 0;
+}
+
+void VideoDecoder::unregisterDecodeAhead() {
+	if (!isDecodingAhead())
+		return;
+
+	Common::atomicStore(_decodeAhead->quit, 1U);
+	_decodeAhead->wakeUp.post();
+	_decodeAhead->thread.join();
+
+	_decodeAhead->draining = true;
+}
+
+void VideoDecoder::decodeAheadThread(void *param) {
+	VideoDecoder *decoder = (VideoDecoder *)param;
+	DecodeAhead &ahead = *decoder->_decodeAhead;
+
+	while (!Common::atomicLoad(ahead.quit)) {
+		// The lock is only held for one frame at a time, so the engine
+		// thread never waits long for it
+		bool decoded;
+		{
+			Common::StackLock lock(ahead.mutex);
+			decoded = decoder->decodeAheadFrame();
+		}
+
+		if (!decoded)
+			ahead.wakeUp.wait();
+	}
+}
+
+bool VideoDecoder::decodeAheadFrame() {
+	DecodeAhead &ahead = *_decodeAhead;
+
+	DecodeAhead::Frame *frame;
+	if (ahead.finished || !ahead.freeFrames.pop(frame))
+		return false;
+
+	TRACE_SCOPE("video", "VideoDecoder::decodeAheadFrame");
+
+	readNextPacket();
+	const Graphics::Surface *surface = ahead.track->decodeNextFrame();
+
+	frame->hasSurface = (surface != 0);
+	if (surface) {
+		if (frame->surface.w != surface->w || frame->surface.h != surface->h || frame->surface.format != surface->format) {
+			frame->surface.free();
+			frame->surface.create(surface->w, surface->h, surface->format);
+		}
+
+		frame->surface.copyRectToSurface(*surface, 0, 0, Common::Rect(surface->w, surface->h));
+	}
+
+	frame->curFrame = ahead.track->getCurFrame();
+	frame->nextFrameStartTime = ahead.track->getNextFrameStartTime();
+	frame->endOfTrack = ahead.track->endOfTrack();
+	frame->dirtyPalette = ahead.track->hasDirtyPalette();
+	if (frame->dirtyPalette)
+		memcpy(frame->palette, ahead.track->getPalette(), sizeof(frame->palette));
+
+	ahead.finished = frame->endOfTrack;
+	ahead.decodedFrames.push(frame);
+	return true;
+}
+
+void VideoDecoder::resetDecodeAhead() {
+	DecodeAhead &ahead = *_decodeAhead;
+
+	// The frame shown stays valid until the next decodeNextFrame() call
+	DecodeAhead::Frame *frame;
+	while (ahead.decodedFrames.pop(frame))
+		ahead.freeFrames.push(frame);
+
+	ahead.finished = ahead.endOfTrack = ahead.track->endOfTrack();
+	ahead.curFrame = ahead.track->getCurFrame();
+	ahead.nextFrameStartTime = ahead.track->getNextFrameStartTime();
+
+	if (!ahead.draining)
+		ahead.wakeUp.post();
+}
+
+bool VideoDecoder::nextDecodedFrame(const Graphics::Surface *&surface) {
+	DecodeAhead &ahead = *_decodeAhead;
+
+	DecodeAhead::Frame *frame;
+	if (!ahead.decodedFrames.pop(frame)) {
+		if (ahead.draining) {
+			// All frames decoded ahead are used up, go back to decoding
+			// them in decodeNextFrame()
+			delete _decodeAhead;
+			_decodeAhead = 0;
+			return false;
+		}
+
+		// The thread did not keep up
+		Common::StackLock lock(ahead.mutex);
+		decodeAheadFrame();
+
+		if (!ahead.decodedFrames.pop(frame)) {
+			surface = 0;
+			return true;
+		}
+	}
+
+	if (ahead.shown) {
+		ahead.freeFrames.push(ahead.shown);
+		if (!ahead.draining)
+			ahead.wakeUp.post();
+	}
+	ahead.shown = frame;
+
+	ahead.curFrame = frame->curFrame;
+	ahead.nextFrameStartTime = frame->nextFrameStartTime;
+	ahead.endOfTrack = frame->endOfTrack;
+
+	if (frame->dirtyPalette) {
+		memcpy(ahead.palette, frame->palette, sizeof(ahead.palette));
+		_palette = ahead.palette;
+		_dirtyPalette = true;
+	}
+
+	findNextVideoTrack();
+	surface = frame->hasSurface ? &frame->surface : 0;
+	return true;
+}
+
+bool VideoDecoder::isTrackFinished(const Track *track) const {
+	if (_decodeAhead && track == _decodeAhead->track)
+		return _decodeAhead->endOfTrack;
+
+	return track->endOfTrack();
+}
+
+int VideoDecoder::getTrackCurFrame(const VideoTrack *track) const {
+	if (_decodeAhead && track == _decodeAhead->track)
+		return _decodeAhead->curFrame;
+
+	return track->getCurFrame();
+}
+
+uint32 VideoDecoder::getTrackNextFrameStartTime(const VideoTrack *track) const {
+	if (_decodeAhead && track == _decodeAhead->track)
+		return _decodeAhead->nextFrameStartTime;
+
+	return track->getNextFrameStartTime();
+}
+
 } // End of namespace Video
@@ -26,7 +26,9 @@
 #include "audio/mixer.h"
 #include "audio/timestamp.h"	// TODO: Move this to common/ ?
 #include "common/array.h"
+#include "common/list.h"
 #include "common/rational.h"
+#include "common/rect.h"
 #include "common/str.h"
 #include "graphics/pixelformat.h"
 
@@ -37,11 +39,13 @@ class SeekableAudioStream;
 }
 
 namespace Common {
+class Mutex;
 class SeekableReadStream;
 }
 
 namespace Graphics {
 struct Surface;
+struct YUV420Frame;
 }
 
 namespace Video {
@@ -52,7 +56,7 @@ namespace Video {
 class VideoDecoder {
 public:
 	VideoDecoder();
-	virtual ~VideoDecoder() {}
+	virtual ~VideoDecoder();
 
 	/////////////////////////////////////////
 	// Opening/Closing a Video
@@ -396,6 +400,118 @@ public:
 	 */
 	bool setDitheringPalette(const byte *palette);
 
+	/**
+	 * Tell the video to hand out its frames as YUV420 planes, without
+	 * converting them to RGB.
+	 *
+	 * This is meant for callers which do the conversion themselves, like
+	 * on the GPU. For video formats or codecs that support it, getYUVFrame()
+	 * then returns the planes of the frame last returned by
+	 * decodeNextFrame(). decodeNextFrame() still returns a surface with the
+	 * size and format of the frame, or 0 when there is no new frame, but its
+	 * pixels are not updated.
+	 *
+	 * This should be called after loadStream(), but before a decodeNextFrame()
+	 * call. This is enforced. Frames can't be decoded ahead in this mode.
+	 *
+	 * @param yuvOutput true to hand out YUV planes, false to convert the
+	 *                  frames (the default)
+	 * @return true on success, false otherwise
+	 */
+	bool setYUVOutput(bool yuvOutput);
+
+	/**
+	 * Get the YUV planes of the frame last returned by decodeNextFrame().
+	 *
+	 * The planes are owned by the VideoDecoder and stay valid until the
+	 * next decodeNextFrame() call.
+	 *
+	 * @return the planes, or 0 if setYUVOutput() was not successfully
+	 *         called or there is no frame yet
+	 * @see setYUVOutput()
+	 */
+	const Graphics::YUV420Frame *getYUVFrame() const { return _yuvFrame; }
+
+	/**
+	 * Hand out YUV planes if the backend can show them itself, see
+	 * OSystem::kFeatureYUVFrames, and the video fits on the screen. The
+	 * frames are then shown with copyFrameToScreen().
+	 *
+	 * Like setYUVOutput(), this has to be called before the first
+	 * decodeNextFrame() call.
+	 *
+	 * @return true if the frames are handed out as YUV planes
+	 */
+	bool setYUVOutputForScreen();
+
+	/**
+	 * Copy the frame last returned by decodeNextFrame() to the screen, with
+	 * its top left corner at the given position. YUV frames are passed to
+	 * OSystem::copyYUVFrameToScreen(), others are clipped to the screen and
+	 * passed to OSystem::copyRectToScreen(). updateScreen() is not called.
+	 *
+	 * @param frame	the frame returned by decodeNextFrame()
+	 */
+	void copyFrameToScreen(const Graphics::Surface *frame, int x, int y) const;
+
+	/**
+	 * Get the areas of the frame last returned by decodeNextFrame() which
+	 * changed compared to the frame returned before it. Callers which still
+	 * have the previous frame on the screen or in a texture only need to
+	 * copy these areas.
+	 *
+	 * The list is owned by the VideoDecoder and stays valid until the next
+	 * decodeNextFrame() call. When that returned 0 because a track repeats
+	 * its previous frame, the list is empty.
+	 *
+	 * @return the changed areas, or 0 if they are not known and the whole
+	 *         frame has to be assumed changed. This is the case for the
+	 *         first frame, after seeking, rewinding or changing direction,
+	 *         for frames decoded ahead, and for formats and codecs which
+	 *         don't keep track of the changed areas.
+	 */
+	const Common::List<Common::Rect> *getDirtyRects() const { return _dirtyRects; }
+
+	enum {
+		/** The maximum number of frames setDecodeAhead() accepts. */
+		kMaxDecodeAheadFrames = 8
+	};
+
+	/**
+	 * Decode frames ahead in the background, so that a frame which takes
+	 * long to decode does not hold up the caller of decodeNextFrame().
+	 *
+	 * A thread of its own decodes up to the given number of frames into a
+	 * queue, and decodeNextFrame() only takes the next one from there. If
+	 * the queue is empty, decodeNextFrame() decodes the frame itself.
+	 * Everything else works as before.
+	 *
+	 * This only works with a single video track which is played forward,
+	 * and on backends with threads, see OSystem::createThread().
+	 * setDitheringPalette() must be called before. While decoding ahead,
+	 * decoder specific methods which access the tracks must not be used.
+	 *
+	 * After setDecodeAhead(0), decodeNextFrame() still returns the frames
+	 * which have already been decoded ahead. The number of frames can only
+	 * be changed again once they are used up, i.e. after the
+	 * decodeNextFrame() call which finds no frame left. Seeking drops the
+	 * frames, so this is the case for the first decodeNextFrame() call
+	 * after seeking.
+	 *
+	 * @param frames the number of frames to decode ahead, up to
+	 *               kMaxDecodeAheadFrames, or 0 to decode each frame in
+	 *               decodeNextFrame() (the default)
+	 * @return true on success, false otherwise, e.g. if the backend has no
+	 *         threads
+	 */
+	bool setDecodeAhead(uint frames);
+
+	/**
+	 * Returns the number of frames decoded ahead.
+	 * @see setDecodeAhead()
+	 */
+	uint getDecodeAhead() const;
+
 	/////////////////////////////////////////
 	// Audio Control
 	/////////////////////////////////////////
@@ -645,6 +761,30 @@ protected:
 		 * Activate dithering mode with a palette
 		 */
 		virtual void setDither(const byte *palette) {}
+
+		/**
+		 * Can the video track hand out its frames as YUV420 planes?
+		 */
+		virtual bool canOutputYUV() const { return false; }
+
+		/**
+		 * Activate handing out YUV420 planes instead of converting the
+		 * frames, see VideoDecoder::setYUVOutput()
+		 */
+		virtual void setYUVOutput(bool yuvOutput) {}
+
+		/**
+		 * Get the YUV420 planes of the last decoded frame
+		 */
+		virtual const Graphics::YUV420Frame *getYUVFrame() const { return 0; }
+
+		/**
+		 * Get the areas of the last decoded frame which changed compared
+		 * to the frame decoded before it, or 0 if they are not known. An
+		 * empty list after decodeNextFrame() returned 0 means the frame
+		 * decoded before is repeated.
+		 */
+		virtual const Common::List<Common::Rect> *getDirtyRects() const { return 0; }
 	};
 
 	/**
@@ -926,6 +1066,17 @@ protected:
 	 */
 	virtual AudioTrack *getAudioTrack(int index) { return 0; }
 
+	/**
+	 * Can frames be decoded ahead on another thread?
+	 *
+	 * A subclass has to return false if it accesses the tracks in the
+	 * engine thread, other than through readNextPacket() and the tracks'
+	 * decodeNextFrame(), e.g. from its own decodeNextFrame() function.
+	 *
+	 * @see setDecodeAhead()
+	 */
+	virtual bool supportsDecodeAhead() const { return true; }
+
 private:
 	// Tracks owned by this VideoDecoder
 	TrackList _tracks;
@@ -946,6 +1097,16 @@ private:
 	// Enforcement of not being able to set dither
 	bool _canSetDither;
 
+	// YUV output, see setYUVOutput()
+	bool _yuvOutput;
+	const Graphics::YUV420Frame *_yuvFrame;
+
+	// Changed areas, see getDirtyRects(). The areas a track reports are
+	// relative to its previous frame, so they are only used when that frame
+	// was the one returned before, by the same track.
+	const Common::List<Common::Rect> *_dirtyRects;
+	const VideoTrack *_dirtyRectsTrack;
+
 	// Default PixelFormat settings
 	Graphics::PixelFormat _defaultHighColorFormat;
 
@@ -955,6 +1116,7 @@ private:
 	void startAudioLimit(const Audio::Timestamp &limit);
 	bool hasFramesLeft() const;
 	bool hasAudio() const;
+	void resetDirtyRects();
 
 	int32 _startTime;
 	uint32 _pauseLevel;
@@ -964,6 +1126,23 @@ private:
 	Audio::Mixer::SoundType _soundType;
 
 	AudioTrack *_mainAudioTrack;
+
+	// Decoding frames ahead, see setDecodeAhead()
+	struct DecodeAhead;
+	DecodeAhead *_decodeAhead;
+
+	static void decodeAheadThread(void *param);
+	bool isDecodingAhead() const;
+	Common::Mutex *getDecodeAheadMutex() const;
+	void unregisterDecodeAhead();
+	bool decodeAheadFrame();
+	void resetDecodeAhead();
+	bool nextDecodedFrame(const Graphics::Surface *&surface);
+
+	// The state of a track as seen by the caller of decodeNextFrame()
+	bool isTrackFinished(const Track *track) const;
+	int getTrackCurFrame(const VideoTrack *track) const;
+	uint32 getTrackNextFrameStartTime(const VideoTrack *track) const;
 };
 
 } // End of namespace Video